@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the add-on server, for testing the installer.
+
+Serves the .zip files in a directory together with a generated
+content.json manifest (size and crc32 included), with HTTP range support.
+Point the engine at it with -addons http://127.0.0.1:8000
+
+The --range option picks how resumed downloads are answered:
+  honor   206 with the requested bytes (default)
+  ignore  200 with the whole file, as servers without range support do
+  reject  416, the server refuses the range
+
+--rate limits the transfer speed (bytes/s) and --drop closes each
+connection after that many bytes, so interrupted transfers can be resumed.
+
+Example:
+  python3 addon_server.py --dir ./addons --rate 200000 --drop 1000000
+"""
+
+import argparse
+import json
+import os
+import re
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+MANIFEST = "content.json"
+CHUNK = 16384
+
+
+def file_crc32(path):
+    crc = 0
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 20), b""):
+            crc = zlib.crc32(block, crc)
+    return "%08x" % (crc & 0xffffffff)
+
+
+def build_manifest(directory, badcrc):
+    addons = []
+    for name in sorted(os.listdir(directory)):
+        path = os.path.join(directory, name)
+        if not name.lower().endswith(".zip") or not os.path.isfile(path):
+            continue
+        gamedir = os.path.splitext(name)[0]
+        addons.append({
+            "name": gamedir,
+            "author": "local test",
+            "date": time.strftime("%d.%m.%Y", time.localtime(os.path.getmtime(path))),
+            "gamedir": gamedir,
+            "download": name,
+            "size": os.path.getsize(path),
+            "crc32": "00000000" if badcrc else file_crc32(path),
+            "description": {"en": "Served by addon_server.py"},
+        })
+    return json.dumps({"addons": addons}, indent=1).encode("utf-8")
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def do_GET(self):
+        opts = self.server.opts
+        name = os.path.basename(self.path.split("?", 1)[0])
+
+        if name == MANIFEST:
+            data = build_manifest(opts.dir, opts.badcrc)
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+            return
+
+        path = os.path.join(opts.dir, name)
+        if not name or not os.path.isfile(path):
+            self.send_error(404)
+            return
+
+        size = os.path.getsize(path)
+        start = 0
+        match = re.match(r"bytes=(\d+)-", self.headers.get("Range", ""))
+        if match and opts.range != "ignore":
+            start = int(match.group(1))
+            if opts.range == "reject" or start >= size:
+                self.send_response(416)
+                self.send_header("Content-Range", "bytes */%d" % size)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            self.send_response(206)
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, size - 1, size))
+        else:
+            self.send_response(200)
+        self.send_header("Content-Type", "application/zip")
+        self.send_header("Content-Length", str(size - start))
+        self.send_header("Accept-Ranges", "bytes")
+        self.end_headers()
+
+        sent = 0
+        with open(path, "rb") as f:
+            f.seek(start)
+            while True:
+                block = f.read(CHUNK)
+                if not block:
+                    break
+                if opts.drop and sent + len(block) > opts.drop:
+                    self.wfile.write(block[:opts.drop - sent])
+                    self.close_connection = True
+                    self.log_message("dropped %s after %d bytes", name, opts.drop)
+                    return
+                self.wfile.write(block)
+                sent += len(block)
+                if opts.rate:
+                    time.sleep(len(block) / opts.rate)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local add-on server for testing the installer")
+    parser.add_argument("--dir", default=".", help="directory with the add-on .zip files")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--range", choices=("honor", "ignore", "reject"), default="honor")
+    parser.add_argument("--rate", type=int, default=0, help="bytes per second, 0 for unlimited")
+    parser.add_argument("--drop", type=int, default=0, help="close connections after this many bytes")
+    parser.add_argument("--badcrc", action="store_true", help="publish wrong checksums")
+    opts = parser.parse_args()
+
+    server = ThreadingHTTPServer(("127.0.0.1", opts.port), Handler)
+    server.opts = opts
+    print("Serving add-ons from %s on http://127.0.0.1:%d" % (os.path.abspath(opts.dir), opts.port))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -31,6 +31,7 @@
 
 qboolean	bgmloop;
 cvar_t		bgm_extmusic = {"bgm_extmusic", "1", CVAR_ARCHIVE};
+cvar_t		bgm_prebuffer = {"bgm_prebuffer", "2", CVAR_ARCHIVE};
 
 static qboolean	no_extmusic= false;
 static float	old_volume = -1.0f;
@@ -75,6 +76,46 @@ static music_handler_t *music_handlers = NULL;
 
 static snd_stream_t *bgmstream = NULL;
 
+/* Streams are decoded on a separate thread into a ring of PCM data
+ * (in the stream's own format), so codec and disk cost never land on
+ * the main thread. The ring has a single producer (the decoder) and a
+ * single consumer (BGM_UpdateStream), so the read/write positions are
+ * plain atomics. The mutex only guards the codec, for music_jump and
+ * music_loop.
+ */
+#define BGM_MIN_RING	(64 * 1024)
+#define BGM_MAX_RING	(16 * 1024 * 1024)
+#define BGM_CHUNK	16384
+
+typedef enum
+{
+	BGMDEC_RUNNING,
+	BGMDEC_EOF,
+	BGMDEC_REPEATED_EOF,
+	BGMDEC_READ_ERROR,
+	BGMDEC_SEEK_ERROR,
+} bgmdecstate_t;
+
+typedef struct
+{
+	SDL_Thread	*thread;
+	SDL_mutex	*mutex;
+	SDL_cond	*cond;
+	SDL_atomic_t	quit;
+	SDL_atomic_t	state;		/* bgmdecstate_t		*/
+	int		error;		/* codec result on error	*/
+	qboolean	did_rewind;
+	byte		*ring;
+	unsigned int	size;		/* power of two			*/
+	unsigned int	framesize;
+	SDL_atomic_t	read;		/* consumer position		*/
+	SDL_atomic_t	write;		/* producer position		*/
+	qboolean	primed;		/* prebuffering done		*/
+	int		underruns;
+} bgmdecoder_t;
+
+static bgmdecoder_t bgmdec;
+
 static void BGM_Play_f (void)
 {
 	if (Cmd_Argc() == 2) {
@@ -84,8 +125,12 @@ static void BGM_Play_f (void)
 		if (bgmstream)
 		{
 			char path[MAX_QPATH];
+			unsigned int buffered = (unsigned int) SDL_AtomicGet (&bgmdec.write) - (unsigned int) SDL_AtomicGet (&bgmdec.read);
 			COM_StripExtension (COM_SkipPath (bgmstream->name), path, sizeof (path));
 			Con_Printf ("Playing %s, use 'music <musicfile>' to change\n", path);
+			Con_Printf ("%.2fs buffered, %d underrun%s%s\n",
+				buffered / (double) (bgmdec.framesize * bgmstream->info.rate),
+				PLURAL (bgmdec.underruns), bgmdec.thread ? "" : " (no decoder thread)");
 		}
 		else
 			Con_Printf ("music <musicfile>\n");
@@ -114,7 +159,12 @@ static void BGM_Loop_f (void)
 		else if (q_strcasecmp(Cmd_Argv(1),"toggle") == 0)
 			bgmloop = !bgmloop;
 
-		if (bgmstream) bgmstream->loop = bgmloop;
+		if (bgmstream)
+		{
+			SDL_LockMutex (bgmdec.mutex);
+			bgmstream->loop = bgmloop;
+			SDL_UnlockMutex (bgmdec.mutex);
+		}
 	}
 
 	if (bgmloop)
@@ -134,7 +184,15 @@ static void BGM_Jump_f (void)
 		Con_Printf ("music_jump <ordernum>\n");
 	}
 	else if (bgmstream) {
+		SDL_LockMutex (bgmdec.mutex);
 		S_CodecJumpToOrder(bgmstream, atoi(Cmd_Argv(1)));
+		/* drop what was decoded before the jump */
+		SDL_AtomicSet (&bgmdec.read, SDL_AtomicGet (&bgmdec.write));
+		SDL_AtomicSet (&bgmdec.state, BGMDEC_RUNNING);
+		bgmdec.did_rewind = false;
+		bgmdec.primed = false;
+		SDL_CondSignal (bgmdec.cond);
+		SDL_UnlockMutex (bgmdec.mutex);
 	}
 }
 
@@ -144,6 +202,7 @@ qboolean BGM_Init (void)
 	int i;
 
 	Cvar_RegisterVariable(&bgm_extmusic);
+	Cvar_RegisterVariable(&bgm_prebuffer);
 	Cmd_AddCommand("music", BGM_Play_f);
 	Cmd_AddCommand("music_pause", BGM_Pause_f);
 	Cmd_AddCommand("music_resume", BGM_Resume_f);
@@ -156,6 +215,11 @@ qboolean BGM_Init (void)
 
 	bgmloop = true;
 
+	bgmdec.mutex = SDL_CreateMutex ();
+	bgmdec.cond = SDL_CreateCond ();
+	if (!bgmdec.mutex || !bgmdec.cond)
+		Sys_Error ("BGM_Init: could not create decoder mutex");
+
 	for (i = 0; wanted_handlers[i].type != CODECTYPE_NONE; i++)
 	{
 		switch (wanted_handlers[i].player)
@@ -195,8 +259,16 @@ void BGM_Shutdown (void)
 /* sever our connections to
  * midi_drv and snd_codec */
 	music_handlers = NULL;
+
+	SDL_DestroyCond (bgmdec.cond);
+	SDL_DestroyMutex (bgmdec.mutex);
+	free (bgmdec.ring);
+	memset (&bgmdec, 0, sizeof (bgmdec));
 }
 
+static qboolean BGM_OpenStream (const char *path, unsigned int type);
+static void BGM_StopDecoder (void);
+
 static void BGM_Play_noext (const char *filename, unsigned int allowed_types)
 {
 	char tmp[MAX_QPATH];
@@ -223,8 +295,7 @@ static void BGM_Play_noext (const char *filename, unsigned int allowed_types)
 		/* not supported in quake */
 			break;
 		case BGM_STREAMER:
-			bgmstream = S_CodecOpenStreamType(tmp, handler->type, bgmloop);
-			if (bgmstream)
+			if (BGM_OpenStream(tmp, handler->type))
 				return;		/* success */
 			break;
 		case BGM_NONE:
@@ -281,8 +352,7 @@ void BGM_Play (const char *filename)
 	/* not supported in quake */
 		break;
 	case BGM_STREAMER:
-		bgmstream = S_CodecOpenStreamType(tmp, handler->type, bgmloop);
-		if (bgmstream)
+		if (BGM_OpenStream(tmp, handler->type))
 			return;		/* success */
 		break;
 	case BGM_NONE:
@@ -357,8 +427,7 @@ void BGM_PlayCDtrack (byte track, qboolean looping)
 	{
 		q_snprintf(tmp, sizeof(tmp), "%s/track%02d.%s",
 				MUSIC_DIRNAME, (int)track, ext);
-		bgmstream = S_CodecOpenStreamType(tmp, type, bgmloop);
-		if (! bgmstream)
+		if (! BGM_OpenStream(tmp, type))
 			Con_Printf("Couldn't handle music file %s\n", tmp);
 	}
 }
@@ -367,6 +436,7 @@ void BGM_Stop (void)
 {
 	if (bgmstream)
 	{
+		BGM_StopDecoder ();
 		bgmstream->status = STREAM_NONE;
 		S_CodecCloseStream(bgmstream);
 		bgmstream = NULL;
@@ -395,14 +465,164 @@ void BGM_Resume (void)
 	}
 }
 
+/* producer side: decodes one chunk into the ring.
+ * returns false if there's nothing to do. */
+static qboolean BGM_DecodeChunk (void)
+{
+	byte		raw[BGM_CHUNK];
+	unsigned int	readpos, writepos, space, ofs, part;
+	int		res;
+
+	if (SDL_AtomicGet (&bgmdec.state) != BGMDEC_RUNNING)
+		return false;
+
+	readpos = (unsigned int) SDL_AtomicGet (&bgmdec.read);
+	writepos = (unsigned int) SDL_AtomicGet (&bgmdec.write);
+	space = bgmdec.size - (writepos - readpos);
+	space = q_min (space, (unsigned int) sizeof (raw));
+	space -= space % bgmdec.framesize;
+	if (!space)
+		return false;
+
+	res = S_CodecReadStream (bgmstream, space, raw);
+	if (res > 0)
+	{
+		res -= res % bgmdec.framesize;
+		ofs = writepos & (bgmdec.size - 1);
+		part = q_min ((unsigned int) res, bgmdec.size - ofs);
+		memcpy (bgmdec.ring + ofs, raw, part);
+		memcpy (bgmdec.ring, raw + part, res - part);
+		SDL_AtomicSet (&bgmdec.write, (int) (writepos + res));
+		bgmdec.did_rewind = false;
+	}
+	else if (res == 0)	/* EOF */
+	{
+		if (!bgmstream->loop)
+			SDL_AtomicSet (&bgmdec.state, BGMDEC_EOF);
+		else if (bgmdec.did_rewind)
+			SDL_AtomicSet (&bgmdec.state, BGMDEC_REPEATED_EOF);
+		else if ((res = S_CodecRewindStream (bgmstream)) != 0)
+		{
+			bgmdec.error = res;
+			SDL_AtomicSet (&bgmdec.state, BGMDEC_SEEK_ERROR);
+		}
+		else
+			bgmdec.did_rewind = true;
+	}
+	else	/* res < 0: some read error */
+	{
+		bgmdec.error = res;
+		SDL_AtomicSet (&bgmdec.state, BGMDEC_READ_ERROR);
+	}
+
+	return true;
+}
+
+static int BGM_DecoderThread (void *unused)
+{
+	SDL_LockMutex (bgmdec.mutex);
+	while (!SDL_AtomicGet (&bgmdec.quit))
+	{
+		if (!BGM_DecodeChunk ())
+			SDL_CondWaitTimeout (bgmdec.cond, bgmdec.mutex, 50);
+	}
+	SDL_UnlockMutex (bgmdec.mutex);
+
+	return 0;
+}
+
+static void BGM_StartDecoder (void)
+{
+	unsigned int size;
+
+	bgmdec.framesize = bgmstream->info.width * bgmstream->info.channels;
+	size = (unsigned int) CLAMP (BGM_MIN_RING, bgm_prebuffer.value * bgmstream->info.rate * bgmdec.framesize, BGM_MAX_RING);
+	size = Q_nextPow2 (size);
+	if (!bgmdec.ring || bgmdec.size != size)
+	{
+		free (bgmdec.ring);
+		bgmdec.ring = (byte *) malloc (size);
+		if (!bgmdec.ring)
+			Sys_Error ("BGM_StartDecoder: out of memory on %u bytes", size);
+		bgmdec.size = size;
+	}
+
+	SDL_AtomicSet (&bgmdec.read, 0);
+	SDL_AtomicSet (&bgmdec.write, 0);
+	SDL_AtomicSet (&bgmdec.state, BGMDEC_RUNNING);
+	SDL_AtomicSet (&bgmdec.quit, 0);
+	bgmdec.did_rewind = false;
+	bgmdec.primed = false;
+	bgmdec.underruns = 0;
+
+	bgmdec.thread = SDL_CreateThread (BGM_DecoderThread, "Music decoder", NULL);
+	if (!bgmdec.thread)
+		Con_DWarning ("Couldn't create music decoder thread, decoding on the main thread\n");
+}
+
+static void BGM_StopDecoder (void)
+{
+	if (!bgmdec.thread)
+		return;
+
+	SDL_LockMutex (bgmdec.mutex);
+	SDL_AtomicSet (&bgmdec.quit, 1);
+	SDL_CondSignal (bgmdec.cond);
+	SDL_UnlockMutex (bgmdec.mutex);
+
+	SDL_WaitThread (bgmdec.thread, NULL);
+	bgmdec.thread = NULL;
+}
+
+static qboolean BGM_OpenStream (const char *path, unsigned int type)
+{
+	bgmstream = S_CodecOpenStreamType(path, type, bgmloop);
+	if (!bgmstream)
+		return false;
+	BGM_StartDecoder ();
+	return true;
+}
+
+/* consumer side: feeds the raw sample buffer from the ring */
 static void BGM_UpdateStream (void)
 {
-	qboolean did_rewind = false;
-	int	res;	/* Number of bytes read. */
 	int	bufferSamples;
 	int	fileSamples;
 	int	fileBytes;
-	byte	raw[16384];
+	byte	raw[BGM_CHUNK];
+	unsigned int	readpos, avail, ofs, part;
+	bgmdecstate_t	state;
+
+	/* no thread: decode here, like we used to */
+	if (!bgmdec.thread)
+	{
+		while (BGM_DecodeChunk ())
+			;
+	}
+
+	state = (bgmdecstate_t) SDL_AtomicGet (&bgmdec.state);
+	readpos = (unsigned int) SDL_AtomicGet (&bgmdec.read);
+	avail = (unsigned int) SDL_AtomicGet (&bgmdec.write) - readpos;
+
+	if (!avail && state != BGMDEC_RUNNING)
+	{
+		switch (state)
+		{
+		case BGMDEC_REPEATED_EOF:
+			Con_Printf("Stream keeps returning EOF.\n");
+			break;
+		case BGMDEC_SEEK_ERROR:
+			Con_Printf("Stream seek error (%i), stopping.\n", bgmdec.error);
+			break;
+		case BGMDEC_READ_ERROR:
+			Con_Printf("Stream read error (%i), stopping.\n", bgmdec.error);
+			break;
+		default:
+			break;
+		}
+		BGM_Stop();
+		return;
+	}
 
 	if (bgmstream->status != STREAM_PLAY)
 		return;
@@ -411,6 +631,14 @@ static void BGM_UpdateStream (void)
 	if (bgmvolume.value <= 0)
 		return;
 
+	/* wait until a quarter of the ring is filled before starting */
+	if (!bgmdec.primed)
+	{
+		if (avail < bgmdec.size / 4 && state == BGMDEC_RUNNING)
+			return;
+		bgmdec.primed = true;
+	}
+
 	/* see how many samples should be copied into the raw buffer */
 	if (s_rawend < paintedtime)
 		s_rawend = paintedtime;
@@ -419,76 +647,54 @@ static void BGM_UpdateStream (void)
 	{
 		bufferSamples = MAX_RAW_SAMPLES - (s_rawend - paintedtime);
 
-		/* ramp up volume after stream was paused */
-		if (bgmstream->volume < 1.f)
-		{
-			bgmstream->volume += bufferSamples / (bgmstream->info.rate * 1.f);
-			bgmstream->volume = q_min (1.f, bgmstream->volume);
-		}
-
-		/* decide how much data needs to be read from the file */
+		/* decide how much data needs to be read from the ring */
 		fileSamples = bufferSamples * bgmstream->info.rate / shm->speed;
 		if (!fileSamples)
-			return;
+			break;
 
 		/* our max buffer size */
-		fileBytes = fileSamples * (bgmstream->info.width * bgmstream->info.channels);
+		fileBytes = fileSamples * bgmdec.framesize;
 		if (fileBytes > (int) sizeof(raw))
 		{
 			fileBytes = (int) sizeof(raw);
-			fileSamples = fileBytes /
-					  (bgmstream->info.width * bgmstream->info.channels);
-		}
-
-		/* Read */
-		res = S_CodecReadStream(bgmstream, fileBytes, raw);
-		if (res < fileBytes)
-		{
-			fileBytes = res;
-			fileSamples = res / (bgmstream->info.width * bgmstream->info.channels);
+			fileSamples = fileBytes / bgmdec.framesize;
 		}
 
-		if (res > 0)	/* data: add to raw buffer */
-		{
-			S_RawSamples(fileSamples, bgmstream->info.rate,
-							bgmstream->info.width,
-							bgmstream->info.channels,
-							raw, bgmvolume.value * bgmstream->volume);
-			did_rewind = false;
-		}
-		else if (res == 0)	/* EOF */
+		if ((unsigned int) fileBytes > avail)
 		{
-			if (bgmloop)
+			fileSamples = avail / bgmdec.framesize;
+			fileBytes = fileSamples * bgmdec.framesize;
+			if (!fileBytes)
 			{
-				if (did_rewind)
-				{
-					Con_Printf("Stream keeps returning EOF.\n");
-					BGM_Stop();
-					return;
-				}
-
-				res = S_CodecRewindStream(bgmstream);
-				if (res != 0)
-				{
-					Con_Printf("Stream seek error (%i), stopping.\n", res);
-					BGM_Stop();
-					return;
-				}
-				did_rewind = true;
-			}
-			else
-			{
-				BGM_Stop();
-				return;
+				if (state == BGMDEC_RUNNING)
+					bgmdec.underruns++;
+				break;
 			}
 		}
-		else	/* res < 0: some read error */
+
+		/* ramp up volume after stream was paused */
+		if (bgmstream->volume < 1.f)
 		{
-			Con_Printf("Stream read error (%i), stopping.\n", res);
-			BGM_Stop();
-			return;
+			bgmstream->volume += bufferSamples / (bgmstream->info.rate * 1.f);
+			bgmstream->volume = q_min (1.f, bgmstream->volume);
 		}
+
+		ofs = readpos & (bgmdec.size - 1);
+		part = q_min ((unsigned int) fileBytes, bgmdec.size - ofs);
+		memcpy (raw, bgmdec.ring + ofs, part);
+		memcpy (raw + part, bgmdec.ring, fileBytes - part);
+		readpos += fileBytes;
+		avail -= fileBytes;
+
+		S_RawSamples(fileSamples, bgmstream->info.rate,
+						bgmstream->info.width,
+						bgmstream->info.channels,
+						raw, bgmvolume.value * bgmstream->volume);
 	}
+
+	SDL_AtomicSet (&bgmdec.read, (int) readpos);
+	if (bgmdec.thread)
+		SDL_CondSignal (bgmdec.cond);
 }
 
 void BGM_Update (void)
@@ -27,6 +27,7 @@
 
 extern qboolean	bgmloop;
 extern cvar_t	bgm_extmusic;
+extern cvar_t	bgm_prebuffer;
 
 qboolean BGM_Init (void);
 void BGM_Shutdown (void);
@@ -80,6 +80,471 @@ static struct
 	}				prev;
 }					demo_rewind;
 
+/*
+==============================================================================
+
+DEMO WRITER
+
+Recording goes through a ring buffer that a background thread drains to
+disk, so the frame loop never waits on fwrite/fflush. The file is flushed
+whenever the thread catches up, and at least every DEMO_SYNC_MSEC
+(together with any partial compressed block), so a crash only loses the
+last moments of the recording.
+
+With cl_democompress 1 the demo is stored in a compressed container:
+
+	"IWDZ" [long] version [long] block size
+	then until the end of the file:
+	[long] uncompressed size [long] compressed size [bytes] deflate data
+
+Each block is deflated on its own, so a reader can get to any block by
+walking the headers without inflating the ones before it. The inflated
+blocks concatenated form a regular demo.
+==============================================================================
+*/
+
+#define DEMO_RING_SIZE			(1 << 20)
+#define DEMOZ_MAGIC				"IWDZ"
+#define DEMOZ_VERSION			1
+#define DEMOZ_BLOCK_SIZE		(64 * 1024)
+#define DEMOZ_HEADER_SIZE		12
+#define DEMOZ_MAX_SIZE			(1 << 30)	// sanity limit on the inflated size
+#define DEMO_SYNC_MSEC			1000		// longest time recorded data may stay in memory
+
+static struct
+{
+	FILE			*file;
+	qboolean		compress;
+	SDL_Thread		*thread;
+	SDL_mutex		*mutex;
+	SDL_cond		*cond;
+	byte			*ring;
+	size_t			head;		// total bytes queued by the main thread
+	size_t			tail;		// total bytes taken by the writer thread
+	qboolean		quit;
+	byte			*block;		// compressed demos: data waiting for a full block
+	size_t			blocksize;
+	Uint32			lastsync;	// SDL_GetTicks of the last DemoWriter_Sync
+}					demo_writer;
+
+static void DemoWriter_PutLong (byte *p, int l)
+{
+	p[0] = l & 255;
+	p[1] = (l >> 8) & 255;
+	p[2] = (l >> 16) & 255;
+	p[3] = (l >> 24) & 255;
+}
+
+static int DemoWriter_GetLong (const byte *p)
+{
+	return (int) ((uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+}
+
+/*
+==============
+DemoWriter_FlushBlock
+
+Deflates and writes out the pending block of a compressed demo
+==============
+*/
+static void DemoWriter_FlushBlock (void)
+{
+	byte	header[8];
+	byte	*data;
+	size_t	size;
+
+	if (!demo_writer.blocksize)
+		return;
+
+	data = COM_Deflate (demo_writer.block, demo_writer.blocksize, &size);
+	DemoWriter_PutLong (header, (int) demo_writer.blocksize);
+	DemoWriter_PutLong (header + 4, (int) size);
+	fwrite (header, 1, sizeof (header), demo_writer.file);
+	fwrite (data, 1, size, demo_writer.file);
+	free (data);
+
+	demo_writer.blocksize = 0;
+}
+
+/*
+==============
+DemoWriter_Output
+
+Called on the writer thread (or the main thread if it couldn't be started)
+==============
+*/
+static void DemoWriter_Output (const byte *data, size_t size)
+{
+	size_t	n;
+
+	if (!demo_writer.compress)
+	{
+		fwrite (data, 1, size, demo_writer.file);
+		return;
+	}
+
+	while (size)
+	{
+		n = q_min (size, DEMOZ_BLOCK_SIZE - demo_writer.blocksize);
+		memcpy (demo_writer.block + demo_writer.blocksize, data, n);
+		demo_writer.blocksize += n;
+		data += n;
+		size -= n;
+		if (demo_writer.blocksize == DEMOZ_BLOCK_SIZE)
+			DemoWriter_FlushBlock ();
+	}
+}
+
+/*
+==============
+DemoWriter_Sync
+
+Pushes everything recorded so far to the disk, including a partial block
+of a compressed demo, so that a crash loses at most DEMO_SYNC_MSEC of it
+==============
+*/
+static void DemoWriter_Sync (void)
+{
+	if (demo_writer.compress)
+		DemoWriter_FlushBlock ();
+	fflush (demo_writer.file);
+	demo_writer.lastsync = SDL_GetTicks ();
+}
+
+/*
+==============
+DemoWriter_SyncDue
+==============
+*/
+static qboolean DemoWriter_SyncDue (void)
+{
+	return SDL_GetTicks () - demo_writer.lastsync >= DEMO_SYNC_MSEC;
+}
+
+static int DemoWriter_Thread (void *unused)
+{
+	size_t		ofs, n;
+	qboolean	dirty = false;
+
+	SDL_LockMutex (demo_writer.mutex);
+	while (1)
+	{
+		while (demo_writer.head == demo_writer.tail && !demo_writer.quit)
+		{
+			if (dirty)
+			{	// caught up, push what we have to the disk without holding up the main thread
+				SDL_UnlockMutex (demo_writer.mutex);
+				fflush (demo_writer.file);
+				SDL_LockMutex (demo_writer.mutex);
+				dirty = false;
+				continue;
+			}
+			if (demo_writer.blocksize)
+			{	// don't keep a partial compressed block in memory for too long
+				Uint32 elapsed = SDL_GetTicks () - demo_writer.lastsync;
+				if (elapsed >= DEMO_SYNC_MSEC)
+				{
+					SDL_UnlockMutex (demo_writer.mutex);
+					DemoWriter_Sync ();
+					SDL_LockMutex (demo_writer.mutex);
+				}
+				else
+					SDL_CondWaitTimeout (demo_writer.cond, demo_writer.mutex, DEMO_SYNC_MSEC - elapsed);
+				continue;
+			}
+			SDL_CondWait (demo_writer.cond, demo_writer.mutex);
+		}
+		if (demo_writer.head == demo_writer.tail)
+			break;
+
+		ofs = demo_writer.tail % DEMO_RING_SIZE;
+		n = q_min (demo_writer.head - demo_writer.tail, DEMO_RING_SIZE - ofs);
+		SDL_UnlockMutex (demo_writer.mutex);
+
+		// the main thread only writes to the free part of the ring, so this is safe without the lock
+		DemoWriter_Output (demo_writer.ring + ofs, n);
+		if (DemoWriter_SyncDue ())
+			DemoWriter_Sync ();	// even if the disk never catches up
+		dirty = true;
+
+		SDL_LockMutex (demo_writer.mutex);
+		demo_writer.tail += n;
+		SDL_CondBroadcast (demo_writer.cond);
+	}
+	SDL_UnlockMutex (demo_writer.mutex);
+
+	return 0;
+}
+
+/*
+==============
+DemoWriter_Open
+==============
+*/
+static void DemoWriter_Open (FILE *f, qboolean compress)
+{
+	byte header[DEMOZ_HEADER_SIZE];
+
+	memset (&demo_writer, 0, sizeof (demo_writer));
+	demo_writer.file = f;
+	demo_writer.compress = compress;
+	demo_writer.lastsync = SDL_GetTicks ();
+
+	if (compress)
+	{
+		memcpy (header, DEMOZ_MAGIC, 4);
+		DemoWriter_PutLong (header + 4, DEMOZ_VERSION);
+		DemoWriter_PutLong (header + 8, DEMOZ_BLOCK_SIZE);
+		fwrite (header, 1, sizeof (header), f);
+		demo_writer.block = (byte *) malloc (DEMOZ_BLOCK_SIZE);
+	}
+
+	demo_writer.ring = (byte *) malloc (DEMO_RING_SIZE);
+	demo_writer.mutex = SDL_CreateMutex ();
+	demo_writer.cond = SDL_CreateCond ();
+	if ((compress && !demo_writer.block) || !demo_writer.ring)
+		Sys_Error ("DemoWriter_Open: out of memory");
+
+	if (demo_writer.mutex && demo_writer.cond)
+		demo_writer.thread = SDL_CreateThread (DemoWriter_Thread, "Demo writer", NULL);
+	if (!demo_writer.thread)
+		Con_DWarning ("Couldn't start demo writer thread, recording synchronously\n");
+}
+
+/*
+==============
+DemoWriter_Write
+==============
+*/
+static void DemoWriter_Write (const void *data, size_t size)
+{
+	const byte	*src = (const byte *) data;
+	size_t		ofs, n;
+
+	if (!demo_writer.thread)
+	{
+		DemoWriter_Output (src, size);
+		if (DemoWriter_SyncDue ())
+			DemoWriter_Sync ();
+		return;
+	}
+
+	SDL_LockMutex (demo_writer.mutex);
+	while (size)
+	{
+		// only blocks if the disk can't keep up with a full megabyte of backlog
+		while (demo_writer.head - demo_writer.tail == DEMO_RING_SIZE)
+			SDL_CondWait (demo_writer.cond, demo_writer.mutex);
+
+		ofs = demo_writer.head % DEMO_RING_SIZE;
+		n = q_min (size, DEMO_RING_SIZE - (demo_writer.head - demo_writer.tail));
+		n = q_min (n, DEMO_RING_SIZE - ofs);
+		memcpy (demo_writer.ring + ofs, src, n);
+		demo_writer.head += n;
+		src += n;
+		size -= n;
+	}
+	SDL_CondBroadcast (demo_writer.cond);
+	SDL_UnlockMutex (demo_writer.mutex);
+}
+
+/*
+==============
+DemoWriter_Close
+
+Waits until everything queued is on disk, then closes the file
+==============
+*/
+static void DemoWriter_Close (void)
+{
+	if (demo_writer.thread)
+	{
+		SDL_LockMutex (demo_writer.mutex);
+		demo_writer.quit = true;
+		SDL_CondBroadcast (demo_writer.cond);
+		SDL_UnlockMutex (demo_writer.mutex);
+		SDL_WaitThread (demo_writer.thread, NULL);
+	}
+
+	if (demo_writer.compress)
+		DemoWriter_FlushBlock ();
+	fclose (demo_writer.file);
+
+	if (demo_writer.cond)
+		SDL_DestroyCond (demo_writer.cond);
+	if (demo_writer.mutex)
+		SDL_DestroyMutex (demo_writer.mutex);
+	free (demo_writer.ring);
+	free (demo_writer.block);
+	memset (&demo_writer, 0, sizeof (demo_writer));
+}
+
+/*
+==============
+CL_IsCompressedDemo
+==============
+*/
+qboolean CL_IsCompressedDemo (const void *data, size_t size)
+{
+	return size >= DEMOZ_HEADER_SIZE && !memcmp (data, DEMOZ_MAGIC, 4);
+}
+
+/*
+==============
+CL_InflateDemo
+
+Returns the regular demo stored in a compressed container
+(allocated with malloc), or NULL if the data is corrupt.
+Doesn't touch any global state, so it's safe to call from any thread.
+==============
+*/
+byte *CL_InflateDemo (const void *data, size_t size, size_t *outsize)
+{
+	const byte	*in = (const byte *) data;
+	size_t		ofs, total;
+	int			rawsize, compsize;
+	byte		*out;
+
+	if (!CL_IsCompressedDemo (data, size) || DemoWriter_GetLong (in + 4) != DEMOZ_VERSION)
+		return NULL;
+
+	// walk the block headers to get the total size
+	total = 0;
+	for (ofs = DEMOZ_HEADER_SIZE; ofs < size; ofs += 8 + compsize)
+	{
+		if (size - ofs < 8)
+			return NULL;
+		rawsize = DemoWriter_GetLong (in + ofs);
+		compsize = DemoWriter_GetLong (in + ofs + 4);
+		if (rawsize <= 0 || compsize <= 0 || (size_t) compsize > size - ofs - 8)
+			return NULL;
+		total += rawsize;
+		if (total > DEMOZ_MAX_SIZE)
+			return NULL;
+	}
+
+	out = (byte *) malloc (q_max (total, (size_t) 1));
+	if (!out)
+		return NULL;
+
+	total = 0;
+	for (ofs = DEMOZ_HEADER_SIZE; ofs < size; ofs += 8 + compsize)
+	{
+		rawsize = DemoWriter_GetLong (in + ofs);
+		compsize = DemoWriter_GetLong (in + ofs + 4);
+		if (!COM_Inflate (in + ofs + 8, compsize, out + total, rawsize))
+		{
+			free (out);
+			return NULL;
+		}
+		total += rawsize;
+	}
+
+	*outsize = total;
+	return out;
+}
+
+/*
+==============
+CL_DemoRead
+
+Reads from the demo being played back, either the file or the inflated data
+==============
+*/
+static qboolean CL_DemoRead (void *buf, size_t size)
+{
+	if (!cls.demodata)
+		return fread (buf, size, 1, cls.demofile) == 1;
+
+	if ((size_t) (cls.demodatasize - cls.demodatapos) < size)
+	{
+		cls.demodatapos = cls.demodatasize;
+		return false;
+	}
+	memcpy (buf, cls.demodata + cls.demodatapos, size);
+	cls.demodatapos += size;
+
+	return true;
+}
+
+/*
+==============
+CL_DemoTell
+==============
+*/
+qfileofs_t CL_DemoTell (void)
+{
+	return cls.demodata ? cls.demodatapos : Sys_ftell (cls.demofile);
+}
+
+/*
+==============
+CL_DemoSeek
+==============
+*/
+static void CL_DemoSeek (qfileofs_t ofs)
+{
+	if (cls.demodata)
+		cls.demodatapos = CLAMP (0, ofs, cls.demodatasize);
+	else
+		Sys_fseek (cls.demofile, ofs, SEEK_SET);
+}
+
+/*
+==============
+CL_DemoReadTrack
+
+Parses the "%i\n" cd track header
+==============
+*/
+static qboolean CL_DemoReadTrack (int *track)
+{
+	qboolean	negative = false;
+	int			digits = 0;
+	char		c;
+
+	*track = 0;
+	do
+	{
+		if (!CL_DemoRead (&c, 1))
+			return false;
+	} while (c == ' ' || c == '\t' || c == '\r');
+
+	if (c == '-' || c == '+')
+	{
+		negative = (c == '-');
+		if (!CL_DemoRead (&c, 1))
+			return false;
+	}
+	while (c >= '0' && c <= '9')
+	{
+		*track = *track * 10 + (c - '0');
+		digits++;
+		if (!CL_DemoRead (&c, 1))
+			return false;
+	}
+	if (negative)
+		*track = -*track;
+
+	return digits && c == '\n';
+}
+
+/*
+==============
+CL_CloseDemoPlayback
+==============
+*/
+static void CL_CloseDemoPlayback (void)
+{
+	if (cls.demofile)
+		fclose (cls.demofile);
+	cls.demofile = NULL;
+	free (cls.demodata);
+	cls.demodata = NULL;
+	cls.demodatasize = 0;
+	cls.demodatapos = 0;
+}
+
 /*
 ==============
 CL_ClearSignons
@@ -104,11 +569,10 @@ void CL_StopPlayback (void)
 	if (!cls.demoplayback)
 		return;
 
-	fclose (cls.demofile);
+	CL_CloseDemoPlayback ();
 	cls.demoplayback = false;
 	cls.demopaused = false;
 	cls.demospeed = 1.f;
-	cls.demofile = NULL;
 	cls.demofilesize = 0;
 	cls.demofilestart = 0;
 	cls.demofilename[0] = '\0';
@@ -132,19 +596,18 @@ Dumps the current net message, prefixed by the length and view angles
 */
 static void CL_WriteDemoMessage (void)
 {
-	int	len;
 	int	i;
 	float	f;
+	byte	header[16];
 
-	len = LittleLong (net_message.cursize);
-	fwrite (&len, 4, 1, cls.demofile);
+	DemoWriter_PutLong (header, net_message.cursize);
 	for (i = 0; i < 3; i++)
 	{
 		f = LittleFloat (cl.viewangles[i]);
-		fwrite (&f, 4, 1, cls.demofile);
+		memcpy (header + 4 + i * 4, &f, 4);
 	}
-	fwrite (net_message.data, net_message.cursize, 1, cls.demofile);
-	fflush (cls.demofile);
+	DemoWriter_Write (header, sizeof (header));
+	DemoWriter_Write (net_message.data, net_message.cursize);
 }
 
 /*
@@ -257,7 +720,7 @@ static qboolean CL_NextDemoFrame (void)
 			demoframe_t newframe;
 
 			memset (&newframe, 0, sizeof (newframe));
-			newframe.fileofs = Sys_ftell (cls.demofile);
+			newframe.fileofs = CL_DemoTell ();
 			newframe.intermission = cl.intermission;
 			newframe.forceunderwater = cl.forceunderwater;
 			VEC_PUSH (demo_rewind.frames, newframe);
@@ -276,7 +739,7 @@ static qboolean CL_NextDemoFrame (void)
 		return false;
 
 	lastframe = &demo_rewind.frames[framecount - 1];
-	Sys_fseek (cls.demofile, lastframe->fileofs, SEEK_SET);
+	CL_DemoSeek (lastframe->fileofs);
 
 	if (framecount == 1)
 		demo_rewind.backstop = true;
@@ -448,12 +911,12 @@ static int CL_GetDemoMessage (void)
 	if (!CL_NextDemoFrame ())
 		return 0;
 
-	if (fread (&net_message.cursize, 4, 1, cls.demofile) != 1)
+	if (!CL_DemoRead (&net_message.cursize, 4))
 		goto readerror;
 	VectorCopy (cl.mviewangles[0], cl.mviewangles[1]);
 	for (i = 0 ; i < 3 ; i++)
 	{
-		if (fread (&f, 4, 1, cls.demofile) != 1)
+		if (!CL_DemoRead (&f, 4))
 			goto readerror;
 		cl.mviewangles[0][i] = LittleFloat (f);
 	}
@@ -461,7 +924,7 @@ static int CL_GetDemoMessage (void)
 	net_message.cursize = LittleLong (net_message.cursize);
 	if (net_message.cursize > MAX_MSGLEN)
 		Sys_Error ("Demo message > MAX_MSGLEN");
-	if (fread (net_message.data, net_message.cursize, 1, cls.demofile) != 1)
+	if (!CL_DemoRead (net_message.data, net_message.cursize))
 	{
 	readerror:
 		CL_StopPlayback ();
@@ -532,13 +995,28 @@ void CL_Stop_f (void)
 		return;
 	}
 
+	CL_StopRecording ();
+}
+
+/*
+====================
+CL_StopRecording
+
+Finishes the demo being recorded, waiting for all of it to reach the disk
+====================
+*/
+void CL_StopRecording (void)
+{
+	if (!cls.demorecording)
+		return;
+
 // write a disconnect message to the demo file
 	SZ_Clear (&net_message);
 	MSG_WriteByte (&net_message, svc_disconnect);
 	CL_WriteDemoMessage ();
 
 // finish up
-	fclose (cls.demofile);
+	DemoWriter_Close ();
 	cls.demofile = NULL;
 	cls.demorecording = false;
 	Con_Printf ("Completed demo\n");
@@ -559,6 +1037,7 @@ void CL_Record_f (void)
 	int		c;
 	char	relname[MAX_OSPATH];
 	char	name[MAX_OSPATH];
+	char	header[16];
 	int		track;
 
 	if (cmd_source != src_command)
@@ -637,7 +1116,9 @@ void CL_Record_f (void)
 	}
 
 	cls.forcetrack = track;
-	fprintf (cls.demofile, "%i\n", cls.forcetrack);
+	DemoWriter_Open (cls.demofile, cl_democompress.value != 0.f);
+	q_snprintf (header, sizeof (header), "%i\n", cls.forcetrack);
+	DemoWriter_Write (header, strlen (header));
 	q_strlcpy (cls.demofilename, name, sizeof (cls.demofilename));
 
 	cls.demorecording = true;
@@ -760,6 +1241,8 @@ play [demoname]
 void CL_PlayDemo_f (void)
 {
 	char	name[MAX_OSPATH];
+	byte	magic[DEMOZ_HEADER_SIZE];
+	qfileofs_t	start, filesize;
 
 	if (cmd_source != src_command)
 		return;
@@ -786,15 +1269,39 @@ void CL_PlayDemo_f (void)
 		cls.demonum = -1;	// stop demo loop
 		return;
 	}
+	filesize = com_filesize;
 
-// ZOID, fscanf is evil
-// O.S.: if a space character e.g. 0x20 (' ') follows '\n',
-// fscanf skips that byte too and screws up further reads.
-//	fscanf (cls.demofile, "%i\n", &cls.forcetrack);
-	if (fscanf (cls.demofile, "%i", &cls.forcetrack) != 1 || fgetc (cls.demofile) != '\n')
+// compressed demos are inflated to memory and played back from there
+	start = Sys_ftell (cls.demofile);
+	if (fread (magic, 1, sizeof (magic), cls.demofile) == sizeof (magic) && CL_IsCompressedDemo (magic, sizeof (magic)))
 	{
+		byte	*data;
+		size_t	rawsize = 0;
+
+		data = (byte *) malloc (filesize);
+		Sys_fseek (cls.demofile, start, SEEK_SET);
+		if (data && fread (data, 1, filesize, cls.demofile) == (size_t) filesize)
+			cls.demodata = CL_InflateDemo (data, filesize, &rawsize);
+		free (data);
 		fclose (cls.demofile);
 		cls.demofile = NULL;
+
+		if (!cls.demodata)
+		{
+			Con_Printf ("ERROR: couldn't decompress %s\n", name);
+			cls.demonum = -1;	// stop demo loop
+			return;
+		}
+		cls.demodatasize = rawsize;
+		cls.demodatapos = 0;
+		filesize = rawsize;
+	}
+	else
+		Sys_fseek (cls.demofile, start, SEEK_SET);
+
+	if (!CL_DemoReadTrack (&cls.forcetrack))
+	{
+		CL_CloseDemoPlayback ();
 		cls.demonum = -1;	// stop demo loop
 		Con_Printf ("ERROR: demo \"%s\" is invalid\n", name);
 		return;
@@ -810,8 +1317,8 @@ void CL_PlayDemo_f (void)
 	q_strlcpy (cls.demofilename, name, sizeof (cls.demofilename));
 	cls.state = ca_connected;
 	cls.demoloop = Cmd_Argc () >= 3 ? Q_atoi (Cmd_Argv (2)) != 0 : false;
-	cls.demofilestart = Sys_ftell (cls.demofile);
-	cls.demofilesize = com_filesize;
+	cls.demofilestart = CL_DemoTell ();
+	cls.demofilesize = filesize;
 
 // if this is a player-initiated demo, get rid of the console
 	if (cls.demonum == -1 && key_dest == key_console)
@@ -858,7 +1365,7 @@ void CL_TimeDemo_f (void)
 	}
 
 	CL_PlayDemo_f ();
-	if (!cls.demofile)
+	if (!cls.demoplayback)
 		return;
 
 // cls.td_starttime will be grabbed at the second frame of the demo, so
@@ -0,0 +1,1046 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// cl_demoparse.c -- batch demo analysis without rendering
+
+#include "quakedef.h"
+
+/*
+==============================================================================
+
+DEMO ANALYSIS
+
+Walks the server messages of a demo with a msgreader_t over the demo
+frame and a minimal client state (no cl, cl_entities or net_message), so
+any number of demos can be processed at the same time on worker threads.
+Entity updates go through the same decoder as CL_ParseUpdate
+(CL_EntityUpdateSize/CL_DecodeEntityUpdate). Nothing is rendered, played
+or precached: only the messages needed for stats (level changes, kills,
+secrets, deaths, intermission times, player position) are interpreted,
+the rest are skipped.
+
+The results are written as JSON to <gamedir>/<demoname>.json.
+==============================================================================
+*/
+
+#define DP_MAX_DEPTH		2		// signon blobs can't nest
+#define DP_BATCH_PER_THREAD	4		// demos loaded in memory at once, per worker
+
+typedef struct
+{
+	char			map[MAX_QPATH];
+	char			name[128];
+	float			start;			// -1 until the first svc_time
+	float			end;			// -1 if the level wasn't completed
+	int				deaths;
+	int				kills, totalkills;
+	int				secrets, totalsecrets;
+} dplevel_t;
+
+typedef struct
+{
+	// input
+	const char		*name;
+	byte			*file;
+	int				filesize;
+	qboolean		frames;			// emit a record per demo frame
+
+	// minimal client state
+	unsigned int	protocol;
+	unsigned int	protocolflags;
+	int				viewentity;
+	int				signon;
+	float			time;
+	vec3_t			viewangles;
+	vec3_t			playerorigin;
+	vec3_t			*baselines;		// baseline origins, MAX_EDICTS
+	int				stats[MAX_CL_STATS];
+	byte			*blob;			// svc_signonblob fragments
+	int				depth;
+
+	dplevel_t		*levels;
+	int				numframes;
+	int				nummessages;
+	char			error[128];
+
+	// output
+	char			*events;		// dynamic vector of json text
+	char			*framesjson;	// dynamic vector of json text
+	char			*json;			// dynamic vector, the final document
+} demoanalysis_t;
+
+//============================================================================
+
+// the reads below go through msgreader_t sections like CL_ParseUpdate does,
+// a section that runs past the end of the message stops the analysis
+
+static qboolean DP_Section (demoanalysis_t *dp, msgreader_t *msg, msgreader_t *section, int size)
+{
+	if (MSGR_BeginSection (msg, section, size))
+		return true;
+	q_strlcpy (dp->error, "bad server message", sizeof (dp->error));
+	return false;
+}
+
+static qboolean DP_Skip (demoanalysis_t *dp, msgreader_t *msg, int size)
+{
+	msgreader_t section;
+	return DP_Section (dp, msg, &section, size);
+}
+
+static qboolean DP_ReadByte (demoanalysis_t *dp, msgreader_t *msg, int *c)
+{
+	msgreader_t section;
+
+	if (!DP_Section (dp, msg, &section, 1))
+		return false;
+	*c = MSGR_ReadByte (&section);
+	return true;
+}
+
+static qboolean DP_ReadString (demoanalysis_t *dp, msgreader_t *msg, char *buf, size_t size)
+{
+	if (MSGR_ReadString (msg, buf, size))
+		return true;
+	q_strlcpy (dp->error, "bad server message", sizeof (dp->error));
+	return false;
+}
+
+//============================================================================
+
+static void DP_Append (char **buf, const char *fmt, ...) FUNC_PRINTF(2,3);
+static void DP_Append (char **buf, const char *fmt, ...)
+{
+	char	text[1024];
+	int		len;
+	va_list	argptr;
+
+	va_start (argptr, fmt);
+	len = q_vsnprintf (text, sizeof (text), fmt, argptr);
+	va_end (argptr);
+
+	if (len > 0)
+		Vec_Append ((void **) buf, 1, text, q_min (len, (int) sizeof (text) - 1));
+}
+
+static void DP_AppendString (char **buf, const char *str)
+{
+	char	c;
+
+	Vec_Append ((void **) buf, 1, "\"", 1);
+	for (; *str; str++)
+	{
+		c = *str & 0x7f;	// drop the quake "red text" bit
+		if (c == '"' || c == '\\')
+			DP_Append (buf, "\\%c", c);
+		else if (c == '\n')
+			DP_Append (buf, "\\n");
+		else if ((unsigned char) c < 0x20 || c == 0x7f)
+			DP_Append (buf, "\\u%04x", c);
+		else
+			Vec_Append ((void **) buf, 1, &c, 1);
+	}
+	Vec_Append ((void **) buf, 1, "\"", 1);
+}
+
+// json has no representation for nan/inf
+static double DP_Number (double f)
+{
+	return isfinite (f) ? f : 0.0;
+}
+
+static void DP_BeginEvent (demoanalysis_t *dp, const char *type)
+{
+	DP_Append (&dp->events, "%s\n\t\t{\"time\": %.3f, \"type\": \"%s\"", VEC_SIZE (dp->events) ? "," : "", DP_Number (dp->time), type);
+}
+
+static void DP_EndEvent (demoanalysis_t *dp)
+{
+	DP_Append (&dp->events, "}");
+}
+
+static dplevel_t *DP_CurrentLevel (demoanalysis_t *dp)
+{
+	return VEC_SIZE (dp->levels) ? &dp->levels[VEC_SIZE (dp->levels) - 1] : NULL;
+}
+
+//============================================================================
+
+/*
+==================
+DP_ParseServerInfo
+==================
+*/
+static qboolean DP_ParseServerInfo (demoanalysis_t *dp, msgreader_t *msg)
+{
+	char		str[MAX_QPATH];
+	dplevel_t	level;
+	msgreader_t	s;
+	int			i;
+
+	if (!DP_Section (dp, msg, &s, 4))
+		return false;
+	dp->protocol = MSGR_ReadLong (&s);
+	if (dp->protocol != PROTOCOL_NETQUAKE && dp->protocol != PROTOCOL_FITZQUAKE && dp->protocol != PROTOCOL_RMQ)
+	{
+		q_snprintf (dp->error, sizeof (dp->error), "unsupported protocol %u", dp->protocol);
+		return false;
+	}
+
+	// protocol flags, maxclients, gametype
+	if (!DP_Section (dp, msg, &s, (dp->protocol == PROTOCOL_RMQ) ? 6 : 2))
+		return false;
+	dp->protocolflags = (dp->protocol == PROTOCOL_RMQ) ? (unsigned int) MSGR_ReadLong (&s) : 0;
+
+	memset (&level, 0, sizeof (level));
+	level.start = level.end = -1.f;
+
+	if (!DP_ReadString (dp, msg, level.name, sizeof (level.name)))
+		return false;
+
+	// the first model is the world
+	for (i = 0; ; i++)
+	{
+		if (!DP_ReadString (dp, msg, str, sizeof (str)))
+			return false;
+		if (!str[0])
+			break;
+		if (i == 0)
+			COM_StripExtension (COM_SkipPath (str), level.map, sizeof (level.map));
+	}
+	do
+	{
+		if (!DP_ReadString (dp, msg, str, sizeof (str)))
+			return false;
+	} while (str[0]);
+
+	VEC_PUSH (dp->levels, level);
+
+	memset (dp->stats, 0, sizeof (dp->stats));
+	memset (dp->baselines, 0, MAX_EDICTS * sizeof (vec3_t));
+	VectorCopy (vec3_origin, dp->playerorigin);
+	dp->viewentity = 0;
+	dp->signon = 0;
+
+	DP_BeginEvent (dp, "map");
+	DP_Append (&dp->events, ", \"map\": ");
+	DP_AppendString (&dp->events, level.map);
+	DP_Append (&dp->events, ", \"name\": ");
+	DP_AppendString (&dp->events, level.name);
+	DP_EndEvent (dp);
+
+	return true;
+}
+
+/*
+==================
+DP_ParseBaseline
+==================
+*/
+static qboolean DP_ParseBaseline (demoanalysis_t *dp, msgreader_t *msg, int version, vec3_t origin)
+{
+	msgreader_t	s;
+	int			i, bits, skip, anglesize;
+
+	bits = 0;
+	if (version == 2 && !DP_ReadByte (dp, msg, &bits))
+		return false;
+
+	skip = ((bits & B_LARGEMODEL) ? 2 : 1) + ((bits & B_LARGEFRAME) ? 2 : 1) + 2;	// model, frame, colormap, skin
+	anglesize = MSG_AngleSize (dp->protocolflags);
+	if (!DP_Section (dp, msg, &s, skip + 3 * (MSG_CoordSize (dp->protocolflags) + anglesize) +
+			((bits & B_ALPHA) != 0) + ((bits & B_SCALE) != 0)))
+		return false;
+
+	MSGR_Skip (&s, skip);
+	for (i = 0; i < 3; i++)
+	{
+		origin[i] = MSGR_ReadCoord (&s, dp->protocolflags);
+		MSGR_Skip (&s, anglesize);
+	}
+
+	return true;
+}
+
+/*
+==================
+DP_ParseUpdate
+
+Decodes the update with the same code as CL_ParseUpdate
+==================
+*/
+static qboolean DP_ParseUpdate (demoanalysis_t *dp, msgreader_t *msg, int bits)
+{
+	entity_state_t	base;
+	entupdate_t		u;
+	msgreader_t		s;
+	qboolean		nehahra;
+	int				num, c;
+
+	if (dp->signon == SIGNONS - 1)
+		dp->signon = SIGNONS;	// first update is the final signon stage
+
+	if (bits & U_MOREBITS)
+	{
+		if (!DP_ReadByte (dp, msg, &c))
+			return false;
+		bits |= c << 8;
+	}
+	if (dp->protocol == PROTOCOL_FITZQUAKE || dp->protocol == PROTOCOL_RMQ)
+	{
+		if (bits & U_EXTEND1)
+		{
+			if (!DP_ReadByte (dp, msg, &c))
+				return false;
+			bits |= c << 16;
+		}
+		if (bits & U_EXTEND2)
+		{
+			if (!DP_ReadByte (dp, msg, &c))
+				return false;
+			bits |= c << 24;
+		}
+	}
+
+	if (!DP_Section (dp, msg, &s, (bits & U_LONGENTITY) ? 2 : 1))
+		return false;
+	num = (bits & U_LONGENTITY) ? MSGR_ReadShort (&s) : MSGR_ReadByte (&s);
+	num = CLAMP (0, num, MAX_EDICTS - 1);
+
+	// the Nehahra fields follow the regular ones
+	nehahra = dp->protocol == PROTOCOL_NETQUAKE && (bits & U_TRANS);
+	if (!DP_Section (dp, msg, &s, CL_EntityUpdateSize (nehahra ? bits & ~U_TRANS : bits, dp->protocol, dp->protocolflags)))
+		return false;
+
+	memset (&base, 0, sizeof (base));
+	VectorCopy (dp->baselines[num], base.origin);
+	CL_DecodeEntityUpdate (&s, bits, dp->protocol, dp->protocolflags, &base, &u);
+
+	if (nehahra)
+	{
+		if (!DP_Section (dp, msg, &s, 8))
+			return false;
+		if (MSGR_ReadFloat (&s) == 2 && !DP_Skip (dp, msg, 4))	// fullbright
+			return false;
+	}
+
+	if (num == dp->viewentity)
+		VectorCopy (u.origin, dp->playerorigin);
+
+	return true;
+}
+
+/*
+==================
+DP_ParseClientdata
+==================
+*/
+static qboolean DP_ParseClientdata (demoanalysis_t *dp, msgreader_t *msg)
+{
+	msgreader_t	s;
+	int			i, c, bits, health, before, after;
+	dplevel_t	*level;
+
+	if (!DP_Section (dp, msg, &s, 2))
+		return false;
+	bits = (unsigned short) MSGR_ReadShort (&s);
+	if (bits & SU_EXTEND1)
+	{
+		if (!DP_ReadByte (dp, msg, &c))
+			return false;
+		bits |= c << 16;
+	}
+	if (bits & SU_EXTEND2)
+	{
+		if (!DP_ReadByte (dp, msg, &c))
+			return false;
+		bits |= c << 24;
+	}
+
+	// everything but the health is skipped
+	before = ((bits & SU_VIEWHEIGHT) != 0) + ((bits & SU_IDEALPITCH) != 0);
+	for (i = 0; i < 3; i++)
+		before += ((bits & (SU_PUNCH1 << i)) != 0) + ((bits & (SU_VELOCITY1 << i)) != 0);
+	before += 4;	// items
+	before += ((bits & SU_WEAPONFRAME) != 0) + ((bits & SU_ARMOR) != 0) + ((bits & SU_WEAPON) != 0);
+	after = 6;		// ammo, shells, nails, rockets, cells, active weapon
+	for (i = 16; i <= 22; i++)	// SU_WEAPON2..SU_CELLS2
+		after += (bits & (1 << i)) != 0;
+	after += ((bits & SU_WEAPONFRAME2) != 0) + ((bits & SU_WEAPONALPHA) != 0);
+
+	if (!DP_Section (dp, msg, &s, before + 2 + after))
+		return false;
+	MSGR_Skip (&s, before);
+	health = MSGR_ReadShort (&s);
+
+	if (health <= 0 && dp->stats[STAT_HEALTH] > 0 && dp->signon == SIGNONS)
+	{
+		level = DP_CurrentLevel (dp);
+		if (level)
+			level->deaths++;
+		DP_BeginEvent (dp, "death");
+		DP_Append (&dp->events, ", \"pos\": [%.1f, %.1f, %.1f]",
+			DP_Number (dp->playerorigin[0]), DP_Number (dp->playerorigin[1]), DP_Number (dp->playerorigin[2]));
+		DP_EndEvent (dp);
+	}
+	dp->stats[STAT_HEALTH] = health;
+
+	return true;
+}
+
+/*
+==================
+DP_ParseTempEntity
+==================
+*/
+static qboolean DP_ParseTempEntity (demoanalysis_t *dp, msgreader_t *msg)
+{
+	int type, coordsize;
+
+	if (!DP_ReadByte (dp, msg, &type))
+		return false;
+	coordsize = MSG_CoordSize (dp->protocolflags);
+
+	switch (type)
+	{
+	case TE_WIZSPIKE:
+	case TE_KNIGHTSPIKE:
+	case TE_SPIKE:
+	case TE_SUPERSPIKE:
+	case TE_GUNSHOT:
+	case TE_EXPLOSION:
+	case TE_TAREXPLOSION:
+	case TE_LAVASPLASH:
+	case TE_TELEPORT:
+		return DP_Skip (dp, msg, 3 * coordsize);
+	case TE_LIGHTNING1:
+	case TE_LIGHTNING2:
+	case TE_LIGHTNING3:
+	case TE_BEAM:
+		return DP_Skip (dp, msg, 2 + 6 * coordsize);
+	case TE_EXPLOSION2:
+		return DP_Skip (dp, msg, 3 * coordsize + 2);
+	default:
+		q_snprintf (dp->error, sizeof (dp->error), "bad temp entity type %d", type);
+		return false;
+	}
+}
+
+/*
+==================
+DP_Completed
+==================
+*/
+static void DP_Completed (demoanalysis_t *dp, const char *type)
+{
+	dplevel_t *level = DP_CurrentLevel (dp);
+
+	if (level && level->end < 0.f)
+	{
+		level->end = dp->time;
+		level->kills = dp->stats[STAT_MONSTERS];
+		level->totalkills = dp->stats[STAT_TOTALMONSTERS];
+		level->secrets = dp->stats[STAT_SECRETS];
+		level->totalsecrets = dp->stats[STAT_TOTALSECRETS];
+	}
+
+	DP_BeginEvent (dp, type);
+	DP_Append (&dp->events, ", \"kills\": %d, \"totalkills\": %d, \"secrets\": %d, \"totalsecrets\": %d",
+		dp->stats[STAT_MONSTERS], dp->stats[STAT_TOTALMONSTERS], dp->stats[STAT_SECRETS], dp->stats[STAT_TOTALSECRETS]);
+	DP_EndEvent (dp);
+}
+
+static qboolean DP_ParseMessage (demoanalysis_t *dp, msgreader_t *msg);
+
+/*
+==================
+DP_ParseSignonBlob
+==================
+*/
+static qboolean DP_ParseSignonBlob (demoanalysis_t *dp, msgreader_t *msg)
+{
+	int			srcsize, size, ofs, len;
+	byte		*data;
+	msgreader_t	s;
+	qboolean	ret;
+
+	if (!DP_Section (dp, msg, &s, 14))
+		return false;
+	srcsize = MSGR_ReadLong (&s);
+	size = MSGR_ReadLong (&s);
+	ofs = MSGR_ReadLong (&s);
+	len = MSGR_ReadShort (&s);
+
+	if (dp->depth >= DP_MAX_DEPTH || srcsize <= 0 || srcsize > NET_MAXMESSAGE * 256 ||
+		size <= 0 || len <= 0 || ofs < 0 || ofs + len > size || len > MSGR_Remaining (msg))
+	{
+		q_strlcpy (dp->error, "bad signon blob", sizeof (dp->error));
+		return false;
+	}
+	MSGR_BeginSection (msg, &s, len);
+
+	if (ofs == 0)
+		VEC_CLEAR (dp->blob);
+	if (ofs != (int) VEC_SIZE (dp->blob))
+	{
+		q_strlcpy (dp->error, "signon blob fragment out of order", sizeof (dp->error));
+		return false;
+	}
+	Vec_Append ((void **) &dp->blob, 1, s.data, len);
+	if ((int) VEC_SIZE (dp->blob) < size)
+		return true;
+
+	data = (byte *) malloc (srcsize);
+	if (!data || !COM_Inflate (dp->blob, size, data, srcsize))
+	{
+		free (data);
+		q_strlcpy (dp->error, "corrupt signon blob", sizeof (dp->error));
+		return false;
+	}
+	VEC_FREE (dp->blob);
+
+	MSGR_Init (&s, data, srcsize);
+
+	dp->depth++;
+	ret = DP_ParseMessage (dp, &s);
+	dp->depth--;
+
+	free (data);
+
+	return ret;
+}
+
+/*
+==================
+DP_ParseMessage
+
+Returns false when the demo can't be parsed any further
+==================
+*/
+static qboolean DP_ParseMessage (demoanalysis_t *dp, msgreader_t *msg)
+{
+	char		str[1024];
+	msgreader_t	s;
+	vec3_t		origin;
+	int			cmd, i, coordsize;
+	dplevel_t	*level;
+
+	dp->nummessages++;
+
+	while (MSGR_Remaining (msg) > 0)
+	{
+		cmd = MSGR_ReadByte (msg);
+
+		if (cmd & U_SIGNAL)
+		{
+			if (!DP_ParseUpdate (dp, msg, cmd & 127))
+				return false;
+			continue;
+		}
+
+		coordsize = MSG_CoordSize (dp->protocolflags);
+
+		switch (cmd)
+		{
+		default:
+			q_snprintf (dp->error, sizeof (dp->error), "illegible server message %d", cmd);
+			return false;
+
+		case svc_nop:
+		case svc_sellscreen:
+		case svc_bf:
+			break;
+
+		case svc_time:
+			if (!DP_Section (dp, msg, &s, 4))
+				return false;
+			dp->time = MSGR_ReadFloat (&s);
+			level = DP_CurrentLevel (dp);
+			if (level && level->start < 0.f)
+				level->start = dp->time;
+			break;
+
+		case svc_clientdata:
+			if (!DP_ParseClientdata (dp, msg))
+				return false;
+			break;
+
+		case svc_version:
+			if (!DP_Section (dp, msg, &s, 4))
+				return false;
+			dp->protocol = MSGR_ReadLong (&s);
+			break;
+
+		case svc_disconnect:
+			DP_BeginEvent (dp, "disconnect");
+			DP_EndEvent (dp);
+			return false;
+
+		case svc_print:
+		case svc_centerprint:
+			if (!DP_ReadString (dp, msg, str, sizeof (str)))
+				return false;
+			DP_BeginEvent (dp, cmd == svc_print ? "print" : "centerprint");
+			DP_Append (&dp->events, ", \"text\": ");
+			DP_AppendString (&dp->events, str);
+			DP_EndEvent (dp);
+			break;
+
+		case svc_stufftext:
+		case svc_skybox:
+		case svc_achievement:
+			if (!DP_ReadString (dp, msg, NULL, 0))
+				return false;
+			break;
+
+		case svc_damage:
+			if (!DP_Skip (dp, msg, 2 + 3 * coordsize))
+				return false;
+			break;
+
+		case svc_serverinfo:
+			if (!DP_ParseServerInfo (dp, msg))
+				return false;
+			break;
+
+		case svc_setangle:
+			if (!DP_Skip (dp, msg, 3 * MSG_AngleSize (dp->protocolflags)))
+				return false;
+			break;
+
+		case svc_setview:
+			if (!DP_Section (dp, msg, &s, 2))
+				return false;
+			dp->viewentity = MSGR_ReadShort (&s);
+			break;
+
+		case svc_lightstyle:
+			if (!DP_Skip (dp, msg, 1) || !DP_ReadString (dp, msg, NULL, 0))
+				return false;
+			break;
+
+		case svc_sound:
+			if (!DP_ReadByte (dp, msg, &i))
+				return false;
+			if (!DP_Skip (dp, msg, ((i & SND_VOLUME) != 0) + ((i & SND_ATTENUATION) != 0) +
+					((i & SND_LARGEENTITY) ? 3 : 2) + ((i & SND_LARGESOUND) ? 2 : 1) + 3 * coordsize))
+				return false;
+			break;
+
+		case svc_localsound:
+			if (!DP_ReadByte (dp, msg, &i) || !DP_Skip (dp, msg, (i & SND_LARGESOUND) ? 2 : 1))
+				return false;
+			break;
+
+		case svc_stopsound:
+			if (!DP_Skip (dp, msg, 2))
+				return false;
+			break;
+
+		case svc_updatename:
+			if (!DP_ReadByte (dp, msg, &i) || !DP_ReadString (dp, msg, str, sizeof (str)))
+				return false;
+			DP_BeginEvent (dp, "name");
+			DP_Append (&dp->events, ", \"player\": %d, \"name\": ", i);
+			DP_AppendString (&dp->events, str);
+			DP_EndEvent (dp);
+			break;
+
+		case svc_updatefrags:
+			if (!DP_Section (dp, msg, &s, 3))
+				return false;
+			i = MSGR_ReadByte (&s);
+			DP_BeginEvent (dp, "frags");
+			DP_Append (&dp->events, ", \"player\": %d, \"frags\": %d", i, MSGR_ReadShort (&s));
+			DP_EndEvent (dp);
+			break;
+
+		case svc_updatecolors:
+			if (!DP_Skip (dp, msg, 2))
+				return false;
+			break;
+
+		case svc_particle:
+			if (!DP_Skip (dp, msg, 3 * coordsize + 5))	// origin, dir, count, color
+				return false;
+			break;
+
+		case svc_spawnbaseline:
+		case svc_spawnbaseline2:
+			if (!DP_Section (dp, msg, &s, 2))
+				return false;
+			i = CLAMP (0, MSGR_ReadShort (&s), MAX_EDICTS - 1);
+			if (!DP_ParseBaseline (dp, msg, cmd == svc_spawnbaseline2 ? 2 : 1, dp->baselines[i]))
+				return false;
+			break;
+
+		case svc_spawnstatic:
+		case svc_spawnstatic2:
+			if (!DP_ParseBaseline (dp, msg, cmd == svc_spawnstatic2 ? 2 : 1, origin))
+				return false;
+			break;
+
+		case svc_spawnstaticsound:
+		case svc_spawnstaticsound2:
+			if (!DP_Skip (dp, msg, 3 * coordsize + ((cmd == svc_spawnstaticsound2) ? 4 : 3)))
+				return false;
+			break;
+
+		case svc_temp_entity:
+			if (!DP_ParseTempEntity (dp, msg))
+				return false;
+			break;
+
+		case svc_setpause:
+			if (!DP_Skip (dp, msg, 1))
+				return false;
+			break;
+
+		case svc_signonnum:
+			if (!DP_ReadByte (dp, msg, &dp->signon))
+				return false;
+			break;
+
+		case svc_killedmonster:
+			dp->stats[STAT_MONSTERS]++;
+			DP_BeginEvent (dp, "kill");
+			DP_Append (&dp->events, ", \"kills\": %d, \"pos\": [%.1f, %.1f, %.1f]", dp->stats[STAT_MONSTERS],
+				DP_Number (dp->playerorigin[0]), DP_Number (dp->playerorigin[1]), DP_Number (dp->playerorigin[2]));
+			DP_EndEvent (dp);
+			break;
+
+		case svc_foundsecret:
+			dp->stats[STAT_SECRETS]++;
+			DP_BeginEvent (dp, "secret");
+			DP_Append (&dp->events, ", \"secrets\": %d, \"pos\": [%.1f, %.1f, %.1f]", dp->stats[STAT_SECRETS],
+				DP_Number (dp->playerorigin[0]), DP_Number (dp->playerorigin[1]), DP_Number (dp->playerorigin[2]));
+			DP_EndEvent (dp);
+			break;
+
+		case svc_updatestat:
+			if (!DP_Section (dp, msg, &s, 5))
+				return false;
+			i = MSGR_ReadByte (&s);
+			if (i < MAX_CL_STATS)
+				dp->stats[i] = MSGR_ReadLong (&s);
+			break;
+
+		case svc_cdtrack:
+			if (!DP_Skip (dp, msg, 2))
+				return false;
+			break;
+
+		case svc_intermission:
+			DP_Completed (dp, "intermission");
+			break;
+
+		case svc_finale:
+		case svc_cutscene:
+			if (!DP_ReadString (dp, msg, NULL, 0))
+				return false;
+			DP_Completed (dp, cmd == svc_finale ? "finale" : "cutscene");
+			break;
+
+		case svc_fog:
+			if (!DP_Skip (dp, msg, 6))
+				return false;
+			break;
+
+		case svc_signonblob:
+			if (!DP_ParseSignonBlob (dp, msg))
+				return false;
+			break;
+		}
+	}
+
+	return true;
+}
+
+/*
+==================
+DP_AnalyzeDemo
+
+Runs on a worker thread, must not touch any global state
+==================
+*/
+static void DP_AnalyzeDemo (demoanalysis_t *dp)
+{
+	msgreader_t	msg;
+	dplevel_t	*level;
+	const byte	*p, *end;
+	float		angles[3];
+	int			i, len, cdtrack;
+	qboolean	negative;
+
+	cdtrack = 0;
+	negative = false;
+
+	dp->baselines = (vec3_t *) calloc (MAX_EDICTS, sizeof (vec3_t));
+	if (!dp->baselines)
+	{
+		q_strlcpy (dp->error, "out of memory", sizeof (dp->error));
+		goto done;
+	}
+
+	if (CL_IsCompressedDemo (dp->file, dp->filesize))
+	{
+		size_t	rawsize;
+		byte	*raw = CL_InflateDemo (dp->file, dp->filesize, &rawsize);
+
+		if (!raw || rawsize > INT_MAX)
+		{
+			free (raw);
+			q_strlcpy (dp->error, "corrupt compressed demo", sizeof (dp->error));
+			goto done;
+		}
+		free (dp->file);
+		dp->file = raw;
+		dp->filesize = (int) rawsize;
+	}
+
+	p = dp->file;
+	end = dp->file + dp->filesize;
+
+	// cd track header, "%i\n"
+	negative = (p < end && *p == '-');
+	if (negative)
+		p++;
+	while (p < end && *p >= '0' && *p <= '9')
+		cdtrack = cdtrack * 10 + (*p++ - '0');
+	if (p >= end || *p != '\n')
+	{
+		q_strlcpy (dp->error, "invalid demo header", sizeof (dp->error));
+		goto done;
+	}
+	p++;
+
+	while (end - p >= 16)
+	{
+		len = (int) ((uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+		for (i = 0; i < 3; i++)
+		{
+			memcpy (&angles[i], p + 4 + i * 4, 4);
+			dp->viewangles[i] = LittleFloat (angles[i]);
+		}
+		p += 16;
+
+		if (len < 0 || len > MAX_MSGLEN || len > end - p)
+		{
+			q_strlcpy (dp->error, "truncated demo frame", sizeof (dp->error));
+			break;
+		}
+
+		MSGR_Init (&msg, p, len);
+		p += len;
+
+		dp->numframes++;
+		if (!DP_ParseMessage (dp, &msg))
+			break;
+
+		if (dp->frames && dp->signon == SIGNONS)
+		{
+			DP_Append (&dp->framesjson, "%s\n\t\t{\"time\": %.3f, \"pos\": [%.1f, %.1f, %.1f], \"angles\": [%.1f, %.1f, %.1f], \"health\": %d}",
+				VEC_SIZE (dp->framesjson) ? "," : "", DP_Number (dp->time),
+				DP_Number (dp->playerorigin[0]), DP_Number (dp->playerorigin[1]), DP_Number (dp->playerorigin[2]),
+				DP_Number (dp->viewangles[0]), DP_Number (dp->viewangles[1]), DP_Number (dp->viewangles[2]),
+				dp->stats[STAT_HEALTH]);
+		}
+	}
+
+done:
+	// assemble the final document
+	DP_Append (&dp->json, "{\n\t\"demo\": ");
+	DP_AppendString (&dp->json, dp->name);
+	DP_Append (&dp->json, ",\n\t\"cdtrack\": %d,\n\t\"frames\": %d,\n\t\"messages\": %d,\n\t\"duration\": %.3f,\n\t\"error\": ",
+		negative ? -cdtrack : cdtrack, dp->numframes, dp->nummessages, DP_Number (dp->time));
+	if (dp->error[0])
+		DP_AppendString (&dp->json, dp->error);
+	else
+		DP_Append (&dp->json, "null");
+
+	DP_Append (&dp->json, ",\n\t\"levels\": [");
+	for (i = 0; i < (int) VEC_SIZE (dp->levels); i++)
+	{
+		level = &dp->levels[i];
+		DP_Append (&dp->json, "%s\n\t\t{\"map\": ", i ? "," : "");
+		DP_AppendString (&dp->json, level->map);
+		DP_Append (&dp->json, ", \"name\": ");
+		DP_AppendString (&dp->json, level->name);
+		DP_Append (&dp->json, ", \"start\": %.3f", DP_Number (level->start));
+		if (level->end >= 0.f)
+			DP_Append (&dp->json, ", \"end\": %.3f, \"time\": %.3f, \"kills\": %d, \"totalkills\": %d, \"secrets\": %d, \"totalsecrets\": %d",
+				DP_Number (level->end), DP_Number (level->end - q_max (level->start, 0.f)),
+				level->kills, level->totalkills, level->secrets, level->totalsecrets);
+		else
+			DP_Append (&dp->json, ", \"end\": null");
+		DP_Append (&dp->json, ", \"deaths\": %d}", level->deaths);
+	}
+	DP_Append (&dp->json, "\n\t],\n\t\"events\": [");
+	if (dp->events)
+		Vec_Append ((void **) &dp->json, 1, dp->events, VEC_SIZE (dp->events));
+	DP_Append (&dp->json, "\n\t]");
+	if (dp->frames)
+	{
+		DP_Append (&dp->json, ",\n\t\"framedata\": [");
+		if (dp->framesjson)
+			Vec_Append ((void **) &dp->json, 1, dp->framesjson, VEC_SIZE (dp->framesjson));
+		DP_Append (&dp->json, "\n\t]");
+	}
+	DP_Append (&dp->json, "\n}\n");
+}
+
+static void DP_FreeAnalysis (demoanalysis_t *dp)
+{
+	free (dp->file);
+	free (dp->baselines);
+	VEC_FREE (dp->blob);
+	VEC_FREE (dp->levels);
+	VEC_FREE (dp->events);
+	VEC_FREE (dp->framesjson);
+	VEC_FREE (dp->json);
+	memset (dp, 0, sizeof (*dp));
+}
+
+//============================================================================
+
+typedef struct
+{
+	demoanalysis_t	*items;
+	int				count;
+	SDL_atomic_t	next;
+} dpbatch_t;
+
+static void DP_Worker (void *param)
+{
+	dpbatch_t	*batch = (dpbatch_t *) param;
+	int			i;
+
+	while ((i = SDL_AtomicAdd (&batch->next, 1)) < batch->count)
+		if (batch->items[i].file)
+			DP_AnalyzeDemo (&batch->items[i]);
+}
+
+/*
+====================
+CL_DemoParse_f
+
+demoparse [-frames] [-threads <n>] <demo> [demo...]
+====================
+*/
+void CL_DemoParse_f (void)
+{
+	taskcounter_t	counter;
+	demoanalysis_t	*items;
+	dpbatch_t		batch;
+	char			**names = NULL;
+	char			name[MAX_QPATH];
+	char			path[MAX_OSPATH];
+	qboolean		frames = false;
+	int				i, first, numthreads, batchsize, numok, numfailed;
+	unsigned int	path_id;
+	double			start;
+
+	numthreads = Tasks_NumWorkers ();
+	for (i = 1; i < Cmd_Argc (); i++)
+	{
+		if (!strcmp (Cmd_Argv (i), "-frames"))
+			frames = true;
+		else if (!strcmp (Cmd_Argv (i), "-threads") && i + 1 < Cmd_Argc ())
+			numthreads = Q_atoi (Cmd_Argv (++i));
+		else
+		{
+			char *name = (char *) malloc (MAX_QPATH);
+			q_strlcpy (name, Cmd_Argv (i), MAX_QPATH);
+			COM_AddExtension (name, ".dem", MAX_QPATH);
+			VEC_PUSH (names, name);
+		}
+	}
+
+	if (!VEC_SIZE (names))
+	{
+		Con_Printf ("demoparse [-frames] [-threads <n>] <demo> [demo...] : writes demo stats to <demo>.json\n");
+		return;
+	}
+
+	numthreads = CLAMP (1, numthreads, (int) VEC_SIZE (names));
+	batchsize = numthreads * DP_BATCH_PER_THREAD;
+	items = (demoanalysis_t *) calloc (batchsize, sizeof (*items));
+	if (!items)
+		Sys_Error ("CL_DemoParse_f: out of memory");
+
+	start = Sys_DoubleTime ();
+	numok = numfailed = 0;
+
+	for (first = 0; first < (int) VEC_SIZE (names); first += batchsize)
+	{
+		// the file system isn't thread-safe, so load the next batch here
+		memset (&batch, 0, sizeof (batch));
+		batch.items = items;
+		batch.count = q_min (batchsize, (int) VEC_SIZE (names) - first);
+		for (i = 0; i < batch.count; i++)
+		{
+			demoanalysis_t *dp = &items[i];
+			dp->name = names[first + i];
+			dp->frames = frames;
+			dp->file = COM_LoadMallocFile (dp->name, &path_id);
+			dp->filesize = (int) com_filesize;
+			if (!dp->file)
+				Con_Printf ("ERROR: couldn't open %s\n", dp->name);
+		}
+
+		memset (&counter, 0, sizeof (counter));
+		for (i = 1; i < numthreads; i++)
+			Task_Run (DP_Worker, &batch, &counter);
+		DP_Worker (&batch);
+		Task_Wait (&counter);
+
+		for (i = 0; i < batch.count; i++)
+		{
+			demoanalysis_t *dp = &items[i];
+			if (dp->file)
+			{
+				COM_StripExtension (dp->name, name, sizeof (name));
+				q_snprintf (path, sizeof (path), "%s/%s.json", com_gamedir, name);
+				COM_CreatePath (path);
+				if (!COM_WriteFile_OSPath (path, dp->json, VEC_SIZE (dp->json)))
+					Con_Printf ("ERROR: couldn't write %s\n", path);
+				else if (dp->error[0])
+					Con_Printf ("%s: %s\n", dp->name, dp->error);
+
+				if (dp->error[0])
+					numfailed++;
+				else
+					numok++;
+			}
+			else
+				numfailed++;
+
+			DP_FreeAnalysis (dp);
+		}
+	}
+
+	Con_Printf ("Analyzed %d demo%s (%d with errors) in %.2f seconds on %d thread%s\n",
+		numok + numfailed, numok + numfailed == 1 ? "" : "s", numfailed,
+		Sys_DoubleTime () - start, numthreads, numthreads == 1 ? "" : "s");
+
+	for (i = 0; i < (int) VEC_SIZE (names); i++)
+		free (names[i]);
+	VEC_FREE (names);
+	free (items);
+}
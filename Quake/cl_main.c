@@ -33,6 +33,8 @@ cvar_t	cl_color = {"_cl_color", "0", CVAR_ARCHIVE};
 
 cvar_t	cl_shownet = {"cl_shownet","0",CVAR_NONE};	// can be 0, 1, or 2
 cvar_t	cl_nolerp = {"cl_nolerp","0",CVAR_NONE};
+cvar_t	cl_signonblob = {"cl_signonblob","1",CVAR_NONE};	// ask servers for deflated signon buffers
+cvar_t	cl_democompress = {"cl_democompress","0",CVAR_ARCHIVE};	// record demos in the compressed container
 
 cvar_t	cfg_unbindall = {"cfg_unbindall", "1", CVAR_ARCHIVE};
 
@@ -77,6 +79,7 @@ void CL_FreeState(void)
 	int i;
 	for (i = 0; i < MAX_CL_STATS; i++)
 		free (cl.statss[i]);
+	VEC_FREE (cl.activeentities);
 	PR_ClearProgs (&cl.qcvm);
 	memset (&cl, 0, sizeof(cl));
 }
@@ -142,7 +145,7 @@ void CL_Disconnect (void)
 	else if (cls.state == ca_connected)
 	{
 		if (cls.demorecording)
-			CL_Stop_f ();
+			CL_StopRecording ();
 
 		Con_DPrintf ("Sending clc_disconnect\n");
 		SZ_Clear (&cls.message);
@@ -243,6 +246,7 @@ void CL_SignonReply (void)
 	case 4:
 		cl.spawntime = cl.mtime[0];
 		SCR_EndLoadingPlaque ();		// allow normal screen updates
+		LoadProf_EndSession ();
 		break;
 	}
 }
@@ -498,6 +502,87 @@ static void CL_RocketTrail (entity_t *ent, int type)
 	CL_ResetTrail (ent);
 }
 
+/*
+===============
+CL_LerpEntity
+
+Interpolates the origin and angles of an entity between its last two updates
+===============
+*/
+static void CL_LerpEntity (entity_t *ent, float frac)
+{
+	float		f;
+#ifdef USE_SSE2
+	__m128		o0, o1, a0, a1, delta, d, f4;
+	vec4_t		origin, angles;
+
+	// the loads read one float past each vector, which stays inside entity_t
+	o0 = _mm_loadu_ps (ent->msg_origins[0]);
+	o1 = _mm_loadu_ps (ent->msg_origins[1]);
+	delta = _mm_sub_ps (o0, o1);
+
+	// if the delta is large, assume a teleport and don't lerp
+	f = frac;
+	if (_mm_movemask_ps (_mm_or_ps (_mm_cmpgt_ps (delta, _mm_set1_ps (100.f)), _mm_cmplt_ps (delta, _mm_set1_ps (-100.f)))) & 7)
+	{
+		f = 1;		// assume a teleportation, not a motion
+		ent->lerpflags |= LERP_RESETMOVE; //johnfitz -- don't lerp teleports
+	}
+
+	//johnfitz -- don't cl_lerp entities that will be r_lerped
+	if (r_lerpmove.value && (ent->lerpflags & LERP_MOVESTEP))
+		f = 1;
+	//johnfitz
+
+	// interpolate the origin and angles, wrapping angle deltas to [-180, 180]
+	a0 = _mm_loadu_ps (ent->msg_angles[0]);
+	a1 = _mm_loadu_ps (ent->msg_angles[1]);
+	d = _mm_sub_ps (a0, a1);
+	d = _mm_sub_ps (d, _mm_and_ps (_mm_cmpgt_ps (d, _mm_set1_ps (180.f)), _mm_set1_ps (360.f)));
+	d = _mm_add_ps (d, _mm_and_ps (_mm_cmplt_ps (d, _mm_set1_ps (-180.f)), _mm_set1_ps (360.f)));
+
+	f4 = _mm_set1_ps (f);
+	_mm_storeu_ps (origin, _mm_add_ps (o1, _mm_mul_ps (f4, delta)));
+	_mm_storeu_ps (angles, _mm_add_ps (a1, _mm_mul_ps (f4, d)));
+	VectorCopy (origin, ent->origin);
+	VectorCopy (angles, ent->angles);
+#else
+	int			j;
+	float		d;
+	vec3_t		delta;
+
+	// if the delta is large, assume a teleport and don't lerp
+	f = frac;
+	for (j=0 ; j<3 ; j++)
+	{
+		delta[j] = ent->msg_origins[0][j] - ent->msg_origins[1][j];
+		if (delta[j] > 100 || delta[j] < -100)
+		{
+			f = 1;		// assume a teleportation, not a motion
+			ent->lerpflags |= LERP_RESETMOVE; //johnfitz -- don't lerp teleports
+		}
+	}
+
+	//johnfitz -- don't cl_lerp entities that will be r_lerped
+	if (r_lerpmove.value && (ent->lerpflags & LERP_MOVESTEP))
+		f = 1;
+	//johnfitz
+
+// interpolate the origin and angles
+	for (j=0 ; j<3 ; j++)
+	{
+		ent->origin[j] = ent->msg_origins[1][j] + f*delta[j];
+
+		d = ent->msg_angles[0][j] - ent->msg_angles[1][j];
+		if (d > 180)
+			d -= 360;
+		else if (d < -180)
+			d += 360;
+		ent->angles[j] = ent->msg_angles[1][j] + f*d;
+	}
+#endif
+}
+
 /*
 ===============
 CL_RelinkEntities
@@ -506,9 +591,8 @@ CL_RelinkEntities
 void CL_RelinkEntities (void)
 {
 	entity_t	*ent;
-	int			i, j;
-	float		frac, f, d;
-	vec3_t		delta;
+	int			i, j, k, numactive;
+	float		frac, d;
 	float		bobjrotate;
 	dlight_t	*dl;
 
@@ -542,9 +626,15 @@ void CL_RelinkEntities (void)
 
 	bobjrotate = anglemod(100*cl.time);
 
-// start on the entity after the world
-	for (i=1,ent=cl_entities+1 ; i<cl.num_entities ; i++,ent++)
+// only visit entities that were updated since they were last removed,
+// compacting the list in place as stale ones drop out
+	for (k=0,numactive=0 ; k<(int)VEC_SIZE (cl.activeentities) ; k++)
 	{
+		i = cl.activeentities[k];
+		if (i <= 0 || i >= cl.num_entities)
+			continue;
+
+		ent = cl_entities + i;
 		if (!ent->model)
 		{	// empty slot
 			
@@ -552,6 +642,7 @@ void CL_RelinkEntities (void)
 			// ent can't be static, so this is a no-op.
 			//if (ent->forcelink)
 			//	R_RemoveEfrags (ent);	// just became empty
+			ent->active = false;
 			continue;
 		}
 
@@ -560,9 +651,12 @@ void CL_RelinkEntities (void)
 		{
 			ent->model = NULL;
 			ent->lerpflags |= LERP_RESETMOVE|LERP_RESETANIM; //johnfitz -- next time this entity slot is reused, the lerp will need to be reset
+			ent->active = false;
 			continue;
 		}
 
+		cl.activeentities[numactive++] = i;
+
 		if (ent->forcelink)
 		{	// the entity was not updated in the last message
 			// so move to the final spot
@@ -570,36 +664,7 @@ void CL_RelinkEntities (void)
 			VectorCopy (ent->msg_angles[0], ent->angles);
 		}
 		else
-		{	// if the delta is large, assume a teleport and don't lerp
-			f = frac;
-			for (j=0 ; j<3 ; j++)
-			{
-				delta[j] = ent->msg_origins[0][j] - ent->msg_origins[1][j];
-				if (delta[j] > 100 || delta[j] < -100)
-				{
-					f = 1;		// assume a teleportation, not a motion
-					ent->lerpflags |= LERP_RESETMOVE; //johnfitz -- don't lerp teleports
-				}
-			}
-
-			//johnfitz -- don't cl_lerp entities that will be r_lerped
-			if (r_lerpmove.value && (ent->lerpflags & LERP_MOVESTEP))
-				f = 1;
-			//johnfitz
-
-		// interpolate the origin and angles
-			for (j=0 ; j<3 ; j++)
-			{
-				ent->origin[j] = ent->msg_origins[1][j] + f*delta[j];
-
-				d = ent->msg_angles[0][j] - ent->msg_angles[1][j];
-				if (d > 180)
-					d -= 360;
-				else if (d < -180)
-					d += 360;
-				ent->angles[j] = ent->msg_angles[1][j] + f*d;
-			}
-		}
+			CL_LerpEntity (ent, frac);
 
 		if (ent->forcelink || ent->lerpflags & LERP_RESETMOVE)
 			CL_ResetTrail (ent);
@@ -705,6 +770,9 @@ void CL_RelinkEntities (void)
 			cl_numvisedicts++;
 		}
 	}
+
+	if (cl.activeentities)
+		VEC_HEADER (cl.activeentities).size = numactive;
 }
 
 
@@ -1017,6 +1085,8 @@ void CL_Init (void)
 	Cvar_RegisterVariable (&cl_anglespeedkey);
 	Cvar_RegisterVariable (&cl_shownet);
 	Cvar_RegisterVariable (&cl_nolerp);
+	Cvar_RegisterVariable (&cl_signonblob);
+	Cvar_RegisterVariable (&cl_democompress);
 	Cvar_RegisterVariable (&freelook);
 	Cvar_RegisterVariable (&lookspring);
 	Cvar_RegisterVariable (&lookstrafe);
@@ -1045,6 +1115,10 @@ void CL_Init (void)
 	Cmd_AddCommand ("stop", CL_Stop_f);
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f);
 	Cmd_AddCommand ("timedemo", CL_TimeDemo_f);
+	Cmd_AddCommand ("demoparse", CL_DemoParse_f);
+#ifdef DEBUG
+	Cmd_AddCommand ("cl_updatetest", CL_UpdateTest_f);
+#endif
 
 	Cmd_AddCommand ("tracepos", CL_Tracepos_f); //johnfitz
 	cmd = Cmd_AddCommand ("viewpos", CL_Viewpos_f); //johnfitz
@@ -96,7 +96,10 @@ const char *svc_strings[] =
 	"svc_chat", // 53
 	"svc_levelcompleted", // 54
 	"svc_backtolobby", // 55
-	"svc_localsound" // 56
+	"svc_localsound", // 56
+
+// ironwail extensions
+	"svc_signonblob", // 57
 };
 #define NUM_SVC_STRINGS Q_COUNTOF(svc_strings)
 
@@ -286,7 +289,7 @@ void CL_ParseServerInfo (void)
 {
 	const char	*str;
 	int		i;
-	int		nummodels, numsounds;
+	int		nummodels, numsounds, total;
 	char	model_precache[MAX_MODELS][MAX_QPATH];
 	char	sound_precache[MAX_SOUNDS][MAX_QPATH];
 
@@ -401,8 +404,18 @@ void CL_ParseServerInfo (void)
 	// copy the naked name of the map file to the cl structure -- O.S
 	COM_StripExtension (COM_SkipPath(model_precache[1]), cl.mapname, sizeof(cl.mapname));
 
+	// a local server has already started the session in SV_SpawnServer
+	if (!sv.active)
+		LoadProf_BeginSession (cl.mapname);
+	LoadProf_Begin ("CL_ParseServerInfo");
+
+	// overall progress: every model, every sound, and R_NewMap
+	total = (nummodels - 1) + (numsounds - 1) + 1;
+
+	LoadProf_Begin ("Model precache");
 	for (i = 1; i < nummodels; i++)
 	{
+		SCR_LoadingProgress ("Loading models", i - 1, total);
 		cl.model_precache[i] = Mod_ForName (model_precache[i], false);
 		if (cl.model_precache[i] == NULL)
 		{
@@ -410,19 +423,26 @@ void CL_ParseServerInfo (void)
 		}
 		CL_KeepaliveMessage ();
 	}
+	LoadProf_End ();
 
+	LoadProf_Begin ("Sound precache");
 	S_BeginPrecaching ();
 	for (i = 1; i < numsounds; i++)
 	{
+		SCR_LoadingProgress ("Loading sounds", (nummodels - 1) + (i - 1), total);
 		cl.sound_precache[i] = S_PrecacheSound (sound_precache[i]);
 		CL_KeepaliveMessage ();
 	}
 	S_EndPrecaching ();
+	LoadProf_End ();
 
 // local state
 	cl_entities[0].model = cl.worldmodel = cl.model_precache[1];
 
+	SCR_LoadingProgress ("Preparing map", total - 1, total);
+	LoadProf_Begin ("R_NewMap");
 	R_NewMap ();
+	LoadProf_End ();
 
 	//johnfitz -- clear out string; we don't consider identical
 	//messages to be duplicates if the map has changed in between
@@ -439,8 +459,265 @@ void CL_ParseServerInfo (void)
 	memset(&dev_stats, 0, sizeof(dev_stats));
 	memset(&dev_peakstats, 0, sizeof(dev_peakstats));
 	memset(&dev_overflows, 0, sizeof(dev_overflows));
+
+	LoadProf_End ();
+	LoadProf_Begin ("Client signon"); // closed by LoadProf_EndSession once the signon is complete
 }
 
+/*
+==================
+CL_EntityUpdateSize
+
+Returns the number of bytes following the entity number of an update
+with the given bits, or -1 if it can't be known up front
+==================
+*/
+int CL_EntityUpdateSize (int bits, unsigned int protocol, unsigned int protocolflags)
+{
+	int		coordsize, anglesize, size;
+
+	coordsize = MSG_CoordSize (protocolflags);
+	anglesize = MSG_AngleSize (protocolflags);
+
+	size = 0;
+	size += (bits & U_MODEL) != 0;
+	size += (bits & U_FRAME) != 0;
+	size += (bits & U_COLORMAP) != 0;
+	size += (bits & U_SKIN) != 0;
+	size += (bits & U_EFFECTS) != 0;
+	size += coordsize * (((bits & U_ORIGIN1) != 0) + ((bits & U_ORIGIN2) != 0) + ((bits & U_ORIGIN3) != 0));
+	size += anglesize * (((bits & U_ANGLE1) != 0) + ((bits & U_ANGLE2) != 0) + ((bits & U_ANGLE3) != 0));
+
+	if (protocol == PROTOCOL_FITZQUAKE || protocol == PROTOCOL_RMQ)
+	{
+		size += (bits & U_ALPHA) != 0;
+		size += (bits & U_SCALE) != 0;
+		size += (bits & U_FRAME2) != 0;
+		size += (bits & U_MODEL2) != 0;
+		size += (bits & U_LERPFINISH) != 0;
+	}
+	else if (protocol == PROTOCOL_NETQUAKE && (bits & U_TRANS))
+		return -1; // Nehahra, size depends on the contents
+
+	return size;
+}
+
+/*
+==================
+CL_DecodeEntityUpdate
+
+Reads the fields of an entity update from a section validated by CL_EntityUpdateSize,
+missing fields come from the baseline. Only touches its arguments, so it can also
+be used on demos parsed outside of the client state.
+==================
+*/
+void CL_DecodeEntityUpdate (msgreader_t *r, int bits, unsigned int protocol, unsigned int protocolflags, const entity_state_t *base, entupdate_t *u)
+{
+	u->modnum = (bits & U_MODEL) ? MSGR_ReadByte (r) : base->modelindex;
+	u->frame = (bits & U_FRAME) ? MSGR_ReadByte (r) : base->frame;
+	u->colormap = (bits & U_COLORMAP) ? MSGR_ReadByte (r) : base->colormap;
+	u->skin = (bits & U_SKIN) ? MSGR_ReadByte (r) : base->skin;
+	u->effects = (bits & U_EFFECTS) ? MSGR_ReadByte (r) : base->effects;
+
+	u->origin[0] = (bits & U_ORIGIN1) ? MSGR_ReadCoord (r, protocolflags) : base->origin[0];
+	u->angles[0] = (bits & U_ANGLE1) ? MSGR_ReadAngle (r, protocolflags) : base->angles[0];
+	u->origin[1] = (bits & U_ORIGIN2) ? MSGR_ReadCoord (r, protocolflags) : base->origin[1];
+	u->angles[1] = (bits & U_ANGLE2) ? MSGR_ReadAngle (r, protocolflags) : base->angles[1];
+	u->origin[2] = (bits & U_ORIGIN3) ? MSGR_ReadCoord (r, protocolflags) : base->origin[2];
+	u->angles[2] = (bits & U_ANGLE3) ? MSGR_ReadAngle (r, protocolflags) : base->angles[2];
+
+	u->alpha = base->alpha;
+	u->scale = base->scale;
+	u->lerpfinish = -1;
+	if (protocol == PROTOCOL_FITZQUAKE || protocol == PROTOCOL_RMQ)
+	{
+		if (bits & U_ALPHA)
+			u->alpha = MSGR_ReadByte (r);
+		if (bits & U_SCALE)
+			u->scale = MSGR_ReadByte (r);
+		if (bits & U_FRAME2)
+			u->frame = (u->frame & 0x00FF) | (MSGR_ReadByte (r) << 8);
+		if (bits & U_MODEL2)
+			u->modnum = (u->modnum & 0x00FF) | (MSGR_ReadByte (r) << 8);
+		if (bits & U_LERPFINISH)
+			u->lerpfinish = MSGR_ReadByte (r);
+	}
+}
+
+/*
+==================
+CL_ReadUpdate
+
+Reads the fields of an entity update with the regular checked reads,
+missing fields come from the baseline
+==================
+*/
+static void CL_ReadUpdate (int bits, const entity_t *ent, entupdate_t *u)
+{
+	const entity_state_t *base = &ent->baseline;
+
+	u->modnum = (bits & U_MODEL) ? MSG_ReadByte () : base->modelindex;
+	u->frame = (bits & U_FRAME) ? MSG_ReadByte () : base->frame;
+	u->colormap = (bits & U_COLORMAP) ? MSG_ReadByte () : base->colormap;
+	u->skin = (bits & U_SKIN) ? MSG_ReadByte () : base->skin;
+	u->effects = (bits & U_EFFECTS) ? MSG_ReadByte () : base->effects;
+
+	u->origin[0] = (bits & U_ORIGIN1) ? MSG_ReadCoord (cl.protocolflags) : base->origin[0];
+	u->angles[0] = (bits & U_ANGLE1) ? MSG_ReadAngle (cl.protocolflags) : base->angles[0];
+	u->origin[1] = (bits & U_ORIGIN2) ? MSG_ReadCoord (cl.protocolflags) : base->origin[1];
+	u->angles[1] = (bits & U_ANGLE2) ? MSG_ReadAngle (cl.protocolflags) : base->angles[1];
+	u->origin[2] = (bits & U_ORIGIN3) ? MSG_ReadCoord (cl.protocolflags) : base->origin[2];
+	u->angles[2] = (bits & U_ANGLE3) ? MSG_ReadAngle (cl.protocolflags) : base->angles[2];
+
+	u->alpha = base->alpha;
+	u->scale = base->scale;
+	u->lerpfinish = -1;
+
+	//johnfitz -- PROTOCOL_FITZQUAKE and PROTOCOL_NEHAHRA
+	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
+	{
+		if (bits & U_ALPHA)
+			u->alpha = MSG_ReadByte();
+		if (bits & U_SCALE)
+			u->scale = MSG_ReadByte();
+		if (bits & U_FRAME2)
+			u->frame = (u->frame & 0x00FF) | (MSG_ReadByte() << 8);
+		if (bits & U_MODEL2)
+			u->modnum = (u->modnum & 0x00FF) | (MSG_ReadByte() << 8);
+		if (bits & U_LERPFINISH)
+			u->lerpfinish = MSG_ReadByte();
+	}
+	else if (cl.protocol == PROTOCOL_NETQUAKE)
+	{
+		//HACK: if this bit is set, assume this is PROTOCOL_NEHAHRA
+		if (bits & U_TRANS)
+		{
+			float a, b;
+
+			if (warn_about_nehahra_protocol)
+			{
+				Con_Warning ("nonstandard update bit, assuming Nehahra protocol\n");
+				warn_about_nehahra_protocol = false;
+			}
+
+			a = MSG_ReadFloat();
+			b = MSG_ReadFloat(); //alpha
+			if (a == 2)
+				MSG_ReadFloat(); //fullbright (not using this yet)
+			u->alpha = ENTALPHA_ENCODE(b);
+		}
+	}
+	//johnfitz
+}
+
+#ifdef DEBUG
+/*
+==================
+CL_UpdateTest_f
+
+Decodes random entity updates (random bits, payloads, baselines and protocols)
+with both CL_DecodeEntityUpdate and CL_ReadUpdate and reports any difference.
+Only built in debug builds.
+==================
+*/
+void CL_UpdateTest_f (void)
+{
+	static const struct
+	{
+		int				protocol;
+		unsigned int	flags;
+	} protocols[] =
+	{
+		{PROTOCOL_NETQUAKE,		0},
+		{PROTOCOL_FITZQUAKE,	0},
+		{PROTOCOL_RMQ,			0},
+		{PROTOCOL_RMQ,			PRFL_SHORTANGLE},
+		{PROTOCOL_RMQ,			PRFL_FLOATANGLE},
+		{PROTOCOL_RMQ,			PRFL_24BITCOORD},
+		{PROTOCOL_RMQ,			PRFL_FLOATCOORD},
+		{PROTOCOL_RMQ,			PRFL_INT32COORD},
+		{PROTOCOL_RMQ,			PRFL_SHORTANGLE|PRFL_24BITCOORD},
+		{PROTOCOL_RMQ,			PRFL_FLOATANGLE|PRFL_FLOATCOORD},
+		{PROTOCOL_RMQ,			PRFL_SHORTANGLE|PRFL_INT32COORD},
+	};
+	sizebuf_t		oldmessage = net_message;
+	int				oldreadcount = msg_readcount;
+	qboolean		oldbadread = msg_badread;
+	unsigned int	oldprotocol = cl.protocol;
+	unsigned int	oldflags = cl.protocolflags;
+	byte			payload[64];
+	entity_t		ent;
+	entupdate_t		fast, checked;
+	msgreader_t		reader;
+	int				i, j, count, tested, failed;
+
+	count = Cmd_Argc () > 1 ? atoi (Cmd_Argv (1)) : 100000;
+	tested = failed = 0;
+
+	memset (&ent, 0, sizeof (ent));
+	net_message.data = payload;
+	net_message.maxsize = net_message.cursize = sizeof (payload);
+
+	for (i = 0; i < count; i++)
+	{
+		int bits = (rand () & 0xffff) | ((rand () & 0xffff) << 16);
+		int size, fastcount;
+
+		j = rand () % countof (protocols);
+		cl.protocol = protocols[j].protocol;
+		cl.protocolflags = protocols[j].flags;
+
+		for (j = 0; j < (int) sizeof (payload); j++)
+			payload[j] = rand () & 255;
+		ent.baseline.modelindex = rand () & 0xffff;
+		ent.baseline.frame = rand () & 0xffff;
+		ent.baseline.colormap = rand () & 255;
+		ent.baseline.skin = rand () & 255;
+		ent.baseline.effects = rand () & 255;
+		ent.baseline.alpha = rand () & 255;
+		ent.baseline.scale = rand () & 255;
+		for (j = 0; j < 3; j++)
+		{
+			ent.baseline.origin[j] = (rand () & 0xffff) * 0.125f - 4096.f;
+			ent.baseline.angles[j] = (rand () & 0xffff) * (360.f / 65536.f);
+		}
+
+		size = CL_EntityUpdateSize (bits, cl.protocol, cl.protocolflags);
+		if (size < 0)
+			continue; // Nehahra, only the checked path handles it
+
+		memset (&fast, 0, sizeof (fast));
+		memset (&checked, 0, sizeof (checked));
+
+		msg_readcount = 0;
+		if (!MSG_BeginSection (&reader, size))
+			continue;
+		CL_DecodeEntityUpdate (&reader, bits, cl.protocol, cl.protocolflags, &ent.baseline, &fast);
+		fastcount = msg_readcount;
+
+		msg_readcount = 0;
+		msg_badread = false;
+		CL_ReadUpdate (bits, &ent, &checked);
+
+		tested++;
+		if (memcmp (&fast, &checked, sizeof (fast)) || fastcount != msg_readcount || msg_badread)
+		{
+			if (failed++ < 10)
+				Con_Printf ("mismatch: protocol %u flags 0x%x bits 0x%08x (%d vs %d bytes)\n",
+					cl.protocol, cl.protocolflags, bits, fastcount, msg_readcount);
+		}
+	}
+
+	net_message = oldmessage;
+	msg_readcount = oldreadcount;
+	msg_badread = oldbadread;
+	cl.protocol = oldprotocol;
+	cl.protocolflags = oldflags;
+
+	Con_Printf ("%d entity updates compared, %d mismatches\n", tested, failed);
+}
+#endif
+
 /*
 ==================
 CL_ParseUpdate
@@ -454,12 +731,12 @@ void CL_ParseUpdate (int bits)
 {
 	int		i;
 	qmodel_t	*model;
-	int		modnum;
 	qboolean	forcelink;
 	entity_t	*ent;
 	int		num;
-	int		skin;
 	int		prevframe;
+	msgreader_t	reader;
+	entupdate_t	u;
 
 	if (cls.signon == SIGNONS - 1)
 	{	// first update is the final signon stage
@@ -489,6 +766,18 @@ void CL_ParseUpdate (int bits)
 		num = MSG_ReadByte ();
 
 	ent = CL_EntityNum (num);
+	if (!ent->active)
+	{
+		ent->active = true;
+		VEC_PUSH (cl.activeentities, num);
+	}
+
+	// one bounds check for the whole update when its size is known,
+	// the checked reads handle the rest (and truncated messages)
+	if (MSG_BeginSection (&reader, CL_EntityUpdateSize (bits, cl.protocol, cl.protocolflags)))
+		CL_DecodeEntityUpdate (&reader, bits, cl.protocol, cl.protocolflags, &ent->baseline, &u);
+	else
+		CL_ReadUpdate (bits, ent, &u);
 
 	if (ent->msgtime != cl.mtime[1])
 		forcelink = true;	// no previous frame to lerp from
@@ -502,25 +791,13 @@ void CL_ParseUpdate (int bits)
 
 	ent->msgtime = cl.mtime[0];
 
-	if (bits & U_MODEL)
-	{
-		modnum = MSG_ReadByte ();
-		if (modnum >= MAX_MODELS)
-			Host_Error ("CL_ParseModel: bad modnum");
-	}
-	else
-		modnum = ent->baseline.modelindex;
+	if (u.modnum >= MAX_MODELS)
+		Host_Error ("CL_ParseModel: bad modnum");
 
 	prevframe = ent->frame;
-	if (bits & U_FRAME)
-		ent->frame = MSG_ReadByte ();
-	else
-		ent->frame = ent->baseline.frame;
+	ent->frame = u.frame;
 
-	if (bits & U_COLORMAP)
-		i = MSG_ReadByte();
-	else
-		i = ent->baseline.colormap;
+	i = u.colormap;
 	if (!i)
 		ent->colormap = vid.colormap;
 	else
@@ -529,51 +806,19 @@ void CL_ParseUpdate (int bits)
 			Sys_Error ("i >= cl.maxclients");
 		ent->colormap = cl.scores[i-1].translations;
 	}
-	if (bits & U_SKIN)
-		skin = MSG_ReadByte();
-	else
-		skin = ent->baseline.skin;
-	if (skin != ent->skinnum)
+	if (u.skin != ent->skinnum)
 	{
-		ent->skinnum = skin;
+		ent->skinnum = u.skin;
 		if (num > 0 && num <= cl.maxclients)
 			R_TranslateNewPlayerSkin (num - 1); //johnfitz -- was R_TranslatePlayerSkin
 	}
-	if (bits & U_EFFECTS)
-		ent->effects = MSG_ReadByte();
-	else
-		ent->effects = ent->baseline.effects;
+	ent->effects = u.effects;
 
 // shift the known values for interpolation
 	VectorCopy (ent->msg_origins[0], ent->msg_origins[1]);
 	VectorCopy (ent->msg_angles[0], ent->msg_angles[1]);
-
-	if (bits & U_ORIGIN1)
-		ent->msg_origins[0][0] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][0] = ent->baseline.origin[0];
-	if (bits & U_ANGLE1)
-		ent->msg_angles[0][0] = MSG_ReadAngle(cl.protocolflags);
-	else
-		ent->msg_angles[0][0] = ent->baseline.angles[0];
-
-	if (bits & U_ORIGIN2)
-		ent->msg_origins[0][1] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][1] = ent->baseline.origin[1];
-	if (bits & U_ANGLE2)
-		ent->msg_angles[0][1] = MSG_ReadAngle(cl.protocolflags);
-	else
-		ent->msg_angles[0][1] = ent->baseline.angles[1];
-
-	if (bits & U_ORIGIN3)
-		ent->msg_origins[0][2] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][2] = ent->baseline.origin[2];
-	if (bits & U_ANGLE3)
-		ent->msg_angles[0][2] = MSG_ReadAngle(cl.protocolflags);
-	else
-		ent->msg_angles[0][2] = ent->baseline.angles[2];
+	VectorCopy (u.origin, ent->msg_origins[0]);
+	VectorCopy (u.angles, ent->msg_angles[0]);
 
 	//johnfitz -- lerping for movetype_step entities
 	if (bits & U_STEP)
@@ -588,21 +833,11 @@ void CL_ParseUpdate (int bits)
 	//johnfitz -- PROTOCOL_FITZQUAKE and PROTOCOL_NEHAHRA
 	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
 	{
-		if (bits & U_ALPHA)
-			ent->alpha = MSG_ReadByte();
-		else
-			ent->alpha = ent->baseline.alpha;
-		if (bits & U_SCALE)
-			ent->scale = MSG_ReadByte();
-		else
-			ent->scale = ent->baseline.scale;
-		if (bits & U_FRAME2)
-			ent->frame = (ent->frame & 0x00FF) | (MSG_ReadByte() << 8);
-		if (bits & U_MODEL2)
-			modnum = (modnum & 0x00FF) | (MSG_ReadByte() << 8);
-		if (bits & U_LERPFINISH)
+		ent->alpha = u.alpha;
+		ent->scale = u.scale;
+		if (u.lerpfinish >= 0)
 		{
-			ent->lerpfinish = ent->msgtime + ((float)(MSG_ReadByte()) / 255);
+			ent->lerpfinish = ent->msgtime + ((float)(u.lerpfinish) / 255);
 			ent->lerpflags |= LERP_FINISH;
 		}
 		else
@@ -610,31 +845,13 @@ void CL_ParseUpdate (int bits)
 	}
 	else if (cl.protocol == PROTOCOL_NETQUAKE)
 	{
-		//HACK: if this bit is set, assume this is PROTOCOL_NEHAHRA
-		if (bits & U_TRANS)
-		{
-			float a, b;
-
-			if (warn_about_nehahra_protocol)
-			{
-				Con_Warning ("nonstandard update bit, assuming Nehahra protocol\n");
-				warn_about_nehahra_protocol = false;
-			}
-
-			a = MSG_ReadFloat();
-			b = MSG_ReadFloat(); //alpha
-			if (a == 2)
-				MSG_ReadFloat(); //fullbright (not using this yet)
-			ent->alpha = ENTALPHA_ENCODE(b);
-		}
-		else
-			ent->alpha = ent->baseline.alpha;
+		ent->alpha = u.alpha;
 		ent->scale = ent->baseline.scale;
 	}
 	//johnfitz
 
 	//johnfitz -- moved here from above
-	model = cl.model_precache[modnum];
+	model = cl.model_precache[u.modnum];
 	if (model != ent->model)
 	{
 		ent->model = model;
@@ -1024,6 +1241,104 @@ static void CL_DumpPacket (void)
 
 #define SHOWNET(x) if(cl_shownet.value==2)Con_Printf ("%3i:%s\n", msg_readcount-1, x);
 
+static byte	*cl_signonblob_data;	// deflated signon buffers received so far
+static int	cl_signonblob_depth;	// > 0 while parsing the inflated blob
+
+/*
+==================
+CL_ParseBaselines
+
+Parses a run of consecutive svc_spawnbaseline/svc_spawnbaseline2 messages
+without going back through the main dispatch loop for each of them
+==================
+*/
+static void CL_ParseBaselines (int cmd)
+{
+	int i;
+
+	while (1)
+	{
+		i = MSG_ReadShort ();
+		// must use CL_EntityNum() to force cl.num_entities up
+		CL_ParseBaseline (CL_EntityNum (i), cmd == svc_spawnbaseline2 ? 2 : 1); // johnfitz -- added second parameter
+
+		if (msg_badread || msg_readcount >= net_message.cursize)
+			break;
+		cmd = net_message.data[msg_readcount];
+		if (cmd != svc_spawnbaseline && cmd != svc_spawnbaseline2)
+			break;
+		msg_readcount++;
+		SHOWNET(svc_strings[cmd]);
+	}
+}
+
+/*
+==================
+CL_ParseSignonBlob
+
+Accumulates fragments of the deflated signon buffers, then inflates
+and parses them as a regular server message once complete
+==================
+*/
+static void CL_ParseSignonBlob (void)
+{
+	int			srcsize, size, ofs, len;
+	int			savedcount;
+	byte		*data;
+	sizebuf_t	savedmsg;
+
+	srcsize = MSG_ReadLong ();
+	size = MSG_ReadLong ();
+	ofs = MSG_ReadLong ();
+	len = MSG_ReadShort ();
+
+	if (msg_badread || cl_signonblob_depth > 0)
+		Host_Error ("CL_ParseSignonBlob: bad message");
+	if (srcsize <= 0 || srcsize > NET_MAXMESSAGE * 256 || size <= 0 || len <= 0 ||
+		ofs < 0 || ofs + len > size || msg_readcount + len > net_message.cursize)
+		Host_Error ("CL_ParseSignonBlob: bad fragment (%d/%d bytes at %d)", len, size, ofs);
+
+	// a new transfer starts over at offset 0 (e.g. when the server's signon buffers change)
+	if (ofs == 0)
+		VEC_CLEAR (cl_signonblob_data);
+	if (ofs != (int) VEC_SIZE (cl_signonblob_data))
+		Host_Error ("CL_ParseSignonBlob: got offset %d, expected %d", ofs, (int) VEC_SIZE (cl_signonblob_data));
+
+	Vec_Append ((void **) &cl_signonblob_data, 1, net_message.data + msg_readcount, len);
+	msg_readcount += len;
+
+	if ((int) VEC_SIZE (cl_signonblob_data) < size)
+		return;
+
+	data = (byte *) malloc (srcsize);
+	if (!data)
+		Sys_Error ("CL_ParseSignonBlob: out of memory on %d bytes", srcsize);
+	if (!COM_Inflate (cl_signonblob_data, size, data, srcsize))
+	{
+		free (data);
+		VEC_FREE (cl_signonblob_data);
+		Host_Error ("CL_ParseSignonBlob: corrupt signon data");
+	}
+	VEC_FREE (cl_signonblob_data);
+
+	Con_DPrintf ("Signon data: %d bytes, %d compressed\n", srcsize, size);
+
+	// parse the inflated buffers in place of the current message
+	savedmsg = net_message;
+	savedcount = msg_readcount;
+	net_message.data = data;
+	net_message.maxsize = net_message.cursize = srcsize;
+
+	cl_signonblob_depth++;
+	CL_ParseServerMessage ();
+	cl_signonblob_depth--;
+
+	net_message = savedmsg;
+	msg_readcount = savedcount;
+	msg_badread = false;
+	free (data);
+}
+
 //mods and servers might not send the \n instantly.
 //some mods bug out and omit the \n entirely, this function helps prevent the damage from spreading too much.
 //some servers or mods use //prefixed commands as extensions to avoid spam about unrecognised commands.
@@ -1100,6 +1415,9 @@ void CL_ParseServerMessage (void)
 		{
 			SHOWNET("END OF MESSAGE");
 
+			if (cl_signonblob_depth > 0)
+				return;	// end of the inflated signon data, the enclosing message handles the rest
+
 			if (*cl.stuffcmdbuf && net_message.cursize < 512)
 				CL_ParseStuffText("\n");	//there's a few mods that forget to write \ns, that then fuck up other things too. So make sure it gets flushed to the cbuf. the cursize check is to reduce backbuffer overflows that would give a false positive.
 
@@ -1234,9 +1552,7 @@ void CL_ParseServerMessage (void)
 			break;
 
 		case svc_spawnbaseline:
-			i = MSG_ReadShort ();
-			// must use CL_EntityNum() to force cl.num_entities up
-			CL_ParseBaseline (CL_EntityNum(i), 1); // johnfitz -- added second parameter
+			CL_ParseBaselines (cmd);
 			break;
 
 		case svc_spawnstatic:
@@ -1357,9 +1673,7 @@ void CL_ParseServerMessage (void)
 			break;
 
 		case svc_spawnbaseline2: //PROTOCOL_FITZQUAKE
-			i = MSG_ReadShort ();
-			// must use CL_EntityNum() to force cl.num_entities up
-			CL_ParseBaseline (CL_EntityNum(i), 2);
+			CL_ParseBaselines (cmd);
 			break;
 
 		case svc_spawnstatic2: //PROTOCOL_FITZQUAKE
@@ -1382,6 +1696,10 @@ void CL_ParseServerMessage (void)
 		case svc_localsound:
 			CL_ParseLocalSound();
 			break;
+
+		case svc_signonblob:
+			CL_ParseSignonBlob ();
+			break;
 		}
 
 		lastcmd = cmd; //johnfitz
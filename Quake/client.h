@@ -135,6 +135,9 @@ typedef struct
 	int		forcetrack;		// -1 = use normal cd track
 	char		demofilename[MAX_OSPATH];
 	FILE		*demofile;
+	byte		*demodata;		// compressed demos are inflated here and played back from memory
+	qfileofs_t	demodatasize;
+	qfileofs_t	demodatapos;
 	qfileofs_t	demofilestart;	// for demos in pak files
 	qfileofs_t	demofilesize;
 	int		td_lastframe;		// to meter out one message a frame
@@ -237,6 +240,7 @@ typedef struct
 	struct qmodel_s	*worldmodel;	// cl_entitites[0].model
 	int			num_efrags;
 	int			num_entities;	// held in cl_entities array
+	int			*activeentities;	// dynamic vector of updated cl_entities indices, pruned by CL_RelinkEntities
 	int			num_statics;	// held in cl_staticentities array
 	entity_t	viewent;			// the gun model
 
@@ -285,6 +289,8 @@ extern	cvar_t	cl_autofire;
 
 extern	cvar_t	cl_shownet;
 extern	cvar_t	cl_nolerp;
+extern	cvar_t	cl_signonblob;
+extern	cvar_t	cl_democompress;
 
 extern	cvar_t	cfg_unbindall;
 
@@ -379,14 +385,83 @@ void CL_FinishDemoFrame (void);
 void CL_AddDemoRewindSound (int entnum, int channel, sfx_t *sfx, vec3_t pos, int vol, float atten);
 
 void CL_Stop_f (void);
+void CL_StopRecording (void);
+qboolean CL_IsCompressedDemo (const void *data, size_t size);
+byte *CL_InflateDemo (const void *data, size_t size, size_t *outsize);
+qfileofs_t CL_DemoTell (void);
 void CL_Record_f (void);
 void CL_PlayDemo_f (void);
 void CL_TimeDemo_f (void);
+void CL_DemoParse_f (void);
 
 //
 // cl_parse.c
 //
+typedef struct
+{
+	int		modnum;
+	int		frame;
+	int		colormap;
+	int		skin;
+	int		effects;
+	vec3_t	origin;
+	vec3_t	angles;
+	int		alpha;
+	int		scale;
+	int		lerpfinish;		// -1 if not sent
+} entupdate_t;
+
+static inline int MSG_CoordSize (unsigned int flags)
+{
+	if (flags & (PRFL_FLOATCOORD|PRFL_INT32COORD))
+		return 4;
+	else if (flags & PRFL_24BITCOORD)
+		return 3;
+	else
+		return 2;
+}
+
+static inline int MSG_AngleSize (unsigned int flags)
+{
+	if (flags & PRFL_FLOATANGLE)
+		return 4;
+	else if (flags & PRFL_SHORTANGLE)
+		return 2;
+	else
+		return 1;
+}
+
+static inline float MSGR_ReadCoord (msgreader_t *r, unsigned int flags)
+{
+	if (flags & PRFL_FLOATCOORD)
+		return MSGR_ReadFloat (r);
+	else if (flags & PRFL_INT32COORD)
+		return MSGR_ReadLong (r) * (1.0 / 16.0);
+	else if (flags & PRFL_24BITCOORD)
+	{
+		int i = MSGR_ReadShort (r);
+		return i + MSGR_ReadByte (r) * (1.0/255);
+	}
+	else
+		return MSGR_ReadShort (r) * (1.0/8);
+}
+
+static inline float MSGR_ReadAngle (msgreader_t *r, unsigned int flags)
+{
+	if (flags & PRFL_FLOATANGLE)
+		return MSGR_ReadFloat (r);
+	else if (flags & PRFL_SHORTANGLE)
+		return MSGR_ReadShort (r) * (360.0 / 65536);
+	else
+		return MSGR_ReadChar (r) * (360.0 / 256);
+}
+
 void CL_ParseServerMessage (void);
+int CL_EntityUpdateSize (int bits, unsigned int protocol, unsigned int protocolflags);
+void CL_DecodeEntityUpdate (msgreader_t *r, int bits, unsigned int protocol, unsigned int protocolflags, const entity_state_t *base, entupdate_t *u);
+#ifdef DEBUG
+void CL_UpdateTest_f (void);
+#endif
 void CL_NewTranslation (int slot);
 
 //
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // cmd.c -- Quake script command processing module
 
 #include "quakedef.h"
+#include "q_ctype.h"
 
 void Cmd_ForwardToServer (void);
 
@@ -35,14 +36,74 @@ typedef struct cmdalias_s
 	struct cmdalias_s	*next;
 	char	name[MAX_ALIAS_NAME];
 	char	*value;
+	struct cmdalias_s	*hash_next;	// next alias in the same Cmd_HashName bucket
 } cmdalias_t;
 
 cmdalias_t	*cmd_alias;
 
+// commands and aliases are also indexed by a case-insensitive hash of their
+// names, so that executing a line doesn't have to walk the whole lists
+#define CMD_HASH_SIZE	1024
+
+static cmd_function_t			*cmd_hashtable[CMD_HASH_SIZE];
+static cmdalias_t				*cmd_aliashash[CMD_HASH_SIZE];
+
 qboolean	cmd_wait;
 
 //=============================================================================
 
+/*
+===============
+Cmd_HashName
+
+FNV-1a hash of the lowercase name, since lookups use q_strcasecmp
+===============
+*/
+static unsigned Cmd_HashName (const char *name)
+{
+	unsigned hash = 0x811c9dc5u;
+	while (*name)
+	{
+		hash ^= (unsigned char) q_tolower (*name++);
+		hash *= 0x01000193u;
+	}
+	return hash % CMD_HASH_SIZE;
+}
+
+/*
+===============
+Cmd_FindAlias
+
+Returns the alias with exactly the given name
+===============
+*/
+static cmdalias_t *Cmd_FindAlias (const char *name)
+{
+	cmdalias_t *a;
+	for (a = cmd_aliashash[Cmd_HashName (name)]; a; a = a->hash_next)
+		if (!strcmp (name, a->name))
+			return a;
+	return NULL;
+}
+
+/*
+===============
+Cmd_UnlinkAliasHash
+===============
+*/
+static void Cmd_UnlinkAliasHash (cmdalias_t *alias)
+{
+	cmdalias_t **link;
+	for (link = &cmd_aliashash[Cmd_HashName (alias->name)]; *link; link = &(*link)->hash_next)
+	{
+		if (*link == alias)
+		{
+			*link = alias->hash_next;
+			return;
+		}
+	}
+}
+
 /*
 ============
 Cmd_Wait_f
@@ -77,6 +138,15 @@ static void Cmd_CfgMarker_f (void)
 */
 
 sizebuf_t	cmd_text;
+static int	cmd_text_start;	// pending commands are cmd_text.data[cmd_text_start..cursize)
+
+/*
+The pending text doesn't get moved down after every command. Executed
+commands just advance cmd_text_start, and the space this frees at the front
+is reused by Cbuf_InsertText, so inserting an alias or a config file
+doesn't have to copy the rest of the buffer either. The text is only
+compacted when appending runs out of room at the end.
+*/
 
 /*
 ============
@@ -88,6 +158,21 @@ void Cbuf_Init (void)
 	SZ_Alloc (&cmd_text, 1<<18);		// space for commands and script files. spike -- was 8192, but modern configs can be _HUGE_, at least if they contain lots of comments/docs for things.
 }
 
+/*
+============
+Cbuf_Compact
+
+Moves the pending text to the start of the buffer
+============
+*/
+static void Cbuf_Compact (void)
+{
+	if (!cmd_text_start)
+		return;
+	cmd_text.cursize -= cmd_text_start;
+	memmove (cmd_text.data, cmd_text.data + cmd_text_start, cmd_text.cursize);
+	cmd_text_start = 0;
+}
 
 /*
 ============
@@ -98,24 +183,18 @@ Adds command text at the end of the buffer
 */
 void Cbuf_AddText (const char *text)
 {
-	int		l;
-
-	l = Q_strlen (text);
-
-	if (cmd_text.cursize + l >= cmd_text.maxsize)
-	{
-		Con_Printf ("Cbuf_AddText: overflow\n");
-		return;
-	}
-
-	SZ_Write (&cmd_text, text, Q_strlen (text));
+	Cbuf_AddTextLen (text, Q_strlen (text));
 }
 void Cbuf_AddTextLen (const char *text, int l)
 {
 	if (cmd_text.cursize + l >= cmd_text.maxsize)
 	{
-		Con_Printf ("Cbuf_AddText: overflow\n");
-		return;
+		Cbuf_Compact ();
+		if (cmd_text.cursize + l >= cmd_text.maxsize)
+		{
+			Con_Printf ("Cbuf_AddText: overflow\n");
+			return;
+		}
 	}
 
 	SZ_Write (&cmd_text, text, l);
@@ -128,34 +207,36 @@ Cbuf_InsertText
 
 Adds command text immediately after the current command
 Adds a \n to the text
-FIXME: actually change the command buffer to do less copying
 ============
 */
 void Cbuf_InsertText (const char *text)
 {
-	char	*temp;
-	int		templen;
+	int		len = Q_strlen (text);
+	int		pending = cmd_text.cursize - cmd_text_start;
+	char	*dst;
 
-// copy off any commands still remaining in the exec buffer
-	templen = cmd_text.cursize;
-	if (templen)
+	if (len + 1 <= cmd_text_start)
 	{
-		temp = (char *) Z_Malloc (templen);
-		Q_memcpy (temp, cmd_text.data, templen);
-		SZ_Clear (&cmd_text);
+	// fits in the space freed by already executed commands
+		cmd_text_start -= len + 1;
+		dst = (char *) cmd_text.data + cmd_text_start;
 	}
 	else
-		temp = NULL;	// shut up compiler
-
-// add the entire text of the file
-	Cbuf_AddText (text);
-	SZ_Write (&cmd_text, "\n", 1);
-// add the copied off data
-	if (templen)
 	{
-		SZ_Write (&cmd_text, temp, templen);
-		Z_Free (temp);
+		if (pending + len + 1 >= cmd_text.maxsize)
+		{
+			Con_Printf ("Cbuf_InsertText: overflow\n");
+			return;
+		}
+	// move the remaining commands up to make room
+		memmove (cmd_text.data + len + 1, cmd_text.data + cmd_text_start, pending);
+		cmd_text_start = 0;
+		cmd_text.cursize = pending + len + 1;
+		dst = (char *) cmd_text.data;
 	}
+
+	memcpy (dst, text, len);
+	dst[len] = '\n';
 }
 
 //Spike: for renderer/server isolation
@@ -173,23 +254,24 @@ Spike: reworked 'wait' for renderer/server rate independance
 */
 void Cbuf_Execute (void)
 {
-	int		i;
+	int		i, len;
 	char	*text;
 	char	line[1024];
 	int		quotes, comment;
 
-	while (cmd_text.cursize && !cmd_wait)
+	while (cmd_text.cursize > cmd_text_start && !cmd_wait)
 	{
 // find a \n or ; line break
-		text = (char *)cmd_text.data;
+		text = (char *)cmd_text.data + cmd_text_start;
+		len = cmd_text.cursize - cmd_text_start;
 
 		quotes = 0;
 		comment = 0;
-		for (i=0 ; i< cmd_text.cursize ; i++)
+		for (i=0 ; i<len ; i++)
 		{
 			if (text[i] == '"')
 				quotes++;
-			if (text[i] == '/' && text[i + 1] == '/')
+			if (text[i] == '/' && i + 1 < len && text[i + 1] == '/')
 				comment = true;
 			if (!(quotes&1) && !comment && text[i] == ';')
 				break;	// don't break if inside a quoted string
@@ -208,17 +290,16 @@ void Cbuf_Execute (void)
 			line[i] = 0;
 		}
 
-// delete the text from the command buffer and move remaining commands down
-// this is necessary because commands (exec, alias) can insert data at the
-// beginning of the text buffer
+// skip past the command. it has to be copied out first since commands
+// (exec, alias) can insert data in front of the remaining text
 
-		if (i == cmd_text.cursize)
-			cmd_text.cursize = 0;
+		if (i == len)
+			cmd_text.cursize = cmd_text_start = 0;
 		else
 		{
-			i++;
-			cmd_text.cursize -= i;
-			memmove (text, text + i, cmd_text.cursize);
+			cmd_text_start += i + 1;
+			if (cmd_text_start == cmd_text.cursize)
+				cmd_text.cursize = cmd_text_start = 0;
 		}
 
 // execute the command line
@@ -378,9 +459,9 @@ void Cmd_Alias_f (void)
 			Con_SafePrintf ("no alias commands found\n");
 		break;
 	case 2: //output current alias string
-		for (a = cmd_alias ; a ; a=a->next)
-			if (!strcmp(Cmd_Argv(1), a->name))
-				Con_Printf ("   %s: %s", a->name, a->value);
+		a = Cmd_FindAlias (Cmd_Argv(1));
+		if (a)
+			Con_Printf ("   %s: %s", a->name, a->value);
 		break;
 	default: //set alias string
 		s = Cmd_Argv(1);
@@ -391,20 +472,17 @@ void Cmd_Alias_f (void)
 		}
 
 		// if the alias already exists, reuse it
-		for (a = cmd_alias ; a ; a=a->next)
-		{
-			if (!strcmp(s, a->name))
-			{
-				Z_Free (a->value);
-				break;
-			}
-		}
-
-		if (!a)
+		a = Cmd_FindAlias (s);
+		if (a)
+			Z_Free (a->value);
+		else
 		{
+			unsigned hash = Cmd_HashName (s);
 			a = (cmdalias_t *) Z_Malloc (sizeof(cmdalias_t));
 			a->next = cmd_alias;
 			cmd_alias = a;
+			a->hash_next = cmd_aliashash[hash];
+			cmd_aliashash[hash] = a;
 		}
 		strcpy (a->name, s);
 
@@ -454,6 +532,7 @@ void Cmd_Unalias_f (void)
 					prev->next = a->next;
 				else
 					cmd_alias  = a->next;
+				Cmd_UnlinkAliasHash (a);
 
 				Z_Free (a->value);
 				Z_Free (a);
@@ -469,7 +548,7 @@ void Cmd_Unalias_f (void)
 qboolean Cmd_AliasExists (const char *aliasname)
 {
 	cmdalias_t *a;
-	for (a=cmd_alias ; a ; a=a->next)
+	for (a = cmd_aliashash[Cmd_HashName (aliasname)]; a; a = a->hash_next)
 	{
 		if (!q_strcasecmp (aliasname, a->name))
 			return true;
@@ -493,6 +572,7 @@ void Cmd_Unaliasall_f (void)
 		Z_Free(cmd_alias);
 		cmd_alias = blah;
 	}
+	memset (cmd_aliashash, 0, sizeof (cmd_aliashash));
 }
 
 /*
@@ -507,6 +587,9 @@ void Cmd_Unaliasall_f (void)
 
 static	int			cmd_argc;
 static	char		*cmd_argv[MAX_ARGS];
+// arguments are copied here instead of being allocated one by one
+static	char		cmd_argbuf[MAX_ARGS * sizeof (com_token)];
+static	size_t		cmd_argbufsize;
 static	char		cmd_null_string[] = "";
 static	const char	*cmd_args = NULL;
 
@@ -702,9 +785,15 @@ Cmd_AddArg
 */
 void Cmd_AddArg (const char *arg)
 {
+	size_t len;
+
 	if (cmd_argc < MAX_ARGS)
 	{
-		cmd_argv[cmd_argc] = Z_Strdup (arg);
+		len = strlen (arg) + 1;
+		if (cmd_argbufsize + len > sizeof (cmd_argbuf))
+			return;
+		cmd_argv[cmd_argc] = (char *) memcpy (cmd_argbuf + cmd_argbufsize, arg, len);
+		cmd_argbufsize += len;
 		cmd_argc++;
 	}
 }
@@ -718,13 +807,9 @@ Parses the given string into command line tokens.
 */
 void Cmd_TokenizeString (const char *text)
 {
-	int		i;
-
 // clear the args from the last string
-	for (i=0 ; i<cmd_argc ; i++)
-		Z_Free (cmd_argv[i]);
-
 	cmd_argc = 0;
+	cmd_argbufsize = 0;
 	cmd_args = NULL;
 
 	while (1)
@@ -755,6 +840,31 @@ void Cmd_TokenizeString (const char *text)
 	}
 }
 
+#ifndef NDEBUG
+/*
+============
+Cmd_CheckHashOrder
+
+Makes sure a hash lookup finds the same command as a walk of the main
+list, which matters when several commands share a name
+============
+*/
+static void Cmd_CheckHashOrder (const char *cmd_name)
+{
+	cmd_function_t	*cmd, *hashcmd;
+
+	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+		if (!q_strcasecmp (cmd_name, cmd->name))
+			break;
+	for (hashcmd=cmd_hashtable[Cmd_HashName (cmd_name)] ; hashcmd ; hashcmd=hashcmd->hash_next)
+		if (!q_strcasecmp (cmd_name, hashcmd->name))
+			break;
+
+	if (cmd != hashcmd)
+		Sys_Error ("Cmd_CheckHashOrder: hash bucket out of order for %s", cmd_name);
+}
+#endif
+
 /*
 ============
 Cmd_AddCommand
@@ -766,6 +876,8 @@ cmd_function_t *Cmd_AddCommand2 (const char *cmd_name, xcommand_t function, cmd_
 {
 	cmd_function_t	*cmd;
 	cmd_function_t	*cursor,*prev; //johnfitz -- sorted list insert
+	cmd_function_t	**link;
+	unsigned		hash = Cmd_HashName (cmd_name);
 
 // fail if the command is a variable name
 	if (Cvar_VariableString(cmd_name)[0])
@@ -775,7 +887,7 @@ cmd_function_t *Cmd_AddCommand2 (const char *cmd_name, xcommand_t function, cmd_
 	}
 
 // fail if the command already exists
-	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+	for (cmd=cmd_hashtable[hash] ; cmd ; cmd=cmd->hash_next)
 	{
 		if (!Q_strcmp (cmd_name, cmd->name) && cmd->srctype == srctype)
 		{
@@ -804,7 +916,7 @@ cmd_function_t *Cmd_AddCommand2 (const char *cmd_name, xcommand_t function, cmd_
 	cmd->qcinterceptable = qcinterceptable;
 
 	//johnfitz -- insert each entry in alphabetical order
-	if (cmd_functions == NULL || strcmp(cmd->name, cmd_functions->name) < 0) //insert at front
+	if (cmd_functions == NULL || strcmp(cmd->name, cmd_functions->name) <= 0) //insert at front (before any duplicates, like the rest of the list)
 	{
 		cmd->next = cmd_functions;
 		cmd_functions = cmd;
@@ -823,16 +935,34 @@ cmd_function_t *Cmd_AddCommand2 (const char *cmd_name, xcommand_t function, cmd_
 	}
 	//johnfitz
 
+	// keep each hash bucket in the same order as the main list, new duplicates go before existing ones
+	for (link = &cmd_hashtable[hash]; *link && strcmp (cmd->name, (*link)->name) > 0; link = &(*link)->hash_next)
+		;
+	cmd->hash_next = *link;
+	*link = cmd;
+
+#ifndef NDEBUG
+	Cmd_CheckHashOrder (cmd->name);
+#endif
+
 	return cmd;
 }
 void Cmd_RemoveCommand (cmd_function_t *cmd)
 {
-	cmd_function_t **link;
+	cmd_function_t **link, **hashlink;
 	for (link = &cmd_functions; *link; link = &(*link)->next)
 	{
 		if (*link == cmd)
 		{
 			*link = cmd->next;
+			for (hashlink = &cmd_hashtable[Cmd_HashName (cmd->name)]; *hashlink; hashlink = &(*hashlink)->hash_next)
+			{
+				if (*hashlink == cmd)
+				{
+					*hashlink = cmd->hash_next;
+					break;
+				}
+			}
 			free(cmd);
 			return;
 		}
@@ -849,7 +979,7 @@ cmd_function_t *Cmd_FindCommand (const char *cmd_name)
 {
 	cmd_function_t	*cmd;
 
-	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+	for (cmd=cmd_hashtable[Cmd_HashName (cmd_name)] ; cmd ; cmd=cmd->hash_next)
 		if (!q_strcasecmp (cmd_name,cmd->name))
 			return cmd;
 
@@ -872,7 +1002,6 @@ qboolean Cmd_Exists (const char *cmd_name)
 Cmd_ExecuteString
 
 A complete command line has been parsed, so try to execute it
-FIXME: lookupnoadd the token to speed search?
 ============
 */
 qboolean Cmd_ExecuteString (const char *text, cmd_source_t src)
@@ -888,7 +1017,7 @@ qboolean Cmd_ExecuteString (const char *text, cmd_source_t src)
 		return true;		// no tokens
 
 // check functions
-	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+	for (cmd=cmd_hashtable[Cmd_HashName (cmd_argv[0])] ; cmd ; cmd=cmd->hash_next)
 	{
 		if (!q_strcasecmp (cmd_argv[0],cmd->name))
 		{
@@ -915,7 +1044,7 @@ qboolean Cmd_ExecuteString (const char *text, cmd_source_t src)
 		return false;
 
 // check alias
-	for (a=cmd_alias ; a ; a=a->next)
+	for (a=cmd_aliashash[Cmd_HashName (cmd_argv[0])] ; a ; a=a->hash_next)
 	{
 		if (!q_strcasecmp (cmd_argv[0], a->name))
 		{
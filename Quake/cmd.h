@@ -92,6 +92,7 @@ typedef void (*xtabcommand_t) (const char *partial);
 typedef struct cmd_function_s
 {
 	struct cmd_function_s	*next;
+	struct cmd_function_s	*hash_next;	// next command in the same Cmd_HashName bucket
 	const char		*name;
 	xcommand_t		function;
 	xtabcommand_t	completion;
@@ -932,6 +932,56 @@ const char *MSG_ReadString (void)
 	return string;
 }
 
+/*
+==================
+MSG_BeginSection
+
+Returns false without consuming anything if fewer than size bytes are left
+==================
+*/
+qboolean MSG_BeginSection (msgreader_t *r, int size)
+{
+	if (size < 0 || msg_readcount + size > net_message.cursize)
+		return false;
+
+	MSGR_Init (r, net_message.data + msg_readcount, size);
+	msg_readcount += size;
+
+	return true;
+}
+
+/*
+==================
+MSGR_ReadString
+
+Reads a null-terminated string, truncating it to fit buf (which may be NULL to skip it).
+Returns false and consumes everything if there's no terminator
+==================
+*/
+qboolean MSGR_ReadString (msgreader_t *r, char *buf, size_t size)
+{
+	const byte	*term = (const byte *) memchr (r->data, 0, MSGR_Remaining (r));
+	size_t		len;
+
+	if (!term)
+	{
+		if (buf && size)
+			buf[0] = 0;
+		r->data = r->end;
+		return false;
+	}
+
+	if (buf && size)
+	{
+		len = q_min ((size_t) (term - r->data), size - 1);
+		memcpy (buf, r->data, len);
+		buf[len] = 0;
+	}
+	r->data = term + 1;
+
+	return true;
+}
+
 //johnfitz -- original behavior, 13.3 fixed point coords, max range +-4096
 float MSG_ReadCoord16 (void)
 {
@@ -1863,27 +1913,18 @@ qfileofs_t COM_filelength (FILE *f)
 
 /*
 ===========
-COM_FindFile
+FS_FindFile
 
-Finds the file in the search path.
-Sets com_filesize and one of handle or file
-If neither of file or handle is set, this
-can be used for detecting a file's presence.
+Fills in the location of the given file in the search path.
+Doesn't touch any global state, so it's safe to call from any thread.
 ===========
 */
-static int COM_FindFile (const char *filename, int *handle, FILE **file,
-							unsigned int *path_id)
+qboolean FS_FindFile (const char *filename, fileloc_t *loc)
 {
 	searchpath_t	*search;
-	char		netpath[MAX_OSPATH];
 	pack_t		*pak;
 	int			i;
 
-	if (file && handle)
-		Sys_Error ("COM_FindFile: both handle and file set");
-
-	file_from_pak = 0;
-
 //
 // search through the path, one element at a time
 //
@@ -1897,27 +1938,12 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file,
 				if (strcmp(pak->files[i].name, filename) != 0)
 					continue;
 				// found it!
-				com_filesize = pak->files[i].filelen;
-				file_from_pak = 1;
-				if (path_id)
-					*path_id = search->path_id;
-				if (handle)
-				{
-					*handle = pak->handle;
-					Sys_FileSeek (pak->handle, pak->files[i].filepos);
-					return com_filesize;
-				}
-				else if (file)
-				{ /* open a new file on the pakfile */
-					*file = Sys_fopen (pak->filename, "rb");
-					if (*file)
-						fseek (*file, pak->files[i].filepos, SEEK_SET);
-					return com_filesize;
-				}
-				else /* for COM_FileExists() */
-				{
-					return com_filesize;
-				}
+				loc->pack = pak;
+				loc->path_id = search->path_id;
+				loc->offset = pak->files[i].filepos;
+				loc->size = pak->files[i].filelen;
+				q_strlcpy (loc->path, pak->filename, sizeof (loc->path));
+				return true;
 			}
 		}
 		else	/* check a file in the directory tree */
@@ -1928,69 +1954,230 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file,
 					continue;
 			}
 
-			q_snprintf (netpath, sizeof(netpath), "%s/%s",search->filename, filename);
-			if (! (Sys_FileType(netpath) & FS_ENT_FILE))
+			q_snprintf (loc->path, sizeof (loc->path), "%s/%s",search->filename, filename);
+			loc->size = Sys_FileSize (loc->path);
+			if (loc->size < 0)
 				continue;
 
-			if (path_id)
-				*path_id = search->path_id;
-			if (handle)
-			{
-				com_filesize = Sys_FileOpenRead (netpath, &i);
-				*handle = i;
-				return com_filesize;
-			}
-			else if (file)
-			{
-				*file = Sys_fopen (netpath, "rb");
-				com_filesize = (*file == NULL) ? -1 : COM_filelength (*file);
-				return com_filesize;
-			}
-			else
+			loc->pack = NULL;
+			loc->path_id = search->path_id;
+			loc->offset = 0;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+===========
+FS_ReadFile
+
+Reads count bytes starting at ofs without using a shared file position.
+===========
+*/
+int FS_ReadFile (const fileloc_t *loc, qfileofs_t ofs, void *dest, int count)
+{
+	sysfile_t	*file;
+	int			nread;
+
+	if (ofs < 0 || count < 0 || ofs > loc->size)
+		return -1;
+	if (count > loc->size - ofs)
+		count = (int) (loc->size - ofs);
+
+	if (loc->pack)
+	{
+		const pack_t *pak = loc->pack;
+		if (pak->data)
+		{
+			if (loc->offset < 0 || (size_t) loc->offset + (size_t) loc->size > pak->datasize)
+				return -1;
+			memcpy (dest, pak->data + loc->offset + ofs, count);
+			return count;
+		}
+		if (!pak->file)
+			return -1;
+		return Sys_FileReadAt (pak->file, loc->offset + ofs, dest, count);
+	}
+
+	file = Sys_FileOpenShared (loc->path);
+	if (!file)
+		return -1;
+	nread = Sys_FileReadAt (file, ofs, dest, count);
+	Sys_FileCloseShared (file);
+
+	return nread;
+}
+
+/*
+===========
+FS_MapFile
+
+Gives read-only access to a file without copying it. Files inside a mapped
+pak point directly into the pak's mapping, which stays valid until the game
+directories change; loose files are mapped on their own. If mapping isn't
+possible the file is read into a private buffer instead, so callers never
+need a separate code path. Release the view with COM_UnmapFile.
+===========
+*/
+qboolean FS_MapFile (const fileloc_t *loc, fileview_t *view)
+{
+	memset (view, 0, sizeof (*view));
+
+	if (loc->size > INT_MAX)
+		return false;
+	view->size = (int) loc->size;
+
+	if (loc->pack && loc->pack->data)
+	{
+		if (loc->offset < 0 || (size_t) loc->offset + (size_t) loc->size > loc->pack->datasize)
+			return false;
+		view->data = loc->pack->data + loc->offset;
+		return true;
+	}
+
+	if (!loc->pack)
+	{
+		view->mapping = Sys_MapFile (loc->path, &view->mapsize);
+		if (view->mapping)
+		{
+			if (view->mapsize > INT_MAX)
 			{
-				return 0; /* dummy valid value for COM_FileExists() */
+				COM_UnmapFile (view);
+				return false;
 			}
+			view->data = (const byte *) view->mapping;
+			view->size = (int) view->mapsize;
+			return true;
 		}
+		// empty files can't be mapped
 	}
 
-	if (developer.value)
-	{
-		const char *ext = COM_FileGetExtension (filename);
-
-		if (strcmp(ext, "pcx") != 0 &&
-			strcmp(ext, "tga") != 0 &&
-			strcmp(ext, "png") != 0 &&
-			strcmp(ext, "jpg") != 0 &&
-			strcmp(ext, "lmp") != 0 &&
-			// music formats
-			strcmp (ext, "ogg") != 0 &&
-			strcmp (ext, "opus") != 0 &&
-			strcmp (ext, "flac") != 0 &&
-			strcmp (ext, "wav") != 0 &&
-			strcmp (ext, "it") != 0 &&
-			strcmp (ext, "s3m") != 0 &&
-			strcmp (ext, "xm") != 0 &&
-			strcmp (ext, "mod") != 0 &&
-			strcmp (ext, "umx") != 0 &&
-			// alternate model formats
-			strcmp(ext, "md5mesh") != 0 &&
-			strcmp (ext, "md3") != 0 &&
-			strcmp (ext, "skin") != 0 &&
-			// optional map files
-			strcmp(ext, "lit") != 0 &&
-			strcmp(ext, "vis") != 0 &&
-			strcmp(ext, "ent") != 0)
-			Con_DPrintf ("FindFile: can't find %s\n", filename);
-		else
-			Con_DPrintf2 ("FindFile: can't find %s\n", filename);
+	view->buffer = malloc (view->size + 1);
+	if (!view->buffer)
+		Sys_Error ("FS_MapFile: not enough space for %s", loc->path);
+	if (FS_ReadFile (loc, 0, view->buffer, view->size) != view->size)
+	{
+		COM_UnmapFile (view);
+		return false;
+	}
+	view->data = (const byte *) view->buffer;
+
+	return true;
+}
+
+/*
+===========
+COM_ReportMissingFile
+===========
+*/
+static void COM_ReportMissingFile (const char *filename)
+{
+	const char *ext;
+
+	if (!developer.value)
+		return;
+
+	ext = COM_FileGetExtension (filename);
+	if (strcmp(ext, "pcx") != 0 &&
+		strcmp(ext, "tga") != 0 &&
+		strcmp(ext, "png") != 0 &&
+		strcmp(ext, "jpg") != 0 &&
+		strcmp(ext, "lmp") != 0 &&
+		// music formats
+		strcmp (ext, "ogg") != 0 &&
+		strcmp (ext, "opus") != 0 &&
+		strcmp (ext, "flac") != 0 &&
+		strcmp (ext, "wav") != 0 &&
+		strcmp (ext, "it") != 0 &&
+		strcmp (ext, "s3m") != 0 &&
+		strcmp (ext, "xm") != 0 &&
+		strcmp (ext, "mod") != 0 &&
+		strcmp (ext, "umx") != 0 &&
+		// alternate model formats
+		strcmp(ext, "md5mesh") != 0 &&
+		strcmp (ext, "md3") != 0 &&
+		strcmp (ext, "skin") != 0 &&
+		// optional map files
+		strcmp(ext, "lit") != 0 &&
+		strcmp(ext, "vis") != 0 &&
+		strcmp(ext, "ent") != 0)
+		Con_DPrintf ("FindFile: can't find %s\n", filename);
+	else
+		Con_DPrintf2 ("FindFile: can't find %s\n", filename);
+}
+
+/*
+===========
+COM_FindFile
+
+Finds the file in the search path.
+Sets com_filesize and one of handle or file
+If neither of file or handle is set, this
+can be used for detecting a file's presence.
+===========
+*/
+static int COM_FindFile (const char *filename, int *handle, FILE **file,
+							unsigned int *path_id)
+{
+	fileloc_t	loc;
+	int			i;
+
+	if (file && handle)
+		Sys_Error ("COM_FindFile: both handle and file set");
+
+	file_from_pak = 0;
+
+	if (!FS_FindFile (filename, &loc))
+	{
+		COM_ReportMissingFile (filename);
+		if (handle)
+			*handle = -1;
+		if (file)
+			*file = NULL;
+		com_filesize = -1;
+		return com_filesize;
+	}
+
+	if (path_id)
+		*path_id = loc.path_id;
+
+	if (loc.pack)
+	{
+		com_filesize = loc.size;
+		file_from_pak = 1;
+		if (handle)
+		{
+			*handle = loc.pack->handle;
+			Sys_FileSeek (loc.pack->handle, loc.offset);
+		}
+		else if (file)
+		{ /* open a new file on the pakfile */
+			*file = Sys_fopen (loc.path, "rb");
+			if (*file)
+				fseek (*file, loc.offset, SEEK_SET);
+		}
+		/* else for COM_FileExists() */
+		return com_filesize;
 	}
 
 	if (handle)
-		*handle = -1;
-	if (file)
-		*file = NULL;
-	com_filesize = -1;
-	return com_filesize;
+	{
+		com_filesize = Sys_FileOpenRead (loc.path, &i);
+		*handle = i;
+		return com_filesize;
+	}
+	else if (file)
+	{
+		*file = Sys_fopen (loc.path, "rb");
+		com_filesize = (*file == NULL) ? -1 : COM_filelength (*file);
+		return com_filesize;
+	}
+	else
+	{
+		return 0; /* dummy valid value for COM_FileExists() */
+	}
 }
 
 
@@ -2007,6 +2194,30 @@ qboolean COM_FileExists (const char *filename, unsigned int *path_id)
 	return (ret == -1) ? false : true;
 }
 
+/*
+===========
+COM_FileInfo
+
+Returns the size of a file in the quake filesystem, or -1 if it's not found.
+Also reports its path_id and modification time (the pak's for packed files)
+so that callers can tell if a previously loaded copy is still current.
+===========
+*/
+int COM_FileInfo (const char *filename, unsigned int *path_id, time_t *mtime)
+{
+	fileloc_t	loc;
+
+	if (!FS_FindFile (filename, &loc))
+		return -1;
+
+	if (path_id)
+		*path_id = loc.path_id;
+	if (mtime && !Sys_GetFileTime (loc.path, mtime))
+		*mtime = 0;
+
+	return (int) loc.size;
+}
+
 /*
 ===========
 COM_OpenFile
@@ -2053,6 +2264,57 @@ void COM_CloseFile (int h)
 }
 
 
+/*
+===========
+COM_MapFile
+
+Wrapper around FS_MapFile that also sets com_filesize and file_from_pak.
+===========
+*/
+qboolean COM_MapFile (const char *path, fileview_t *view, unsigned int *path_id)
+{
+	fileloc_t	loc;
+
+	memset (view, 0, sizeof (*view));
+	file_from_pak = 0;
+	com_filesize = -1;
+
+	if (!FS_FindFile (path, &loc))
+	{
+		COM_ReportMissingFile (path);
+		return false;
+	}
+
+	if (path_id)
+		*path_id = loc.path_id;
+
+	if (!FS_MapFile (&loc, view))
+	{
+		if (loc.pack || loc.size > INT_MAX)
+			Sys_Error ("COM_MapFile: Error reading %s", path);
+		return false;
+	}
+
+	file_from_pak = loc.pack != NULL;
+	com_filesize = view->size;
+	LoadProf_AddFile (view->size);
+
+	return true;
+}
+
+/*
+===========
+COM_UnmapFile
+===========
+*/
+void COM_UnmapFile (fileview_t *view)
+{
+	if (view->mapping)
+		Sys_UnmapFile (view->mapping, view->mapsize);
+	free (view->buffer);
+	memset (view, 0, sizeof (*view));
+}
+
 /*
 ============
 COM_LoadFile
@@ -2066,17 +2328,17 @@ Allways appends a 0 byte.
 
 byte *COM_LoadFile (const char *path, int usehunk, unsigned int *path_id)
 {
-	int		h;
+	fileview_t	view;
 	byte	*buf;
 	char	base[32];
-	int	len, nread;
+	int	len;
 
 	buf = NULL;	// quiet compiler warning
 
 // look for it in the filesystem or pack files
-	len = COM_OpenFile (path, &h, path_id);
-	if (h == -1)
+	if (!COM_MapFile (path, &view, path_id))
 		return NULL;
+	len = view.size;
 
 // extract the filename base name for hunk tag
 	COM_FileBase (path, base, sizeof(base));
@@ -2096,12 +2358,9 @@ byte *COM_LoadFile (const char *path, int usehunk, unsigned int *path_id)
 	if (!buf)
 		Sys_Error ("COM_LoadFile: not enough space for %s", path);
 
+	memcpy (buf, view.data, len);
 	((byte *)buf)[len] = 0;
-
-	nread = Sys_FileRead (h, buf, len);
-	COM_CloseFile (h);
-	if (nread != len)
-		Sys_Error ("COM_LoadFile: Error reading %s", path);
+	COM_UnmapFile (&view);
 
 	return buf;
 }
@@ -2301,6 +2560,12 @@ static pack_t *COM_LoadPackFile (const char *packfile)
 	pack->handle = packhandle;
 	pack->numfiles = numpackfiles;
 	pack->files = newfiles;
+	// map the whole pak once so that loaders can read from it without
+	// going through (and seeking) the shared handle. if that fails, e.g.
+	// due to lack of address space, fall back to positional reads.
+	pack->data = (const byte *) Sys_MapFile (packfile, &pack->datasize);
+	if (!pack->data)
+		pack->file = Sys_FileOpenShared (packfile);
 
 	//Sys_Printf ("Added packfile %s (%i files)\n", packfile, numpackfiles);
 	return pack;
@@ -2447,6 +2712,8 @@ void COM_ResetGameDirectories(const char *newgamedirs)
 		if (com_searchpaths->pack)
 		{
 			Sys_FileClose (com_searchpaths->pack->handle);
+			Sys_UnmapFile (com_searchpaths->pack->data, com_searchpaths->pack->datasize);
+			Sys_FileCloseShared (com_searchpaths->pack->file);
 			Z_Free (com_searchpaths->pack->files);
 			Z_Free (com_searchpaths->pack);
 		}
@@ -2564,8 +2831,9 @@ void COM_SwitchGame (const char *paths)
 	//Write config file
 	Host_WriteConfiguration ();
 
-	// stop parsing map files before changing file system search paths
+	// stop parsing map files and streaming textures before changing file system search paths
 	ExtraMaps_Clear ();
+	TexMgr_CancelStreaming ();
 
 	COM_ResetGameDirectories(paths);
 
@@ -3544,6 +3812,228 @@ unsigned COM_HashBlock (const void *data, size_t size)
 	return hash;
 }
 
+/*
+===============================================================================
+
+DEFLATE
+
+Minimal raw deflate encoder (greedy LZ77 matching, a single block with
+the fixed Huffman codes), decoded with miniz's tinfl. Good enough for
+small repetitive data such as network messages.
+
+===============================================================================
+*/
+
+#define DEFLATE_WINDOW		32768
+#define DEFLATE_HASH_BITS	15
+#define DEFLATE_MAX_CHAIN	32
+#define DEFLATE_MIN_MATCH	3
+#define DEFLATE_MAX_MATCH	258
+
+typedef struct
+{
+	byte		*out;		// VEC
+	uint32_t	bitbuf;
+	int			bitcount;
+} deflatestate_t;
+
+static const unsigned short deflate_lenbase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const byte deflate_lenextra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const unsigned short deflate_distbase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const byte deflate_distextra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+static void Deflate_PutBits (deflatestate_t *s, uint32_t bits, int count)
+{
+	s->bitbuf |= bits << s->bitcount;
+	s->bitcount += count;
+	while (s->bitcount >= 8)
+	{
+		VEC_PUSH (s->out, (byte) s->bitbuf);
+		s->bitbuf >>= 8;
+		s->bitcount -= 8;
+	}
+}
+
+// Huffman codes are stored starting with the most significant bit
+static void Deflate_PutCode (deflatestate_t *s, uint32_t code, int len)
+{
+	uint32_t rev = 0;
+	int i;
+	for (i = 0; i < len; i++, code >>= 1)
+		rev = (rev << 1) | (code & 1);
+	Deflate_PutBits (s, rev, len);
+}
+
+static void Deflate_PutSymbol (deflatestate_t *s, int sym)
+{
+	if (sym < 144)
+		Deflate_PutCode (s, 0x30 + sym, 8);
+	else if (sym < 256)
+		Deflate_PutCode (s, 0x190 + sym - 144, 9);
+	else if (sym < 280)
+		Deflate_PutCode (s, sym - 256, 7);
+	else
+		Deflate_PutCode (s, 0xc0 + sym - 280, 8);
+}
+
+static void Deflate_PutMatch (deflatestate_t *s, int len, int dist)
+{
+	int i;
+
+	for (i = countof (deflate_lenbase) - 1; deflate_lenbase[i] > len; i--)
+		;
+	Deflate_PutSymbol (s, 257 + i);
+	Deflate_PutBits (s, len - deflate_lenbase[i], deflate_lenextra[i]);
+
+	for (i = countof (deflate_distbase) - 1; deflate_distbase[i] > dist; i--)
+		;
+	Deflate_PutCode (s, i, 5);
+	Deflate_PutBits (s, dist - deflate_distbase[i], deflate_distextra[i]);
+}
+
+static unsigned Deflate_Hash (const byte *p)
+{
+	return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+/*
+================
+COM_Deflate
+
+Compresses a memory block into a raw deflate stream.
+Returns a malloc'ed buffer, the caller is responsible for freeing it.
+================
+*/
+byte *COM_Deflate (const void *data, size_t size, size_t *outsize)
+{
+	const byte		*in = (const byte *) data;
+	deflatestate_t	s;
+	int				*head, *prev;
+	size_t			pos, i;
+	byte			*out;
+
+	head = (int *) malloc (sizeof (int) * (1 << DEFLATE_HASH_BITS));
+	prev = (int *) malloc (sizeof (int) * DEFLATE_WINDOW);
+	if (!head || !prev)
+		Sys_Error ("COM_Deflate: out of memory");
+	for (i = 0; i < (1 << DEFLATE_HASH_BITS); i++)
+		head[i] = -1;
+
+	memset (&s, 0, sizeof (s));
+	Deflate_PutBits (&s, 1, 1);	// final block
+	Deflate_PutBits (&s, 1, 2);	// fixed Huffman codes
+
+	for (pos = 0; pos < size; )
+	{
+		int bestlen = 0, bestdist = 0;
+
+		if (pos + DEFLATE_MIN_MATCH <= size)
+		{
+			unsigned	h = Deflate_Hash (in + pos);
+			int			cand = head[h];
+			int			chain = DEFLATE_MAX_CHAIN;
+			int			maxlen = (int) q_min (size - pos, (size_t) DEFLATE_MAX_MATCH);
+
+			while (cand >= 0 && pos - cand <= DEFLATE_WINDOW && chain-- > 0)
+			{
+				int len = 0, next;
+				while (len < maxlen && in[cand + len] == in[pos + len])
+					len++;
+				if (len > bestlen)
+				{
+					bestlen = len;
+					bestdist = (int)(pos - cand);
+					if (len == maxlen)
+						break;
+				}
+				next = prev[cand & (DEFLATE_WINDOW - 1)];
+				if (next >= cand)
+					break;
+				cand = next;
+			}
+
+			prev[pos & (DEFLATE_WINDOW - 1)] = head[h];
+			head[h] = (int) pos;
+		}
+
+		if (bestlen >= DEFLATE_MIN_MATCH)
+		{
+			Deflate_PutMatch (&s, bestlen, bestdist);
+			for (i = 1; i < (size_t) bestlen; i++)
+			{
+				size_t p = pos + i;
+				if (p + DEFLATE_MIN_MATCH <= size)
+				{
+					unsigned h = Deflate_Hash (in + p);
+					prev[p & (DEFLATE_WINDOW - 1)] = head[h];
+					head[h] = (int) p;
+				}
+			}
+			pos += bestlen;
+		}
+		else
+		{
+			Deflate_PutSymbol (&s, in[pos]);
+			pos++;
+		}
+	}
+
+	Deflate_PutSymbol (&s, 256);	// end of block
+	if (s.bitcount > 0)
+		Deflate_PutBits (&s, 0, 8 - s.bitcount);
+
+	free (head);
+	free (prev);
+
+	*outsize = VEC_SIZE (s.out);
+	out = (byte *) malloc (q_max (*outsize, (size_t) 1));
+	if (!out)
+		Sys_Error ("COM_Deflate: out of memory");
+	if (*outsize)
+		memcpy (out, s.out, *outsize);
+	VEC_FREE (s.out);
+
+	return out;
+}
+
+/*
+================
+COM_Inflate
+
+Decompresses a raw deflate stream into a buffer of exactly outsize bytes.
+Returns false if the data is corrupt or doesn't match the expected size.
+================
+*/
+qboolean COM_Inflate (const void *data, size_t size, void *out, size_t outsize)
+{
+	tinfl_decompressor	*inflator;
+	tinfl_status		status;
+	size_t				insize = size;
+	size_t				produced = outsize;
+
+	inflator = (tinfl_decompressor *) malloc (sizeof (*inflator));
+	if (!inflator)
+		Sys_Error ("COM_Inflate: out of memory");
+	tinfl_init (inflator);
+	status = tinfl_decompress (inflator, (const mz_uint8 *) data, &insize, (mz_uint8 *) out, (mz_uint8 *) out, &produced,
+		TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+	free (inflator);
+
+	return status == TINFL_STATUS_DONE && produced == outsize;
+}
+
 static size_t mz_zip_file_read_func(void *opaque, mz_uint64 ofs, void *buf, size_t n)
 {
 	if (SDL_RWseek((SDL_RWops*)opaque, (Sint64)ofs, RW_SEEK_SET) < 0)
@@ -242,6 +242,81 @@ float MSG_ReadCoord (unsigned int flags);
 float MSG_ReadAngle (unsigned int flags);
 float MSG_ReadAngle16 (unsigned int flags); //johnfitz
 
+// bulk reader: a section is a range of bytes checked once up front,
+// the MSGR_Read* functions then walk it without any further bounds checks.
+// MSG_BeginSection takes a section from net_message, MSGR_BeginSection
+// takes one from another reader (e.g. a demo frame held in memory)
+typedef struct msgreader_s
+{
+	const byte	*data;
+	const byte	*end;
+} msgreader_t;
+
+qboolean MSG_BeginSection (msgreader_t *r, int size);
+qboolean MSGR_ReadString (msgreader_t *r, char *buf, size_t size);
+
+static inline void MSGR_Init (msgreader_t *r, const void *data, int size)
+{
+	r->data = (const byte *) data;
+	r->end = r->data + size;
+}
+
+static inline int MSGR_Remaining (const msgreader_t *r)
+{
+	return (int) (r->end - r->data);
+}
+
+// returns false without consuming anything if fewer than size bytes are left
+static inline qboolean MSGR_BeginSection (msgreader_t *r, msgreader_t *section, int size)
+{
+	if (size < 0 || size > MSGR_Remaining (r))
+		return false;
+	MSGR_Init (section, r->data, size);
+	r->data += size;
+	return true;
+}
+
+static inline void MSGR_Skip (msgreader_t *r, int count)
+{
+	r->data += count;
+}
+
+static inline int MSGR_ReadChar (msgreader_t *r)
+{
+	return (signed char) *r->data++;
+}
+
+static inline int MSGR_ReadByte (msgreader_t *r)
+{
+	return *r->data++;
+}
+
+static inline int MSGR_ReadShort (msgreader_t *r)
+{
+	int c = (short) (r->data[0] | (r->data[1] << 8));
+	r->data += 2;
+	return c;
+}
+
+static inline int MSGR_ReadLong (msgreader_t *r)
+{
+	int c = (int) ((uint32_t) r->data[0] | ((uint32_t) r->data[1] << 8) | ((uint32_t) r->data[2] << 16) | ((uint32_t) r->data[3] << 24));
+	r->data += 4;
+	return c;
+}
+
+static inline float MSGR_ReadFloat (msgreader_t *r)
+{
+	union
+	{
+		int		l;
+		float	f;
+	} dat;
+
+	dat.l = MSGR_ReadLong (r);
+	return dat.f;
+}
+
 //============================================================================
 
 void Q_memset (void *dest, int fill, size_t count);
@@ -334,6 +409,7 @@ const char *COM_FileGetExtension (const char *in); /* doesn't return NULL */
 void COM_ExtractExtension (const char *in, char *out, size_t outsize);
 char *COM_TempSuffix (unsigned seq);
 void COM_CreatePath (char *path);
+qfileofs_t COM_filelength (FILE *f);
 
 // Describes the given duration, e.g. "3 minutes"
 void COM_DescribeDuration (char *out, size_t outsize, double seconds);
@@ -347,6 +423,9 @@ char *COM_TintString (const char *in, char *out, size_t outsize);
 unsigned COM_HashString (const char *str);
 unsigned COM_HashBlock (const void *data, size_t size);
 
+byte *COM_Deflate (const void *data, size_t size, size_t *outsize);
+qboolean COM_Inflate (const void *data, size_t size, void *out, size_t outsize);
+
 // localization support for 2021 rerelease version:
 void LOC_Init (void);
 void LOC_Shutdown (void);
@@ -383,6 +462,9 @@ typedef struct pack_s
 	int		handle;
 	int		numfiles;
 	packfile_t	*files;
+	const byte	*data;		// read-only mapping of the whole pak, or NULL
+	size_t		datasize;
+	sysfile_t	*file;		// for positional reads if the pak isn't mapped
 } pack_t;
 
 typedef struct searchpath_s
@@ -414,6 +496,7 @@ qboolean COM_WriteFile_OSPath (const char *filename, const void *data, size_t le
 int COM_OpenFile (const char *filename, int *handle, unsigned int *path_id);
 int COM_FOpenFile (const char *filename, FILE **file, unsigned int *path_id);
 qboolean COM_FileExists (const char *filename, unsigned int *path_id);
+int COM_FileInfo (const char *filename, unsigned int *path_id, time_t *mtime);
 void COM_CloseFile (int h);
 
 // these procedures open a file using COM_FindFile and loads it into a proper
@@ -424,6 +507,42 @@ byte *COM_LoadHunkFile (const char *path, unsigned int *path_id);
 byte *COM_LoadMallocFile (const char *path, unsigned int *path_id);
 	// allocates the buffer on the system mem (malloc).
 
+// Read-only view of a file in the quake filesystem. Files inside a pak point
+// straight into the pak's mapping, loose files get a mapping of their own.
+// The data is NOT '\0'-terminated and must never be written to.
+typedef struct fileview_s
+{
+	const byte	*data;
+	int			size;
+	const void	*mapping;	// private mapping to release, if any
+	size_t		mapsize;
+	void		*buffer;	// malloc'ed copy when the file couldn't be mapped
+} fileview_t;
+
+qboolean COM_MapFile (const char *path, fileview_t *view, unsigned int *path_id);
+void COM_UnmapFile (fileview_t *view);
+
+// Re-entrant file system access. A lookup fills in an immutable location
+// record, and reads through it neither use nor modify any global state
+// (com_filesize, file_from_pak, the pak handles), so these can be called
+// from any thread as long as the search paths don't change meanwhile.
+// The COM_* functions above are wrappers around these.
+typedef struct fileloc_s
+{
+	const pack_t	*pack;		// NULL for loose files
+	unsigned int	path_id;
+	int				offset;		// start of the file inside the pak
+	qfileofs_t		size;
+	char			path[MAX_OSPATH];	// OS path of the loose file or pak
+} fileloc_t;
+
+qboolean FS_FindFile (const char *filename, fileloc_t *loc);
+	// returns false if the file isn't found
+int FS_ReadFile (const fileloc_t *loc, qfileofs_t ofs, void *dest, int count);
+	// returns the number of bytes read starting at ofs, or -1 on error
+qboolean FS_MapFile (const fileloc_t *loc, fileview_t *view);
+	// release the view with COM_UnmapFile
+
 // Opens the given path directly, ignoring search paths.
 // Returns NULL on failure, or else a '\0'-terminated malloc'ed buffer.
 // Loads in "t" mode so CRLF to LF translation is performed on Windows.
@@ -57,6 +57,25 @@ int		con_current;		// where next message will be printed
 int		con_x;				// offset in current line for next print
 char		*con_text = NULL;
 
+// cached glyph runs for the visible lines, rebuilt only when a line changes
+typedef struct
+{
+	int			line;
+	int			epoch;
+	unsigned	stamp;
+	int			len;		// length without trailing spaces
+	int			numglyphs;
+	drawglyph_t	*glyphs;
+} conrun_t;
+
+static conrun_t		*con_runs;
+static drawglyph_t	*con_runglyphs;
+static int			con_numruns;
+static int			con_runwidth;
+static unsigned		*con_linestamp;	// bumped whenever a line in con_text changes
+static int			con_linestampsize;
+static int			con_epoch;		// bumped when the whole buffer changes
+
 static float	con_scrollspeed;
 static float	con_scrolldelta;
 
@@ -785,6 +804,7 @@ static void Con_Clear_f (void)
 
 	if (con_text)
 		Q_memset (con_text, ' ', con_buffersize); //johnfitz -- con_buffersize replaces CON_TEXTSIZE
+	con_epoch++;
 
 	con_backscroll = 0; //johnfitz -- if console is empty, being scrolled up is confusing
 
@@ -954,6 +974,22 @@ void Con_RecalcOffset (conofs_t *ofs, int oldnumlines)
 }
 
 
+/*
+================
+Con_AllocLineStamps
+================
+*/
+static void Con_AllocLineStamps (void)
+{
+	if (con_totallines <= con_linestampsize)
+		return;
+	free (con_linestamp);
+	con_linestamp = (unsigned *) calloc (con_totallines, sizeof (con_linestamp[0]));
+	if (!con_linestamp)
+		Sys_Error ("Con_AllocLineStamps: out of memory on %d lines", con_totallines);
+	con_linestampsize = con_totallines;
+}
+
 /*
 ================
 Con_CheckResize
@@ -1003,6 +1039,9 @@ void Con_CheckResize (void)
 
 	Hunk_FreeToLowMark (mark); //johnfitz
 
+	Con_AllocLineStamps ();
+	con_epoch++;
+
 	for (i = 0; i < (int) VEC_SIZE (con_links); i++)
 	{
 		conlink_t *link = con_links[i];
@@ -1074,6 +1113,7 @@ void Con_Init (void)
 	con_backscroll = 0;
 	con_current = con_totallines - 1;
 	//johnfitz
+	Con_AllocLineStamps ();
 
 	Con_Printf ("Console initialized.\n");
 
@@ -1110,6 +1150,7 @@ static void Con_Linefeed (void)
 	con_x = 0;
 	con_current++;
 	Q_memset (&con_text[(con_current%con_totallines)*con_linewidth], ' ', con_linewidth);
+	con_linestamp[con_current%con_totallines]++;
 }
 
 /*
@@ -1203,6 +1244,7 @@ static void Con_Print (const char *txt)
 		default:	// display character and advance
 			y = con_current % con_totallines;
 			con_text[y*con_linewidth+con_x] = c | mask;
+			con_linestamp[y]++;
 			con_x++;
 			if (con_x >= con_linewidth)
 				con_x = 0;
@@ -1214,9 +1256,221 @@ static void Con_Print (const char *txt)
 
 // borrowed from uhexen2 by S.A. for new procs, LOG_Init, LOG_Close
 
+/*
+Messages are copied to a ring buffer and written out by a background
+thread, so a slow disk never stalls the frame. The thread wakes up every
+LOG_FLUSH_MS, or sooner once the buffer is half full. If the disk can't
+keep up and the buffer fills, new messages are dropped and counted, and
+a note with the count is written once there's room again.
+
+Every line gets a timestamp. With -condebugsize <MB> and/or
+-condebugrotate <minutes> the log is rotated to qconsole.1.log ...
+qconsole.<LOG_MAX_ROTATIONS>.log.
+*/
+
+#define LOG_RING_SIZE		(1024 * 1024)
+#define LOG_FLUSH_MS		250
+#define LOG_MAX_ROTATIONS	5
+
 static char	logfilename[MAX_OSPATH];	// current logfile name
 static int	log_fd = -1;			// log file descriptor
 
+static struct
+{
+	SDL_Thread		*thread;
+	SDL_mutex		*mutex;
+	SDL_cond		*cond;
+	char			*ring;
+	size_t			head;		// producer position
+	size_t			tail;		// writer position
+	qboolean		quit;
+	qboolean		linestart;
+	int				dropped;
+	int64_t			written;	// bytes in the current file
+	int64_t			maxsize;	// rotate after this many bytes (0 = never)
+	double			maxage;		// rotate after this many seconds (0 = never)
+	double			opentime;
+} log_writer;
+
+/*
+================
+LOG_Write
+
+Writes directly to the log file, only called by the writer (or when there's no writer thread)
+================
+*/
+static void LOG_Write (const char *data, size_t size)
+{
+	if (log_fd == -1 || !size)
+		return;
+
+	if (write (log_fd, data, size) < 0)
+	{
+		close (log_fd);
+		log_fd = -1;
+		fprintf (stderr, "Error writing to log file\n");
+		return;
+	}
+
+	log_writer.written += size;
+}
+
+/*
+================
+LOG_Rotate
+
+Shifts qconsole.log -> qconsole.1.log -> ... and starts a new file
+================
+*/
+static void LOG_Rotate (void)
+{
+	char	oldname[MAX_OSPATH];
+	char	newname[MAX_OSPATH];
+	char	base[MAX_OSPATH];
+	int		i;
+
+	if (log_fd == -1)
+		return;
+
+	close (log_fd);
+	log_fd = -1;
+
+	COM_StripExtension (logfilename, base, sizeof (base));
+	for (i = LOG_MAX_ROTATIONS; i > 0; i--)
+	{
+		if (i > 1)
+			q_snprintf (oldname, sizeof (oldname), "%s.%d.log", base, i - 1);
+		else
+			q_strlcpy (oldname, logfilename, sizeof (oldname));
+		q_snprintf (newname, sizeof (newname), "%s.%d.log", base, i);
+		Sys_remove (newname);
+		Sys_rename (oldname, newname);
+	}
+
+	log_fd = open (logfilename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (log_fd == -1)
+		fprintf (stderr, "Error: Unable to create log file %s\n", logfilename);
+
+	log_writer.written = 0;
+	log_writer.opentime = Sys_DoubleTime ();
+}
+
+/*
+================
+LOG_CheckRotation
+================
+*/
+static void LOG_CheckRotation (void)
+{
+	if ((log_writer.maxsize && log_writer.written >= log_writer.maxsize) ||
+		(log_writer.maxage && Sys_DoubleTime () - log_writer.opentime >= log_writer.maxage))
+		LOG_Rotate ();
+}
+
+/*
+================
+LOG_WriterThread
+================
+*/
+static int LOG_WriterThread (void *unused)
+{
+	char	note[64];
+	size_t	tail, size;
+	int		dropped;
+
+	SDL_LockMutex (log_writer.mutex);
+	while (true)
+	{
+		if (log_writer.head == log_writer.tail && !log_writer.dropped)
+		{
+			if (log_writer.quit)
+				break;
+			SDL_CondWaitTimeout (log_writer.cond, log_writer.mutex, LOG_FLUSH_MS);
+		}
+
+		// write everything that's pending, one contiguous span at a time
+		while (log_writer.head != log_writer.tail)
+		{
+			tail = log_writer.tail & (LOG_RING_SIZE - 1);
+			size = q_min (log_writer.head - log_writer.tail, LOG_RING_SIZE - tail);
+			SDL_UnlockMutex (log_writer.mutex);
+			LOG_Write (log_writer.ring + tail, size);
+			SDL_LockMutex (log_writer.mutex);
+			log_writer.tail += size;
+		}
+
+		dropped = log_writer.dropped;
+		log_writer.dropped = 0;
+		SDL_UnlockMutex (log_writer.mutex);
+
+		if (dropped)
+		{
+			q_snprintf (note, sizeof (note), "\n[%d log message%s dropped]\n", PLURAL (dropped));
+			LOG_Write (note, strlen (note));
+		}
+		LOG_CheckRotation ();
+
+		SDL_LockMutex (log_writer.mutex);
+	}
+	SDL_UnlockMutex (log_writer.mutex);
+
+	return 0;
+}
+
+/*
+================
+LOG_Timestamp
+================
+*/
+static size_t LOG_Timestamp (char *buf, size_t size)
+{
+	time_t now = time (NULL);
+	return strftime (buf, size, "[%Y-%m-%d %H:%M:%S] ", localtime (&now));
+}
+
+/*
+================
+LOG_Append
+
+Copies msg to the ring, prefixing every line with a timestamp.
+Returns false if it doesn't fit. Must be called with the mutex held.
+================
+*/
+static qboolean LOG_Append (const char *msg, size_t len)
+{
+	char		stamp[32];
+	size_t		stamplen, needed, i;
+	const char	*p;
+
+	stamplen = LOG_Timestamp (stamp, sizeof (stamp));
+
+	// worst case size: one timestamp per line
+	needed = len;
+	if (log_writer.linestart)
+		needed += stamplen;
+	for (p = msg; (p = strchr (p, '\n')) != NULL && p[1]; p++)
+		needed += stamplen;
+
+	if (needed > LOG_RING_SIZE - (log_writer.head - log_writer.tail))
+		return false;
+
+	for (i = 0; i < len; i++)
+	{
+		if (log_writer.linestart)
+		{
+			size_t j;
+			for (j = 0; j < stamplen; j++)
+				log_writer.ring[(log_writer.head++) & (LOG_RING_SIZE - 1)] = stamp[j];
+			log_writer.linestart = false;
+		}
+		log_writer.ring[(log_writer.head++) & (LOG_RING_SIZE - 1)] = msg[i];
+		if (msg[i] == '\n')
+			log_writer.linestart = true;
+	}
+
+	return true;
+}
+
 /*
 ================
 Con_DebugLog
@@ -1228,17 +1482,42 @@ Note: msg is expected to be in UTF-8, not Quake charset
 */
 void Con_DebugLog(const char *msg)
 {
-	if (log_fd == -1)
+	size_t len;
+
+	len = strlen (msg);
+	if (!len)
 		return;
 
-	if (write(log_fd, msg, strlen(msg)) < 0)
+	if (!log_writer.thread)
 	{
-		close (log_fd);
-		log_fd = -1;
-		fprintf (stderr, "Error writing to log file\n");
+		char		stamp[32];
+		const char	*end;
+
+		if (log_fd == -1)
+			return;
+
+		// no writer thread: write synchronously, line by line
+		while (*msg)
+		{
+			if (log_writer.linestart)
+				LOG_Write (stamp, LOG_Timestamp (stamp, sizeof (stamp)));
+			end = strchr (msg, '\n');
+			end = end ? end + 1 : msg + strlen (msg);
+			LOG_Write (msg, end - msg);
+			log_writer.linestart = end[-1] == '\n';
+			msg = end;
+		}
+		LOG_CheckRotation ();
+		return;
 	}
-}
 
+	SDL_LockMutex (log_writer.mutex);
+	if (!LOG_Append (msg, len))
+		log_writer.dropped++;
+	if (log_writer.head - log_writer.tail >= LOG_RING_SIZE / 2)
+		SDL_CondSignal (log_writer.cond);
+	SDL_UnlockMutex (log_writer.mutex);
+}
 
 /*
 ================
@@ -1271,7 +1550,6 @@ void Con_Printf (const char *fmt, ...)
 {
 	va_list		argptr;
 	char		msg[MAXPRINTMSG];
-	static qboolean	inupdate;
 
 	va_start (argptr, fmt);
 	q_vsnprintf (msg, sizeof(msg), fmt, argptr);
@@ -1290,17 +1568,9 @@ void Con_Printf (const char *fmt, ...)
 	Con_Print (msg);
 
 // update the screen if the console is displayed
+// (rate-limited, so that printing a lot while loading doesn't slow it down)
 	if (cls.signon != SIGNONS && !scr_disabled_for_loading )
-	{
-	// protect against infinite loop if something in SCR_UpdateScreen calls
-	// Con_Printd
-		if (!inupdate)
-		{
-			inupdate = true;
-			SCR_UpdateScreen ();
-			inupdate = false;
-		}
-	}
+		SCR_LoadingUpdate ();
 }
 
 /*
@@ -1561,6 +1831,7 @@ typedef struct cmdalias_s
 	struct cmdalias_s	*next;
 	char	name[MAX_ALIAS_NAME];
 	char	*value;
+	struct cmdalias_s	*hash_next;
 } cmdalias_t;
 extern	cmdalias_t	*cmd_alias;
 
@@ -1568,7 +1839,9 @@ extern	cmdalias_t	*cmd_alias;
 ============
 Con_AddToTabList -- johnfitz
 
-tablist is a doubly-linked loop, alphabetized by name
+tablist is a doubly-linked loop, alphabetized by name.
+Matches are only collected here, BuildTabList sorts and links them
+once it's done, instead of doing a sorted insert for every match.
 ============
 */
 
@@ -1576,13 +1849,14 @@ tablist is a doubly-linked loop, alphabetized by name
 // aka Linux Bash shell. -- S.A.
 static char	bash_partial[80];
 static qboolean	bash_singlematch;
+static tab_t	**tabmatches;	// unsorted, see BuildTabList
 
 void Con_AddToTabList (const char *name, const char *partial, const char *type)
 {
-	tab_t	*t,*insert;
+	tab_t	*t;
 	char	*i_bash, *i_bash2;
 	const char *i_name, *i_name2;
-	int		namelen, typelen, mark;
+	int		namelen, typelen;
 
 	if (!Con_Match (name, partial))
 		return;
@@ -1621,7 +1895,6 @@ void Con_AddToTabList (const char *name, const char *partial, const char *type)
 		}
 	}
 
-	mark = Hunk_LowMark ();
 	namelen = (int) strlen (name) + 1;
 	typelen = type ? (int) strlen (type) + 1 : 0;
 	t = (tab_t *) Hunk_AllocName (sizeof (tab_t) + namelen + typelen, "tablist");
@@ -1634,42 +1907,67 @@ void Con_AddToTabList (const char *name, const char *partial, const char *type)
 	}
 	t->count = 1;
 
-	if (!tablist) //create list
-	{
-		tablist = t;
-		t->next = t;
-		t->prev = t;
-	}
-	else if (q_strnaturalcmp (name, tablist->name) < 0) //insert at front
-	{
-		t->next = tablist;
-		t->prev = tablist->prev;
-		t->next->prev = t;
-		t->prev->next = t;
-		tablist = t;
-	}
-	else //insert later
+	VEC_PUSH (tabmatches, t);
+}
+
+/*
+============
+Con_CmpTabMatch
+============
+*/
+static int Con_CmpTabMatch (const void *a, const void *b)
+{
+	const tab_t *t1 = *(const tab_t **) a;
+	const tab_t *t2 = *(const tab_t **) b;
+	int cmp = q_strnaturalcmp (t1->name, t2->name);
+	if (cmp)
+		return cmp;
+	return strcmp (t1->name, t2->name); // keep exact duplicates next to each other
+}
+
+/*
+============
+Con_LinkTabList
+
+Sorts the collected matches and links them into tablist, merging duplicates
+============
+*/
+static void Con_LinkTabList (void)
+{
+	size_t	i, count = VEC_SIZE (tabmatches);
+	tab_t	*t, *last = NULL;
+
+	tablist = NULL;
+	if (!count)
+		return;
+
+	qsort (tabmatches, count, sizeof (tabmatches[0]), Con_CmpTabMatch);
+
+	for (i = 0; i < count; i++)
 	{
-		insert = tablist;
-		do
+		t = tabmatches[i];
+		if (last && !strcmp (t->name, last->name))
 		{
-			int cmp = q_strnaturalcmp (name, insert->name);
-			if (!cmp && !strcmp (name, insert->name)) // avoid duplicates
-			{
-				Hunk_FreeToLowMark (mark);
-				insert->count++;
-				return;
-			}
-			if (cmp < 0)
-				break;
-			insert = insert->next;
-		} while (insert != tablist);
-
-		t->next = insert;
-		t->prev = insert->prev;
-		t->next->prev = t;
-		t->prev->next = t;
+			last->count++;
+			continue;
+		}
+		if (!last)
+		{
+			tablist = t;
+			t->prev = t;
+		}
+		else
+		{
+			t->prev = last;
+			last->next = t;
+		}
+		last = t;
 	}
+
+	last->next = tablist;
+	tablist->prev = last;
+
+	VEC_CLEAR (tabmatches);
 }
 
 /*
@@ -1814,21 +2112,16 @@ static const int num_arg_completion_types = Q_COUNTOF(arg_completion_types);
 
 /*
 ============
-BuildTabList -- johnfitz
+CollectTabMatches -- johnfitz
 ============
 */
-static void BuildTabList (const char *partial)
+static void CollectTabMatches (const char *partial)
 {
 	cmdalias_t		*alias;
 	cvar_t			*cvar;
 	cmd_function_t	*cmd;
 	int				i;
 
-	tablist = NULL;
-
-	bash_partial[0] = 0;
-	bash_singlematch = 1;
-
 	ParseCommand ();
 
 	if (Cmd_Argc () >= 2)
@@ -1881,6 +2174,23 @@ static void BuildTabList (const char *partial)
 			Con_AddToTabList (alias->name, partial, "alias");
 }
 
+/*
+============
+BuildTabList
+============
+*/
+static void BuildTabList (const char *partial)
+{
+	tablist = NULL;
+
+	bash_partial[0] = 0;
+	bash_singlematch = 1;
+
+	VEC_CLEAR (tabmatches);
+	CollectTabMatches (partial);
+	Con_LinkTabList ();
+}
+
 /*
 ============
 Con_FormatTabMatch
@@ -2114,6 +2424,60 @@ static float Con_NotifyAlpha (double time)
 	return q_min (time, 1.0);
 }
 
+/*
+================
+Con_GetLineRun
+
+Returns the cached glyph run for the given line, rebuilding it if the
+line has changed since it was last drawn
+================
+*/
+static const conrun_t *Con_GetLineRun (int line, int minruns)
+{
+	conrun_t	*run;
+	const char	*text;
+	int			i, slot;
+
+	if (minruns > con_numruns || con_linewidth != con_runwidth)
+	{
+		con_numruns = q_max (minruns, con_numruns);
+		con_runwidth = con_linewidth;
+		con_runs = (conrun_t *) realloc (con_runs, con_numruns * sizeof (con_runs[0]));
+		con_runglyphs = (drawglyph_t *) realloc (con_runglyphs, con_numruns * con_runwidth * sizeof (con_runglyphs[0]));
+		if (!con_runs || !con_runglyphs)
+			Sys_Error ("Con_GetLineRun: out of memory on %d lines", con_numruns);
+		for (i = 0; i < con_numruns; i++)
+		{
+			con_runs[i].line = -1;
+			con_runs[i].glyphs = con_runglyphs + i * con_runwidth;
+		}
+	}
+
+	slot = line % con_numruns;
+	run = &con_runs[slot];
+	if (run->line == line && run->epoch == con_epoch && run->stamp == con_linestamp[line % con_totallines])
+		return run;
+
+	run->line = line;
+	run->epoch = con_epoch;
+	run->stamp = con_linestamp[line % con_totallines];
+	run->len = 0;
+	run->numglyphs = 0;
+
+	text = con_text + (line % con_totallines)*con_linewidth;
+	for (i = 0; i < con_linewidth; i++)
+	{
+		if ((text[i] & 0x7f) == ' ')
+			continue;
+		run->glyphs[run->numglyphs].x = i << 3;
+		run->glyphs[run->numglyphs].num = (byte) text[i];
+		run->numglyphs++;
+		run->len = i + 1;
+	}
+
+	return run;
+}
+
 /*
 ================
 Con_DrawNotify
@@ -2125,6 +2489,7 @@ void Con_DrawNotify (void)
 {
 	int	i, x, v;
 	const char	*text;
+	const conrun_t	*run;
 	float	alpha;
 
 	GL_SetCanvas (CANVAS_CONSOLE); //johnfitz
@@ -2137,22 +2502,15 @@ void Con_DrawNotify (void)
 		alpha = Con_NotifyAlpha (con_times[i % NUM_CON_TIMES]);
 		if (alpha <= 0.f)
 			continue;
-		text = con_text + (i % con_totallines)*con_linewidth;
+		run = Con_GetLineRun (i, NUM_CON_TIMES);
 
 		clearnotify = 0;
 
 		GL_SetCanvasColor (1.f, 1.f, 1.f, alpha);
 		if (con_notifycenter.value)
-		{
-			int len = con_linewidth;
-			while (len > 0 && text[len - 1] == ' ')
-				--len;
-			for (x = 0; x < len; x++)
-				Draw_Character ((con_linewidth - len)*4 + x*8, v + 16, text[x]);
-		}
+			Draw_GlyphRun ((con_linewidth - run->len)*4, v + 16, run->glyphs, run->numglyphs);
 		else
-			for (x = 0; x < con_linewidth; x++)
-				Draw_Character ((x+1)<<3, v, text[x]);
+			Draw_GlyphRun (8, v, run->glyphs, run->numglyphs);
 		GL_SetCanvasColor (1.f, 1.f, 1.f, 1.f);
 
 		v += 8;
@@ -2328,6 +2686,15 @@ void Con_DrawConsole (int lines, qboolean drawbg, qboolean drawinput)
 		j = i - con_backscroll;
 		if (j < 0)
 			j = 0;
+
+		// lines without a hotlink use the cached glyph run
+		if (!con_hotlink || j < con_hotlink->begin.line || j > con_hotlink->end.line)
+		{
+			const conrun_t *run = Con_GetLineRun (j, rows);
+			Draw_GlyphRun (8, y, run->glyphs, run->numglyphs);
+			continue;
+		}
+
 		text = con_text + (j % con_totallines)*con_linewidth;
 		ofs.line = j;
 		for (x = 0; x < con_linewidth; x++)
@@ -2408,6 +2775,7 @@ void LOG_Init (quakeparms_t *parms)
 {
 	time_t	inittime;
 	char	session[24];
+	int		i;
 
 	if (!COM_CheckParm("-condebug"))
 		return;
@@ -2425,15 +2793,52 @@ void LOG_Init (quakeparms_t *parms)
 		return;
 	}
 
+	memset (&log_writer, 0, sizeof (log_writer));
+	log_writer.linestart = true;
+	log_writer.opentime = Sys_DoubleTime ();
+
+	i = COM_CheckParm ("-condebugsize");
+	if (i && i < com_argc - 1)
+		log_writer.maxsize = (int64_t) (Q_atof (com_argv[i + 1]) * 1024 * 1024);
+	i = COM_CheckParm ("-condebugrotate");
+	if (i && i < com_argc - 1)
+		log_writer.maxage = Q_atof (com_argv[i + 1]) * 60.0;
+
+	log_writer.ring = (char *) malloc (LOG_RING_SIZE);
+	log_writer.mutex = SDL_CreateMutex ();
+	log_writer.cond = SDL_CreateCond ();
+	if (log_writer.ring && log_writer.mutex && log_writer.cond)
+		log_writer.thread = SDL_CreateThread (LOG_WriterThread, "Log writer", NULL);
+	if (!log_writer.thread)
+		fprintf (stderr, "Warning: Unable to create log writer thread, logging synchronously\n");
+
 	Con_DebugLog (va("LOG started on: %s \n", session));
 
 }
 
 void LOG_Close (void)
 {
-	if (log_fd == -1)
+	if (log_fd == -1 && !log_writer.thread)
 		return;
-	close (log_fd);
+
+	if (log_writer.thread)
+	{
+		SDL_LockMutex (log_writer.mutex);
+		log_writer.quit = true;
+		SDL_CondSignal (log_writer.cond);
+		SDL_UnlockMutex (log_writer.mutex);
+		SDL_WaitThread (log_writer.thread, NULL);
+		log_writer.thread = NULL;
+	}
+	if (log_writer.cond)
+		SDL_DestroyCond (log_writer.cond);
+	if (log_writer.mutex)
+		SDL_DestroyMutex (log_writer.mutex);
+	free (log_writer.ring);
+	memset (&log_writer, 0, sizeof (log_writer));
+
+	if (log_fd != -1)
+		close (log_fd);
 	log_fd = -1;
 }
 
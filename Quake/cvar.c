@@ -577,7 +577,7 @@ void Cvar_RegisterVariable (cvar_t *variable)
 {
 	char	value[512];
 	qboolean	set_rom;
-	int			i;
+	int			i, lo, hi;
 
 // first check to see if it has already been defined
 	if (Cvar_FindVar (variable->name))
@@ -598,9 +598,18 @@ void Cvar_RegisterVariable (cvar_t *variable)
 
 // link the variable in
 	//johnfitz -- insert each entry in alphabetical order
-	for (i = 0; i < cvar_count; i++)
-		if (strcmp (variable->name, cvar_list[i]->name) < 0)
-			break;
+	// (binary search for the first entry that sorts after it)
+	lo = 0;
+	hi = cvar_count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (strcmp (variable->name, cvar_list[mid]->name) < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	i = lo;
 	if (i < cvar_count)
 	{
 		variable->next = cvar_list[i];
@@ -34,6 +34,12 @@ extern	const vec3_t	rgb_white;
 
 #define CHARSIZE	8
 
+typedef struct drawglyph_s
+{
+	short		x;
+	short		num;
+} drawglyph_t;
+
 void Draw_Init (void);
 void Draw_Character (int x, int y, int num);
 void Draw_CharacterEx (float x, float y, float dimx, float dimy, int num);
@@ -48,6 +54,7 @@ void Draw_PartialFadeScreen (float x0, float x1, float y0, float y1, float alpha
 void Draw_FadeScreen (float alpha);
 void Draw_String (int x, int y, const char *str);
 void Draw_StringEx (float x, float y, float dim, const char *str);
+void Draw_GlyphRun (float x, float y, const drawglyph_t *glyphs, int count);
 qpic_t *Draw_PicFromWad2 (const char *name, unsigned int texflags);
 qpic_t *Draw_PicFromWad (const char *name);
 qpic_t *Draw_CachePic (const char *path);
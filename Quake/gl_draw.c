@@ -113,14 +113,23 @@ typedef struct guivertex_t {
 	float		pos[2];
 	float		uv[2];
 	byte		color[4];
+	uint32_t	texslot;
 } guivertex_t;
 
 #define MAX_BATCH_QUADS 2048
+#define MAX_BATCH_TEXTURES 8 // must match the sampler array in gui_fragment_shader
 
 static int numbatchquads = 0;
 static guivertex_t batchverts[4 * MAX_BATCH_QUADS];
 static GLushort batchindices[6 * MAX_BATCH_QUADS];
 
+// textures referenced by the current batch, bound to consecutive units
+// and selected per vertex, so switching between them doesn't need a flush
+static int numbatchtextures = 0;
+static int batchtexslot = 0;
+static gltexture_t *batchtextures[MAX_BATCH_TEXTURES];
+static int numguidraws = 0;
+
 glcanvas_t glcanvas;
 
 //==============================================================================
@@ -355,7 +364,9 @@ qpic_t	*Draw_TryCachePic (const char *path, unsigned int texflags)
 {
 	cachepic_t	*pic;
 	int			i, x, y;
-	qpic_t		*dat;
+	int			width, height;
+	fileview_t	file;
+	const qpic_t	*dat;
 	glpic_t		gl;
 
 	for (pic=menu_cachepics, i=0 ; i<menu_numcachepics ; pic++, i++)
@@ -371,10 +382,23 @@ qpic_t	*Draw_TryCachePic (const char *path, unsigned int texflags)
 //
 // load the pic from disk
 //
-	dat = (qpic_t *)COM_LoadMallocFile (path, NULL);
-	if (!dat)
+	if (!COM_MapFile (path, &file, NULL))
+		return NULL;
+	dat = (const qpic_t *) file.data;
+	if (file.size < (int) sizeof (int) * 2)
+	{
+		COM_UnmapFile (&file);
 		return NULL;
-	SwapPic (dat);
+	}
+	// the file is a read-only view, so don't swap the header in place
+	width = LittleLong (dat->width);
+	height = LittleLong (dat->height);
+	if (width < 0 || height < 0 || (int64_t) width * height > file.size - (int) sizeof (int) * 2)
+	{
+		Con_Printf ("Draw_CachePic: %s is truncated\n", path);
+		COM_UnmapFile (&file);
+		return NULL;
+	}
 
 	// HACK HACK HACK --- we need to keep this as a separate texture
 	// so that the menu configuration dialog can translate its colors
@@ -382,29 +406,29 @@ qpic_t	*Draw_TryCachePic (const char *path, unsigned int texflags)
 	if (!strcmp (path, "gfx/menuplyr.lmp"))
 		texflags &= ~TEXPREF_PAD; // no scrap usage
 
-	pic->pic.width = dat->width;
-	pic->pic.height = dat->height;
+	pic->pic.width = width;
+	pic->pic.height = height;
 
-	if (Scrap_Compatible (texflags) && Scrap_AllocBlock (dat->width, dat->height, &x, &y))
+	if (Scrap_Compatible (texflags) && Scrap_AllocBlock (width, height, &x, &y))
 	{
-		Scrap_FillTexels (x, y, dat->width, dat->height, dat->data);
+		Scrap_FillTexels (x, y, width, height, dat->data);
 		gl.gltexture = scrap_texture;
 		gl.sl = x/(float)SCRAP_ATLAS_WIDTH;
 		gl.tl = y/(float)SCRAP_ATLAS_HEIGHT;
-		gl.sh = (x+dat->width)/(float)SCRAP_ATLAS_WIDTH;
-		gl.th = (y+dat->height)/(float)SCRAP_ATLAS_HEIGHT;
+		gl.sh = (x+width)/(float)SCRAP_ATLAS_WIDTH;
+		gl.th = (y+height)/(float)SCRAP_ATLAS_HEIGHT;
 	}
 	else
 	{
-		gl.gltexture = TexMgr_LoadImage (NULL, path, dat->width, dat->height, SRC_INDEXED, dat->data, path,
+		gl.gltexture = TexMgr_LoadImage (NULL, path, width, height, SRC_INDEXED, (byte *) dat->data, path,
 										  sizeof(int)*2, texflags); //johnfitz -- TexMgr
 		gl.sl = 0;
-		gl.sh = (float)dat->width/(float)TexMgr_PadConditional(dat->width); //johnfitz
+		gl.sh = (float)width/(float)TexMgr_PadConditional(width); //johnfitz
 		gl.tl = 0;
-		gl.th = (float)dat->height/(float)TexMgr_PadConditional(dat->height); //johnfitz
+		gl.th = (float)height/(float)TexMgr_PadConditional(height); //johnfitz
 	}
 
-	free (dat);
+	COM_UnmapFile (&file);
 	memcpy (pic->pic.data, &gl, sizeof(glpic_t));
 
 	return &pic->pic;
@@ -585,41 +609,76 @@ void Draw_Flush (void)
 {
 	GLuint buf;
 	GLbyte *ofs;
+	int i;
 
 	if (!numbatchquads)
 		return;
 
-	if (scrap_dirty && glcanvas.texture == scrap_texture)
-		Scrap_Upload ();
+	for (i = 0; i < numbatchtextures; i++)
+	{
+		if (scrap_dirty && batchtextures[i] == scrap_texture)
+			Scrap_Upload ();
+		if (!batchtextures[i])
+			batchtextures[i] = nulltexture;
+	}
 
 	GL_UseProgram (glprogs.gui);
-	GL_SetState (glcanvas.blendmode | GLS_NO_ZTEST | GLS_NO_ZWRITE | GLS_CULL_NONE | GLS_ATTRIBS(3));
-	GL_Bind (GL_TEXTURE0, glcanvas.texture);
+	GL_SetState (glcanvas.blendmode | GLS_NO_ZTEST | GLS_NO_ZWRITE | GLS_CULL_NONE | GLS_ATTRIBS(4));
+	GL_BindTextures (0, numbatchtextures, batchtextures);
 
 	GL_Upload (GL_ARRAY_BUFFER, batchverts, sizeof(batchverts[0]) * 4 * numbatchquads, &buf, &ofs);
 	GL_BindBuffer (GL_ARRAY_BUFFER, buf);
 	GL_VertexAttribPointerFunc (0, 2, GL_FLOAT, GL_FALSE, sizeof(batchverts[0]), ofs + offsetof(guivertex_t, pos));
 	GL_VertexAttribPointerFunc (1, 2, GL_FLOAT, GL_FALSE, sizeof(batchverts[0]), ofs + offsetof(guivertex_t, uv));
 	GL_VertexAttribPointerFunc (2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(batchverts[0]), ofs + offsetof(guivertex_t, color));
+	GL_VertexAttribIPointerFunc (3, 1, GL_UNSIGNED_INT, sizeof(batchverts[0]), ofs + offsetof(guivertex_t, texslot));
 
 	GL_Upload (GL_ELEMENT_ARRAY_BUFFER, batchindices, sizeof(batchindices[0]) * 6 * numbatchquads, &buf, &ofs);
 	GL_BindBuffer (GL_ELEMENT_ARRAY_BUFFER, buf);
 	glDrawElements (GL_TRIANGLES, numbatchquads * 6, GL_UNSIGNED_SHORT, ofs);
+	numguidraws++;
 
 	numbatchquads = 0;
+
+	// keep the current texture for the next batch
+	numbatchtextures = 0;
+	batchtexslot = 0;
+	if (glcanvas.texture)
+		batchtextures[numbatchtextures++] = glcanvas.texture;
 }
 
 /*
 ================
 Draw_SetTexture
+
+Only flushes when the batch already references MAX_BATCH_TEXTURES
+other textures
 ================
 */
 static void Draw_SetTexture (gltexture_t *tex)
 {
-	if (tex == glcanvas.texture)
+	int i;
+
+	if (tex == glcanvas.texture && numbatchtextures)
 		return;
-	Draw_Flush ();
+
+	for (i = 0; i < numbatchtextures; i++)
+		if (batchtextures[i] == tex)
+			break;
+
+	if (i == numbatchtextures)
+	{
+		if (numbatchtextures == MAX_BATCH_TEXTURES)
+		{
+			Draw_Flush ();
+			numbatchtextures = 0;
+		}
+		i = numbatchtextures++;
+		batchtextures[i] = tex;
+	}
+
 	glcanvas.texture = tex;
+	batchtexslot = i;
 }
 
 /*
@@ -711,6 +770,22 @@ static void Draw_SetVertex (guivertex_t *v, float x, float y, float s, float t)
 	v->color[1] = (color >>  8) & 0xff;
 	v->color[2] = (color >> 16) & 0xff;
 	v->color[3] = (color >> 24) & 0xff;
+	v->texslot = batchtexslot;
+}
+
+/*
+================
+Draw_SetTransformedVertex
+================
+*/
+static void Draw_SetTransformedVertex (guivertex_t *v, float x, float y, float s, float t, uint32_t color)
+{
+	v->pos[0] = x;
+	v->pos[1] = y;
+	v->uv[0] = s;
+	v->uv[1] = t;
+	memcpy (v->color, &color, sizeof (v->color));
+	v->texslot = batchtexslot;
 }
 
 /*
@@ -777,6 +852,52 @@ void Draw_Character (int x, int y, int num)
 	Draw_CharacterEx (x, y, 8, 8, (char) num);
 }
 
+/*
+================
+Draw_GlyphRun
+
+Draws a prebuilt run of 8x8 characters starting at x, y.
+Glyph offsets are in canvas units, spaces should already be left out.
+================
+*/
+void Draw_GlyphRun (float x, float y, const drawglyph_t *glyphs, int count)
+{
+	guivertex_t		*verts;
+	uint32_t		color;
+	float			x0, y0, y1, w, fsize;
+	int				i;
+
+	if (count <= 0 || y <= glcanvas.top - 8)
+		return;			// totally off screen
+
+	if (Draw_FadedOut ())
+		return;
+
+	Draw_SetTexture (char_texture);
+
+	color = glcanvas.colorstack[glcanvas.colorstacktop];
+	color = LittleLong (color);
+	x0 = x * glcanvas.transform.scale[0] + glcanvas.transform.offset[0];
+	y0 = y * glcanvas.transform.scale[1] + glcanvas.transform.offset[1];
+	y1 = y0 + 8.f * glcanvas.transform.scale[1];
+	w = 8.f * glcanvas.transform.scale[0];
+	fsize = 8.f / (16.f * 10.f);
+
+	for (i = 0; i < count; i++)
+	{
+		int		num = glyphs[i].num & 255;
+		float	l = x0 + glyphs[i].x * glcanvas.transform.scale[0];
+		float	frow = (num >> 4) * 0.0625f + 1.f / (16.f * 10.f);
+		float	fcol = (num & 15) * 0.0625f + 1.f / (16.f * 10.f);
+
+		verts = Draw_AllocQuad ();
+		Draw_SetTransformedVertex (verts++, l,     y0, fcol,         frow,         color);
+		Draw_SetTransformedVertex (verts++, l + w, y0, fcol + fsize, frow,         color);
+		Draw_SetTransformedVertex (verts++, l + w, y1, fcol + fsize, frow + fsize, color);
+		Draw_SetTransformedVertex (verts++, l,     y1, fcol,         frow + fsize, color);
+	}
+}
+
 /*
 ================
 Draw_StringEx
@@ -1297,8 +1418,14 @@ GL_Set2D
 */
 void GL_Set2D (void)
 {
+	dev_stats.guidraws = numguidraws;
+	dev_peakstats.guidraws = q_max (dev_peakstats.guidraws, numguidraws);
+	numguidraws = 0;
+
 	glcanvas.type = CANVAS_INVALID;
 	glcanvas.texture = NULL;
+	numbatchtextures = 0;
+	batchtexslot = 0;
 	glcanvas.blendmode = GLS_BLEND_ALPHA;
 	glcanvas.colorstacktop = 0;
 	glViewport (glx, gly, glwidth, glheight);
@@ -116,31 +116,536 @@ void GL_MakeAliasModelDisplayLists (qmodel_t *aliasmodel, aliashdr_t *paliashdr)
 	// free temporary data
 	Hunk_FreeToLowMark (mark);
 
+	GLMesh_BuildLODs (aliasmodel, pheader);
+
 	// upload immediately
 	GLMesh_LoadVertexBuffer (aliasmodel, pheader);
 }
 
+/*
+=================================================================
+
+ALIAS MODEL LEVELS OF DETAIL
+
+Reduced versions of each surface's index list, made by collapsing
+edges in order of increasing quadric error (Garland & Heckbert) on the
+first pose. Only half-edge collapses are used (a vertex is merged into
+one of its neighbours), so all levels keep referencing the original
+vertices and share the pose/skeleton data. Vertices on open edges,
+which includes UV seams, are never removed.
+
+=================================================================
+*/
+
+#define LOD_MIN_SURF_TRIS	128		// don't simplify surfaces below this
+#define LOD_MIN_LEVEL_TRIS	64		// don't generate levels below this
+#define LOD_MIN_REDUCTION	0.75f	// drop levels that aren't at least this much smaller
+#define LOD_MAX_PASSES		32
+
+typedef struct lodquadric_s
+{
+	double		a[10];	// xx xy xz xw yy yz yw zz zw ww
+} lodquadric_t;
+
+typedef struct lodcollapse_s
+{
+	float			cost;
+	unsigned short	v, u;	// v is merged into u
+} lodcollapse_t;
+
 /*
 ================
-GLMesh_LoadVertexBuffer
+LOD_AddPlane
+================
+*/
+static void LOD_AddPlane (lodquadric_t *q, const double n[3], double d, double w)
+{
+	q->a[0] += w * n[0] * n[0];
+	q->a[1] += w * n[0] * n[1];
+	q->a[2] += w * n[0] * n[2];
+	q->a[3] += w * n[0] * d;
+	q->a[4] += w * n[1] * n[1];
+	q->a[5] += w * n[1] * n[2];
+	q->a[6] += w * n[1] * d;
+	q->a[7] += w * n[2] * n[2];
+	q->a[8] += w * n[2] * d;
+	q->a[9] += w * d * d;
+}
+
+/*
+================
+LOD_Error
+
+Evaluates the sum of two quadrics at p
+================
+*/
+static double LOD_Error (const lodquadric_t *q1, const lodquadric_t *q2, const float p[3])
+{
+	double a[10], x = p[0], y = p[1], z = p[2];
+	int i;
+
+	for (i = 0; i < 10; i++)
+		a[i] = q1->a[i] + q2->a[i];
+
+	return
+		a[0]*x*x + 2*a[1]*x*y + 2*a[2]*x*z + 2*a[3]*x +
+		a[4]*y*y + 2*a[5]*y*z + 2*a[6]*y +
+		a[7]*z*z + 2*a[8]*z +
+		a[9];
+}
+
+/*
+================
+LOD_Normal
+================
+*/
+static void LOD_Normal (const float *a, const float *b, const float *c, double n[3])
+{
+	double e1[3], e2[3];
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		e1[i] = b[i] - a[i];
+		e2[i] = c[i] - a[i];
+	}
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+/*
+================
+LOD_CollapseFlips
+
+Returns true if moving v onto u would flip or degenerate any triangle of v that doesn't contain u
+================
+*/
+static qboolean LOD_CollapseFlips (const float *pos, const unsigned short *tris, const int *vtris, int numvtris, int v, int u)
+{
+	int i, j;
+
+	for (i = 0; i < numvtris; i++)
+	{
+		const unsigned short *t = tris + vtris[i] * 3;
+		const float *p[3], *q[3];
+		double n1[3], n2[3];
+
+		if (t[0] == u || t[1] == u || t[2] == u)
+			continue;
 
-Upload the given alias model's mesh to a VBO
+		for (j = 0; j < 3; j++)
+		{
+			p[j] = pos + t[j] * 3;
+			q[j] = t[j] == v ? pos + u * 3 : p[j];
+		}
+
+		LOD_Normal (p[0], p[1], p[2], n1);
+		LOD_Normal (q[0], q[1], q[2], n2);
+		if (n1[0] * n2[0] + n1[1] * n2[1] + n1[2] * n2[2] <= 0.0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+================
+LOD_CmpCollapse
+================
+*/
+static int LOD_CmpCollapse (const void *pa, const void *pb)
+{
+	const lodcollapse_t *a = (const lodcollapse_t *) pa;
+	const lodcollapse_t *b = (const lodcollapse_t *) pb;
+	if (a->cost != b->cost)
+		return a->cost < b->cost ? -1 : 1;
+	return (int) a->v - (int) b->v;
+}
+
+/*
+================
+LOD_CmpEdge
+================
+*/
+static int LOD_CmpEdge (const void *pa, const void *pb)
+{
+	uint32_t a = *(const uint32_t *) pa;
+	uint32_t b = *(const uint32_t *) pb;
+	return a < b ? -1 : a > b;
+}
+
+/*
+================
+GLMesh_GetPosePositions
+
+Fills in the first pose's vertex positions for the given surface
+================
+*/
+static void GLMesh_GetPosePositions (const aliashdr_t *hdr, float *pos)
+{
+	int v, k;
+
+	switch (hdr->poseverttype)
+	{
+	case PV_QUAKE1:
+		{
+			const aliasmesh_t *desc = (const aliasmesh_t *) ((const byte *) hdr + hdr->meshdesc);
+			const trivertx_t *tv = (const trivertx_t *) ((const byte *) hdr + hdr->vertexes);
+			for (v = 0; v < hdr->numverts_vbo; v++)
+				for (k = 0; k < 3; k++)
+					pos[v*3 + k] = tv[desc[v].vertindex].v[k] * hdr->scale[k];
+		}
+		break;
+	case PV_MD3:
+		{
+			const md3pose_t *pose = (const md3pose_t *) ((const byte *) hdr + hdr->vertexes);
+			for (v = 0; v < hdr->numverts_vbo; v++)
+				for (k = 0; k < 3; k++)
+					pos[v*3 + k] = (pose[v].xyz[k] - 32768) * MD3_XYZ_SCALE;
+		}
+		break;
+	case PV_IQM:
+		{
+			const iqmvert_t *vert = (const iqmvert_t *) ((const byte *) hdr + hdr->vertexes);
+			for (v = 0; v < hdr->numverts_vbo; v++)
+				for (k = 0; k < 3; k++)
+					pos[v*3 + k] = vert[v].xyz[k];
+		}
+		break;
+	default:
+		memset (pos, 0, hdr->numverts_vbo * 3 * sizeof (float));
+		break;
+	}
+}
+
+/*
+================
+GLMesh_SimplifySurface
+
+Produces up to MAX_ALIAS_LODS index lists for the given surface, each
+with roughly half the triangles of the previous one. Returns the number
+of levels; the lists are malloc'ed and owned by the caller.
+================
+*/
+static int GLMesh_SimplifySurface (const aliashdr_t *hdr, unsigned short *lods[MAX_ALIAS_LODS], int lodnumindexes[MAX_ALIAS_LODS])
+{
+	const unsigned short	*srcidx = (const unsigned short *) ((const byte *) hdr + hdr->indexes);
+	int						numverts = hdr->numverts_vbo;
+	int						numtris = hdr->numindexes / 3;
+	int						i, j, k, level, pass, numlods, prevtris, target;
+	float					*pos;
+	unsigned short			*tris;
+	lodquadric_t			*quadrics;
+	byte					*locked, *touched;
+	int						*vtrisofs, *vtris;
+	uint32_t				*edges;
+	lodcollapse_t			*collapses;
+
+	if (numtris < LOD_MIN_SURF_TRIS || numverts <= 0)
+		return 0;
+
+	pos = (float *) malloc (numverts * 3 * sizeof (float));
+	tris = (unsigned short *) malloc (numtris * 3 * sizeof (unsigned short));
+	quadrics = (lodquadric_t *) calloc (numverts, sizeof (lodquadric_t));
+	locked = (byte *) calloc (numverts, 1);
+	touched = (byte *) malloc (numverts);
+	vtrisofs = (int *) malloc ((numverts + 1) * sizeof (int));
+	vtris = (int *) malloc (numtris * 3 * sizeof (int));
+	edges = (uint32_t *) malloc (numtris * 3 * sizeof (uint32_t));
+	collapses = (lodcollapse_t *) malloc (numverts * sizeof (lodcollapse_t));
+	if (!pos || !tris || !quadrics || !locked || !touched || !vtrisofs || !vtris || !edges || !collapses)
+		Sys_Error ("GLMesh_SimplifySurface: out of memory");
+
+	GLMesh_GetPosePositions (hdr, pos);
+	memcpy (tris, srcidx, numtris * 3 * sizeof (unsigned short));
+
+	// accumulate area-weighted face quadrics
+	for (i = 0; i < numtris; i++)
+	{
+		const unsigned short *t = tris + i * 3;
+		double n[3], len, d;
+
+		LOD_Normal (pos + t[0] * 3, pos + t[1] * 3, pos + t[2] * 3, n);
+		len = sqrt (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (len <= 0.0)
+			continue;
+		n[0] /= len; n[1] /= len; n[2] /= len;
+		d = -(n[0] * pos[t[0]*3+0] + n[1] * pos[t[0]*3+1] + n[2] * pos[t[0]*3+2]);
+		for (j = 0; j < 3; j++)
+			LOD_AddPlane (&quadrics[t[j]], n, d, len * 0.5);
+	}
+
+	// lock vertices on edges that aren't shared by exactly two triangles
+	for (i = 0; i < numtris; i++)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			uint32_t a = tris[i*3 + j];
+			uint32_t b = tris[i*3 + (j + 1) % 3];
+			edges[i*3 + j] = a < b ? (a << 16) | b : (b << 16) | a;
+		}
+	}
+	qsort (edges, numtris * 3, sizeof (edges[0]), LOD_CmpEdge);
+	for (i = 0; i < numtris * 3; i = j)
+	{
+		for (j = i + 1; j < numtris * 3 && edges[j] == edges[i]; j++)
+			;
+		if (j - i != 2)
+			locked[edges[i] >> 16] = locked[edges[i] & 0xffff] = 1;
+	}
+
+	numlods = 0;
+	prevtris = numtris;
+	for (level = 0; level < MAX_ALIAS_LODS; level++)
+	{
+		target = prevtris / 2;
+		if (target < LOD_MIN_LEVEL_TRIS)
+			break;
+
+		for (pass = 0; pass < LOD_MAX_PASSES && numtris > target; pass++)
+		{
+			int numcollapses = 0, numcollapsed = 0;
+
+			// vertex -> triangle adjacency
+			memset (vtrisofs, 0, (numverts + 1) * sizeof (int));
+			for (i = 0; i < numtris * 3; i++)
+				vtrisofs[tris[i] + 1]++;
+			for (i = 0; i < numverts; i++)
+				vtrisofs[i + 1] += vtrisofs[i];
+			for (i = 0; i < numtris * 3; i++)
+				vtris[vtrisofs[tris[i]]++] = i / 3;
+			for (i = numverts; i > 0; i--)
+				vtrisofs[i] = vtrisofs[i - 1];
+			vtrisofs[0] = 0;
+
+			// find the cheapest collapse for each vertex
+			for (i = 0; i < numverts; i++)
+			{
+				const int *vt = vtris + vtrisofs[i];
+				int numvt = vtrisofs[i + 1] - vtrisofs[i];
+				double best = DBL_MAX;
+				int bestu = -1;
+
+				if (locked[i] || !numvt)
+					continue;
+
+				for (j = 0; j < numvt; j++)
+				{
+					for (k = 0; k < 3; k++)
+					{
+						int u = tris[vt[j] * 3 + k];
+						double cost;
+						if (u == i)
+							continue;
+						cost = LOD_Error (&quadrics[i], &quadrics[u], pos + u * 3);
+						if (cost >= best || LOD_CollapseFlips (pos, tris, vt, numvt, i, u))
+							continue;
+						best = cost;
+						bestu = u;
+					}
+				}
+
+				if (bestu >= 0)
+				{
+					collapses[numcollapses].cost = (float) best;
+					collapses[numcollapses].v = i;
+					collapses[numcollapses].u = bestu;
+					numcollapses++;
+				}
+			}
+
+			if (!numcollapses)
+				break;
+			qsort (collapses, numcollapses, sizeof (collapses[0]), LOD_CmpCollapse);
+
+			// apply them in order, skipping those whose neighbourhood has already changed in this pass
+			memset (touched, 0, numverts);
+			for (i = 0; i < numcollapses && numtris - numcollapsed > target; i++)
+			{
+				int v = collapses[i].v, u = collapses[i].u;
+				const int *vt = vtris + vtrisofs[v];
+				int numvt = vtrisofs[v + 1] - vtrisofs[v];
+
+				if (touched[v] || touched[u])
+					continue;
+
+				for (j = 0; j < numvt; j++)
+				{
+					unsigned short *t = tris + vt[j] * 3;
+					touched[t[0]] = touched[t[1]] = touched[t[2]] = 1;
+					if (t[0] == u || t[1] == u || t[2] == u)
+					{
+						t[0] = t[1] = t[2] = 0xffff; // removed
+						numcollapsed++;
+					}
+					else
+					{
+						for (k = 0; k < 3; k++)
+							if (t[k] == v)
+								t[k] = u;
+					}
+				}
+
+				for (k = 0; k < 10; k++)
+					quadrics[u].a[k] += quadrics[v].a[k];
+			}
+
+			// drop the removed triangles
+			for (i = j = 0; i < numtris; i++)
+			{
+				if (tris[i * 3] == 0xffff)
+					continue;
+				if (i != j)
+					memcpy (tris + j * 3, tris + i * 3, 3 * sizeof (tris[0]));
+				j++;
+			}
+			numtris = j;
+
+			if (!numcollapsed)
+				break;
+		}
+
+		if (numtris > prevtris * LOD_MIN_REDUCTION)
+			break;
+
+		lods[numlods] = (unsigned short *) malloc (numtris * 3 * sizeof (unsigned short));
+		if (!lods[numlods])
+			Sys_Error ("GLMesh_SimplifySurface: out of memory");
+		memcpy (lods[numlods], tris, numtris * 3 * sizeof (unsigned short));
+		lodnumindexes[numlods] = numtris * 3;
+		numlods++;
+		prevtris = numtris;
+	}
+
+	free (collapses);
+	free (edges);
+	free (vtris);
+	free (vtrisofs);
+	free (touched);
+	free (locked);
+	free (quadrics);
+	free (tris);
+	free (pos);
+
+	return numlods;
+}
+
+/*
+================
+GLMesh_BuildLODs
+
+Generates the reduced detail levels for all the surfaces of an alias
+model that is still being loaded (the index lists are put on the hunk).
+Surfaces that can't be simplified as far as the others reuse their
+last level.
+================
+*/
+void GLMesh_BuildLODs (qmodel_t *m, aliashdr_t *mainhdr)
+{
+	aliashdr_t		*hdr;
+	unsigned short	*lods[MAX_ALIAS_LODS];
+	int				lodnumindexes[MAX_ALIAS_LODS];
+	int				i, count, numlods = 0, basetris = 0, lodtris[MAX_ALIAS_LODS];
+
+	if (isDedicated)
+		return;
+
+	memset (lodtris, 0, sizeof (lodtris));
+
+	for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+	{
+		count = GLMesh_SimplifySurface (hdr, lods, lodnumindexes);
+		numlods = q_max (numlods, count);
+		basetris += hdr->numindexes / 3;
+
+		for (i = 0; i < MAX_ALIAS_LODS; i++)
+		{
+			if (i < count)
+			{
+				unsigned short *dst = (unsigned short *) Hunk_AllocNoFill (lodnumindexes[i] * sizeof (unsigned short));
+				memcpy (dst, lods[i], lodnumindexes[i] * sizeof (unsigned short));
+				free (lods[i]);
+				hdr->lodindexes[i] = (byte *) dst - (byte *) hdr;
+				hdr->lodnumindexes[i] = lodnumindexes[i];
+			}
+			else if (i > 0)
+			{
+				hdr->lodindexes[i] = hdr->lodindexes[i - 1];
+				hdr->lodnumindexes[i] = hdr->lodnumindexes[i - 1];
+			}
+			else
+			{
+				hdr->lodindexes[i] = hdr->indexes;
+				hdr->lodnumindexes[i] = hdr->numindexes;
+			}
+			lodtris[i] += hdr->lodnumindexes[i] / 3;
+		}
+	}
+
+	for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+		hdr->numlods = numlods;
+
+	if (numlods)
+		Con_DPrintf ("%s: %d tris, LODs %d/%d/%d\n", m->name, basetris, lodtris[0], lodtris[1], lodtris[2]);
+}
+
+/*
+=================================================================
+
+ALIAS MODEL VERTEX POOL
+
+Alias models share vertex and index buffers, so that instances of
+different models can be submitted with one multi-draw call. The vertex
+buffer is also read as a shader storage block, which only has to be
+GL_MAX_SHADER_STORAGE_BLOCK_SIZE bytes large (16 MB in GL 4.3), so the
+models are spread over as few pools below that size as possible, with
+one multi-draw per pool.
+
+Models loaded during play are appended to the end of the last pool,
+growing it if needed, so the offsets of the models already in a pool stay
+valid. The pools are only rebuilt from scratch (dropping the space used
+by evicted models) on map load; the rebuild is deferred until the next
+draw so that loading a whole map only rebuilds them once.
+
+=================================================================
+*/
+
+aliaspool_t			gl_alias_pools[MAX_ALIAS_POOLS];
+int					gl_alias_numpools;
+
+static qmodel_t		**alias_pool_models;
+static qmodel_t		**alias_pool_pending;	// loaded since the last update, not in the buffers yet
+static qboolean		alias_pool_rebuild;
+
+/*
+================
+GLMesh_Align
+================
+*/
+static size_t GLMesh_Align (size_t ofs, size_t elemsize)
+{
+	return (ofs + elemsize - 1) / elemsize * elemsize;
+}
+
+/*
+================
+GLMesh_FillVertexBuffer
+
+Lays out the given alias model's mesh at the current pool offsets and
+advances them. The data is written to vbodata/ebodata, which hold the
+pool contents starting at vbobase/ebobase. Only computes the offsets if
+vbodata is NULL.
 
 Original code by MH from RMQEngine
 ================
 */
-void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr)
+static qboolean GLMesh_FillVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr, byte *vbodata, size_t vbobase, size_t *vbosize, byte *ebodata, size_t ebobase, size_t *ebosize)
 {
-	int totalvbosize = 0;
-	byte *ebodata;
-	byte *vbodata;
 	int f, v;
 	aliashdr_t *hdr;
 	unsigned int numindexes, numverts;
-	intptr_t vertofs;
-
-	if (isDedicated)
-		return;
+	size_t vertofs;
 
 	//count how much space we're going to need.
 	for(hdr = mainhdr, numverts = 0, numindexes = 0; hdr; hdr = Mod_NextSurface (hdr))
@@ -148,13 +653,8 @@ void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr)
 		switch(hdr->poseverttype)
 		{
 		case PV_QUAKE1:
-			totalvbosize += hdr->numposes * hdr->numverts_vbo * sizeof (meshxyz_t); // ericw -- what RMQEngine called nummeshframes is called numposes in QuakeSpasm
-			break;
 		case PV_IQM:
-			totalvbosize += hdr->numverts_vbo * sizeof (iqmvert_t);
-			break;
 		case PV_MD3:
-			totalvbosize += hdr->numposes * hdr->numverts_vbo * sizeof (md3pose_t);
 			break;
 		default:
 			Sys_Error ("Bad vert type %i for %s", hdr->poseverttype, m->name);
@@ -169,50 +669,49 @@ void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr)
 	if (numverts >= 65535)
 		Sys_Error ("Model %s has too many verts (%d)", m->name, numverts);
 
-	totalvbosize = GL_AlignSSBO (totalvbosize);
-	if (mainhdr->poseverttype == PV_QUAKE1 || mainhdr->poseverttype == PV_MD3)
-		totalvbosize += numverts * sizeof (meshst_t);
-	else
-		totalvbosize += mainhdr->numposes * mainhdr->numbones * sizeof (bonepose_t);
-
-	if (!totalvbosize) return;
-	if (!numindexes) return;
-
-	// create an elements buffer
-	ebodata = (byte *) malloc(numindexes * sizeof(unsigned short));
-	if (!ebodata)
-		return;	//fatal
-
-	// create the vertex buffer (empty)
-	vbodata = (byte *) malloc(totalvbosize);
-	if (!vbodata)
-	{	//fatal
-		free(ebodata);
-		return;
-	}
-	memset(vbodata, 0, totalvbosize);
+	if (!numverts || !numindexes)
+		return false;
 
 	// fill in index data
 	for (hdr = mainhdr, numverts = 0, numindexes = 0; hdr; hdr = Mod_NextSurface (hdr))
 	{
-		unsigned short *dstidx;
-		const unsigned short *srcidx;
-
-		hdr->eboofs = numindexes * sizeof (unsigned short);
-		dstidx = (unsigned short *) (ebodata + hdr->eboofs);
-		srcidx = (const unsigned short *) ((byte *) hdr + hdr->indexes);
-		for (f = 0; f < hdr->numindexes; f++)
-			dstidx[f] = srcidx[f] + numverts;
+		hdr->eboofs = *ebosize + numindexes * sizeof (unsigned short);
+		if (ebodata)
+		{
+			unsigned short *dstidx = (unsigned short *) (ebodata + (hdr->eboofs - ebobase));
+			const unsigned short *srcidx = (const unsigned short *) ((byte *) hdr + hdr->indexes);
+			for (f = 0; f < hdr->numindexes; f++)
+				dstidx[f] = srcidx[f] + numverts;
+		}
 		numindexes += hdr->numindexes;
 		numverts += hdr->numverts;
 	}
+	*ebosize += numindexes * sizeof (unsigned short);
 
-	vertofs = 0;
-	for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
-		hdr->vbovertofs = vertofs;
+	// LOD index lists go after the full detail ones, with the same per-surface vertex offsets
+	for (hdr = mainhdr, numverts = 0; hdr; hdr = Mod_NextSurface (hdr))
+	{
+		for (v = 0; v < hdr->numlods; v++)
+		{
+			hdr->lodeboofs[v] = *ebosize;
+			if (ebodata)
+			{
+				unsigned short *dstidx = (unsigned short *) (ebodata + (hdr->lodeboofs[v] - ebobase));
+				const unsigned short *srcidx = (const unsigned short *) ((byte *) hdr + hdr->lodindexes[v]);
+				for (f = 0; f < hdr->lodnumindexes[v]; f++)
+					dstidx[f] = srcidx[f] + numverts;
+			}
+			*ebosize += hdr->lodnumindexes[v] * sizeof (unsigned short);
+		}
+		numverts += hdr->numverts;
+	}
 
 	if (mainhdr->poseverttype == PV_QUAKE1 || mainhdr->poseverttype == PV_MD3)
 	{
+		vertofs = GLMesh_Align (*vbosize, mainhdr->poseverttype == PV_QUAKE1 ? sizeof (meshxyz_t) : sizeof (md3pose_t));
+		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+			hdr->vbovertofs = vertofs;
+
 		// fill in pose data
 		for (f = 0; f < mainhdr->numposes; f++)
 		{
@@ -220,27 +719,30 @@ void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr)
 			{
 				if (mainhdr->poseverttype == PV_QUAKE1)
 				{
-					// grab the pointers to data in the extradata
-					const aliasmesh_t *desc = (aliasmesh_t *) ((byte *) hdr + hdr->meshdesc);
-					const trivertx_t *tv = (const trivertx_t *) ((byte *)hdr + hdr->vertexes) + hdr->numverts * f;
-					meshxyz_t *xyz = (meshxyz_t *) (vbodata + vertofs);
-
-					for (v = 0; v < hdr->numverts_vbo; v++)
+					if (vbodata)
 					{
-						trivertx_t trivert = tv[desc[v].vertindex];
-
-						xyz[v].xyz[0] = trivert.v[0];
-						xyz[v].xyz[1] = trivert.v[1];
-						xyz[v].xyz[2] = trivert.v[2];
-						xyz[v].xyz[3] = 1;	// need w 1 for 4 byte vertex compression
-
-						// map the normal coordinates in [-1..1] to [-127..127] and store in an unsigned char.
-						// this introduces some error (less than 0.004), but the normals were very coarse
-						// to begin with
-						xyz[v].normal[0] = 127 * r_avertexnormals[trivert.lightnormalindex][0];
-						xyz[v].normal[1] = 127 * r_avertexnormals[trivert.lightnormalindex][1];
-						xyz[v].normal[2] = 127 * r_avertexnormals[trivert.lightnormalindex][2];
-						xyz[v].normal[3] = 0;	// unused; for 4-byte alignment
+						// grab the pointers to data in the extradata
+						const aliasmesh_t *desc = (aliasmesh_t *) ((byte *) hdr + hdr->meshdesc);
+						const trivertx_t *tv = (const trivertx_t *) ((byte *)hdr + hdr->vertexes) + hdr->numverts * f;
+						meshxyz_t *xyz = (meshxyz_t *) (vbodata + (vertofs - vbobase));
+
+						for (v = 0; v < hdr->numverts_vbo; v++)
+						{
+							trivertx_t trivert = tv[desc[v].vertindex];
+
+							xyz[v].xyz[0] = trivert.v[0];
+							xyz[v].xyz[1] = trivert.v[1];
+							xyz[v].xyz[2] = trivert.v[2];
+							xyz[v].xyz[3] = 1;	// need w 1 for 4 byte vertex compression
+
+							// map the normal coordinates in [-1..1] to [-127..127] and store in an unsigned char.
+							// this introduces some error (less than 0.004), but the normals were very coarse
+							// to begin with
+							xyz[v].normal[0] = 127 * r_avertexnormals[trivert.lightnormalindex][0];
+							xyz[v].normal[1] = 127 * r_avertexnormals[trivert.lightnormalindex][1];
+							xyz[v].normal[2] = 127 * r_avertexnormals[trivert.lightnormalindex][2];
+							xyz[v].normal[3] = 0;	// unused; for 4-byte alignment
+						}
 					}
 
 					vertofs += hdr->numverts_vbo * sizeof (meshxyz_t);
@@ -248,68 +750,98 @@ void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr)
 				else // PV_MD3
 				{
 					size_t posesize = hdr->numverts_vbo * sizeof (md3pose_t);
-					memcpy (vbodata + vertofs, (byte*)hdr + hdr->vertexes + f * posesize, posesize);
+					if (vbodata)
+						memcpy (vbodata + (vertofs - vbobase), (byte*)hdr + hdr->vertexes + f * posesize, posesize);
 					vertofs += posesize;
 				}
 			}
 		}
+
+		// fill in the ST coords
+		vertofs = GLMesh_Align (vertofs, sizeof (meshst_t));
+		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+			hdr->vbostofs = vertofs;
+		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+		{
+			if (vbodata)
+			{
+				const aliasmesh_t *desc = (aliasmesh_t *) ((byte *) hdr + hdr->meshdesc);
+				meshst_t *st = (meshst_t *) (vbodata + (vertofs - vbobase));
+
+				//johnfitz -- padded skins
+				float hscale = 1.0f / (float)TexMgr_PadConditional(hdr->skinwidth);
+				float vscale = 1.0f / (float)TexMgr_PadConditional(hdr->skinheight);
+				//johnfitz
+
+				for (f = 0; f < hdr->numverts_vbo; f++, st++) {
+					st->st[0] = hscale * ((float)desc[f].st[0] + 0.5f);
+					st->st[1] = vscale * ((float)desc[f].st[1] + 0.5f);
+				}
+			}
+			vertofs += hdr->numverts_vbo * sizeof (meshst_t);
+		}
 	}
 	else // PV_IQM
 	{
 		// copy vertices
+		vertofs = GLMesh_Align (*vbosize, sizeof (iqmvert_t));
+		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+			hdr->vbovertofs = vertofs;
 		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
 		{
-			memcpy (vbodata + vertofs, (byte *)hdr + hdr->vertexes, hdr->numverts_vbo * sizeof (iqmvert_t));
+			if (vbodata)
+				memcpy (vbodata + (vertofs - vbobase), (byte *)hdr + hdr->vertexes, hdr->numverts_vbo * sizeof (iqmvert_t));
 			vertofs += hdr->numverts_vbo * sizeof (iqmvert_t);
 		}
 
 		// copy bone poses
-		vertofs = GL_AlignSSBO (vertofs);
+		vertofs = GLMesh_Align (vertofs, sizeof (bonepose_t));
 		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
 			hdr->vboposeofs = vertofs;
-		memcpy (vbodata + mainhdr->vboposeofs, (byte *)mainhdr + mainhdr->boneposedata, mainhdr->numposes * mainhdr->numbones * sizeof (bonepose_t));
+		if (vbodata)
+			memcpy (vbodata + (mainhdr->vboposeofs - vbobase), (byte *)mainhdr + mainhdr->boneposedata, mainhdr->numposes * mainhdr->numbones * sizeof (bonepose_t));
+		vertofs += mainhdr->numposes * mainhdr->numbones * sizeof (bonepose_t);
 	}
 
-	vertofs = GL_AlignSSBO (vertofs);
+	*vbosize = vertofs;
 
-	// fill in the ST coords at the end of the buffer
-	if (mainhdr->poseverttype == PV_QUAKE1 || mainhdr->poseverttype == PV_MD3)
-	{
-		meshst_t *st = (meshst_t *) (vbodata + vertofs);
-		for (hdr = mainhdr, numverts = 0; hdr; hdr = Mod_NextSurface (hdr))
-		{
-			const aliasmesh_t *desc = (aliasmesh_t *) ((byte *) hdr + hdr->meshdesc);
+	return true;
+}
 
-			//johnfitz -- padded skins
-			float hscale = 1.0f / (float)TexMgr_PadConditional(hdr->skinwidth);
-			float vscale = 1.0f / (float)TexMgr_PadConditional(hdr->skinheight);
-			//johnfitz
+/*
+================
+GLMesh_LoadVertexBuffer
 
-			hdr->vbostofs = vertofs;
-			for (f = 0; f < hdr->numverts_vbo; f++, st++) {
-				st->st[0] = hscale * ((float)desc[f].st[0] + 0.5f);
-				st->st[1] = vscale * ((float)desc[f].st[1] + 0.5f);
-			}
-		}
-	}
+Adds the given alias model to the shared vertex pool.
+Its data is uploaded by GLMesh_UpdateVertexBuffers.
+================
+*/
+void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *mainhdr)
+{
+	size_t i, count;
 
-	// upload indexes buffer
-	GL_DeleteBuffer (m->meshindexesvbo);
-	m->meshindexesvbo = GL_CreateBuffer (GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, va ("%s indices", m->name), numindexes * sizeof (unsigned short), ebodata);
+	if (isDedicated)
+		return;
 
-	// upload vertexes buffer
-	GL_DeleteBuffer (m->meshvbo);
-	m->meshvbo = GL_CreateBuffer (GL_ARRAY_BUFFER, GL_STATIC_DRAW, va ("%s vertices", m->name), totalvbosize, vbodata);
+	mainhdr->vbopool = -1; // not drawable until it's uploaded
 
-	free (vbodata);
-	free (ebodata);
+	for (i = 0, count = VEC_SIZE (alias_pool_pending); i < count; i++)
+		if (alias_pool_pending[i] == m)
+			break;
+	if (i == count)
+		VEC_PUSH (alias_pool_pending, m);
+
+	for (i = 0, count = VEC_SIZE (alias_pool_models); i < count; i++)
+		if (alias_pool_models[i] == m)
+			return;
+	VEC_PUSH (alias_pool_models, m);
 }
 
 /*
 ================
 GLMesh_LoadVertexBuffers
 
-Loop over all precached alias models, and upload each one to a VBO.
+Loop over all precached alias models, and add each one to the pool.
 ================
 */
 void GLMesh_LoadVertexBuffers (void)
@@ -329,32 +861,332 @@ void GLMesh_LoadVertexBuffers (void)
 	}
 }
 
+/*
+================
+GLMesh_RebuildVertexBuffers
+
+Requests a full rebuild of the pool before the next draw (called on map load)
+================
+*/
+void GLMesh_RebuildVertexBuffers (void)
+{
+	alias_pool_rebuild = true;
+}
+
+/*
+================
+GLMesh_VertexBuffersDirty
+
+Returns true if the pool needs to be rebuilt before the next draw
+(which also invalidates all previously computed model offsets)
+================
+*/
+qboolean GLMesh_VertexBuffersDirty (void)
+{
+	return alias_pool_rebuild;
+}
+
+/*
+================
+GLMesh_MaxPoolSize
+
+Largest vertex buffer that can be bound as a shader storage block
+================
+*/
+static size_t GLMesh_MaxPoolSize (void)
+{
+	static GLint maxsize;
+
+	if (!maxsize)
+	{
+		glGetIntegerv (GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxsize);
+		maxsize = q_max (maxsize, 16 * 1024 * 1024);	// GL 4.3 minimum
+	}
+
+	return (size_t) maxsize;
+}
+
+/*
+================
+GLMesh_PlaceModel
+
+Reserves space for the model at the end of the last pool, or in a new pool
+if it doesn't fit there, and sets its offsets. Returns false if the model
+can't be placed at all.
+================
+*/
+static qboolean GLMesh_PlaceModel (qmodel_t *m, aliashdr_t *mainhdr, size_t *vbostart, size_t *ebostart)
+{
+	size_t		maxsize = GLMesh_MaxPoolSize ();
+	size_t		vbosize, ebosize;
+	aliaspool_t	*pool;
+
+	mainhdr->vbopool = -1;
+
+	if (!gl_alias_numpools)
+		memset (&gl_alias_pools[gl_alias_numpools++], 0, sizeof (gl_alias_pools[0]));
+	pool = &gl_alias_pools[gl_alias_numpools - 1];
+
+	vbosize = pool->vbosize;
+	ebosize = pool->ibosize;
+	if (!GLMesh_FillVertexBuffer (m, mainhdr, NULL, 0, &vbosize, NULL, 0, &ebosize))
+		return false;
+
+	if (vbosize > maxsize && pool->vbosize)
+	{
+		if (gl_alias_numpools == MAX_ALIAS_POOLS)
+		{
+			Con_Warning ("Alias vertex pool full, not drawing %s\n", m->name);
+			return false;
+		}
+		pool = &gl_alias_pools[gl_alias_numpools];
+		memset (pool, 0, sizeof (*pool));
+		vbosize = ebosize = 0;
+		GLMesh_FillVertexBuffer (m, mainhdr, NULL, 0, &vbosize, NULL, 0, &ebosize);
+		if (vbosize <= maxsize)
+			gl_alias_numpools++;
+	}
+
+	if (vbosize > maxsize)
+	{
+		Con_Warning ("%s needs %" SDL_PRIu64 "K of vertex data, more than the %" SDL_PRIu64 "K limit, not drawing it\n",
+			m->name, (uint64_t) (vbosize >> 10), (uint64_t) (maxsize >> 10));
+		return false;
+	}
+
+	*vbostart = pool->vbosize;
+	*ebostart = pool->ibosize;
+	pool->vbosize = vbosize;
+	pool->ibosize = ebosize;
+	mainhdr->vbopool = (int) (pool - gl_alias_pools);
+
+	return true;
+}
+
+/*
+================
+GLMesh_UploadModel
+
+Writes a placed model's data to its pool
+================
+*/
+static void GLMesh_UploadModel (qmodel_t *m, aliashdr_t *mainhdr, size_t vbostart, size_t ebostart)
+{
+	const aliaspool_t	*pool = &gl_alias_pools[mainhdr->vbopool];
+	size_t				vbosize = vbostart, ebosize = ebostart;
+	byte				*vbodata, *ebodata;
+
+	// stage the data, it starts at the given offsets in the pool
+	GLMesh_FillVertexBuffer (m, mainhdr, NULL, 0, &vbosize, NULL, 0, &ebosize);
+	vbodata = (byte *) calloc (vbosize - vbostart, 1);
+	ebodata = (byte *) malloc (ebosize - ebostart);
+	if (!vbodata || !ebodata)
+		Sys_Error ("GLMesh_UploadModel: out of memory (%" SDL_PRIu64 " bytes)", (uint64_t) (vbosize - vbostart + ebosize - ebostart));
+
+	vbosize = vbostart;
+	ebosize = ebostart;
+	GLMesh_FillVertexBuffer (m, mainhdr, vbodata, vbostart, &vbosize, ebodata, ebostart, &ebosize);
+
+	GL_BindBufferFunc (GL_COPY_WRITE_BUFFER, pool->vbo);
+	GL_BufferSubDataFunc (GL_COPY_WRITE_BUFFER, vbostart, vbosize - vbostart, vbodata);
+	GL_BindBufferFunc (GL_COPY_WRITE_BUFFER, pool->ibo);
+	GL_BufferSubDataFunc (GL_COPY_WRITE_BUFFER, ebostart, ebosize - ebostart, ebodata);
+
+	free (vbodata);
+	free (ebodata);
+}
+
+/*
+================
+GLMesh_GrowBuffer
+
+Reallocates a pool buffer with the given capacity, keeping its contents
+================
+*/
+static GLuint GLMesh_GrowBuffer (GLuint buffer, size_t used, size_t capacity, const char *name)
+{
+	GLuint newbuffer;
+
+	GL_GenBuffersFunc (1, &newbuffer);
+	GL_BindBufferFunc (GL_COPY_WRITE_BUFFER, newbuffer);
+	GL_ObjectLabelFunc (GL_BUFFER, newbuffer, -1, name);
+	GL_BufferDataFunc (GL_COPY_WRITE_BUFFER, capacity, NULL, GL_STATIC_DRAW);
+	if (used)
+	{
+		GL_BindBufferFunc (GL_COPY_READ_BUFFER, buffer);
+		GL_CopyBufferSubDataFunc (GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+	}
+	GL_DeleteBuffer (buffer);
+
+	return newbuffer;
+}
+
+/*
+================
+GLMesh_ReservePool
+
+Makes sure the pool's buffers can hold what has been placed in it.
+Buffer contents up to the given sizes are kept.
+================
+*/
+static void GLMesh_ReservePool (aliaspool_t *pool, size_t vboused, size_t iboused)
+{
+	size_t maxsize = GLMesh_MaxPoolSize ();
+
+	// leave some room for models loaded later, placing never goes past maxsize
+	if (pool->vbosize > pool->vbocapacity)
+	{
+		pool->vbocapacity = q_min (q_max (pool->vbosize + pool->vbosize / 4, pool->vbocapacity + pool->vbocapacity / 2), maxsize);
+		pool->vbo = GLMesh_GrowBuffer (pool->vbo, vboused, pool->vbocapacity, "alias vertices");
+	}
+	if (pool->ibosize > pool->ibocapacity)
+	{
+		pool->ibocapacity = q_max (pool->ibosize + pool->ibosize / 4, pool->ibocapacity + pool->ibocapacity / 2);
+		pool->ibo = GLMesh_GrowBuffer (pool->ibo, iboused, pool->ibocapacity, "alias indices");
+	}
+}
+
+/*
+================
+GLMesh_AppendVertexBuffers
+
+Appends the models loaded since the last update to the end of the pools
+================
+*/
+static void GLMesh_AppendVertexBuffers (void)
+{
+	size_t		i, count, vbostart, ebostart;
+	aliashdr_t	*hdr;
+	aliaspool_t	*pool;
+
+	for (i = 0, count = VEC_SIZE (alias_pool_pending); i < count; i++)
+	{
+		qmodel_t *m = alias_pool_pending[i];
+		if (m->type != mod_alias || !(hdr = (aliashdr_t *) Cache_Check (&m->cache)))
+			continue;
+		if (!GLMesh_PlaceModel (m, hdr, &vbostart, &ebostart))
+			continue;
+		pool = &gl_alias_pools[hdr->vbopool];
+		GLMesh_ReservePool (pool, vbostart, ebostart);
+		GLMesh_UploadModel (m, hdr, vbostart, ebostart);
+	}
+
+	Con_DPrintf ("Alias vertex pool: appended %d models\n", (int) VEC_SIZE (alias_pool_pending));
+}
+
+/*
+================
+GLMesh_DeletePools
+================
+*/
+static void GLMesh_DeletePools (void)
+{
+	int i;
+
+	for (i = 0; i < gl_alias_numpools; i++)
+	{
+		GL_DeleteBuffer (gl_alias_pools[i].vbo);
+		GL_DeleteBuffer (gl_alias_pools[i].ibo);
+	}
+	memset (gl_alias_pools, 0, sizeof (gl_alias_pools));
+	gl_alias_numpools = 0;
+}
+
+/*
+================
+GLMesh_UpdateVertexBuffers
+
+Uploads the alias models loaded since the last update. If a full rebuild
+was requested, the pools are instead recreated from all the alias models
+that are still in the cache. Evicted models are dropped from the pool,
+they are added back when reloaded.
+================
+*/
+void GLMesh_UpdateVertexBuffers (void)
+{
+	size_t		i, j, count;
+	size_t		vbosize = 0, ebosize = 0;
+	size_t		*starts;
+	aliashdr_t	*hdr;
+
+	if (!alias_pool_rebuild)
+	{
+		if (VEC_SIZE (alias_pool_pending))
+		{
+			GLMesh_AppendVertexBuffers ();
+			VEC_CLEAR (alias_pool_pending);
+		}
+		return;
+	}
+	alias_pool_rebuild = false;
+	VEC_CLEAR (alias_pool_pending);
+
+	GLMesh_DeletePools ();
+
+	// drop evicted models
+	for (i = j = 0, count = VEC_SIZE (alias_pool_models); i < count; i++)
+	{
+		qmodel_t *m = alias_pool_models[i];
+		if (m->type != mod_alias || !Cache_Check (&m->cache))
+			continue;
+		alias_pool_models[j++] = m;
+	}
+	if (j < count)
+		VEC_POP_N (alias_pool_models, count - j);
+
+	count = VEC_SIZE (alias_pool_models);
+	if (!count)
+		return;
+	starts = (size_t *) malloc (count * 2 * sizeof (*starts));
+	if (!starts)
+		Sys_Error ("GLMesh_UpdateVertexBuffers: out of memory");
+
+	// lay out all the models first, so that each pool is created with its final size
+	for (i = 0; i < count; i++)
+	{
+		qmodel_t *m = alias_pool_models[i];
+		hdr = (aliashdr_t *) Cache_Check (&m->cache);
+		GLMesh_PlaceModel (m, hdr, &starts[i*2], &starts[i*2+1]);
+	}
+
+	for (i = 0; i < (size_t) gl_alias_numpools; i++)
+	{
+		GLMesh_ReservePool (&gl_alias_pools[i], 0, 0);
+		vbosize += gl_alias_pools[i].vbosize;
+		ebosize += gl_alias_pools[i].ibosize;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		qmodel_t *m = alias_pool_models[i];
+		hdr = (aliashdr_t *) Cache_Check (&m->cache);
+		if (hdr->vbopool >= 0)
+			GLMesh_UploadModel (m, hdr, starts[i*2], starts[i*2+1]);
+	}
+
+	free (starts);
+
+	Con_DPrintf ("Alias vertex pool: %d models in %d pools, %" SDL_PRIu64 "K vertex data, %" SDL_PRIu64 "K indices\n",
+		(int) VEC_SIZE (alias_pool_models), gl_alias_numpools, (uint64_t) (vbosize >> 10), (uint64_t) (ebosize >> 10));
+}
+
 /*
 ================
 GLMesh_DeleteVertexBuffers
 
-Delete VBOs for all loaded alias models
+Delete the vertex pool and forget all the models in it
 ================
 */
 void GLMesh_DeleteVertexBuffers (void)
 {
-	int j;
-	qmodel_t *m;
-	
 	if (isDedicated)
 		return;
 
-	for (j = 1; j < MAX_MODELS; j++)
-	{
-		if (!(m = cl.model_precache[j])) break;
-		if (m->type != mod_alias) continue;
-		
-		GL_DeleteBuffersFunc (1, &m->meshvbo);
-		m->meshvbo = 0;
+	GLMesh_DeletePools ();
 
-		GL_DeleteBuffersFunc (1, &m->meshindexesvbo);
-		m->meshindexesvbo = 0;
-	}
+	VEC_CLEAR (alias_pool_models);
+	VEC_CLEAR (alias_pool_pending);
+	alias_pool_rebuild = false;
 	
 	GL_ClearBufferBindings ();
 }
@@ -52,6 +52,30 @@ static int	mod_decompressed_capacity;
 static qmodel_t	mod_known[MAX_MOD_KNOWN];
 static int		mod_numknown;
 
+static cvar_t	mod_resident_mb = {"mod_resident_mb", "256", CVAR_ARCHIVE}; // 0 = always reload the world on level change
+
+// files checked before reusing a resident world
+static const char *const mod_resident_exts[] = {"bsp", "lit", "ent"};
+
+typedef struct
+{
+	int				size;		// -1 if not found
+	unsigned int	path_id;
+	time_t			mtime;
+} modfileinfo_t;
+
+// The last world model is kept loaded across level changes to the same map.
+// Only one world can be resident: it lives at the bottom of the level's hunk
+// space, and the hunk is only ever freed down to a mark.
+static struct
+{
+	qmodel_t		*world;		// NULL if nothing is resident
+	qboolean		keep;		// set by Mod_KeepWorld for the next Mod_ClearAll
+	int				hunkstart;
+	int				hunkend;
+	modfileinfo_t	files[countof (mod_resident_exts)];
+} mod_resident;
+
 texture_t	*r_notexture_mip; //johnfitz -- moved here from r_main.c
 texture_t	*r_notexture_mip2; //johnfitz -- used for non-lightmapped surfs with a missing texture
 /*
@@ -99,6 +123,7 @@ void Mod_Init (void)
 	Cvar_RegisterVariable (&r_enhancedmodels_prio);
 	Cvar_SetCallback (&r_enhancedmodels, R_ENHANCEDMODELS_f);
 	Cvar_SetCallback (&r_enhancedmodels_prio, R_ENHANCEDMODELS_f);
+	Cvar_RegisterVariable (&mod_resident_mb);
 
 	Cmd_AddCommand ("mcache", Mod_Print);
 
@@ -254,6 +279,135 @@ byte *Mod_NoVisPVS (qmodel_t *model)
 	return mod_novis;
 }
 
+/*
+===================
+Mod_GetWorldFiles
+===================
+*/
+static void Mod_GetWorldFiles (const char *modelname, modfileinfo_t *files)
+{
+	char	path[MAX_QPATH];
+	size_t	i;
+
+	for (i = 0; i < countof (mod_resident_exts); i++)
+	{
+		COM_StripExtension (modelname, path, sizeof (path));
+		COM_AddExtension (path, va (".%s", mod_resident_exts[i]), sizeof (path));
+		files[i].path_id = 0;
+		files[i].mtime = 0;
+		files[i].size = COM_FileInfo (path, &files[i].path_id, &files[i].mtime);
+	}
+}
+
+/*
+===================
+Mod_IsResident
+
+Returns true for the resident world and its submodels
+===================
+*/
+static qboolean Mod_IsResident (qmodel_t *mod)
+{
+	qmodel_t *world = mod_resident.world;
+
+	if (!world)
+		return false;
+	if (mod == world)
+		return true;
+	return mod->name[0] == '*' && mod->type == mod_brush && !mod->needload && mod->surfaces == world->surfaces;
+}
+
+/*
+===================
+Mod_KeepWorld
+
+Called before Host_ClearMemory when the server is about to load a map.
+If it's the resident world and none of its files changed on disk,
+the next Mod_ClearAll leaves it loaded instead of parsing it again.
+===================
+*/
+void Mod_KeepWorld (const char *modelname)
+{
+	modfileinfo_t	files[countof (mod_resident_exts)];
+	size_t			i;
+
+	mod_resident.keep = false;
+
+	if (!mod_resident.world || mod_resident.world->needload || strcmp (mod_resident.world->name, modelname) != 0)
+		return;
+	if (mod_resident.hunkstart != host_hunklevel || Hunk_LowMark () < mod_resident.hunkend)
+		return;
+	if (mod_resident_mb.value <= 0.f)
+		return;
+
+	Mod_GetWorldFiles (modelname, files);
+	for (i = 0; i < countof (files); i++)
+	{
+		if (files[i].size != mod_resident.files[i].size ||
+			files[i].path_id != mod_resident.files[i].path_id ||
+			files[i].mtime != mod_resident.files[i].mtime)
+		{
+			Con_DPrintf ("%s changed on disk, reloading\n", modelname);
+			return;
+		}
+	}
+
+	mod_resident.keep = true;
+}
+
+/*
+===================
+Mod_SetResidentWorld
+
+Called after the world and its submodels have been loaded,
+with the hunk mark from before loading them
+===================
+*/
+void Mod_SetResidentWorld (qmodel_t *world, int hunkstart)
+{
+	double	bytes;
+	int		hunkend;
+
+	if (world == mod_resident.world)
+	{
+		Con_DPrintf ("Reusing resident %s\n", world->name);
+		return;
+	}
+
+	mod_resident.world = NULL;
+
+	// the world must be the first thing allocated for the level,
+	// anything below it would be kept around as well
+	if (hunkstart != host_hunklevel || mod_resident_mb.value <= 0.f)
+		return;
+
+	hunkend = Hunk_LowMark ();
+	bytes = (double)(hunkend - hunkstart) + (double)TexMgr_GetOwnerBytes (world);
+	if (bytes > mod_resident_mb.value * 0x100000)
+	{
+		Con_DPrintf ("%s exceeds mod_resident_mb (%.1f MB), not keeping it resident\n", world->name, bytes / 0x100000);
+		return;
+	}
+
+	mod_resident.world = world;
+	mod_resident.hunkstart = hunkstart;
+	mod_resident.hunkend = hunkend;
+	Mod_GetWorldFiles (world->name, mod_resident.files);
+}
+
+/*
+===================
+Mod_ResidentHunkMark
+
+Returns the lowest hunk mark that a level change can free to
+without discarding the resident world
+===================
+*/
+int Mod_ResidentHunkMark (void)
+{
+	return mod_resident.world ? mod_resident.hunkend : 0;
+}
+
 /*
 ===================
 Mod_ClearAll
@@ -268,10 +422,16 @@ void Mod_ClearAll (void)
 	{
 		if (mod->type != mod_alias)
 		{
+			if (mod_resident.keep && Mod_IsResident (mod))
+				continue;
 			mod->needload = true;
 			TexMgr_FreeTexturesForOwner (mod); //johnfitz
 		}
 	}
+
+	if (!mod_resident.keep)
+		mod_resident.world = NULL;
+	mod_resident.keep = false;
 }
 
 void Mod_ResetAll (void)
@@ -289,6 +449,8 @@ void Mod_ResetAll (void)
 		memset(mod, 0, sizeof(qmodel_t));
 	}
 	mod_numknown = 0;
+
+	memset (&mod_resident, 0, sizeof (mod_resident));
 }
 
 /*
@@ -405,17 +567,21 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
 	switch (mod_type)
 	{
 	case IDPOLYHEADER:
+		LoadProf_Begin ("Mod_LoadAliasModel");
 		Mod_LoadAliasModel (mod, buf);
 		break;
 
 	case IDSPRITEHEADER:
+		LoadProf_Begin ("Mod_LoadSpriteModel");
 		Mod_LoadSpriteModel (mod, buf);
 		break;
 
 	default:
+		LoadProf_Begin ("Mod_LoadBrushModel");
 		Mod_LoadBrushModel (mod, buf);
 		break;
 	}
+	LoadProf_End ();
 
 	free (buf);
 
@@ -2599,7 +2765,7 @@ qboolean Mod_LoadMapDescription (char *desc, size_t maxchars, const char *map)
 	char		buf[4 * 1024];
 	char		path[MAX_QPATH];
 	const char	*data;
-	FILE		*f;
+	fileloc_t	loc;
 	lump_t		*entlump;
 	dheader_t	header;
 	int			i, filesize;
@@ -2612,19 +2778,13 @@ qboolean Mod_LoadMapDescription (char *desc, size_t maxchars, const char *map)
 	if ((size_t) q_snprintf (path, sizeof (path), "maps/%s.bsp", map) >= sizeof (path))
 		return false;
 
-	filesize = COM_FOpenFile (path, &f, NULL);
-	if (filesize <= (int) sizeof (header))
-	{
-		if (filesize != -1)
-			fclose (f);
+	// use the re-entrant file system functions, since this runs on a worker thread
+	if (!FS_FindFile (path, &loc) || loc.size <= (int) sizeof (header) || loc.size > INT_MAX)
 		return false;
-	}
+	filesize = (int) loc.size;
 
-	if (fread (&header, sizeof (header), 1, f) != 1)
-	{
-		fclose (f);
+	if (FS_ReadFile (&loc, 0, &header, sizeof (header)) != (int) sizeof (header))
 		return false;
-	}
 
 	header.version = LittleLong (header.version);
 
@@ -2636,7 +2796,6 @@ qboolean Mod_LoadMapDescription (char *desc, size_t maxchars, const char *map)
 	case BSPVERSION_QUAKE64:
 		break;
 	default:
-		fclose (f);
 		return false;
 	}
 
@@ -2646,10 +2805,7 @@ qboolean Mod_LoadMapDescription (char *desc, size_t maxchars, const char *map)
 	entlump = &header.lumps[LUMP_ENTITIES];
 	if (entlump->filelen < 0 || entlump->filelen >= filesize ||
 		entlump->fileofs < 0 || entlump->fileofs + entlump->filelen > filesize)
-	{
-		fclose (f);
 		return false;
-	}
 
 	// if the entity lump is large enough we assume the map is playable
 	// and only try to parse the first entity (worldspawn) for the map title
@@ -2659,10 +2815,7 @@ qboolean Mod_LoadMapDescription (char *desc, size_t maxchars, const char *map)
 		entlump->filelen = sizeof (buf) - 1;
 	}
 
-	fseek (f, entlump->fileofs - sizeof (header), SEEK_CUR);
-	i = fread (buf, 1, entlump->filelen, f);
-	fclose (f);
-
+	i = FS_ReadFile (&loc, entlump->fileofs, buf, entlump->filelen);
 	if (i <= 0)
 		return false;
 	buf[i] = '\0';
@@ -2919,7 +3072,7 @@ static void *Mod_LoadAllSkins (int numskins, daliasskintype_t *pskintype)
 	daliasskininterval_t	*pinskinintervals;
 	char			fbr_mask_name[MAX_QPATH]; //johnfitz -- added for fullbright support
 	src_offset_t		offset; //johnfitz
-	unsigned int		texflags = TEXPREF_PAD;
+	unsigned int		texflags = TEXPREF_PAD | TEXPREF_BINDLESS;
 
 	skin = (byte *)(pskintype + 1);
 
@@ -4306,24 +4459,24 @@ static void Mod_LoadMD5MeshModel (qmodel_t *mod, const char *buffer)
 				//now load whatever we found
 				if (data) //load external image
 				{
-					surf->gltextures[surf->numskins][f] = TexMgr_LoadImage (mod, texname, fwidth, fheight, fmt, data, texname, 0, TEXPREF_ALPHA|TEXPREF_NOBRIGHT|TEXPREF_MIPMAP );
+					surf->gltextures[surf->numskins][f] = TexMgr_LoadImage (mod, texname, fwidth, fheight, fmt, data, texname, 0, TEXPREF_ALPHA|TEXPREF_NOBRIGHT|TEXPREF_MIPMAP|TEXPREF_BINDLESS );
 					surf->fbtextures[surf->numskins][f] = NULL;
 					if (fmt == SRC_INDEXED)
 					{	//8bit base texture. use it for fullbrights.
 						if (Mod_CheckFullbrights (data, fwidth*fheight))
-							surf->fbtextures[surf->numskins][f] = TexMgr_LoadImage (mod, va("%s_luma", texname), fwidth, fheight, fmt, data, texname, 0, TEXPREF_ALPHA|TEXPREF_FULLBRIGHT|TEXPREF_MIPMAP );
+							surf->fbtextures[surf->numskins][f] = TexMgr_LoadImage (mod, va("%s_luma", texname), fwidth, fheight, fmt, data, texname, 0, TEXPREF_ALPHA|TEXPREF_FULLBRIGHT|TEXPREF_MIPMAP|TEXPREF_BINDLESS );
 					}
 					else
 					{	//we found a 32bit base texture.
 						if (!surf->fbtextures[surf->numskins][f])
 						{
 							q_snprintf(texname, sizeof(texname), "progs/%s_%02u_%02u_glow", com_token, surf->numskins, f);
-							surf->fbtextures[surf->numskins][f] = TexMgr_LoadImage(mod, texname, surf->skinwidth, surf->skinheight, SRC_RGBA, NULL, texname, 0, TEXPREF_MIPMAP);
+							surf->fbtextures[surf->numskins][f] = TexMgr_LoadImage(mod, texname, surf->skinwidth, surf->skinheight, SRC_RGBA, NULL, texname, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 						}
 						if (!surf->fbtextures[surf->numskins][f])
 						{
 							q_snprintf(texname, sizeof(texname), "progs/%s_%02u_%02u_luma", com_token, surf->numskins, f);
-							surf->fbtextures[surf->numskins][f] = TexMgr_LoadImage(mod, texname, surf->skinwidth, surf->skinheight, SRC_RGBA, NULL, texname, 0, TEXPREF_MIPMAP);
+							surf->fbtextures[surf->numskins][f] = TexMgr_LoadImage(mod, texname, surf->skinwidth, surf->skinheight, SRC_RGBA, NULL, texname, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 						}
 					}
 
@@ -4426,6 +4579,7 @@ static void Mod_LoadMD5MeshModel (qmodel_t *mod, const char *buffer)
 	}
 	Z_Free(outposes);
 
+	GLMesh_BuildLODs (mod, outhdr);
 	GLMesh_LoadVertexBuffer (mod, outhdr);
 
 	// Note: the md5 format does not have its own modelflags, yet we still need to know about trails and rotating etc, so we reuse the flags from the mdl version.
@@ -4564,7 +4718,7 @@ static void Mod_LoadMD3_LoadGlowLuma (qmodel_t* mod, aliashdr_t* hdr, int skinnu
 	{
 		if (Mod_CheckFullbrights (base_data, fwidth * fheight))
 		{
-			fb_tex = TexMgr_LoadImage (mod, luma_path, fwidth, fheight, fmt, base_data, luma_path, 0, TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT);
+			fb_tex = TexMgr_LoadImage (mod, luma_path, fwidth, fheight, fmt, base_data, luma_path, 0, TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT | TEXPREF_BINDLESS);
 		}
 	}
 	else
@@ -4576,14 +4730,14 @@ static void Mod_LoadMD3_LoadGlowLuma (qmodel_t* mod, aliashdr_t* hdr, int skinnu
 		fb_data = Image_LoadImage (glow_path, (int*)&fb_width, (int*)&fb_height, &fb_fmt);
 		if (fb_data)
 		{
-			fb_tex = TexMgr_LoadImage (mod, glow_path, fb_width, fb_height, fb_fmt, fb_data, glow_path, 0, TEXPREF_MIPMAP);
+			fb_tex = TexMgr_LoadImage (mod, glow_path, fb_width, fb_height, fb_fmt, fb_data, glow_path, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 		}
 		else
 		{
 			fb_data = Image_LoadImage (luma_path, (int*)&fb_width, (int*)&fb_height, &fb_fmt);
 			if (fb_data)
 			{
-				fb_tex = TexMgr_LoadImage (mod, luma_path, fb_width, fb_height, fb_fmt, fb_data, luma_path, 0, TEXPREF_MIPMAP);
+				fb_tex = TexMgr_LoadImage (mod, luma_path, fb_width, fb_height, fb_fmt, fb_data, luma_path, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 			}
 		}
 	}
@@ -4681,7 +4835,7 @@ static void Mod_LoadMD3_LoadSkinFileTextures (qmodel_t* mod, aliashdr_t* hdr, in
 						void* data = Image_LoadImage (texture_path, (int*)&fwidth, (int*)&fheight, &fmt);
 
 						if (data) {
-							struct gltexture_s* tex = TexMgr_LoadImage (mod, texture_path, fwidth, fheight, fmt, data, texture_path, 0, TEXPREF_MIPMAP);
+							struct gltexture_s* tex = TexMgr_LoadImage (mod, texture_path, fwidth, fheight, fmt, data, texture_path, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 
 							for (int frame = 0; frame < 4; frame++) {
 								if (!hdr->gltextures[skinnum][frame])
@@ -4734,7 +4888,7 @@ static void Mod_LoadMD3_LoadNonSkinFileTextures (qmodel_t* mod, aliashdr_t* hdr,
 			}
 
 			if (data) {
-				hdr->gltextures[skinnum][f] = TexMgr_LoadImage (mod, fallback_path, fwidth, fheight, fmt, data, fallback_path, 0, TEXPREF_MIPMAP);
+				hdr->gltextures[skinnum][f] = TexMgr_LoadImage (mod, fallback_path, fwidth, fheight, fmt, data, fallback_path, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 				hdr->numskins = skinnum + 1;
 				frames_found++;
 
@@ -4767,7 +4921,7 @@ static void Mod_LoadMD3_LoadNonSkinFileTextures (qmodel_t* mod, aliashdr_t* hdr,
 		}
 
 		if (data) {
-			hdr->gltextures[skinnum][0] = TexMgr_LoadImage (mod, fallback_path, fwidth, fheight, fmt, data, fallback_path, 0, TEXPREF_MIPMAP);
+			hdr->gltextures[skinnum][0] = TexMgr_LoadImage (mod, fallback_path, fwidth, fheight, fmt, data, fallback_path, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 			hdr->numskins = skinnum + 1;
 
 			char base_tex_name[MAX_QPATH];
@@ -4794,7 +4948,7 @@ static void Mod_LoadMD3_LoadNonSkinFileTextures (qmodel_t* mod, aliashdr_t* hdr,
 			}
 
 			if (data) {
-				hdr->gltextures[0][0] = TexMgr_LoadImage (mod, fallback_path, fwidth, fheight, fmt, data, fallback_path, 0, TEXPREF_MIPMAP);
+				hdr->gltextures[0][0] = TexMgr_LoadImage (mod, fallback_path, fwidth, fheight, fmt, data, fallback_path, 0, TEXPREF_MIPMAP | TEXPREF_BINDLESS);
 				hdr->numskins = 1;
 
 				char base_tex_name[MAX_QPATH];
@@ -4863,7 +5017,6 @@ static void Mod_LoadMD3Model (qmodel_t* mod, const char* buffer)
 	char basepath[MAX_QPATH], md3path[MAX_QPATH], loadname[32];
 	int skinnum;
 
-	int validation_mark;
 	char** md3_surface_names;
 	int valid_skin_path_id[MAX_SKINS];
 	memset (valid_skin_path_id, 0, sizeof (valid_skin_path_id));
@@ -4889,7 +5042,6 @@ static void Mod_LoadMD3Model (qmodel_t* mod, const char* buffer)
 	mainhdr = (aliashdr_t*)Hunk_Alloc (in_header->numSurfaces * hdrsize);
 	memset (mainhdr, 0, in_header->numSurfaces * hdrsize);
 
-	validation_mark = Hunk_LowMark ();
 	md3_surface_names = (char**)Hunk_Alloc (in_header->numSurfaces * sizeof (char*));
 	md3Surface_t* temp_surf = (md3Surface_t*)((byte*)in_header + in_header->ofsSurfaces);
 	for (i = 0; i < in_header->numSurfaces; i++)
@@ -5104,11 +5256,13 @@ static void Mod_LoadMD3Model (qmodel_t* mod, const char* buffer)
 		}
 	}
 
-	Hunk_FreeToLowMark (validation_mark);
+	// Note: the temporary allocations are interleaved with the surface data,
+	// which has to end up in the cache (the alias vertex pool is built from it)
 
 	mod->type = mod_alias;
 	mod->synctype = ST_SYNC;
 
+	GLMesh_BuildLODs (mod, mainhdr);
 	GLMesh_LoadVertexBuffer (mod, mainhdr);
 	Mod_CalcAliasBounds (mainhdr);
 
@@ -296,6 +296,7 @@ typedef struct
 } maliasframedesc_t;
 
 #define	MAX_SKINS	32
+#define	MAX_ALIAS_LODS	3	// not counting full detail
 typedef struct {
 	int			ident;
 	int			version;
@@ -324,8 +325,15 @@ typedef struct {
 	intptr_t	vbostofs;
 	intptr_t	vboposeofs;
 	intptr_t	eboofs;
+	int			vbopool;	// index in gl_alias_pools, -1 if not uploaded (main surface only)
 	//ericw --
 
+	// reduced detail index lists, using the same vertices (see GLMesh_BuildLODs)
+	int			numlods;						// same for all surfaces of a model
+	int			lodnumindexes[MAX_ALIAS_LODS];
+	intptr_t	lodindexes[MAX_ALIAS_LODS];	// offset into extradata: lodnumindexes[i] unsigned shorts
+	intptr_t	lodeboofs[MAX_ALIAS_LODS];
+
 	int					numposes;
 	intptr_t			nextsurface;		//spike
 	int					numbones;			//spike -- for iqm
@@ -502,13 +510,6 @@ typedef struct qmodel_s
 	int			contentstransparent;	//spike -- added this so we can disable glitchy wateralpha where its not supported.
 	qboolean	haslitwater;
 
-//
-// alias model
-//
-
-	GLuint		meshvbo;
-	GLuint		meshindexesvbo;
-
 //
 // additional model data
 //
@@ -533,6 +534,9 @@ typedef struct qmodel_s
 void	Mod_Init (void);
 void	Mod_ClearAll (void);
 void	Mod_ResetAll (void); // for gamedir changes (Host_Game_f)
+void	Mod_KeepWorld (const char *modelname);
+void	Mod_SetResidentWorld (qmodel_t *world, int hunkstart);
+int		Mod_ResidentHunkMark (void);
 qmodel_t *Mod_ForName (const char *name, qboolean crash);
 void	*Mod_Extradata (qmodel_t *mod);	// handles caching
 void	Mod_TouchModel (const char *name);
@@ -110,6 +110,7 @@ R_ClearEfrags
 void R_ClearEfrags (void)
 {
 	VEC_CLEAR (cl_efrags);
+	R_InvalidateStaticBModels ();
 }
 
 /*
@@ -146,6 +147,9 @@ void R_AddEfrags (entity_t *ent)
 	cl_efrags[i] = VEC_SIZE (cl_efrags) - i - 1; // write actual count
 	cl.num_efrags += cl_efrags[i];
 
+	if (R_IsGPUStaticBModel (ent))
+		R_InvalidateStaticBModels ();
+
 	R_CheckEfrags (); //johnfitz
 }
 
@@ -163,7 +167,13 @@ void R_AddStaticModels (const byte *vis)
 	{
 		if (!ent->model)
 			continue;
-		for (j = 0, numleafs = *efrags++; j < numleafs; j++)
+		numleafs = *efrags++;
+		if (R_IsGPUStaticBModel (ent)) // culled in R_MarkVisSurfaces
+		{
+			efrags += numleafs;
+			continue;
+		}
+		for (j = 0; j < numleafs; j++)
 		{
 			leafidx = efrags[j];
 			if ((vis[leafidx >> 3] & (1 << (leafidx & 7))))
@@ -70,6 +70,8 @@ cvar_t	r_norefresh = {"r_norefresh","0",CVAR_NONE};
 cvar_t	r_drawentities = {"r_drawentities","1",CVAR_NONE};
 cvar_t	r_drawviewmodel = {"r_drawviewmodel","1",CVAR_NONE};
 cvar_t	r_speeds = {"r_speeds","0",CVAR_NONE};
+cvar_t	r_gpuspeeds = {"r_gpuspeeds","0",CVAR_NONE};
+cvar_t	r_gpuspeeds_log = {"r_gpuspeeds_log","0",CVAR_NONE};
 cvar_t	r_pos = {"r_pos","0",CVAR_NONE};
 cvar_t	r_fullbright = {"r_fullbright","0",CVAR_NONE};
 cvar_t	r_lightmap = {"r_lightmap","0",CVAR_NONE};
@@ -109,6 +111,7 @@ cvar_t	r_showfields = {"r_showfields", "0", CVAR_NONE};
 cvar_t	r_showfields_align = {"r_showfields_align", "1", CVAR_ARCHIVE}; // 0=entity pos; 1=bottom-right
 cvar_t	r_lerpmodels = {"r_lerpmodels", "1", CVAR_ARCHIVE};
 cvar_t	r_lerpmove = {"r_lerpmove", "1", CVAR_ARCHIVE};
+cvar_t	r_lodbias = {"r_lodbias", "0", CVAR_ARCHIVE};
 cvar_t	r_nolerp_list = {"r_nolerp_list", "progs/flame.mdl,progs/flame2.mdl,progs/braztall.mdl,progs/brazshrt.mdl,progs/longtrch.mdl,progs/flame_pyre.mdl,progs/v_saw.mdl,progs/v_xfist.mdl,progs/h2stuff/newfire.mdl", CVAR_NONE};
 cvar_t	r_noshadow_list = {"r_noshadow_list", "progs/flame2.mdl,progs/flame.mdl,progs/bolt1.mdl,progs/bolt2.mdl,progs/bolt3.mdl,progs/laser.mdl", CVAR_NONE};
 
@@ -1113,10 +1116,23 @@ void R_DrawEntitiesOnList (qboolean alphapass) //johnfitz -- added parameter
 	GL_BeginGroup (alphapass ? "Translucent entities" : "Opaque entities");
 
 	ofs = cl_modtype_ofs + (alphapass ? 1 : 0);
+
+	GL_BeginGroup ("Brush models");
 	R_DrawBrushModels  (entlist + ofs[2*mod_brush ], ofs[2*mod_brush +1] - ofs[2*mod_brush ]);
+	if (!alphapass)
+		R_DrawStaticBrushModels ();
+	GL_EndGroup ();
+
+	GL_BeginGroup ("Alias models");
 	R_DrawAliasModels  (entlist + ofs[2*mod_alias ], ofs[2*mod_alias +1] - ofs[2*mod_alias ]);
+	GL_EndGroup ();
+
 	if (!alphapass)
+	{
+		GL_BeginGroup ("Sprites");
 		R_DrawSpriteModels (entlist + cl_modtype_ofs[2*mod_sprite], cl_modtype_ofs[2*mod_sprite+2] - cl_modtype_ofs[2*mod_sprite]);
+		GL_EndGroup ();
+	}
 
 	GL_EndGroup ();
 }
@@ -1797,6 +1813,7 @@ void R_ShowTris (void)
 
 	ofs = cl_modtype_ofs;
 	R_DrawBrushModels_ShowTris  (entlist + ofs[2*mod_brush ], ofs[2*mod_brush +2] - ofs[2*mod_brush ]);
+	R_DrawStaticBrushModels_ShowTris ();
 	R_DrawAliasModels_ShowTris  (entlist + ofs[2*mod_alias ], ofs[2*mod_alias +2] - ofs[2*mod_alias ]);
 	R_DrawSpriteModels_ShowTris (entlist + ofs[2*mod_sprite], ofs[2*mod_sprite+2] - ofs[2*mod_sprite]);
 
@@ -2029,6 +2046,8 @@ void R_RenderView (void)
 	else if (gl_finish.value)
 		glFinish ();
 
+	memset (dev_stats.aliaslods, 0, sizeof (dev_stats.aliaslods));
+
 	R_SetupView (); //johnfitz -- this does everything that should be done once per frame
 	R_RenderScene ();
 	R_WarpScaleView ();
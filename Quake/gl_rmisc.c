@@ -44,6 +44,7 @@ extern cvar_t r_showfields;
 extern cvar_t r_showfields_align;
 extern cvar_t r_lerpmodels;
 extern cvar_t r_lerpmove;
+extern cvar_t r_lodbias;
 extern cvar_t r_nolerp_list;
 extern cvar_t r_noshadow_list;
 //johnfitz
@@ -310,6 +311,8 @@ void R_Init (void)
 	R_SIMD_f(&r_simd);
 #endif
 	Cvar_RegisterVariable (&r_speeds);
+	Cvar_RegisterVariable (&r_gpuspeeds);
+	Cvar_RegisterVariable (&r_gpuspeeds_log);
 	Cvar_RegisterVariable (&r_pos);
 	Cvar_RegisterVariable (&r_alphasort);
 	Cvar_RegisterVariable (&r_oit);
@@ -343,6 +346,7 @@ void R_Init (void)
 	Cvar_RegisterVariable (&gl_overbright_models);
 	Cvar_RegisterVariable (&r_lerpmodels);
 	Cvar_RegisterVariable (&r_lerpmove);
+	Cvar_RegisterVariable (&r_lodbias);
 	Cvar_RegisterVariable (&r_nolerp_list);
 	Cvar_SetCallback (&r_nolerp_list, R_Model_ExtraFlags_List_f);
 	Cvar_RegisterVariable (&r_noshadow_list);
@@ -516,11 +520,18 @@ void R_NewMap (void)
 	R_ClearParticles ();
 	VEC_CLEAR (r_pointfile);
 
+	LoadProf_Begin ("GL_BuildLightmaps");
 	GL_BuildLightmaps ();
+	LoadProf_End ();
 	GL_DeleteBModelBuffers ();
+	LoadProf_Begin ("GL_BuildBModelVertexBuffer");
 	GL_BuildBModelVertexBuffer ();
+	LoadProf_End ();
+	LoadProf_Begin ("GL_BuildBModelMarkBuffers");
 	GL_BuildBModelMarkBuffers ();
+	LoadProf_End ();
 	//ericw -- no longer load alias models into a VBO here, it's done in Mod_LoadAliasModel
+	GLMesh_RebuildVertexBuffers (); // but do compact the pool once per map
 
 	r_framecount = 0; //johnfitz -- paranoid?
 	r_visframecount = 0; //johnfitz -- paranoid?
@@ -752,6 +763,9 @@ void GL_ClearBufferBindings (void)
 */
 
 #define FRAMES_IN_FLIGHT 3
+#define MAX_GPU_TIMERS		128
+#define MAX_GPU_TIMER_DEPTH	32
+#define MAX_GPU_QUERIES		(MAX_GPU_TIMERS * 2 + 2)	// begin/end per timer, plus whole frame
 
 typedef enum
 {
@@ -761,6 +775,15 @@ typedef enum
 	FRAMERES_ALL_BITS			= FRAMERES_HOST_BUFFER_BIT | FRAMERES_DEVICE_BUFFER_BIT
 } frameres_bits_t;
 
+typedef struct gputimer_s
+{
+	char			name[32];
+	int				depth;
+	int				parent;		// enclosing timer, -1 if none
+	int				begin;		// query indices
+	int				end;
+} gputimer_t;
+
 typedef struct frameres_t
 {
 	GLsync			fence;
@@ -768,6 +791,10 @@ typedef struct frameres_t
 	GLuint			host_buffer;
 	GLubyte			*host_ptr;
 	GLuint			*garbage;
+	GLuint			queries[MAX_GPU_QUERIES];
+	int				numqueries;
+	gputimer_t		timers[MAX_GPU_TIMERS];
+	int				numtimers;
 } frameres_t;
 
 static frameres_t	frameres[FRAMES_IN_FLIGHT];
@@ -777,6 +804,16 @@ static size_t		frameres_device_offset = 0;
 static size_t		frameres_host_buffer_size = 1 * 1024 * 1024;
 static size_t		frameres_device_buffer_size = 1 * 1024 * 1024;
 
+static qboolean		gputimer_active = false;
+static int			gputimer_maxdepth;
+static int			gputimer_stack[MAX_GPU_TIMER_DEPTH];
+static int			gputimer_depth;
+static gputime_t	gputimes[MAX_GPU_TIMERS];
+static int			numgputimes;
+static float		gputime_frame;
+static FILE			*gputimes_log;
+static int			gputimes_logframe;
+
 /*
 ====================
 GL_AddGarbageBuffer
@@ -903,7 +940,203 @@ void GL_DeleteFrameResources (void)
 			GL_DeleteBuffer (frame->device_buffer);
 			frame->device_buffer = 0;
 		}
+
+		if (frame->queries[0])
+		{
+			GL_DeleteQueriesFunc (MAX_GPU_QUERIES, frame->queries);
+			memset (frame->queries, 0, sizeof (frame->queries));
+		}
+		frame->numqueries = 0;
+		frame->numtimers = 0;
+	}
+
+	gputimer_active = false;
+}
+
+/*
+====================
+GL_WriteQuery
+====================
+*/
+static int GL_WriteQuery (frameres_t *frame)
+{
+	int idx = frame->numqueries++;
+	GL_QueryCounterFunc (frame->queries[idx], GL_TIMESTAMP);
+	return idx;
+}
+
+/*
+====================
+GL_TimerBegin
+
+Starts timing a render pass, if r_gpuspeeds is on and the pass isn't nested too deeply
+====================
+*/
+void GL_TimerBegin (const char *name)
+{
+	frameres_t *frame = &frameres[frameres_idx];
+	int depth = gputimer_depth++;
+	int idx = -1;
+
+	if (depth >= MAX_GPU_TIMER_DEPTH)
+		return;
+
+	if (gputimer_active && depth < gputimer_maxdepth && frame->numtimers < MAX_GPU_TIMERS)
+	{
+		gputimer_t *timer;
+		int i;
+
+		idx = frame->numtimers++;
+		timer = &frame->timers[idx];
+		q_strlcpy (timer->name, name, sizeof (timer->name));
+		timer->depth = depth;
+		timer->parent = -1;
+		for (i = depth - 1; i >= 0; i--)
+		{
+			if (gputimer_stack[i] >= 0)
+			{
+				timer->parent = gputimer_stack[i];
+				break;
+			}
+		}
+		timer->begin = GL_WriteQuery (frame);
+		timer->end = -1;
+	}
+
+	gputimer_stack[depth] = idx;
+}
+
+/*
+====================
+GL_TimerEnd
+====================
+*/
+void GL_TimerEnd (void)
+{
+	frameres_t *frame = &frameres[frameres_idx];
+	int idx;
+
+	if (gputimer_depth <= 0)
+		return;
+	if (--gputimer_depth >= MAX_GPU_TIMER_DEPTH)
+		return;
+
+	idx = gputimer_stack[gputimer_depth];
+	if (idx >= 0 && gputimer_active)
+		frame->timers[idx].end = GL_WriteQuery (frame);
+}
+
+/*
+====================
+GL_GetGPUTimes
+
+Returns the most recent per-pass GPU timings (a few frames behind)
+and the total GPU time for that frame in milliseconds
+====================
+*/
+int GL_GetGPUTimes (const gputime_t **out, float *framems)
+{
+	*out = gputimes;
+	*framems = gputime_frame;
+	return numgputimes;
+}
+
+/*
+====================
+GL_LogGPUTimes
+====================
+*/
+static void GL_LogGPUTimes (void)
+{
+	int i;
+
+	if (!cls.timedemo || !r_gpuspeeds_log.value)
+	{
+		if (gputimes_log)
+		{
+			fclose (gputimes_log);
+			gputimes_log = NULL;
+			Con_Printf ("Wrote gpuspeeds.csv\n");
+		}
+		return;
+	}
+
+	if (!gputimes_log)
+	{
+		char path[MAX_OSPATH];
+		q_snprintf (path, sizeof (path), "%s/gpuspeeds.csv", com_gamedir);
+		gputimes_log = Sys_fopen (path, "w");
+		if (!gputimes_log)
+		{
+			Con_Printf ("Couldn't write %s\n", path);
+			Cvar_SetValueQuick (&r_gpuspeeds_log, 0.f);
+			return;
+		}
+		fprintf (gputimes_log, "frame,pass,depth,ms\n");
+		gputimes_logframe = 0;
+	}
+
+	fprintf (gputimes_log, "%d,Frame,-1,%.4f\n", gputimes_logframe, gputime_frame);
+	for (i = 0; i < numgputimes; i++)
+		fprintf (gputimes_log, "%d,\"%s\",%d,%.4f\n", gputimes_logframe, gputimes[i].name, gputimes[i].depth, gputimes[i].ms);
+	gputimes_logframe++;
+}
+
+/*
+====================
+GL_ReadGPUTimers
+
+Collects the results of the timers recorded the last time this frame slot was used.
+Passes with the same name and parent (e.g. one group per alias model) are summed up.
+====================
+*/
+static void GL_ReadGPUTimers (frameres_t *frame)
+{
+	int			i, j, remap[MAX_GPU_TIMERS];
+	GLint		available = 0;
+	GLuint64	begin, end;
+
+	if (frame->numqueries < 2)
+		return;
+
+	GL_GetQueryObjectivFunc (frame->queries[frame->numqueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) // shouldn't happen once the fence has signalled
+		return;
+
+	GL_GetQueryObjectui64vFunc (frame->queries[0], GL_QUERY_RESULT, &begin);
+	GL_GetQueryObjectui64vFunc (frame->queries[frame->numqueries - 1], GL_QUERY_RESULT, &end);
+	gputime_frame = (end - begin) * 1e-6f;
+
+	numgputimes = 0;
+	for (i = 0; i < frame->numtimers; i++)
+	{
+		const gputimer_t *timer = &frame->timers[i];
+		int parent = timer->parent >= 0 ? remap[timer->parent] : -1;
+		float ms = 0.f;
+
+		if (timer->end >= 0)
+		{
+			GL_GetQueryObjectui64vFunc (frame->queries[timer->begin], GL_QUERY_RESULT, &begin);
+			GL_GetQueryObjectui64vFunc (frame->queries[timer->end], GL_QUERY_RESULT, &end);
+			ms = (end - begin) * 1e-6f;
+		}
+
+		for (j = 0; j < numgputimes; j++)
+			if (gputimes[j].parent == parent && gputimes[j].depth == timer->depth && !strcmp (gputimes[j].name, timer->name))
+				break;
+		if (j == numgputimes)
+		{
+			numgputimes++;
+			q_strlcpy (gputimes[j].name, timer->name, sizeof (gputimes[j].name));
+			gputimes[j].depth = timer->depth;
+			gputimes[j].parent = parent;
+			gputimes[j].ms = 0.f;
+		}
+		gputimes[j].ms += ms;
+		remap[i] = j;
 	}
+
+	GL_LogGPUTimes ();
 }
 
 /*
@@ -938,6 +1171,28 @@ void GL_AcquireFrameResources (void)
 	for (i = 0; i < num_garbage_bufs; i++)
 		GL_DeleteBuffer (frame->garbage[i]);
 	VEC_CLEAR (frame->garbage);
+
+	GL_ReadGPUTimers (frame);
+	frame->numqueries = 0;
+	frame->numtimers = 0;
+	gputimer_depth = 0;
+
+	gputimer_maxdepth = (int) r_gpuspeeds.value;
+	if (cls.timedemo && r_gpuspeeds_log.value)
+		gputimer_maxdepth = q_max (gputimer_maxdepth, (int) r_gpuspeeds_log.value);
+	gputimer_active = gputimer_maxdepth > 0;
+	if (gputimer_active)
+	{
+		if (!frame->queries[0])
+			GL_GenQueriesFunc (MAX_GPU_QUERIES, frame->queries);
+		GL_WriteQuery (frame);
+	}
+	else
+	{
+		numgputimes = 0;
+		gputime_frame = 0.f;
+		GL_LogGPUTimes ();
+	}
 }
 
 /*
@@ -949,6 +1204,12 @@ void GL_ReleaseFrameResources (void)
 {
 	frameres_t *frame = &frameres[frameres_idx];
 
+	if (gputimer_active)
+	{
+		GL_WriteQuery (frame);
+		gputimer_active = false;
+	}
+
 	SDL_assert (!frame->fence);
 	frame->fence = GL_FenceSyncFunc (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
@@ -111,6 +111,7 @@ cvar_t		scr_centertime = {"scr_centertime","2",CVAR_NONE};
 cvar_t		scr_showturtle = {"showturtle","0",CVAR_NONE};
 cvar_t		scr_showpause = {"showpause","1",CVAR_NONE};
 cvar_t		scr_printspeed = {"scr_printspeed","8",CVAR_NONE};
+cvar_t		scr_loadingfps = {"scr_loadingfps","30",CVAR_NONE}; // max redraw rate while loading, 0 = redraw on every print
 cvar_t		gl_triplebuffer = {"gl_triplebuffer", "1", CVAR_ARCHIVE};
 
 cvar_t		cl_gun_fovscale = {"cl_gun_fovscale","1",CVAR_ARCHIVE}; // Qrack
@@ -659,6 +660,7 @@ void SCR_Init (void)
 	Cvar_RegisterVariable (&scr_showpause);
 	Cvar_RegisterVariable (&scr_centertime);
 	Cvar_RegisterVariable (&scr_printspeed);
+	Cvar_RegisterVariable (&scr_loadingfps);
 	Cvar_RegisterVariable (&gl_triplebuffer);
 	Cvar_RegisterVariable (&cl_gun_fovscale);
 	Cvar_RegisterVariable (&cl_gun_x);
@@ -895,7 +897,7 @@ void SCR_DrawDemoControls (void)
 	// Approximate the fraction of the demo that's already been played back
 	// based on the current file offset and total demo size
 	// Note: we need to take into account the starting offset for pak files
-	frac = (Sys_ftell (cls.demofile) - cls.demofilestart) / (double)cls.demofilesize;
+	frac = (CL_DemoTell () - cls.demofilestart) / (double)cls.demofilesize;
 	frac = CLAMP (0.f, frac, 1.f);
 
 	if (cl.intermission)
@@ -979,15 +981,16 @@ SCR_DrawDevStats
 void SCR_DrawDevStats (void)
 {
 	char	str[40];
-	int		y = 25-10; //10=number of lines to print
+	int		y = 25-(11+MAX_ALIAS_LODS+1); //number of lines to print
 	int		x = 0; //margin
+	int		i;
 
 	if (!devstats.value)
 		return;
 
 	GL_SetCanvas (CANVAS_BOTTOMLEFT);
 
-	Draw_Fill (x, y*8, 21*8, 10*8, 0, 0.5); //dark rectangle
+	Draw_Fill (x, y*8, 21*8, (11+MAX_ALIAS_LODS+1)*8, 0, 0.5); //dark rectangle
 
 	sprintf (str, "devstats | Curr  Peak");
 	Draw_String (x, (y++)*8-x, str);
@@ -1018,6 +1021,15 @@ void SCR_DrawDevStats (void)
 
 	sprintf (str, "GL upload|%4iK %4iK", dev_stats.gpu_upload/1024, dev_peakstats.gpu_upload/1024);
 	Draw_String (x, (y++)*8-x, str);
+
+	sprintf (str, "2D draws |%5i %5i", dev_stats.guidraws, dev_peakstats.guidraws);
+	Draw_String (x, (y++)*8-x, str);
+
+	for (i = 0; i <= MAX_ALIAS_LODS; i++)
+	{
+		sprintf (str, "MDL LOD %i|%5i %5i", i, dev_stats.aliaslods[i], dev_peakstats.aliaslods[i]);
+		Draw_String (x, (y++)*8-x, str);
+	}
 }
 
 /*
@@ -1120,6 +1132,136 @@ void SCR_DrawLoading (void)
 	scr_tileclear_updates = 0; //johnfitz
 }
 
+static struct
+{
+	const char	*phase;
+	int			done;
+	int			total;
+	double		lastupdate;
+	double		lastduration;
+	qboolean	inupdate;
+} scr_loading;
+
+/*
+==============
+SCR_DrawLoadingProgress
+
+Progress bar for the current load phase, shown until the signon is complete
+==============
+*/
+static void SCR_DrawLoadingProgress (void)
+{
+	int x, y, w;
+
+	if (cls.signon == SIGNONS || cls.state != ca_connected)
+	{
+		scr_loading.phase = NULL; // done, don't show stale progress next time
+		return;
+	}
+	if (!scr_loading.phase || !scr_loading.total)
+		return;
+
+	GL_SetCanvas (CANVAS_MENU);
+
+	x = 80;
+	y = 200 - 24;
+	w = (int) (160LL * CLAMP (0, scr_loading.done, scr_loading.total) / scr_loading.total);
+
+	Draw_String (x, y - 10, scr_loading.phase);
+	Draw_Fill (x - 1, y - 1, 162, 6, 0, 0.75f);
+	Draw_Fill (x, y, w, 4, 208, 1.f);
+}
+
+/*
+==============
+SCR_LoadingUpdate
+
+Redraws the screen while loading, at most scr_loadingfps times per second
+and spending at most ~10% of the load time on redraws (so that vsync doesn't
+make loading slower)
+==============
+*/
+void SCR_LoadingUpdate (void)
+{
+	double start, interval;
+
+	// protect against infinite loop if something in SCR_UpdateScreen calls Con_Printf
+	if (scr_loading.inupdate)
+		return;
+
+	start = Sys_DoubleTime ();
+	if (scr_loadingfps.value > 0.f)
+	{
+		interval = q_max (1.0 / scr_loadingfps.value, scr_loading.lastduration * 9.0);
+		if (start - scr_loading.lastupdate < interval)
+			return;
+	}
+
+	scr_loading.inupdate = true;
+	SCR_UpdateScreen ();
+	scr_loading.inupdate = false;
+
+	scr_loading.lastupdate = Sys_DoubleTime ();
+	scr_loading.lastduration = scr_loading.lastupdate - start;
+}
+
+/*
+==============
+SCR_LoadingProgress
+
+Sets the current load phase and overall progress, then updates the screen if it's time to
+==============
+*/
+void SCR_LoadingProgress (const char *phase, int done, int total)
+{
+	scr_loading.phase = phase;
+	scr_loading.done = done;
+	scr_loading.total = total;
+
+	if (cls.signon != SIGNONS && !scr_disabled_for_loading)
+		SCR_LoadingUpdate ();
+}
+
+/*
+==============
+SCR_DrawGpuSpeeds
+
+Per-pass GPU timings, nested passes are indented
+==============
+*/
+void SCR_DrawGpuSpeeds (void)
+{
+	const gputime_t	*times;
+	char			str[40];
+	float			framems;
+	int				i, count, lines, x, y;
+
+	if (!r_gpuspeeds.value)
+		return;
+
+	count = GL_GetGPUTimes (&times, &framems);
+	lines = q_min (count, 20);
+
+	GL_SetCanvas (CANVAS_TOPRIGHT);
+
+	x = 320 - 28*8;
+	y = 32;
+	Draw_Fill (x, y, 28*8, (lines + 2)*8, 0, 0.5); //dark rectangle
+
+	q_snprintf (str, sizeof (str), "%-20s %6.2f", "GPU frame", framems);
+	Draw_String (x, y, str);
+	y += 8;
+	Draw_String (x, y, "----------------------------");
+	y += 8;
+
+	for (i = 0; i < lines; i++, y += 8)
+	{
+		int indent = q_min (times[i].depth, 4);
+		q_snprintf (str, sizeof (str), "%*s%-*.*s %6.2f", indent, "", 20 - indent, 20 - indent, times[i].name, times[i].ms);
+		Draw_String (x, y, str);
+	}
+}
+
 /*
 ==============
 SCR_DrawSaving
@@ -2130,6 +2272,7 @@ void SCR_UpdateScreen (void)
 	else if (scr_drawloading) //loading
 	{
 		SCR_DrawLoading ();
+		SCR_DrawLoadingProgress ();
 		Sbar_Draw ();
 		M_Draw ();
 	}
@@ -2153,11 +2296,13 @@ void SCR_UpdateScreen (void)
 		SCR_CheckDrawCenterString ();
 		Sbar_Draw ();
 		SCR_DrawDevStats (); //johnfitz
+		SCR_DrawGpuSpeeds ();
 		SCR_DrawClock (); //johnfitz
 		SCR_DrawDemoControls ();
 		SCR_DrawSpeed ();
 		SCR_DrawEdictInfo ();
 		SCR_DrawConsole ();
+		SCR_DrawLoadingProgress ();
 		M_Draw ();
 		SCR_DrawFPS (); //johnfitz
 		SCR_DrawSaving ();
@@ -2167,6 +2312,8 @@ void SCR_UpdateScreen (void)
 
 	GL_EndGroup ();
 
+	TexMgr_UpdateResidency ();
+
 	GL_EndRendering ();
 }
 
@@ -41,30 +41,50 @@ static const char gui_vertex_shader[] =
 "layout(location=0) in vec2 in_pos;\n"
 "layout(location=1) in vec2 in_uv;\n"
 "layout(location=2) in vec4 in_color;\n"
+"layout(location=3) in uint in_texslot;\n"
 "\n"
 "layout(location=0) centroid out vec2 out_uv;\n"
 "layout(location=1) centroid out vec4 out_color;\n"
+"layout(location=2) flat out uint out_texslot;\n"
 "\n"
 "void main()\n"
 "{\n"
 "	gl_Position = vec4(in_pos, 0.0, 1.0);\n"
 "	out_uv = in_uv;\n"
 "	out_color = in_color;\n"
+"	out_texslot = in_texslot;\n"
 "}\n";
 
 ////////////////////////////////////////////////////////////////
 
 static const char gui_fragment_shader[] =
-"layout(binding=0) uniform sampler2D Tex;\n"
+"layout(binding=0) uniform sampler2D Tex[8];\n"
 "\n"
 "layout(location=0) centroid in vec2 in_uv;\n"
 "layout(location=1) centroid in vec4 in_color;\n"
+"layout(location=2) flat in uint in_texslot;\n"
 "\n"
 "layout(location=0) out vec4 out_fragcolor;\n"
 "\n"
 "void main()\n"
 "{\n"
-"	out_fragcolor = texture(Tex, in_uv) * in_color;\n"
+"	// sampler arrays can only be indexed with dynamically uniform values,\n"
+"	// so select the texture with constant indices and explicit gradients\n"
+"	vec2 dx = dFdx(in_uv);\n"
+"	vec2 dy = dFdy(in_uv);\n"
+"	vec4 result;\n"
+"	switch (in_texslot)\n"
+"	{\n"
+"	case 0u: result = textureGrad(Tex[0], in_uv, dx, dy); break;\n"
+"	case 1u: result = textureGrad(Tex[1], in_uv, dx, dy); break;\n"
+"	case 2u: result = textureGrad(Tex[2], in_uv, dx, dy); break;\n"
+"	case 3u: result = textureGrad(Tex[3], in_uv, dx, dy); break;\n"
+"	case 4u: result = textureGrad(Tex[4], in_uv, dx, dy); break;\n"
+"	case 5u: result = textureGrad(Tex[5], in_uv, dx, dy); break;\n"
+"	case 6u: result = textureGrad(Tex[6], in_uv, dx, dy); break;\n"
+"	default: result = textureGrad(Tex[7], in_uv, dx, dy); break;\n"
+"	}\n"
+"	out_fragcolor = result * in_color;\n"
 "}\n";
 
 ////////////////////////////////////////////////////////////////
@@ -1058,8 +1078,35 @@ NOISE_FUNCTIONS
 
 ////////////////////////////////////////////////////////////////
 
+#define ALIAS_CALLDATA_BUFFER \
+"struct Call\n"\
+"{\n"\
+"#if BINDLESS\n"\
+"	uvec2	txhandle;\n"\
+"	uvec2	fbhandle;\n"\
+"#else\n"\
+"	int		baseinstance;\n"\
+"	int		padding;\n"\
+"#endif // BINDLESS\n"\
+"};\n"\
+"\n"\
+"layout(std430, binding=3) restrict readonly buffer CallBuffer\n"\
+"{\n"\
+"	Call call_data[];\n"\
+"};\n"\
+"\n"\
+"#if BINDLESS\n"\
+"	#define GET_INSTANCE_ID(call) (gl_BaseInstanceARB + gl_InstanceID)\n"\
+"#else\n"\
+"	#define GET_INSTANCE_ID(call) (call.baseinstance + gl_InstanceID)\n"\
+"#endif\n"\
+
+////////////////////////////////////////////////////////////////
+
 static const char alias_vertex_shader[] =
+BINDLESS_VERTEX_HEADER
 ALIAS_INSTANCE_BUFFER
+ALIAS_CALLDATA_BUFFER
 "\n"
 "struct PoseVertex\n"
 "{\n"
@@ -1138,10 +1185,17 @@ ALIAS_INSTANCE_BUFFER
 "#endif\n"
 "layout(location=1) out vec4 out_color;\n"
 "layout(location=2) out vec3 out_pos;\n"
+"#if BINDLESS\n"
+"	layout(location=3) flat out uvec4 out_samplers;\n"
+"#endif\n"
 "\n"
 "void main()\n"
 "{\n"
-"	InstanceData inst = instances[gl_InstanceID];\n"
+"	Call call = call_data[DRAW_ID];\n"
+"	InstanceData inst = instances[GET_INSTANCE_ID(call)];\n"
+"#if BINDLESS\n"
+"	out_samplers = uvec4(call.txhandle, call.fbhandle);\n"
+"#endif\n"
 "	out_texcoord = in_uv;\n"
 "	PoseVertex pose1 = GetPoseVertex(inst.Pose1);\n"
 "	PoseVertex pose2 = GetPoseVertex(inst.Pose2);\n"
@@ -1163,12 +1217,16 @@ ALIAS_INSTANCE_BUFFER
 ////////////////////////////////////////////////////////////////
 
 static const char alias_fragment_shader[] =
+"#if BINDLESS\n"
+"	#extension GL_ARB_bindless_texture : require\n"
+"#else\n"
+"	layout(binding=0) uniform sampler2D Tex;\n"
+"	layout(binding=1) uniform sampler2D FullbrightTex;\n"
+"#endif\n"
+"\n"
 ALIAS_INSTANCE_BUFFER
 NOISE_FUNCTIONS
 "\n"
-"layout(binding=0) uniform sampler2D Tex;\n"
-"layout(binding=1) uniform sampler2D FullbrightTex;\n"
-"\n"
 "#if MODE == " QS_STRINGIFY (ALIASSHADER_NOPERSP) "\n"
 "	layout(location=0) noperspective in vec2 in_texcoord;\n"
 "#else\n"
@@ -1176,11 +1234,18 @@ NOISE_FUNCTIONS
 "#endif\n"
 "layout(location=1) in vec4 in_color;\n"
 "layout(location=2) in vec3 in_pos;\n"
+"#if BINDLESS\n"
+"	layout(location=3) flat in uvec4 in_samplers;\n"
+"#endif\n"
 "\n"
 OIT_OUTPUT (out_fragcolor)
 "\n"
 "void main()\n"
 "{\n"
+"#if BINDLESS\n"
+"	sampler2D Tex = sampler2D(in_samplers.xy);\n"
+"	sampler2D FullbrightTex = sampler2D(in_samplers.zw);\n"
+"#endif\n"
 "	vec2 uv = in_texcoord;\n"
 "#if MODE == " QS_STRINGIFY (ALIASSHADER_NOPERSP) "\n"
 "	uv -= 0.5 / vec2(textureSize(Tex, 0).xy);\n"
@@ -1519,7 +1584,8 @@ DRAW_ELEMENTS_INDIRECT_COMMAND
 ////////////////////////////////////////////////////////////////
 //
 // Cull/mark: leaf vis/frustum culling, surface backface culling,
-// index buffer + draw indirect buffer updates
+// index buffer + draw indirect buffer updates,
+// static brush entity vis/frustum culling
 //
 ////////////////////////////////////////////////////////////////
 
@@ -1600,13 +1666,99 @@ DRAW_ELEMENTS_INDIRECT_COMMAND
 "	vec3	vieworg;\n"
 "	uint	oldskyleaf;\n"
 "	uint	framecount;\n"
+"	uint	numstatics;\n"
+"};\n"
+"\n"
+"// Static brush entities are culled by the threads following the marksurfaces\n"
+"\n"
+"layout(std430, binding=6) restrict writeonly buffer StaticDrawIndirectBuffer\n"
+"{\n"
+"	uint static_rawcmds[];\n"
 "};\n"
 "\n"
+"struct StaticEntity\n"
+"{\n"
+"	vec3	mins;\n"
+"	uint	firstleaf;\n"
+"	vec3	maxs;\n"
+"	uint	numleafs;\n"
+"	uint	firstcmd;\n"
+"	uint	numsolid;\n"
+"	uint	numcutout;\n"
+"	uint	firstsolid;\n"
+"	uint	firstcutout;\n"
+"	uint	_pad0;\n"
+"	uint	_pad1;\n"
+"	uint	_pad2;\n"
+"};\n"
+"\n"
+"layout(std430, binding=7) restrict readonly buffer StaticEntityBuffer\n"
+"{\n"
+"	StaticEntity statics[];\n"
+"};\n"
+"\n"
+"layout(std430, binding=0) restrict readonly buffer StaticLeafBuffer\n"
+"{\n"
+"	uint static_leafs[];\n"
+"};\n"
+"\n"
+"bool IsBoxVisible(vec3 mins, vec3 maxs)\n"
+"{\n"
+"	for (uint i = 0u; i < 4u; i++)\n"
+"	{\n"
+"		vec4 plane = frustum[i];\n"
+"		vec3 v;\n"
+"		v.x = plane.x < 0.0 ? mins.x : maxs.x;\n"
+"		v.y = plane.y < 0.0 ? mins.y : maxs.y;\n"
+"		v.z = plane.z < 0.0 ? mins.z : maxs.z;\n"
+"		if (dot(plane.xyz, v) < plane.w)\n"
+"			return false;\n"
+"	}\n"
+"	return true;\n"
+"}\n"
+"\n"
+"void CullStaticEntity(uint index)\n"
+"{\n"
+"	StaticEntity ent = statics[index];\n"
+"\n"
+"	// vis culling: the entity is visible if any of its leafs is\n"
+"	bool visible = false;\n"
+"	for (uint i = 0u; i < ent.numleafs && !visible; i++)\n"
+"	{\n"
+"		uint leaf = static_leafs[ent.firstleaf + i];\n"
+"		visible = (vis[leaf >> 5u] & (1u << (leaf & 31u))) != 0u;\n"
+"	}\n"
+"\n"
+"	// frustum culling\n"
+"	if (visible)\n"
+"		visible = IsBoxVisible(ent.mins, ent.maxs);\n"
+"\n"
+"	// write the draw commands for all of the entity's textures,\n"
+"	// with an instance count of 0 if the entity was culled\n"
+"	uint numcmds = ent.numsolid + ent.numcutout;\n"
+"	for (uint i = 0u; i < numcmds; i++)\n"
+"	{\n"
+"		uint src = (ent.firstcmd + i) * uint(SIZEOF_CMD);\n"
+"		uint dst = i < ent.numsolid ? ent.firstsolid + i : ent.firstcutout + (i - ent.numsolid);\n"
+"		dst *= uint(SIZEOF_CMD);\n"
+"		static_rawcmds[dst    ] = CMD_COUNT(src);\n"
+"		static_rawcmds[dst + 1] = visible ? 1u : 0u;\n"
+"		static_rawcmds[dst + 2] = CMD_FIRST_INDEX(src);\n"
+"		static_rawcmds[dst + 3] = CMD_BASE_VERTEX(src);\n"
+"		static_rawcmds[dst + 4] = index;\n"
+"	}\n"
+"}\n"
+"\n"
 "void main()\n"
 "{\n"
 "	uint thread_id = gl_GlobalInvocationID.x;\n"
-"	if (thread_id >= marksurfs.length())\n"
+"	uint nummarks = uint(marksurfs.length());\n"
+"	if (thread_id >= nummarks)\n"
+"	{\n"
+"		if (thread_id - nummarks < numstatics)\n"
+"			CullStaticEntity(thread_id - nummarks);\n"
 "		return;\n"
+"	}\n"
 "	MarkSurface mark = marksurfs[thread_id];\n"
 "\n"
 "	// sky culling: when r_oldskyleaf is 0, surfaces inside a sky leaf are skipped\n"
@@ -1627,18 +1779,8 @@ DRAW_ELEMENTS_INDIRECT_COMMAND
 "		return;\n"
 "\n"
 "	// frustum culling\n"
-"	vec3 mins = SURF_MINS(surfbase);\n"
-"	vec3 maxs = SURF_MAXS(surfbase);\n"
-"	for (uint i = 0u; i < 4u; i++)\n"
-"	{\n"
-"		vec4 plane = frustum[i];\n"
-"		vec3 v;\n"
-"		v.x = plane.x < 0.0 ? mins.x : maxs.x;\n"
-"		v.y = plane.y < 0.0 ? mins.y : maxs.y;\n"
-"		v.z = plane.z < 0.0 ? mins.z : maxs.z;\n"
-"		if (dot(plane.xyz, v) < plane.w)\n"
-"			return;\n"
-"	}\n"
+"	if (!IsBoxVisible(SURF_MINS(surfbase), SURF_MAXS(surfbase)))\n"
+"		return;\n"
 "\n"
 "	// surfaces can appear in multiple leaves\n"
 "	// check if this is the first time this surface has passed culling this frame\n"
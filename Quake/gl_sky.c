@@ -400,6 +400,21 @@ static void Skywind_f (void)
 		skybox->wind_pitch = fmod (atof (Cmd_Argv (4)) + 90.0, 180.0) - 90.0;
 }
 
+/*
+==================
+Sky_FreeStaleTexture
+
+Skybox textures are owned by the world, which may have been kept
+resident across a level change (see Mod_KeepWorld)
+==================
+*/
+static void Sky_FreeStaleTexture (const char *name)
+{
+	gltexture_t *glt = TexMgr_FindTexture (cl.worldmodel, name);
+	if (glt)
+		TexMgr_FreeTexture (glt);
+}
+
 /*
 ==================
 Sky_LoadSkyBox
@@ -495,6 +510,7 @@ void Sky_LoadSkyBox (const char *name)
 		}
 
 		q_snprintf (filename, sizeof(filename), "gfx/env/%s", name);
+		Sky_FreeStaleTexture (filename);
 		newsky.cubemap = TexMgr_LoadImage (cl.worldmodel, filename,
 			samesize, samesize, SRC_RGBA,
 			(byte *)newsky.cubemap_offsets, "", (src_offset_t)newsky.cubemap_offsets,
@@ -506,6 +522,7 @@ void Sky_LoadSkyBox (const char *name)
 		for (i = 0; i < 6; i++)
 		{
 			q_snprintf (filename, sizeof(filename), "gfx/env/%s%s", name, suf[i]);
+			Sky_FreeStaleTexture (filename);
 			newsky.textures[i] = TexMgr_LoadImage (cl.worldmodel, filename, width[i], height[i], SRC_RGBA, data[i], filename, 0, TEXPREF_NONE);
 		}
 	}
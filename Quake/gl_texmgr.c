@@ -50,6 +50,8 @@ cvar_t			gl_lodbias = {"gl_lodbias", "auto", CVAR_ARCHIVE };
 cvar_t			gl_texturemode = {"gl_texturemode", "", CVAR_ARCHIVE};
 cvar_t			gl_texture_anisotropy = {"gl_texture_anisotropy", "8", CVAR_ARCHIVE};
 cvar_t			gl_compress_textures = {"gl_compress_textures", "0", CVAR_ARCHIVE};
+static cvar_t	gl_texture_budget_mb = {"gl_texture_budget_mb", "0", CVAR_ARCHIVE};
+static cvar_t	gl_texture_evict_time = {"gl_texture_evict_time", "10", CVAR_ARCHIVE};
 GLint			gl_max_texture_size;
 
 static float	lodbias;
@@ -72,6 +74,34 @@ unsigned int d_8to24table_conchars[256];		//conchars palette, 0 and 255 are tran
 uint32_t is_fullbright[256/32];
 
 static void GL_DeleteTexture (gltexture_t *texture);
+static void TexMgr_FinishTexture (gltexture_t *glt);
+static qboolean TexMgr_IsStreamable (const gltexture_t *glt);
+static int TexMgr_MaxLodSkip (int width, int height);
+
+#define TEXMGR_INITIAL_LODSKIP	2		// mip levels skipped when loading streamable textures under a budget
+#define TEXMGR_MAX_LODSKIP		4
+#define TEXMGR_MIN_STREAM_SIZE	32		// textures are never reduced below this size
+#define TEXMGR_RECENT_TIME		1.0		// textures used within this many seconds get streamed in
+
+static struct
+{
+	int		streamed;		// uploads of higher mip levels
+	double	streamedbytes;
+	int		evicted;		// top mip levels dropped
+	double	evictedbytes;
+} residency_stats;
+
+static struct
+{
+	qboolean		active;
+	gltexture_t		*glt;		// NULL if the texture got freed meanwhile
+	gltexture_t		work;		// the worker's copy of glt, with the new lodskip
+	int				oldskip;
+	int				mipwidth, mipheight;
+	fileloc_t		loc;
+	byte			*data;		// malloc'ed result, NULL if the worker failed
+	taskcounter_t	counter;
+} stream_request;
 
 /*
 ================================================================================
@@ -384,6 +414,7 @@ static void TexMgr_Imagelist_f (void)
 	double bytes = 0;
 	double texels = 0;
 	int count = 0;
+	int reduced = 0;
 	const char *filter = NULL;
 	gltexture_t	*glt;
 
@@ -392,7 +423,7 @@ static void TexMgr_Imagelist_f (void)
 
 	for (glt = active_gltextures; glt; glt = glt->next)
 	{
-		char buf[MAX_QPATH];
+		char buf[MAX_QPATH + 16];
 		char mip = glt->flags & TEXPREF_MIPMAP ? 'm' : ' ';
 		char comp = glt->compression > 1 ? 'c' : ' ';
 		unsigned int layers = glt->flags & TEXPREF_CUBEMAP ? glt->depth * 6 : glt->depth;
@@ -409,6 +440,8 @@ static void TexMgr_Imagelist_f (void)
 			q_strlcpy (buf, glt->name, sizeof (buf));
 		}
 
+		if (glt->lodskip)
+			q_strlcat (buf, va (" [-%d mips]", glt->lodskip), sizeof (buf));
 		if (layers > 1)
 			Con_SafePrintf ("%3i x %4i x %4i %c%c %s\n", layers, glt->width, glt->height, comp, mip, buf);
 		else
@@ -418,6 +451,7 @@ static void TexMgr_Imagelist_f (void)
 			s = (s * 4 + 3) / 3;
 		texels += s;
 		bytes += s * 4 / glt->compression;
+		reduced += glt->lodskip != 0;
 		count++;
 	}
 
@@ -427,6 +461,14 @@ static void TexMgr_Imagelist_f (void)
 	else
 		Con_Printf ("%i textures %.1lf mpixels %1.1lf megabytes\n",
 			numgltextures, texels * 1e-6, bytes / 0x100000);
+
+	if (gl_texture_budget_mb.value > 0.f || reduced)
+		Con_Printf ("budget %1.1lf megabytes, %i/%i textures reduced\n",
+			(double) q_max (gl_texture_budget_mb.value, 0.f), reduced, count);
+	if (residency_stats.streamed || residency_stats.evicted)
+		Con_Printf ("%i uploads streamed in (%1.1lf megabytes), %i mip levels evicted (%1.1lf megabytes)\n",
+			residency_stats.streamed, residency_stats.streamedbytes / 0x100000,
+			residency_stats.evicted, residency_stats.evictedbytes / 0x100000);
 }
 
 /*
@@ -631,6 +673,9 @@ void TexMgr_FreeTexture (gltexture_t *kill)
 		return;
 	}
 
+	if (kill == stream_request.glt)
+		stream_request.glt = NULL;
+
 	if (active_gltextures == kill)
 	{
 		active_gltextures = kill->next;
@@ -695,6 +740,35 @@ void TexMgr_FreeTexturesForOwner (qmodel_t *owner)
 	}
 }
 
+/*
+================
+TexMgr_GetOwnerBytes
+
+Estimated video memory used by the textures of a model
+================
+*/
+size_t TexMgr_GetOwnerBytes (qmodel_t *owner)
+{
+	gltexture_t *glt;
+	size_t bytes = 0;
+
+	for (glt = active_gltextures; glt; glt = glt->next)
+	{
+		unsigned int layers, s;
+
+		if (glt->owner != owner)
+			continue;
+
+		layers = glt->flags & TEXPREF_CUBEMAP ? glt->depth * 6 : glt->depth;
+		s = glt->width * glt->height * layers;
+		if (glt->flags & TEXPREF_MIPMAP)
+			s = (s * 4 + 3) / 3;
+		bytes += s * 4 / glt->compression;
+	}
+
+	return bytes;
+}
+
 /*
 ================
 TexMgr_DeleteTextureObjects
@@ -875,6 +949,8 @@ void TexMgr_Init (void)
 	Cvar_RegisterVariable (&r_softemu_mdl_warp);
 	Cvar_RegisterVariable (&r_softemu_dither_screen);
 	Cvar_RegisterVariable (&r_softemu_dither_texture);
+	Cvar_RegisterVariable (&gl_texture_budget_mb);
+	Cvar_RegisterVariable (&gl_texture_evict_time);
 	Cmd_AddCommand ("gl_describetexturemodes", &TexMgr_DescribeTextureModes_f);
 	cmd = Cmd_AddCommand ("imagelist", &TexMgr_Imagelist_f);
 	if (cmd)
@@ -1256,6 +1332,9 @@ static void GL_TexImage (gltexture_t *glt, GLint level, GLint internalformat, GL
 	const GLvoid **images = (const GLvoid **)pixels; // for arrays/cubemaps "pixels" is actually an array of pointers
 	unsigned int i;
 
+	if (pixels && type == GL_UNSIGNED_BYTE)
+		LoadProf_AddUpload ((int64_t) width * height * 4 * (glt->target == GL_TEXTURE_CUBE_MAP ? 6 : q_max (glt->depth, 1)));
+
 	switch (glt->target)
 	{
 	case GL_TEXTURE_2D_ARRAY:
@@ -1281,15 +1360,28 @@ static void GL_TexImage (gltexture_t *glt, GLint level, GLint internalformat, GL
 
 /*
 ================
-TexMgr_LoadImage32 -- handles 32bit source data
+TexMgr_UploadSize -- size of the top mip level after picmip and dropped mip levels
 ================
 */
-static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
+static void TexMgr_UploadSize (const gltexture_t *glt, int *width, int *height)
 {
-	int	miplevel, mipwidth, mipheight, picmip;
-	glformat_t internalformat;
-	qboolean compress;
+	int picmip;
 
+	picmip = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max((int)gl_picmip.value, 0);
+	picmip += glt->lodskip;
+	*width = TexMgr_SafeTextureSize (glt->width >> picmip);
+	*height = TexMgr_SafeTextureSize (glt->height >> picmip);
+}
+
+/*
+================
+TexMgr_MipDown32 -- detects alpha and mips 32bit data down to the upload size
+
+touches nothing but glt and data, so it's also used by the streaming worker
+================
+*/
+static void TexMgr_MipDown32 (gltexture_t *glt, unsigned *data, int mipwidth, int mipheight)
+{
 	// HASALPHA detection
 	if (glt->source_format == SRC_RGBA && !(glt->flags & TEXPREF_ALPHAPIXELS))
 	{
@@ -1308,9 +1400,6 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	}
 
 	// mipmap down
-	picmip = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max((int)gl_picmip.value, 0);
-	mipwidth = TexMgr_SafeTextureSize (glt->width >> picmip);
-	mipheight = TexMgr_SafeTextureSize (glt->height >> picmip);
 	while ((int) glt->height > mipheight)
 	{
 		TexMgr_MipMapH (data, glt->width, glt->height, glt->depth);
@@ -1325,6 +1414,21 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 		if (glt->flags & TEXPREF_ALPHA && glt->target == GL_TEXTURE_2D)
 			TexMgr_AlphaEdgeFix ((byte *)data, glt->width, glt->height);
 	}
+}
+
+/*
+================
+TexMgr_LoadImage32 -- handles 32bit source data
+================
+*/
+static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
+{
+	int	miplevel, mipwidth, mipheight;
+	glformat_t internalformat;
+	qboolean compress;
+
+	TexMgr_UploadSize (glt, &mipwidth, &mipheight);
+	TexMgr_MipDown32 (glt, data, mipwidth, mipheight);
 
 	// upload
 	compress = gl_compress_textures.value && TexMgr_CanCompress (glt);
@@ -1524,6 +1628,13 @@ gltexture_t *TexMgr_LoadImageEx (qmodel_t *owner, const char *name, int width, i
 
 		if ((glt = TexMgr_FindTexture (owner, name)) && glt->source_crc == crc)
 			return glt;
+
+		// a texture with a resident handle is immutable, start over with a new object
+		if (glt && glt->bindless_handle)
+		{
+			GL_DeleteTexture (glt);
+			glGenTextures (1, &glt->texnum);
+		}
 	}
 
 	if (!glt)
@@ -1551,6 +1662,10 @@ gltexture_t *TexMgr_LoadImageEx (qmodel_t *owner, const char *name, int width, i
 	glt->source_width = width;
 	glt->source_height = height;
 	glt->source_crc = crc;
+	glt->lastseen = -1.0;
+	glt->lodskip = 0;
+	if (gl_texture_budget_mb.value > 0.f && TexMgr_IsStreamable (glt))
+		glt->lodskip = q_min (TEXMGR_INITIAL_LODSKIP, TexMgr_MaxLodSkip (width, height));
 
 	//upload it
 	mark = Hunk_LowMark();
@@ -1568,12 +1683,8 @@ gltexture_t *TexMgr_LoadImageEx (qmodel_t *owner, const char *name, int width, i
 		break;
 	}
 
-	GL_ObjectLabelFunc (GL_TEXTURE, glt->texnum, -1, glt->name);
-	if (flags & TEXPREF_BINDLESS && gl_bindless_able)
-	{
-		glt->bindless_handle = GL_GetTextureHandleARBFunc (glt->texnum);
-		GL_MakeTextureHandleResidentARBFunc (glt->bindless_handle);
-	}
+	TexMgr_FinishTexture (glt);
+	glt->visframe = -1; // uploading doesn't count as use
 
 	Hunk_FreeToLowMark(mark);
 
@@ -1605,7 +1716,7 @@ gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int
 TexMgr_ReloadImage -- reloads a texture, and colormaps it if needed
 ================
 */
-void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
+qboolean TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
 {
 	byte	translation[256];
 	byte	*src, *dst, *data = NULL, *translated;
@@ -1646,10 +1757,10 @@ void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
 	else if (!glt->source_file[0] && glt->source_offset) {
 		data = (byte *) glt->source_offset; //image in memory
 	}
-	if (!data && shirt > -1 && pants > -1) {
+	if (!data && (glt->source_file[0] || (shirt > -1 && pants > -1))) {
 invalid:	Con_Printf ("TexMgr_ReloadImage: invalid source for %s\n", glt->name);
 		Hunk_FreeToLowMark(mark);
-		return;
+		return false;
 	}
 
 	if (fmt != glt->source_format)
@@ -1731,14 +1842,11 @@ invalid:	Con_Printf ("TexMgr_ReloadImage: invalid source for %s\n", glt->name);
 		break;
 	}
 
-	GL_ObjectLabelFunc (GL_TEXTURE, glt->texnum, -1, glt->name);
-	if (glt->flags & TEXPREF_BINDLESS && gl_bindless_able)
-	{
-		glt->bindless_handle = GL_GetTextureHandleARBFunc (glt->texnum);
-		GL_MakeTextureHandleResidentARBFunc (glt->bindless_handle);
-	}
+	TexMgr_FinishTexture (glt);
 
 	Hunk_FreeToLowMark(mark);
+
+	return true;
 }
 
 /*
@@ -1785,6 +1893,504 @@ void TexMgr_ReloadNobrightImages (void)
 			TexMgr_ReloadImage(glt, -1, -1);
 }
 
+/*
+================================================================================
+
+	TEXTURE RESIDENCY
+
+With gl_texture_budget_mb set, mipmapped textures that can be reloaded from
+their source file start out without their top mip levels. Textures used in
+the last second get their full resolution streamed back in, one upload per
+frame, as long as it fits in the budget. While over budget, the largest
+texture that hasn't been used for gl_texture_evict_time seconds loses its
+top mip level, one per frame.
+
+================================================================================
+*/
+
+/*
+================
+TexMgr_FinishTexture -- label the texture object and create its bindless handle, if needed
+================
+*/
+static void TexMgr_FinishTexture (gltexture_t *glt)
+{
+	GL_ObjectLabelFunc (GL_TEXTURE, glt->texnum, -1, glt->name);
+	if (glt->flags & TEXPREF_BINDLESS && gl_bindless_able)
+	{
+		glt->bindless_handle = GL_GetTextureHandleARBFunc (glt->texnum);
+		GL_MakeTextureHandleResidentARBFunc (glt->bindless_handle);
+	}
+}
+
+/*
+================
+TexMgr_IsStreamable
+================
+*/
+static qboolean TexMgr_IsStreamable (const gltexture_t *glt)
+{
+	if (glt->target != GL_TEXTURE_2D || glt->source_format == SRC_LIGHTMAP)
+		return false;
+	if (!(glt->flags & TEXPREF_MIPMAP) || (glt->flags & (TEXPREF_NOPICMIP | TEXPREF_OVERWRITE | TEXPREF_PERSIST)))
+		return false;
+	// in-memory sources aren't guaranteed to stay around
+	return glt->source_file[0] != 0;
+}
+
+/*
+================
+TexMgr_MaxLodSkip -- number of mip levels that can be dropped from a full-size texture
+================
+*/
+static int TexMgr_MaxLodSkip (int width, int height)
+{
+	int skip = 0;
+	while (skip < TEXMGR_MAX_LODSKIP && (width >> (skip + 1)) >= TEXMGR_MIN_STREAM_SIZE && (height >> (skip + 1)) >= TEXMGR_MIN_STREAM_SIZE)
+		skip++;
+	return skip;
+}
+
+/*
+================
+TexMgr_TextureBytes -- estimated video memory used by a texture
+================
+*/
+static double TexMgr_TextureBytes (const gltexture_t *glt, int lodskip)
+{
+	int layers = glt->flags & TEXPREF_CUBEMAP ? glt->depth * 6 : glt->depth;
+	int width = q_max ((glt->width << glt->lodskip) >> lodskip, 1);
+	int height = q_max ((glt->height << glt->lodskip) >> lodskip, 1);
+	double s = (double) width * height * layers;
+	if (glt->flags & TEXPREF_MIPMAP)
+		s *= 4.0 / 3.0;
+	return s * 4.0 / glt->compression;
+}
+
+/*
+================
+TexMgr_SetLodSkip -- reload a texture from its source with a different number of dropped mip levels
+================
+*/
+static qboolean TexMgr_SetLodSkip (gltexture_t *glt, int lodskip)
+{
+	int oldskip = glt->lodskip;
+	int visframe = glt->visframe;
+
+	glt->lodskip = lodskip;
+	if (!TexMgr_ReloadImage (glt, -1, -1))
+	{
+		// the source is gone, stop streaming this texture
+		glt->lodskip = oldskip;
+		glt->source_file[0] = 0;
+		glt->source_offset = 0;
+		return false;
+	}
+	glt->visframe = visframe;
+
+	return true;
+}
+
+/*
+================
+TexMgr_CountLodChange
+================
+*/
+static void TexMgr_CountLodChange (const gltexture_t *glt, int oldskip, double before)
+{
+	if (glt->lodskip < oldskip)
+	{
+		residency_stats.streamed++;
+		residency_stats.streamedbytes += TexMgr_TextureBytes (glt, glt->lodskip);
+	}
+	else if (glt->lodskip > oldskip)
+	{
+		residency_stats.evicted++;
+		residency_stats.evictedbytes += before - TexMgr_TextureBytes (glt, glt->lodskip);
+	}
+}
+
+/*
+================
+TexMgr_BuildMipChain -- mips 32bit data down to the upload size and appends all smaller levels
+
+runs on the streaming worker. takes ownership of data, returns the malloc'ed chain or NULL
+================
+*/
+static unsigned *TexMgr_BuildMipChain (gltexture_t *glt, unsigned *data, int mipwidth, int mipheight)
+{
+	unsigned	*chain, *level;
+	size_t		size = 0;
+	int			width, height;
+
+	TexMgr_MipDown32 (glt, data, mipwidth, mipheight);
+
+	for (width = glt->width, height = glt->height; ; width = q_max (width >> 1, 1), height = q_max (height >> 1, 1))
+	{
+		size += (size_t) width * height;
+		if (width == 1 && height == 1)
+			break;
+	}
+
+	chain = (unsigned *) malloc (size * sizeof (unsigned));
+	if (chain)
+	{
+		// same steps as TexMgr_LoadImage32, with each level copied out
+		width = glt->width;
+		height = glt->height;
+		memcpy (chain, data, (size_t) width * height * sizeof (unsigned));
+		for (level = chain + width * height; width > 1 || height > 1; level += width * height)
+		{
+			if (height > 1)
+			{
+				TexMgr_MipMapH (data, width, height, glt->depth);
+				height >>= 1;
+			}
+			if (width > 1)
+			{
+				TexMgr_MipMapW (data, width, height, glt->depth);
+				width >>= 1;
+			}
+			memcpy (level, data, (size_t) width * height * sizeof (unsigned));
+		}
+	}
+
+	free (data);
+	return chain;
+}
+
+/*
+================
+TexMgr_UploadMipChain -- uploads the levels built by TexMgr_BuildMipChain
+================
+*/
+static void TexMgr_UploadMipChain (gltexture_t *glt, const unsigned *data)
+{
+	int	miplevel, mipwidth, mipheight;
+	glformat_t internalformat;
+	qboolean compress;
+
+	compress = gl_compress_textures.value && TexMgr_CanCompress (glt);
+	internalformat = (glt->flags & TEXPREF_HASALPHA) ? glformats[compress].alpha : glformats[compress].solid;
+	glt->compression = internalformat.ratio;
+	GL_Bind (GL_TEXTURE0, glt);
+
+	mipwidth = glt->width;
+	mipheight = glt->height;
+	for (miplevel = 0; ; miplevel++)
+	{
+		GL_TexImage (glt, miplevel, internalformat.id, mipwidth, mipheight, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		if (mipwidth == 1 && mipheight == 1)
+			break;
+		data += mipwidth * mipheight;
+		mipwidth = q_max (mipwidth >> 1, 1);
+		mipheight = q_max (mipheight >> 1, 1);
+	}
+
+	TexMgr_SetFilterModes (glt);
+}
+
+/*
+================
+TexMgr_StreamTask -- reads and decodes the source of a streamed texture on a worker
+
+32bit images also get mipped down and their smaller levels built, so only
+the upload is left to the main thread. 8bit lumps are just read, they're
+small and their palette conversion stays on the main thread.
+================
+*/
+static void TexMgr_StreamTask (void *unused)
+{
+	gltexture_t	*glt = &stream_request.work;
+	fileview_t	view;
+	byte		*data = NULL;
+	int			width, height, size;
+
+	if (glt->source_offset)
+	{
+		//lump inside file
+		size = glt->source_width * glt->source_height;
+		if (glt->source_format == SRC_RGBA)
+			size *= 4;
+		data = (byte *) malloc (size);
+		if (data && FS_ReadFile (&stream_request.loc, glt->source_offset, data, size) != size)
+		{
+			free (data);
+			data = NULL;
+		}
+	}
+	else if (FS_MapFile (&stream_request.loc, &view))
+	{
+		//simple file
+		data = Image_DecodeFile (&view, &width, &height);
+		COM_UnmapFile (&view);
+		if (data && (width != (int) glt->source_width || height != (int) glt->source_height))
+		{
+			// changed on disk, leave it to the synchronous reload
+			free (data);
+			data = NULL;
+		}
+	}
+
+	if (data && glt->source_format == SRC_RGBA)
+		data = (byte *) TexMgr_BuildMipChain (glt, (unsigned *) data, stream_request.mipwidth, stream_request.mipheight);
+
+	stream_request.data = data;
+}
+
+/*
+================
+TexMgr_StartStreaming -- queues a reload of a texture with a different number of dropped mip levels
+
+returns false if the source can't be decoded off the main thread
+================
+*/
+static qboolean TexMgr_StartStreaming (gltexture_t *glt, int lodskip)
+{
+	gltexture_t *work = &stream_request.work;
+
+	if (glt->shirt > -1 && glt->pants > -1)
+		return false;
+
+	if (glt->source_offset)
+	{
+		if (!FS_FindFile (glt->source_file, &stream_request.loc))
+			return false;
+	}
+	else if (!Image_FindDecodableFile (glt->source_file, &stream_request.loc))
+		return false;
+
+	*work = *glt;
+	work->width = work->source_width;
+	work->height = work->source_height;
+	work->lodskip = lodskip;
+	TexMgr_UploadSize (work, &stream_request.mipwidth, &stream_request.mipheight);
+
+	stream_request.active = true;
+	stream_request.glt = glt;
+	stream_request.oldskip = glt->lodskip;
+	stream_request.data = NULL;
+	Task_Run (TexMgr_StreamTask, NULL, &stream_request.counter);
+
+	return true;
+}
+
+/*
+================
+TexMgr_FinishStreaming -- uploads the result of a finished stream request
+================
+*/
+static void TexMgr_FinishStreaming (void)
+{
+	gltexture_t	*glt = stream_request.glt;
+	gltexture_t	*work = &stream_request.work;
+	byte		*data = stream_request.data;
+	int			oldskip = stream_request.oldskip;
+	int			mark, visframe;
+	double		before;
+
+	stream_request.active = false;
+	stream_request.glt = NULL;
+	stream_request.data = NULL;
+
+	// freed or reloaded meanwhile
+	if (!glt || glt->lodskip != oldskip)
+	{
+		free (data);
+		return;
+	}
+
+	before = TexMgr_TextureBytes (glt, oldskip);
+	if (!data)
+	{
+		if (!TexMgr_SetLodSkip (glt, work->lodskip))
+			return;
+	}
+	else
+	{
+		visframe = glt->visframe;
+		GL_DeleteTexture (glt);
+		glGenTextures (1, &glt->texnum);
+		glt->lodskip = work->lodskip;
+
+		if (glt->source_format == SRC_RGBA)
+		{
+			glt->flags |= work->flags & (TEXPREF_ALPHA | TEXPREF_ALPHAPIXELS);
+			glt->width = work->width;
+			glt->height = work->height;
+			TexMgr_UploadMipChain (glt, (unsigned *) data);
+		}
+		else
+		{
+			mark = Hunk_LowMark ();
+			glt->width = glt->source_width;
+			glt->height = glt->source_height;
+			TexMgr_LoadImage8 (glt, data);
+			Hunk_FreeToLowMark (mark);
+		}
+
+		TexMgr_FinishTexture (glt);
+		glt->visframe = visframe;
+		free (data);
+	}
+
+	TexMgr_CountLodChange (glt, oldskip, before);
+}
+
+/*
+================
+TexMgr_RequestLodSkip -- changes the number of dropped mip levels, decoding the source on a worker if possible
+================
+*/
+static void TexMgr_RequestLodSkip (gltexture_t *glt, int lodskip)
+{
+	int		oldskip = glt->lodskip;
+	double	before = TexMgr_TextureBytes (glt, oldskip);
+
+	if (TexMgr_StartStreaming (glt, lodskip))
+		return;
+	if (TexMgr_SetLodSkip (glt, lodskip))
+		TexMgr_CountLodChange (glt, oldskip, before);
+}
+
+/*
+================
+TexMgr_CancelStreaming -- waits for the streaming worker and drops its result
+
+must be called before the search paths change
+================
+*/
+void TexMgr_CancelStreaming (void)
+{
+	if (!stream_request.active)
+		return;
+
+	Task_Wait (&stream_request.counter);
+	free (stream_request.data);
+	stream_request.data = NULL;
+	stream_request.glt = NULL;
+	stream_request.active = false;
+}
+
+/*
+================
+TexMgr_DropTopMip -- drop the top mip level of an uncompressed texture, keeping the others
+================
+*/
+static void TexMgr_DropTopMip (gltexture_t *glt)
+{
+	GLuint		texnum;
+	GLint		internalformat;
+	int			level, numlevels, width, height;
+	int			visframe = glt->visframe;
+
+	GL_Bind (GL_TEXTURE0, glt);
+	glGetTexLevelParameteriv (glt->target, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalformat);
+
+	width = q_max (glt->width >> 1, 1);
+	height = q_max (glt->height >> 1, 1);
+
+	// allocate the whole chain first, copies need a complete destination
+	glGenTextures (1, &texnum);
+	GL_BindNative (GL_TEXTURE0, glt->target, texnum);
+	for (numlevels = 1; (q_max (width, height) >> numlevels) > 0; numlevels++)
+		;
+	for (level = 0; level < numlevels; level++)
+		glTexImage2D (glt->target, level, internalformat, q_max (width >> level, 1), q_max (height >> level, 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	for (level = 0; level < numlevels; level++)
+		GL_CopyImageSubDataFunc (glt->texnum, glt->target, level + 1, 0, 0, 0, texnum, glt->target, level, 0, 0, 0,
+			q_max (width >> level, 1), q_max (height >> level, 1), 1);
+
+	GL_DeleteTexture (glt);
+	glt->texnum = texnum;
+	glt->width = width;
+	glt->height = height;
+	glt->lodskip++;
+
+	TexMgr_SetFilterModes (glt);
+	TexMgr_FinishTexture (glt);
+	glt->visframe = visframe;
+}
+
+/*
+================
+TexMgr_UpdateResidency -- called once per frame, after rendering
+================
+*/
+void TexMgr_UpdateResidency (void)
+{
+	static int	lastframe = -1;
+	gltexture_t	*glt, *stream = NULL, *evict = NULL;
+	double		budget, resident = 0.0;
+	double		evicttime = q_max (gl_texture_evict_time.value, 0.f);
+
+	// only track usage for frames that actually rendered the scene
+	if (r_framecount == lastframe)
+		return;
+	lastframe = r_framecount;
+
+	if (stream_request.active && Task_IsDone (&stream_request.counter))
+		TexMgr_FinishStreaming ();
+
+	budget = q_max (gl_texture_budget_mb.value, 0.f) * 0x100000;
+
+	for (glt = active_gltextures; glt; glt = glt->next)
+	{
+		double unseen;
+
+		if (glt->visframe == r_framecount)
+			glt->lastseen = realtime;
+		resident += TexMgr_TextureBytes (glt, glt->lodskip);
+
+		if (!TexMgr_IsStreamable (glt) || glt == stream_request.glt)
+			continue;
+
+		unseen = glt->lastseen < 0.0 ? 1e30 : realtime - glt->lastseen;
+
+		// without a budget, everything goes back to full resolution
+		if (glt->lodskip && (budget <= 0.0 || unseen < TEXMGR_RECENT_TIME))
+			if (!stream || glt->lastseen > stream->lastseen || (glt->lastseen == stream->lastseen && glt->lodskip > stream->lodskip))
+				stream = glt;
+
+		if (unseen >= evicttime && glt->lodskip < TexMgr_MaxLodSkip (glt->width << glt->lodskip, glt->height << glt->lodskip))
+			if (!evict || TexMgr_TextureBytes (glt, glt->lodskip) > TexMgr_TextureBytes (evict, evict->lodskip))
+				evict = glt;
+	}
+
+	if (budget > 0.0 && resident > budget)
+	{
+		if (evict && evict->compression > 1)
+		{
+			// compressed textures get reloaded from their source instead
+			if (!stream_request.active)
+				TexMgr_RequestLodSkip (evict, evict->lodskip + 1);
+		}
+		else if (evict)
+		{
+			double before = TexMgr_TextureBytes (evict, evict->lodskip);
+			TexMgr_DropTopMip (evict);
+			TexMgr_CountLodChange (evict, evict->lodskip - 1, before);
+		}
+		return;
+	}
+
+	if (stream && !stream_request.active)
+	{
+		// pick the highest resolution that fits in the budget
+		double current = TexMgr_TextureBytes (stream, stream->lodskip);
+		int lodskip = stream->lodskip;
+
+		if (budget <= 0.0)
+			lodskip = 0;
+		else
+			while (lodskip > 0 && resident - current + TexMgr_TextureBytes (stream, lodskip - 1) <= budget)
+				lodskip--;
+
+		if (lodskip < stream->lodskip)
+			TexMgr_RequestLodSkip (stream, lodskip);
+	}
+}
+
 /*
 ================================================================================
 
@@ -1838,7 +2444,7 @@ void GL_BindTextures (GLuint first, GLsizei count, gltexture_t **textures)
 	GLuint handles[8];
 	GLsizei i;
 
-	if (gl_multi_bind_able && count < countof (handles))
+	if (gl_multi_bind_able && count <= countof (handles))
 	{
 		for (i = 0; i < count; i++)
 		{
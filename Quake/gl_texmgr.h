@@ -78,6 +78,9 @@ typedef struct gltexture_s {
 	signed char			pants; //0-13 pants color, or -1 if never colormapped
 //used for rendering
 	int			visframe; //matches r_framecount if texture was bound this frame
+//managed by the residency manager
+	double			lastseen; //realtime of the last frame the texture was used in, -1 if never
+	unsigned char		lodskip; //number of top mip levels that are not resident
 } gltexture_t;
 
 extern gltexture_t *notexture;
@@ -137,11 +140,14 @@ extern texfilter_t gl_texfilter;
 // TEXTURE MANAGER
 
 float TexMgr_FrameUsage (void);
+void TexMgr_UpdateResidency (void);
+void TexMgr_CancelStreaming (void);
 gltexture_t *TexMgr_FindTexture (qmodel_t *owner, const char *name);
 gltexture_t *TexMgr_NewTexture (void);
 void TexMgr_FreeTexture (gltexture_t *kill);
 void TexMgr_FreeTextures (unsigned int flags, unsigned int mask);
 void TexMgr_FreeTexturesForOwner (qmodel_t *owner);
+size_t TexMgr_GetOwnerBytes (qmodel_t *owner);
 void TexMgr_NewGame (void);
 void TexMgr_Init (void);
 void TexMgr_DeleteTextureObjects (void);
@@ -153,7 +159,7 @@ gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int
 			       byte *data, const char *source_file, src_offset_t source_offset, unsigned flags);
 gltexture_t *TexMgr_LoadImageEx (qmodel_t *owner, const char *name, int width, int height, int depth, enum srcformat format,
 			       byte *data, const char *source_file, src_offset_t source_offset, unsigned flags);
-void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants);
+qboolean TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants);
 void TexMgr_ReloadImages (void);
 void TexMgr_ReloadNobrightImages (void);
 
@@ -92,6 +92,8 @@ extern	cvar_t	r_drawentities;
 extern	cvar_t	r_drawworld;
 extern	cvar_t	r_drawviewmodel;
 extern	cvar_t	r_speeds;
+extern	cvar_t	r_gpuspeeds;
+extern	cvar_t	r_gpuspeeds_log;
 extern	cvar_t	r_pos;
 extern	cvar_t	r_waterwarp;
 extern	cvar_t	r_fullbright;
@@ -139,6 +141,7 @@ extern	const char	*gl_version;
 	x(void,			BindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size))\
 	x(void,			BufferData, (GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage))\
 	x(void,			BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data))\
+	x(void,			CopyBufferSubData, (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size))\
 	x(GLvoid*,		MapBuffer, (GLenum target, GLenum access))\
 	x(GLboolean,	UnmapBuffer, (GLenum target))\
 	x(void*,		MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))\
@@ -219,6 +222,7 @@ extern	const char	*gl_version;
 	x(void,			QueryCounter, (GLuint id, GLenum target))\
 	x(void,			GetQueryObjecti64v, (GLuint id, GLenum pname, GLint64 *params))\
 	x(void,			GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64 *params))\
+	x(void,			CopyImageSubData, (GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ, GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth))\
 
 #define QGL_ARB_buffer_storage_FUNCTIONS(x)\
 	x(void,			BufferStorage, (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags))\
@@ -352,6 +356,8 @@ typedef struct {
 	int		beams;
 	int		dlights;
 	int		gpu_upload;
+	int		guidraws;
+	int		aliaslods[MAX_ALIAS_LODS + 1];	// instances drawn per detail level
 } devstats_t;
 extern devstats_t dev_stats, dev_peakstats;
 
@@ -443,6 +449,7 @@ void R_AnimateLight (void);
 void R_MarkSurfaces (void);
 qboolean R_CullBox (vec3_t emins, vec3_t emaxs);
 qboolean R_CullModelForEntity (entity_t *e);
+void R_GetEntityBounds (const entity_t *e, vec3_t mins, vec3_t maxs);
 void R_EntityMatrix (float matrix[16], vec3_t origin, vec3_t angles, unsigned char scale);
 
 void R_InitParticles (void);
@@ -464,6 +471,10 @@ void R_DrawBrushModels_SkyStencil (entity_t **ents, int count);
 void R_DrawAliasModels (entity_t **ents, int count);
 void R_DrawSpriteModels (entity_t **ents, int count);
 void R_DrawBrushModels_ShowTris (entity_t **ents, int count);
+void R_DrawStaticBrushModels (void);
+void R_DrawStaticBrushModels_ShowTris (void);
+qboolean R_IsGPUStaticBModel (const entity_t *ent);
+void R_InvalidateStaticBModels (void);
 void R_DrawAliasModels_ShowTris (entity_t **ents, int count);
 void R_DrawSpriteModels_ShowTris (entity_t **ents, int count);
 
@@ -499,13 +510,45 @@ typedef struct bmodel_gpu_surf_s {
 	GLuint		padding1;
 } bmodel_gpu_surf_t;
 
+typedef struct bmodel_gpu_static_s {
+	vec3_t		mins;
+	GLuint		firstleaf;
+	vec3_t		maxs;
+	GLuint		numleafs;
+	GLuint		firstcmd;		// first source draw command (model->firstcmd)
+	GLuint		numsolid;
+	GLuint		numcutout;
+	GLuint		firstsolid;		// first output draw command for the solid pass
+	GLuint		firstcutout;	// first output draw command for the alpha-tested pass
+	GLuint		padding[3];
+} bmodel_gpu_static_t;
+
 void GL_BuildLightmaps (void);
 
 void GL_DeleteBModelBuffers (void);
 void GL_BuildBModelVertexBuffer (void);
 void GL_BuildBModelMarkBuffers (void);
+#define MAX_ALIAS_POOLS		16
+
+typedef struct aliaspool_s
+{
+	GLuint			vbo;
+	GLuint			ibo;
+	size_t			vbosize;		// bytes in use
+	size_t			ibosize;
+	size_t			vbocapacity;	// buffer sizes
+	size_t			ibocapacity;
+} aliaspool_t;
+
+extern aliaspool_t	gl_alias_pools[MAX_ALIAS_POOLS];
+extern int			gl_alias_numpools;
+
+void GLMesh_BuildLODs (qmodel_t *m, aliashdr_t *mainhdr);
 void GLMesh_LoadVertexBuffer (qmodel_t *m, aliashdr_t *hdr);
 void GLMesh_LoadVertexBuffers (void);
+void GLMesh_RebuildVertexBuffers (void);
+qboolean GLMesh_VertexBuffersDirty (void);
+void GLMesh_UpdateVertexBuffers (void);
 void GLMesh_DeleteVertexBuffers (void);
 
 int R_LightPoint (vec3_t p, float ofs, lightcache_t *cache);
@@ -645,6 +688,18 @@ void GL_AcquireFrameResources (void);
 void GL_ReleaseFrameResources (void);
 void GL_AddGarbageBuffer (GLuint handle);
 
+typedef struct gputime_s
+{
+	char	name[32];
+	int		depth;
+	int		parent;		// index of the enclosing pass, -1 if none
+	float	ms;
+} gputime_t;
+
+void GL_TimerBegin (const char *name);
+void GL_TimerEnd (void);
+int GL_GetGPUTimes (const gputime_t **out, float *framems);
+
 qboolean GL_NeedsSceneEffects (void);
 qboolean GL_NeedsPostprocess (void);
 void GL_PostProcess (void);
@@ -656,116 +656,15 @@ void Host_ClearMemory (void)
 	PR_ClearProgs(&sv.qcvm);
 	PR_ClearProgs(&cl.qcvm);
 /* host_hunklevel MUST be set at this point */
-	Hunk_FreeToLowMark (host_hunklevel);
+	Hunk_FreeToLowMark (q_max (host_hunklevel, Mod_ResidentHunkMark ()));
 	cls.signon = 0; // not CL_ClearSignons()
+	SV_FreeSignonBlob ();
 	memset (&sv, 0, sizeof(sv));
 
 	CL_FreeState ();
 }
 
 
-//==============================================================================
-//
-// Main thread APC queue
-//
-//==============================================================================
-
-typedef struct asyncproc_s
-{
-	void				(*func) (void *param);
-	void				*param;
-} asyncproc_t;
-
-typedef struct asyncqueue_s
-{
-	size_t				head;
-	size_t				tail;
-	size_t				capacity;
-	qboolean			teardown;
-	SDL_mutex			*mutex;
-	SDL_cond			*notfull;
-	asyncproc_t			*procs;
-} asyncqueue_t;
-
-static asyncqueue_t		async_queue;
-
-static void AsyncQueue_Init (asyncqueue_t *queue, size_t capacity)
-{
-	memset (queue, 0, sizeof (*queue));
-
-	if (!capacity)
-		capacity = 1024;
-	else
-		capacity = Q_nextPow2 (capacity);
-	queue->capacity = capacity;
-	capacity *= sizeof (queue->procs[0]);
-	queue->procs = (asyncproc_t *) malloc (capacity);
-	if (!queue->procs)
-		Sys_Error ("AsyncQueue_Init: malloc failed on %" SDL_PRIu64 " bytes", (uint64_t) capacity);
-
-	queue->mutex = SDL_CreateMutex ();
-	if (!queue->mutex)
-		Sys_Error ("AsyncQueue_Init: could not create mutex");
-
-	queue->notfull = SDL_CreateCond ();
-	if (!queue->notfull)
-		Sys_Error ("AsyncQueue_Init: could not create condition variable");
-}
-
-static void AsyncQueue_Push (asyncqueue_t *queue, void (*func) (void *param), void *param)
-{
-	asyncproc_t *proc;
-
-	if (!queue->mutex)
-		return;
-	SDL_LockMutex (queue->mutex);
-	while (!queue->teardown && queue->tail - queue->head >= queue->capacity)
-		SDL_CondWait (queue->notfull, queue->mutex);
-
-	if (!queue->teardown)
-	{
-		proc = &queue->procs[(queue->tail++) & (queue->capacity - 1)];
-		proc->func = func;
-		proc->param = param;
-	}
-
-	SDL_UnlockMutex (queue->mutex);
-}
-
-static void AsyncQueue_Drain (asyncqueue_t *queue)
-{
-	SDL_LockMutex (queue->mutex);
-	while (queue->head != queue->tail)
-	{
-		asyncproc_t *proc = &queue->procs[(queue->head++) & (queue->capacity - 1)];
-		proc->func (proc->param);
-		SDL_CondSignal (queue->notfull);
-	}
-	SDL_UnlockMutex (queue->mutex);
-}
-
-static void AsyncQueue_Destroy (asyncqueue_t *queue)
-{
-	if (!queue->mutex)
-		return;
-
-	SDL_LockMutex (queue->mutex);
-	queue->teardown = true;
-	SDL_UnlockMutex (queue->mutex);
-	SDL_CondBroadcast (queue->notfull);
-
-	AsyncQueue_Drain (queue);
-
-	SDL_DestroyCond (queue->notfull);
-	SDL_DestroyMutex (queue->mutex);
-	memset (queue, 0, sizeof (*queue));
-}
-
-void Host_InvokeOnMainThread (void (*func) (void *param), void *param)
-{
-	AsyncQueue_Push (&async_queue, func, param);
-}
-
 //==============================================================================
 //
 // Host Frame
@@ -1214,8 +1113,8 @@ void _Host_Frame (double time)
 	accumtime += host_netinterval?CLAMP(0.0, time, 0.2):0.0;	//for renderer/server isolation
 	Host_AdvanceTime (time);
 
-// run async procs
-	AsyncQueue_Drain (&async_queue);
+// run procs queued by other threads
+	Tasks_RunMainThreadQueue ();
 
 // get new key events
 	Key_UpdateForDest ();
@@ -1239,7 +1138,11 @@ void _Host_Frame (double time)
 
 		cl.sendprespawn = false;
 		MSG_WriteByte (&cls.message, clc_stringcmd);
-		MSG_WriteString (&cls.message, "prespawn");
+		// demos should stay playable in other engines, so don't ask for the blob while recording
+		if (cl_signonblob.value && !cls.demorecording)
+			MSG_WriteString (&cls.message, "prespawn blob");
+		else
+			MSG_WriteString (&cls.message, "prespawn");
 		vid.recalc_refdef = true;
 	}
 
@@ -1381,6 +1284,8 @@ Host_Init
 */
 void Host_Init (void)
 {
+	int		i;
+
 	if (standard_quake)
 		minimum_memory = MINIMUM_MEMORY;
 	else	minimum_memory = MINIMUM_MEMORY_LEVELPAK;
@@ -1392,13 +1297,14 @@ void Host_Init (void)
 		Sys_Error ("Only %4.1f megs of memory available, can't execute game", host_parms->memsize / (float)0x100000);
 
 	Memory_Init (host_parms->membase, host_parms->memsize);
-	AsyncQueue_Init (&async_queue, 1024);
+	Tasks_Init ();
 	Cbuf_Init ();
 	Cmd_Init ();
 	LOG_Init (host_parms);
 	Cvar_Init (); //johnfitz
 	COM_Init ();
 	COM_InitFilesystem ();
+	LoadProf_Init ();
 	Host_InitLocal ();
 	W_LoadWadFile (); //johnfitz -- filename is now hard-coded for honesty
 	if (cls.state != ca_dedicated)
@@ -1464,6 +1370,16 @@ void Host_Init (void)
 	// johnfitz -- in case the vid mode was locked during vid_init, we can unlock it now.
 		// note: two leading newlines because the command buffer swallows one of them.
 		Cbuf_AddText ("\n\nvid_unlock\n");
+
+	// -demoanalyze <demo> [demo...]: batch analysis, then quit
+		i = COM_CheckParm ("-demoanalyze");
+		if (i)
+		{
+			Cbuf_AddText ("demoparse");
+			for (i++; i < com_argc && com_argv[i][0] != '-' && com_argv[i][0] != '+'; i++)
+				Cbuf_AddText (va (" \"%s\"", com_argv[i]));
+			Cbuf_AddText ("\nquit\n");
+		}
 	}
 
 	if (cls.state == ca_dedicated)
@@ -1501,9 +1417,10 @@ void Host_Shutdown(void)
 
 	Steam_Shutdown ();
 
-	AsyncQueue_Destroy (&async_queue);
+	Tasks_CloseMainThreadQueue ();
 
 	Host_ShutdownSave ();
+	CL_StopRecording ();
 	Host_WriteConfiguration ();
 
 // stop downloads before shutting down networking
@@ -1523,6 +1440,8 @@ void Host_Shutdown(void)
 		VID_Shutdown();
 	}
 
+	Tasks_Shutdown ();
+
 	LOG_Close ();
 
 	LOC_Shutdown ();
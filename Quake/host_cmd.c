@@ -28,7 +28,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef WITHOUT_CURL
 #include <curl/curl.h>
 #endif
-#define MAX_URL	2048
 
 extern cvar_t	pausable;
 extern cvar_t	nomonsters;
@@ -67,12 +66,16 @@ FileList_AddWithData
 */
 static filelist_item_t *FileList_AddWithData (const char *name, const void *data, size_t datasize, filelist_item_t **list)
 {
-	filelist_item_t	*item,*cursor,*prev;
+	filelist_item_t	*item, **link, **cursor;
 
-	// ignore duplicate
-	for (item = *list; item; item = item->next)
-		if (!q_strcasecmp (name, item->name))
-			return item;
+	// find the insertion point (the list is in natural order) in the same
+	// pass as the duplicate check: case-insensitive duplicates always
+	// compare equal, so they can only follow the insertion point
+	for (link = list; *link && q_strnaturalcmp (name, (*link)->name) > 0; link = &(*link)->next)
+		;
+	for (cursor = link; *cursor && !q_strnaturalcmp (name, (*cursor)->name); cursor = &(*cursor)->next)
+		if (!q_strcasecmp (name, (*cursor)->name))
+			return *cursor; // ignore duplicate
 
 	item = (filelist_item_t *) malloc (sizeof(filelist_item_t) + datasize);
 	if (!item)
@@ -86,25 +89,8 @@ static filelist_item_t *FileList_AddWithData (const char *name, const void *data
 			memset (item + 1, 0, datasize);
 	}
 
-	// insert each entry in alphabetical order
-	if (*list == NULL ||
-	    q_strnaturalcmp (item->name, (*list)->name) < 0) //insert at front
-	{
-		item->next = *list;
-		*list = item;
-	}
-	else //insert later
-	{
-		prev = *list;
-		cursor = (*list)->next;
-		while (cursor && (q_strnaturalcmp (item->name, cursor->name) > 0))
-		{
-			prev = cursor;
-			cursor = cursor->next;
-		}
-		item->next = prev->next;
-		prev->next = item;
-	}
+	item->next = *link;
+	*link = item;
 
 	return item;
 }
@@ -162,7 +148,7 @@ filelist_item_t *extralevels;
 filelist_item_t **extralevels_sorted;
 size_t maxlevelnamelen;
 
-static SDL_Thread*	extralevels_parsing_thread;
+static taskcounter_t	extralevels_parsing_task;
 static SDL_atomic_t	extralevels_cancel_parsing;
 
 /*
@@ -396,7 +382,7 @@ static void ExtraMaps_Add (const char *name, const searchpath_t *source)
 ExtraMaps_ParseDescriptions
 ==================
 */
-static int ExtraMaps_ParseDescriptions (void *unused)
+static void ExtraMaps_ParseDescriptions (void *unused)
 {
 	char buf[1024];
 	int i;
@@ -407,29 +393,23 @@ static int ExtraMaps_ParseDescriptions (void *unused)
 		levelinfo_t		*extra = (levelinfo_t *) (item + 1);
 
 		if (SDL_AtomicGet (&extralevels_cancel_parsing))
-			return 1;
+			return;
 
 		if (!Mod_LoadMapDescription (buf, sizeof (buf), item->name))
 			SDL_AtomicSet (&extra->type, MAPTYPE_BMODEL);
 		SDL_AtomicSetPtr ((void **) &extra->message, buf[0] ? strdup (buf) : "");
 	}
-
-	return 0;
 }
 
 /*
 ==================
-ExtraMaps_WaitForParsingThread
+ExtraMaps_WaitForParsingTask
 ==================
 */
-static void ExtraMaps_WaitForParsingThread (void)
+static void ExtraMaps_WaitForParsingTask (void)
 {
-	if (extralevels_parsing_thread)
-	{
-		SDL_WaitThread (extralevels_parsing_thread, NULL);
-		extralevels_parsing_thread = NULL;
-		SDL_AtomicSet (&extralevels_cancel_parsing, 0);
-	}
+	Task_Wait (&extralevels_parsing_task);
+	SDL_AtomicSet (&extralevels_cancel_parsing, 0);
 }
 
 /*
@@ -485,7 +465,7 @@ void ExtraMaps_Init (void)
 	ExtraMaps_Sort ();
 
 	SDL_AtomicSet (&extralevels_cancel_parsing, 0);
-	extralevels_parsing_thread = SDL_CreateThread (ExtraMaps_ParseDescriptions, "Map parser", NULL);
+	Task_Run (ExtraMaps_ParseDescriptions, NULL, &extralevels_parsing_task);
 }
 
 /*
@@ -498,7 +478,7 @@ void ExtraMaps_Clear (void)
 	filelist_item_t *item;
 
 	SDL_AtomicSet (&extralevels_cancel_parsing, 1);
-	ExtraMaps_WaitForParsingThread ();
+	ExtraMaps_WaitForParsingTask ();
 
 	maxlevelnamelen = 0;
 	for (item = extralevels; item; item = item->next)
@@ -664,6 +644,8 @@ typedef struct
 	const char			*date;
 	const char			*download;
 	double				bytes_total;
+	uint32_t			crc;
+	qboolean			hascrc;
 	const jsonentry_t	*json;
 	SDL_atomic_t		bytes_downloaded;
 	SDL_atomic_t		status;
@@ -673,9 +655,7 @@ filelist_item_t			*modlist;
 static char				extramods_addons_url[MAX_URL];
 static json_t			*extramods_json;
 static SDL_atomic_t		extramods_json_cancel;
-static SDL_Thread*		extramods_json_downloader;
-static SDL_atomic_t		extramods_install_cancel;
-static SDL_Thread*		extramods_install_thread;
+static taskcounter_t	extramods_json_task;
 
 const char *Modlist_GetFullName (const filelist_item_t *item)
 {
@@ -752,7 +732,7 @@ static void Modlist_RegisterAddons (void *param)
 
 	for (entry = addons->firstchild; entry; entry = entry->next)
 	{
-		const char		*download, *gamedir, *name, *author, *date, *description;
+		const char		*download, *gamedir, *name, *author, *date, *description, *crc;
 		const double	*size;
 		modinfo_t		*info;
 		filelist_item_t	*item;
@@ -769,6 +749,7 @@ static void Modlist_RegisterAddons (void *param)
 		author		= JSON_FindString (entry, "author");
 		date		= JSON_FindString (entry, "date");
 		size		= JSON_FindNumber (entry, "size");
+		crc			= JSON_FindString (entry, "crc32");
 		description	= JSON_FindString (JSON_Find (entry, "description", JSON_OBJECT), "en");
 
 		item = FileList_AddWithData (gamedir, NULL, sizeof (*info), &modlist);
@@ -788,6 +769,11 @@ static void Modlist_RegisterAddons (void *param)
 			info->download = download;
 			if (size)
 				info->bytes_total = *size;
+			if (crc && *crc)
+			{
+				info->crc = (uint32_t) strtoul (crc, NULL, 16);
+				info->hascrc = true;
+			}
 			info->description = description;
 			info->author = author;
 			info->date = date;
@@ -828,7 +814,7 @@ static const char *Modlist_GetInstallDir (void)
 	return com_nightdivedir[0] ? com_nightdivedir : com_basedirs[com_numbasedirs - 1];
 }
 
-static int Modlist_DownloadJSON (void *unused)
+static void Modlist_DownloadJSON (void *unused)
 {
 	const char	*accept = "Accept: application/json";
 	const char	*basedir;
@@ -845,7 +831,7 @@ static int Modlist_DownloadJSON (void *unused)
 
 	// URL too long?
 	if ((size_t) q_snprintf (url, sizeof (url), "%s/" ADDON_MANIFEST_FILE, extramods_addons_url) >= sizeof (url))
-		return 1;
+		return;
 
 	time (&now);
 	basedir = com_basedirs[com_numbasedirs - 1];
@@ -890,17 +876,17 @@ static int Modlist_DownloadJSON (void *unused)
 	if (!Download (url, &download))
 	{
 		if (download.error)
-			Host_InvokeOnMainThread (Modlist_PrintJSONCurlError, (void *) download.error);
+			Tasks_PostToMainThread (Modlist_PrintJSONCurlError, (void *) download.error);
 		else if (download.response && download.response != 200)
-			Host_InvokeOnMainThread (Modlist_PrintJSONHTTPError, (void *) (uintptr_t) download.response);
+			Tasks_PostToMainThread (Modlist_PrintJSONHTTPError, (void *) (uintptr_t) download.response);
 		VEC_FREE (manifest);
-		return 1;
+		return;
 	}
 
 	if (SDL_AtomicGet (&extramods_json_cancel))
 	{
 		VEC_FREE (manifest);
-		return 1;
+		return;
 	}
 
 	VEC_PUSH (manifest, '\0');
@@ -916,176 +902,88 @@ static int Modlist_DownloadJSON (void *unused)
 
 	VEC_FREE (manifest);
 	if (!json)
-		return 1;
+		return;
 
 done:
-	Host_InvokeOnMainThread (Modlist_RegisterAddons, json);
-
-	return 0;
+	Tasks_PostToMainThread (Modlist_RegisterAddons, json);
 }
 
-typedef struct
-{
-	FILE			*file;
-	SDL_atomic_t	*progress;
-} moddownload_t;
-
-static size_t WriteModChunk (void *buffer, size_t size, size_t nmemb, void *stream)
+static void Modlist_OnInstallDone (void *param, installresult_t result, const char *error)
 {
-	moddownload_t *dl = (moddownload_t *) stream;
-	size_t ret = fwrite (buffer, size, nmemb, dl->file);
-	SDL_AtomicAdd (dl->progress, (int) ret);
-	return ret;
-}
-
-static void Modlist_FinishInstalling (void *param)
-{
-	if (extramods_install_thread)
-	{
-		SDL_WaitThread (extramods_install_thread, NULL);
-		extramods_install_thread = NULL;
-	}
-	if (param)
-	{
-		filelist_item_t *item = (filelist_item_t *) param;
-		const char *desc = Modlist_GetFullName (item);
-		if (!desc)
-			desc = item->name;
-
-		Con_Printf (
-			"\n"
-			"Add-on \"%s\" is ready,\n"
-			"type \"game %s\" to activate.\n"
-			"\n",
-			desc, item->name
-		);
-
-		M_OnModInstall (item->name);
-	}
-}
-
-static void Modlist_OnInstallFileCreationError (void *param)
-{
-	Modlist_FinishInstalling (NULL);
-	Con_Warning ("Couldn't create temporary file for add-on\n");
-}
-
-static void Modlist_OnInstallHTTPError (void *param)
-{
-	uintptr_t status = (uintptr_t) param;
-	Modlist_FinishInstalling (NULL);
-	Con_Warning ("Couldn't download add-on (HTTP status %d)\n", (int) status);
-}
-
-static void Modlist_OnInstallCurlError (void *param)
-{
-	Modlist_FinishInstalling (NULL);
-	Con_Warning ("Couldn't download add-on (%s)\n", (const char *) param);
-}
-
-static void Modlist_OnInstallRenameError (void *param)
-{
-	Modlist_FinishInstalling (NULL);
-	Con_Warning ("Couldn't install add-on (rename error)\n");
-}
-
-static int Modlist_InstallerThread (void *param)
-{
-	char			url[MAX_URL];
-	char			tmp[MAX_OSPATH];
-	char			path[MAX_OSPATH];
-	const char		*basedir;
-	FILE			*file;
 	filelist_item_t	*item = (filelist_item_t *) param;
 	modinfo_t		*info = (modinfo_t *) (item + 1);
-	download_t		download;
-	moddownload_t	mod;
-	qboolean		ok;
-	int				i;
-
-	basedir = Modlist_GetInstallDir ();
-	for (i = 0; i < 1000; i++)
-	{
-		q_snprintf (tmp, sizeof (tmp), "%s/%s/pak0.%s.tmp", basedir, item->name, COM_TempSuffix (i));
-		file = Sys_fopen (tmp, "wb");
-		if (file)
-			break;
-	}
-
-	if (!file)
-	{
-		Host_InvokeOnMainThread (Modlist_OnInstallFileCreationError, NULL);
-		return 1;
-	}
-
-	SDL_AtomicSet (&info->bytes_downloaded, 0);
-	SDL_AtomicSet (&info->status, MODSTATUS_INSTALLING);
-
-	mod.file = file;
-	mod.progress = &info->bytes_downloaded;
-
-	memset (&download, 0, sizeof (download));
-	download.write_fn		= WriteModChunk;
-	download.write_data		= &mod;
-	download.abort			= &extramods_install_cancel;
-
-	q_snprintf (url, sizeof (url), "%s/%s", extramods_addons_url, info->download);
-	ok = Download (url, &download);
-	fclose (file);
+	const char		*desc;
 
-	if (!ok)
-	{
-		Sys_remove (tmp);
-		SDL_AtomicSet (&info->status, MODSTATUS_DOWNLOADABLE);
-		if (download.error)
-			Host_InvokeOnMainThread (Modlist_OnInstallCurlError, (void *) download.error);
-		else if (download.response && download.response != 200)
-			Host_InvokeOnMainThread (Modlist_OnInstallHTTPError, (void *) (uintptr_t) download.response);
-		return 1;
-	}
+	desc = Modlist_GetFullName (item);
+	if (!desc)
+		desc = item->name;
 
-	q_snprintf (path, sizeof (path), "%s/%s/pak0.pak", basedir, item->name);
-	if (Sys_rename (tmp, path) != 0)
+	if (result != INSTALL_OK)
 	{
-		Sys_remove (tmp);
 		SDL_AtomicSet (&info->status, MODSTATUS_DOWNLOADABLE);
-		Host_InvokeOnMainThread (Modlist_OnInstallRenameError, NULL);
-		return 1;
+		if (result != INSTALL_CANCELLED)
+			Con_Warning ("Couldn't install add-on \"%s\" (%s)\n", desc, error ? error : "unknown error");
+		return;
 	}
 
 	SDL_AtomicSet (&info->status, MODSTATUS_INSTALLED);
-	Host_InvokeOnMainThread (Modlist_FinishInstalling, item);
 
-	return 0;
+	Con_Printf (
+		"\n"
+		"Add-on \"%s\" is ready,\n"
+		"type \"game %s\" to activate.\n"
+		"\n",
+		desc, item->name
+	);
+
+	M_OnModInstall (item->name);
 }
 
 qboolean Modlist_StartInstalling (const filelist_item_t *item)
 {
-	const char	*desc;
-	double		size;
+	modinfo_t			*info = (modinfo_t *) (item + 1);
+	installrequest_t	req;
+	const char			*desc;
+	double				size;
 
-	if (extramods_install_thread)
+	if (Modlist_GetStatus (item) != MODSTATUS_DOWNLOADABLE)
 		return false;
 
+	memset (&req, 0, sizeof (req));
+	if ((size_t) q_snprintf (req.url, sizeof (req.url), "%s/%s", extramods_addons_url, info->download) >= sizeof (req.url) ||
+		(size_t) q_snprintf (req.dir, sizeof (req.dir), "%s/%s", Modlist_GetInstallDir (), item->name) >= sizeof (req.dir))
+		return false;
+	q_strlcpy (req.filename, "pak0.pak", sizeof (req.filename));
+	req.size = info->bytes_total;
+	req.crc = info->crc;
+	req.hascrc = info->hascrc;
+	req.progress = &info->bytes_downloaded;
+	req.done = Modlist_OnInstallDone;
+	req.param = (void *) item;
+
 	size = Modlist_GetDownloadSize (item);
 	desc = Modlist_GetFullName (item);
 	if (!desc)
 		desc = item->name;
 
+	SDL_AtomicSet (&info->status, MODSTATUS_INSTALLING);
+	if (!Install_Start (&req))
+	{
+		SDL_AtomicSet (&info->status, MODSTATUS_DOWNLOADABLE);
+		return false;
+	}
+
 	if (size)
 		Con_Printf ("\nDownloading \"%s\" (%.1f MB)...\n\n", desc, size / (double) 0x100000);
 	else
 		Con_Printf ("\nDownloading \"%s\"...\n\n", desc);
 
-	SDL_AtomicSet (&extramods_install_cancel, 0);
-	extramods_install_thread = 	SDL_CreateThread (Modlist_InstallerThread, "Mod install", (void *) item);
-
-	return extramods_install_thread != NULL;
+	return true;
 }
 
 qboolean Modlist_IsInstalling (void)
 {
-	return extramods_install_thread != NULL;
+	return Install_NumActive () > 0;
 }
 
 static void Modlist_Add (const char *name)
@@ -1287,7 +1185,7 @@ static void Modlist_FindOnline (void)
 
 	Con_SafePrintf ("\nUsing add-on server \"%s\"\n", extramods_addons_url);
 
-	extramods_json_downloader = SDL_CreateThread (Modlist_DownloadJSON, "JSON dl", NULL);
+	Task_RunBlocking (Modlist_DownloadJSON, NULL, &extramods_json_task);
 }
 
 void Modlist_Init (void)
@@ -1298,18 +1196,10 @@ void Modlist_Init (void)
 
 void Modlist_ShutDown (void)
 {
-	if (extramods_json_downloader)
-	{
-		SDL_AtomicSet (&extramods_json_cancel, 1);
-		SDL_WaitThread (extramods_json_downloader, NULL);
-		extramods_json_downloader = NULL;
-	}
-	if (extramods_install_thread)
-	{
-		SDL_AtomicSet (&extramods_install_cancel, 1);
-		SDL_WaitThread (extramods_install_thread, NULL);
-		extramods_install_thread = NULL;
-	}
+	SDL_AtomicSet (&extramods_json_cancel, 1);
+	Task_Wait (&extramods_json_task);
+
+	Install_Shutdown ();
 }
 
 qboolean Modlist_IsInstalled (const char *game)
@@ -2199,11 +2089,8 @@ LOAD / SAVE GAME
 */
 
 static savedata_t		save_data;
-static qboolean			save_pending;
-static SDL_Thread		*save_thread;
-static SDL_mutex		*save_mutex;
-static SDL_cond			*save_finished_condition;
-static SDL_cond			*save_pending_condition;
+static qboolean			save_initialized;
+static taskcounter_t	save_task;
 
 /*
 ===============
@@ -2255,45 +2142,22 @@ static void Host_InvalidateSave (const char *relname)
 
 void Host_ShutdownSave (void)
 {
-	if (!save_mutex)
+	if (!save_initialized)
 		return; // not initialized yet
 
-	SDL_LockMutex (save_mutex);
-	while (save_pending)
-		SDL_CondWait (save_finished_condition, save_mutex);
-	save_pending = true;
-	save_data.file = NULL;
-	SDL_CondSignal (save_pending_condition);
-	SDL_UnlockMutex (save_mutex);
-
-	SDL_WaitThread (save_thread, NULL);
-	save_thread = NULL;
-
-	SDL_DestroyCond (save_finished_condition);
-	save_finished_condition = NULL;
-
-	SDL_DestroyCond (save_pending_condition);
-	save_pending_condition = NULL;
-
+	Task_Wait (&save_task);
 	SaveData_Clear (&save_data);
+	save_initialized = false;
 }
 
 void Host_WaitForSaveThread (void)
 {
-	SDL_LockMutex (save_mutex);
-	while (save_pending)
-		SDL_CondWait (save_finished_condition, save_mutex);
-	SDL_UnlockMutex (save_mutex);
+	Task_Wait (&save_task);
 }
 
 qboolean Host_IsSaving (void)
 {
-	qboolean saving;
-	SDL_LockMutex (save_mutex);
-	saving = save_pending;
-	SDL_UnlockMutex (save_mutex);
-
-	if (saving)
+	if (!Task_IsDone (&save_task))
 		return true;
 
 	if (save_data.abort.value && sv.lastsave[0])
@@ -2306,61 +2170,39 @@ qboolean Host_IsSaving (void)
 	return false;
 }
 
-static int Host_BackgroundSave (void *param)
+static void Host_BackgroundSave (void *param)
 {
 	savedata_t	*save = (savedata_t *) param;
+	edict_t		*ed;
+	int			i;
+	qboolean	abort = false;
 
-	while (true)
+	PR_SwitchQCVM (&sv.qcvm);
+	SaveData_WriteHeader (save);
+	for (i = 0, ed = save->edicts; i < save->num_edicts; i++, ed = NEXT_EDICT (ed))
 	{
-		edict_t		*ed;
-		int			i;
-		qboolean	abort = false;
-
-		SDL_LockMutex (save_mutex);
-		while (!save_pending)
-			SDL_CondWait (save_pending_condition, save_mutex);
-		SDL_UnlockMutex (save_mutex);
-
-		if (!save->file)
-			break;
-
-		PR_SwitchQCVM (&sv.qcvm);
-		SaveData_WriteHeader (save);
-		for (i = 0, ed = save->edicts; i < save->num_edicts; i++, ed = NEXT_EDICT (ed))
+		if (SDL_AtomicGet(&save->abort))
 		{
-			if (SDL_AtomicGet(&save->abort))
-			{
-				abort = true;
-				break;
-			}
-			ED_Write (save, ed);
-			fflush (save->file);
+			abort = true;
+			break;
 		}
-		if (!abort)
-			fprintf (save->file, "// %d edicts\n", save->num_edicts);
-		PR_SwitchQCVM (NULL);
-
-		fclose (save->file);
-		save->file = NULL;
-		if (abort)
-			Sys_remove (save->path);
-
-		SDL_LockMutex (save_mutex);
-		save_pending = false;
-		SDL_CondSignal (save_finished_condition);
-		SDL_UnlockMutex (save_mutex);
+		ED_Write (save, ed);
+		fflush (save->file);
 	}
+	if (!abort)
+		fprintf (save->file, "// %d edicts\n", save->num_edicts);
+	PR_SwitchQCVM (NULL);
 
-	return 0;
+	fclose (save->file);
+	save->file = NULL;
+	if (abort)
+		Sys_remove (save->path);
 }
 
-static void Host_InitSaveThread (void)
+static void Host_InitSave (void)
 {
-	save_mutex = SDL_CreateMutex ();
-	save_finished_condition = SDL_CreateCond ();
-	save_pending_condition = SDL_CreateCond ();
-	save_thread = SDL_CreateThread (Host_BackgroundSave, "SaveThread", &save_data);
 	SaveData_Init (&save_data);
+	save_initialized = true;
 }
 
 /*
@@ -2437,10 +2279,7 @@ static void Host_Savegame_f (void)
 	if (!strcmp (relname, sv.lastsave) && Host_IsSaving ())
 	{
 		SDL_AtomicCAS (&save_data.abort, 0, 1);
-		SDL_LockMutex (save_mutex);
-		while (save_pending)
-			SDL_CondWait (save_finished_condition, save_mutex);
-		SDL_UnlockMutex (save_mutex);
+		Task_Wait (&save_task);
 	}
 
 	f = Sys_fopen (name, "w");
@@ -2450,9 +2289,7 @@ static void Host_Savegame_f (void)
 		return;
 	}
 
-	SDL_LockMutex (save_mutex);
-	while (save_pending)
-		SDL_CondWait (save_finished_condition, save_mutex);
+	Task_Wait (&save_task);
 
 	q_strlcpy (save_data.path, name, sizeof (save_data.path));
 	save_data.file = f;
@@ -2462,9 +2299,8 @@ static void Host_Savegame_f (void)
 	SaveData_Fill (&save_data);
 	PR_SwitchQCVM (NULL);
 
-	save_pending = true;
-	SDL_CondSignal (save_pending_condition);
-	SDL_UnlockMutex (save_mutex);
+	// it switches to sv.qcvm, so it can't be run by a Task_Wait on a thread that has one
+	Task_RunOnWorker (Host_BackgroundSave, &save_data, &save_task);
 
 	q_strlcpy (sv.lastsave, relname, sizeof (sv.lastsave));
 	COM_StripExtension (sv.lastsave, relname, sizeof (relname));
@@ -3039,6 +2875,7 @@ static void Host_PreSpawn_f (void)
 
 	host_client->sendsignon = PRESPAWN_SIGNONBUFS;
 	host_client->signonidx = 0;
+	host_client->signonblob = Cmd_Argc () >= 2 && !strcmp (Cmd_Argv (1), "blob");
 }
 
 /*
@@ -3741,7 +3578,7 @@ Host_InitCommands
 */
 void Host_InitCommands (void)
 {
-	Host_InitSaveThread ();
+	Host_InitSave ();
 
 	Cmd_AddCommand ("maps", Host_Maps_f); //johnfitz
 	Cmd_AddCommand ("mods", Host_Mods_f); //johnfitz
@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-static byte *Image_LoadPCX (FILE *f, int *width, int *height);
+static byte *Image_LoadPCX (const fileview_t *file, int *width, int *height);
 static byte *Image_LoadLMP (FILE *f, int *width, int *height);
 
 #ifdef __GNUC__
@@ -61,6 +61,8 @@ static byte *Image_LoadLMP (FILE *f, int *width, int *height);
 
 static char loadfilename[MAX_OSPATH]; //file scope so that error messages can use it
 
+static const char *const stbi_formats[] = {"png", "tga", "jpg", NULL};
+
 typedef struct stdio_buffer_s {
 	FILE *f;
 	unsigned char buffer[1024];
@@ -105,8 +107,8 @@ returns a pointer to hunk allocated RGBA data
 */
 byte *Image_LoadImage (const char *name, int *width, int *height, enum srcformat *fmt)
 {
-	static const char *const stbi_formats[] = {"png", "tga", "jpg", NULL};
 	FILE	*f;
+	fileview_t	view;
 	int		i;
 
 	for (i = 0; stbi_formats[i]; i++)
@@ -136,11 +138,13 @@ byte *Image_LoadImage (const char *name, int *width, int *height, enum srcformat
 	}
 
 	q_snprintf (loadfilename, sizeof(loadfilename), "%s.pcx", name);
-	COM_FOpenFile (loadfilename, &f, NULL);
-	if (f)
+	if (COM_MapFile (loadfilename, &view, NULL))
 	{
+		byte *data;
 		*fmt = SRC_RGBA;
-		return Image_LoadPCX(f, width, height);
+		data = Image_LoadPCX (&view, width, height);
+		COM_UnmapFile (&view);
+		return data;
 	}
 
 	q_snprintf (loadfilename, sizeof(loadfilename), "%s.lmp", name);
@@ -154,6 +158,43 @@ byte *Image_LoadImage (const char *name, int *width, int *height, enum srcformat
 	return NULL;
 }
 
+/*
+============
+Image_FindDecodableFile
+
+looks up the file Image_LoadImage would load for name, if it's one that
+Image_DecodeFile can handle. returns false for pcx and lmp images.
+============
+*/
+qboolean Image_FindDecodableFile (const char *name, fileloc_t *loc)
+{
+	char	path[MAX_OSPATH];
+	int		i;
+
+	for (i = 0; stbi_formats[i]; i++)
+	{
+		q_snprintf (path, sizeof(path), "%s.%s", name, stbi_formats[i]);
+		if (FS_FindFile (path, loc))
+			return loc->size > 0 && loc->size <= INT_MAX;
+	}
+
+	return false;
+}
+
+/*
+============
+Image_DecodeFile
+
+decodes a png, tga or jpg file without touching the hunk or any other global
+state, so it's safe to call from worker threads.
+returns a pointer to malloc'ed RGBA data, or NULL
+============
+*/
+byte *Image_DecodeFile (const fileview_t *file, int *width, int *height)
+{
+	return stbi_load_from_memory (file->data, file->size, width, height, NULL, 4);
+}
+
 //==============================================================================
 //
 //  TGA
@@ -239,20 +280,20 @@ typedef struct
 /*
 ============
 Image_LoadPCX
+
+Decodes straight from the read-only file view
 ============
 */
-static byte *Image_LoadPCX (FILE *f, int *width, int *height)
+static byte *Image_LoadPCX (const fileview_t *file, int *width, int *height)
 {
 	pcxheader_t	pcx;
-	int			x, y, w, h, readbyte, runlength, start;
+	int			x, y, w, h, readbyte, runlength;
 	byte		*p, *data;
-	byte		palette[768];
-	stdio_buffer_t  *buf;
-
-	start = ftell (f); //save start of file (since we might be inside a pak file, SEEK_SET might not be the start of the pcx)
+	const byte	*palette, *src, *end;
 
-	if (fread(&pcx, sizeof(pcx), 1, f) != 1)
+	if (file->size < (int) sizeof(pcx) + 768)
 		Sys_Error ("Failed reading header from '%s'", loadfilename);
+	memcpy (&pcx, file->data, sizeof(pcx));
 
 	pcx.xmin = (unsigned short)LittleShort (pcx.xmin);
 	pcx.ymin = (unsigned short)LittleShort (pcx.ymin);
@@ -274,15 +315,10 @@ static byte *Image_LoadPCX (FILE *f, int *width, int *height)
 
 	data = (byte *) Hunk_AllocNoFill ((w*h+1)*4); //+1 to allow reading padding byte on last line
 
-	//load palette
-	fseek (f, start + com_filesize - 768, SEEK_SET);
-	if (fread (palette, 768, 1, f) != 1)
-		Sys_Error ("Failed reading palette from '%s'", loadfilename);
-
-	//back to start of image data
-	fseek (f, start + sizeof(pcx), SEEK_SET);
-
-	buf = Buf_Alloc(f);
+	//the palette is at the end of the file, the image data in between
+	palette = file->data + file->size - 768;
+	src = file->data + sizeof(pcx);
+	end = palette;
 
 	for (y=0; y<h; y++)
 	{
@@ -290,12 +326,12 @@ static byte *Image_LoadPCX (FILE *f, int *width, int *height)
 
 		for (x=0; x<(pcx.bytes_per_line); ) //read the extra padding byte if necessary
 		{
-			readbyte = Buf_GetC(buf);
+			readbyte = src < end ? *src++ : 0;
 
 			if(readbyte >= 0xC0)
 			{
 				runlength = readbyte & 0x3F;
-				readbyte = Buf_GetC(buf);
+				readbyte = src < end ? *src++ : 0;
 			}
 			else
 				runlength = 1;
@@ -312,9 +348,6 @@ static byte *Image_LoadPCX (FILE *f, int *width, int *height)
 		}
 	}
 
-	Buf_Free(buf);
-	fclose(f);
-
 	*width = w;
 	*height = h;
 	return data;
@@ -29,6 +29,10 @@ enum srcformat;
 //be sure to free the hunk after using this loading function
 byte *Image_LoadImage (const char *name, int *width, int *height, enum srcformat *fmt);
 
+//thread-safe decoding of the png/tga/jpg files Image_LoadImage would pick, returns malloc'ed RGBA data
+qboolean Image_FindDecodableFile (const char *name, fileloc_t *loc);
+byte *Image_DecodeFile (const fileview_t *file, int *width, int *height);
+
 byte* Image_CopyFlipped (const void *src, int width, int height, int bpp);
 
 qboolean Image_WriteTGA (const char *name, byte *data, int width, int height, int bpp, qboolean upsidedown);
@@ -0,0 +1,429 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// loadprof.c -- level load timeline
+
+#include "quakedef.h"
+
+#define MAX_LOADPROF_NODES	512
+#define MAX_LOADPROF_DEPTH	32
+
+typedef struct loadprofnode_s
+{
+	char		name[64];
+	int			parent;
+	int			firstchild;
+	int			lastchild;
+	int			next;
+	int			calls;
+	double		start;
+	double		time;		// inclusive
+
+	// exclusive counters, children are summed up when reporting
+	int			files;
+	int64_t		bytes;
+	int			uploads;
+	int64_t		uploadbytes;
+} loadprofnode_t;
+
+typedef struct loadproftotals_s
+{
+	int			files;
+	int64_t		bytes;
+	int			uploads;
+	int64_t		uploadbytes;
+} loadproftotals_t;
+
+static struct
+{
+	qboolean		active;
+	qboolean		finished;
+	int				numnodes;
+	int				stack[MAX_LOADPROF_DEPTH];
+	int				depth;
+	int				skipped;	// unmatched Begin calls that didn't get a node
+	loadprofnode_t	nodes[MAX_LOADPROF_NODES];
+} loadprof;
+
+static cvar_t host_loadprofile = {"host_loadprofile", "0", CVAR_NONE}; // 1 = print after the map starts, 2 = also write loadprofile.json
+
+/*
+================
+LoadProf_Current
+================
+*/
+static loadprofnode_t *LoadProf_Current (void)
+{
+	return &loadprof.nodes[loadprof.stack[loadprof.depth - 1]];
+}
+
+/*
+================
+LoadProf_Active
+================
+*/
+qboolean LoadProf_Active (void)
+{
+	return loadprof.active;
+}
+
+/*
+================
+LoadProf_BeginSession
+================
+*/
+void LoadProf_BeginSession (const char *name)
+{
+	loadprofnode_t *root;
+
+	loadprof.active = true;
+	loadprof.finished = false;
+	loadprof.skipped = 0;
+	loadprof.numnodes = 1;
+	loadprof.depth = 1;
+	loadprof.stack[0] = 0;
+
+	root = &loadprof.nodes[0];
+	memset (root, 0, sizeof (*root));
+	q_strlcpy (root->name, name, sizeof (root->name));
+	root->parent = root->firstchild = root->lastchild = root->next = -1;
+	root->calls = 1;
+	root->start = Sys_DoubleTime ();
+}
+
+/*
+================
+LoadProf_Begin
+================
+*/
+void LoadProf_Begin (const char *name)
+{
+	loadprofnode_t *parent, *node;
+	int i;
+
+	if (!loadprof.active)
+		return;
+
+	if (loadprof.skipped || loadprof.depth == MAX_LOADPROF_DEPTH)
+	{
+		loadprof.skipped++;
+		return;
+	}
+
+	parent = LoadProf_Current ();
+	for (i = parent->firstchild; i != -1; i = loadprof.nodes[i].next)
+		if (!strcmp (loadprof.nodes[i].name, name))
+			break;
+
+	if (i == -1)
+	{
+		if (loadprof.numnodes == MAX_LOADPROF_NODES)
+		{
+			loadprof.skipped++;
+			return;
+		}
+
+		i = loadprof.numnodes++;
+		node = &loadprof.nodes[i];
+		memset (node, 0, sizeof (*node));
+		q_strlcpy (node->name, name, sizeof (node->name));
+		node->parent = loadprof.stack[loadprof.depth - 1];
+		node->firstchild = node->lastchild = node->next = -1;
+		if (parent->lastchild != -1)
+			loadprof.nodes[parent->lastchild].next = i;
+		else
+			parent->firstchild = i;
+		parent->lastchild = i;
+	}
+
+	node = &loadprof.nodes[i];
+	node->calls++;
+	node->start = Sys_DoubleTime ();
+	loadprof.stack[loadprof.depth++] = i;
+}
+
+/*
+================
+LoadProf_End
+================
+*/
+void LoadProf_End (void)
+{
+	loadprofnode_t *node;
+
+	if (!loadprof.active)
+		return;
+
+	if (loadprof.skipped)
+	{
+		loadprof.skipped--;
+		return;
+	}
+
+	if (loadprof.depth <= 1)
+		return; // unbalanced, never pop the root
+
+	node = LoadProf_Current ();
+	node->time += Sys_DoubleTime () - node->start;
+	loadprof.depth--;
+}
+
+/*
+================
+LoadProf_AddFile
+================
+*/
+void LoadProf_AddFile (int64_t bytes)
+{
+	loadprofnode_t *node;
+
+	if (!loadprof.active)
+		return;
+
+	node = LoadProf_Current ();
+	node->files++;
+	node->bytes += bytes;
+}
+
+/*
+================
+LoadProf_AddUpload
+================
+*/
+void LoadProf_AddUpload (int64_t bytes)
+{
+	loadprofnode_t *node;
+
+	if (!loadprof.active)
+		return;
+
+	node = LoadProf_Current ();
+	node->uploads++;
+	node->uploadbytes += bytes;
+}
+
+/*
+================
+LoadProf_GetTotals
+
+Sums up the exclusive counters of a node and all its children
+================
+*/
+static void LoadProf_GetTotals (int index, loadproftotals_t *totals)
+{
+	const loadprofnode_t *node = &loadprof.nodes[index];
+	int i;
+
+	totals->files		+= node->files;
+	totals->bytes		+= node->bytes;
+	totals->uploads		+= node->uploads;
+	totals->uploadbytes	+= node->uploadbytes;
+
+	for (i = node->firstchild; i != -1; i = loadprof.nodes[i].next)
+		LoadProf_GetTotals (i, totals);
+}
+
+/*
+================
+LoadProf_PrintNode
+================
+*/
+static void LoadProf_PrintNode (int index, int depth)
+{
+	const loadprofnode_t *node = &loadprof.nodes[index];
+	loadproftotals_t totals;
+	char calls[32];
+	int i;
+
+	memset (&totals, 0, sizeof (totals));
+	LoadProf_GetTotals (index, &totals);
+
+	if (node->calls > 1)
+		q_snprintf (calls, sizeof (calls), " (x%d)", node->calls);
+	else
+		calls[0] = '\0';
+
+	Con_SafePrintf ("%9.1f %6d %8d %6d %8d  %*s%s%s\n",
+		node->time * 1000.0,
+		totals.files, (int)(totals.bytes / 1024),
+		totals.uploads, (int)(totals.uploadbytes / 1024),
+		depth * 2, "", node->name, calls
+	);
+
+	for (i = node->firstchild; i != -1; i = loadprof.nodes[i].next)
+		LoadProf_PrintNode (i, depth + 1);
+}
+
+/*
+================
+LoadProf_Print
+================
+*/
+static void LoadProf_Print (void)
+{
+	Con_SafePrintf ("\n%s\n", Con_Quakebar (40));
+	Con_SafePrintf ("%9s %6s %8s %6s %8s  %s\n", "ms", "files", "KB", "upl", "uplKB", "phase");
+	LoadProf_PrintNode (0, 0);
+	if (loadprof.numnodes == MAX_LOADPROF_NODES)
+		Con_SafePrintf ("(phase limit reached, some phases were not recorded)\n");
+}
+
+/*
+================
+LoadProf_WriteString
+================
+*/
+static void LoadProf_WriteString (FILE *f, const char *str)
+{
+	fputc ('"', f);
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			fprintf (f, "\\%c", *str);
+		else if ((unsigned char)*str < 32)
+			fprintf (f, "\\u%04x", (unsigned char)*str);
+		else
+			fputc (*str, f);
+	}
+	fputc ('"', f);
+}
+
+/*
+================
+LoadProf_WriteNode
+================
+*/
+static void LoadProf_WriteNode (FILE *f, int index, int depth)
+{
+	const loadprofnode_t *node = &loadprof.nodes[index];
+	loadproftotals_t totals;
+	int i;
+
+	memset (&totals, 0, sizeof (totals));
+	LoadProf_GetTotals (index, &totals);
+
+	fprintf (f, "%*s{\"name\": ", depth * 2, "");
+	LoadProf_WriteString (f, node->name);
+	fprintf (f, ", \"ms\": %.3f, \"calls\": %d, \"files\": %d, \"bytes\": %" SDL_PRIs64 ", \"uploads\": %d, \"uploadbytes\": %" SDL_PRIs64,
+		node->time * 1000.0, node->calls, totals.files, (int64_t)totals.bytes, totals.uploads, (int64_t)totals.uploadbytes);
+
+	if (node->firstchild != -1)
+	{
+		fprintf (f, ", \"children\": [\n");
+		for (i = node->firstchild; i != -1; i = loadprof.nodes[i].next)
+		{
+			LoadProf_WriteNode (f, i, depth + 1);
+			fprintf (f, loadprof.nodes[i].next != -1 ? ",\n" : "\n");
+		}
+		fprintf (f, "%*s]", depth * 2, "");
+	}
+
+	fputc ('}', f);
+}
+
+/*
+================
+LoadProf_WriteJSON
+================
+*/
+static void LoadProf_WriteJSON (const char *relname)
+{
+	char	name[MAX_OSPATH];
+	char	relpath[MAX_OSPATH];
+	FILE	*f;
+
+	q_strlcpy (relpath, relname, sizeof (relpath));
+	COM_AddExtension (relpath, ".json", sizeof (relpath));
+	q_snprintf (name, sizeof (name), "%s/%s", com_gamedir, relpath);
+	f = Sys_fopen (name, "w");
+	if (!f)
+	{
+		Con_Printf ("ERROR: couldn't open file %s.\n", relpath);
+		return;
+	}
+
+	LoadProf_WriteNode (f, 0, 0);
+	fputc ('\n', f);
+	fclose (f);
+
+	Con_Printf ("Wrote %s\n", relpath);
+}
+
+/*
+================
+LoadProf_EndSession
+================
+*/
+void LoadProf_EndSession (void)
+{
+	double now;
+
+	if (!loadprof.active)
+		return;
+
+	// close any phases still open (e.g. the client signon)
+	now = Sys_DoubleTime ();
+	loadprof.skipped = 0;
+	while (loadprof.depth > 0)
+	{
+		loadprofnode_t *node = LoadProf_Current ();
+		node->time += now - node->start;
+		loadprof.depth--;
+	}
+
+	loadprof.active = false;
+	loadprof.finished = true;
+
+	if (host_loadprofile.value)
+		LoadProf_Print ();
+	if (host_loadprofile.value >= 2.f)
+		LoadProf_WriteJSON ("loadprofile");
+}
+
+/*
+================
+LoadProf_f
+================
+*/
+static void LoadProf_f (void)
+{
+	if (!loadprof.finished)
+	{
+		Con_Printf ("No level load has been profiled yet.\n");
+		return;
+	}
+
+	if (Cmd_Argc () >= 2 && !q_strcasecmp (Cmd_Argv (1), "json"))
+		LoadProf_WriteJSON (Cmd_Argc () >= 3 ? Cmd_Argv (2) : "loadprofile");
+	else if (Cmd_Argc () >= 2)
+		Con_Printf ("usage: %s [json [filename]]\n", Cmd_Argv (0));
+	else
+		LoadProf_Print ();
+}
+
+/*
+================
+LoadProf_Init
+================
+*/
+void LoadProf_Init (void)
+{
+	Cmd_AddCommand ("loadprofile", LoadProf_f);
+	Cvar_RegisterVariable (&host_loadprofile);
+}
@@ -0,0 +1,46 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef _LOADPROF_H_
+#define _LOADPROF_H_
+
+// loadprof.h -- level load timeline
+
+/*
+A session covers one level change, from SV_SpawnServer (or the serverinfo
+message for remote clients and demos) until the client signon is complete.
+Phases nest: each LoadProf_Begin must be paired with a LoadProf_End.
+Sibling phases with the same name are merged, so it's fine to wrap
+functions that are called many times (e.g. per-model loading).
+Outside of a session all calls are no-ops.
+*/
+
+void LoadProf_Init (void);
+
+void LoadProf_BeginSession (const char *name);
+void LoadProf_EndSession (void);
+qboolean LoadProf_Active (void);
+
+void LoadProf_Begin (const char *name);
+void LoadProf_End (void);
+
+void LoadProf_AddFile (int64_t bytes);
+void LoadProf_AddUpload (int64_t bytes);
+
+#endif /* _LOADPROF_H_ */
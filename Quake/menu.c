@@ -6899,7 +6899,7 @@ void M_Menu_ModInfo_f (const filelist_item_t *item)
 	size_t i, j;
 
 	m_entersound = true;
-	if (Modlist_IsInstalling () || Modlist_GetStatus (item) != MODSTATUS_DOWNLOADABLE)
+	if (Modlist_GetStatus (item) != MODSTATUS_DOWNLOADABLE)
 	{
 		modsmenu.download_flash_time = DOWNLOAD_FLASH_TIME;
 		return;
@@ -247,10 +247,8 @@ extern "C" {
 typedef unsigned long mz_ulong;
 
 #define MZ_CRC32_INIT (0)
-#if 0
 /* mz_crc32() returns the initial CRC-32 value to use when called with ptr==NULL. */
 MINIZ_EXPORT mz_ulong mz_crc32(mz_ulong crc, const unsigned char *ptr, size_t buf_len);
-#endif
 
 /* Method */
 #define MZ_DEFLATED 8
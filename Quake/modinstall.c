@@ -0,0 +1,783 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// modinstall.c -- add-on download and install service
+
+#include "quakedef.h"
+#include "miniz.h"
+#ifndef WITHOUT_CURL
+#include <curl/curl.h>
+#endif
+
+#define INSTALL_POLL_MS		250
+#define INSTALL_CHUNK_SIZE	(64 * 1024)
+
+typedef struct installjob_s
+{
+	installrequest_t		req;
+	char					partpath[MAX_OSPATH];
+	qboolean				archive;
+	FILE					*file;
+	qfileofs_t				offset;			// size of the partial file when the transfer started
+	qfileofs_t				written;		// bytes written since then
+	qboolean				checkedresponse;
+	qboolean				discard;		// response body is not file data
+#ifndef WITHOUT_CURL
+	CURL					*curl;
+#endif
+	installresult_t			result;
+	char					error[256];
+	struct installjob_s		*next;
+} installjob_t;
+
+static struct
+{
+	SDL_SpinLock		lock;
+	installjob_t		*queue;			// waiting for a download slot
+	installjob_t		*queuetail;
+	qboolean			running;		// service task is active
+	SDL_atomic_t		active;			// jobs started but not yet reported
+	SDL_atomic_t		cancel;
+	taskcounter_t		service_task;
+	taskcounter_t		finish_tasks;
+} install;
+
+/*
+==================
+Install_Done
+
+Runs on the main thread
+==================
+*/
+static void Install_Done (void *param)
+{
+	installjob_t *job = (installjob_t *) param;
+
+	SDL_AtomicAdd (&install.active, -1);
+	if (job->req.done)
+		job->req.done (job->req.param, job->result, job->error[0] ? job->error : NULL);
+	free (job);
+}
+
+/*
+==================
+Install_Fail
+==================
+*/
+static void Install_Fail (installjob_t *job, installresult_t result, const char *fmt, ...)
+{
+	va_list argptr;
+
+	job->result = result;
+	va_start (argptr, fmt);
+	q_vsnprintf (job->error, sizeof (job->error), fmt, argptr);
+	va_end (argptr);
+}
+
+/*
+==================
+Install_FileCRC
+==================
+*/
+static qboolean Install_FileCRC (FILE *f, uint32_t *crc)
+{
+	byte	*buf;
+	size_t	n;
+
+	buf = (byte *) malloc (INSTALL_CHUNK_SIZE);
+	if (!buf)
+		return false;
+
+	*crc = (uint32_t) mz_crc32 (MZ_CRC32_INIT, NULL, 0);
+	Sys_fseek (f, 0, SEEK_SET);
+	while ((n = fread (buf, 1, INSTALL_CHUNK_SIZE, f)) > 0)
+		*crc = (uint32_t) mz_crc32 (*crc, buf, n);
+
+	free (buf);
+	return !ferror (f);
+}
+
+/*
+==================
+Install_Verify
+==================
+*/
+static qboolean Install_Verify (installjob_t *job)
+{
+	FILE		*f;
+	qfileofs_t	size;
+	uint32_t	crc;
+
+	f = Sys_fopen (job->partpath, "rb");
+	if (!f)
+	{
+		Install_Fail (job, INSTALL_ERR_FILE, "couldn't open %s", job->partpath);
+		return false;
+	}
+
+	size = COM_filelength (f);
+	if (job->req.size > 0.0 && (double) size != job->req.size)
+	{
+		fclose (f);
+		Install_Fail (job, INSTALL_ERR_VERIFY, "size mismatch (expected %.0f bytes, got %.0f)", job->req.size, (double) size);
+		return false;
+	}
+
+	if (job->req.hascrc)
+	{
+		if (!Install_FileCRC (f, &crc))
+		{
+			fclose (f);
+			Install_Fail (job, INSTALL_ERR_FILE, "couldn't read %s", job->partpath);
+			return false;
+		}
+		if (crc != job->req.crc)
+		{
+			fclose (f);
+			Install_Fail (job, INSTALL_ERR_VERIFY, "checksum mismatch (expected %08x, got %08x)", job->req.crc, crc);
+			return false;
+		}
+	}
+
+	fclose (f);
+	return true;
+}
+
+/*
+==================
+Install_ZipRead
+==================
+*/
+static size_t Install_ZipRead (void *opaque, mz_uint64 ofs, void *buf, size_t n)
+{
+	FILE *f = (FILE *) opaque;
+	if (Sys_fseek (f, (qfileofs_t) ofs, SEEK_SET) != 0)
+		return 0;
+	return fread (buf, 1, n, f);
+}
+
+/*
+==================
+Install_IsSafePath
+
+Rejects absolute paths and paths that would escape the destination directory
+==================
+*/
+static qboolean Install_IsSafePath (const char *path)
+{
+	const char *p;
+
+	if (!*path || *path == '/' || *path == '\\' || strchr (path, ':'))
+		return false;
+
+	for (p = path; *p; )
+	{
+		if (p[0] == '.' && p[1] == '.' && (!p[2] || p[2] == '/' || p[2] == '\\'))
+			return false;
+		while (*p && *p != '/' && *p != '\\')
+			p++;
+		while (*p == '/' || *p == '\\')
+			p++;
+	}
+
+	return true;
+}
+
+/*
+==================
+Install_UnpackEntry
+
+Streams a single archive entry to disk, inflating it in dictionary-sized chunks
+==================
+*/
+static qboolean Install_UnpackEntry (FILE *f, const mz_zip_archive_file_stat *stat, FILE *out)
+{
+	tinfl_decompressor	*inflator = NULL;
+	tinfl_status		status = TINFL_STATUS_FAILED;
+	byte				header[30];
+	byte				*inbuf = NULL;
+	byte				*dict = NULL;
+	size_t				inavail = 0, inofs = 0, dictofs = 0;
+	mz_uint64			remaining, written = 0;
+	uint32_t			crc;
+	qboolean			ok = false;
+
+	// local header is followed by the file name and extra field
+	if (Sys_fseek (f, (qfileofs_t) stat->m_local_header_ofs, SEEK_SET) != 0 ||
+		fread (header, 1, sizeof (header), f) != sizeof (header) ||
+		header[0] != 'P' || header[1] != 'K' || header[2] != 3 || header[3] != 4)
+		return false;
+	if (Sys_fseek (f, (header[26] | header[27] << 8) + (header[28] | header[29] << 8), SEEK_CUR) != 0)
+		return false;
+
+	inbuf = (byte *) malloc (INSTALL_CHUNK_SIZE);
+	if (!inbuf)
+		return false;
+
+	crc = (uint32_t) mz_crc32 (MZ_CRC32_INIT, NULL, 0);
+	remaining = stat->m_comp_size;
+
+	if (stat->m_method == 0) // stored
+	{
+		while (remaining)
+		{
+			size_t n = (size_t) q_min (remaining, (mz_uint64) INSTALL_CHUNK_SIZE);
+			if (fread (inbuf, 1, n, f) != n || fwrite (inbuf, 1, n, out) != n)
+				goto done;
+			crc = (uint32_t) mz_crc32 (crc, inbuf, n);
+			written += n;
+			remaining -= n;
+		}
+		ok = true;
+		goto done;
+	}
+
+	if (stat->m_method != MZ_DEFLATED)
+		goto done;
+
+	inflator = (tinfl_decompressor *) malloc (sizeof (*inflator));
+	dict = (byte *) malloc (TINFL_LZ_DICT_SIZE);
+	if (!inflator || !dict)
+		goto done;
+	tinfl_init (inflator);
+
+	for (;;)
+	{
+		size_t inbytes, outbytes;
+
+		if (!inavail && remaining)
+		{
+			inavail = (size_t) q_min (remaining, (mz_uint64) INSTALL_CHUNK_SIZE);
+			if (fread (inbuf, 1, inavail, f) != inavail)
+				goto done;
+			remaining -= inavail;
+			inofs = 0;
+		}
+
+		inbytes = inavail;
+		outbytes = TINFL_LZ_DICT_SIZE - dictofs;
+		status = tinfl_decompress (inflator, inbuf + inofs, &inbytes, dict, dict + dictofs, &outbytes,
+			remaining ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+		inavail -= inbytes;
+		inofs += inbytes;
+
+		if (outbytes)
+		{
+			if (fwrite (dict + dictofs, 1, outbytes, out) != outbytes)
+				goto done;
+			crc = (uint32_t) mz_crc32 (crc, dict + dictofs, outbytes);
+			written += outbytes;
+			dictofs = (dictofs + outbytes) & (TINFL_LZ_DICT_SIZE - 1);
+		}
+
+		if (status <= TINFL_STATUS_DONE)
+			break;
+		if (status == TINFL_STATUS_NEEDS_MORE_INPUT && !inavail && !remaining)
+			break;
+	}
+
+	ok = status == TINFL_STATUS_DONE;
+
+done:
+	free (dict);
+	free (inflator);
+	free (inbuf);
+
+	return ok && written == stat->m_uncomp_size && crc == stat->m_crc32;
+}
+
+/*
+==================
+Install_Unpack
+==================
+*/
+static qboolean Install_Unpack (installjob_t *job)
+{
+	mz_zip_archive			zip;
+	mz_zip_archive_file_stat	stat;
+	char					path[MAX_OSPATH];
+	char					tmp[MAX_OSPATH];
+	FILE					*f, *out;
+	mz_uint					i, count;
+	qboolean				ok = true;
+
+	f = Sys_fopen (job->partpath, "rb");
+	if (!f)
+	{
+		Install_Fail (job, INSTALL_ERR_FILE, "couldn't open %s", job->partpath);
+		return false;
+	}
+
+	memset (&zip, 0, sizeof (zip));
+	zip.m_pRead = Install_ZipRead;
+	zip.m_pIO_opaque = f;
+	if (!mz_zip_reader_init (&zip, (mz_uint64) COM_filelength (f), 0))
+	{
+		fclose (f);
+		Install_Fail (job, INSTALL_ERR_ARCHIVE, "not a valid zip archive");
+		return false;
+	}
+
+	count = zip.m_total_files;
+	for (i = 0; i < count && ok; i++)
+	{
+		if (SDL_AtomicGet (&install.cancel))
+		{
+			job->result = INSTALL_CANCELLED;
+			ok = false;
+			break;
+		}
+
+		if (!mz_zip_reader_file_stat (&zip, i, &stat))
+		{
+			Install_Fail (job, INSTALL_ERR_ARCHIVE, "corrupt archive");
+			ok = false;
+			break;
+		}
+		if (stat.m_is_directory)
+			continue;
+		if (!stat.m_is_supported || !Install_IsSafePath (stat.m_filename))
+		{
+			Install_Fail (job, INSTALL_ERR_ARCHIVE, "unsupported entry \"%s\"", stat.m_filename);
+			ok = false;
+			break;
+		}
+
+		if ((size_t) q_snprintf (path, sizeof (path), "%s/%s", job->req.dir, stat.m_filename) >= sizeof (path) ||
+			(size_t) q_snprintf (tmp, sizeof (tmp), "%s.tmp", path) >= sizeof (tmp))
+		{
+			Install_Fail (job, INSTALL_ERR_ARCHIVE, "path too long for \"%s\"", stat.m_filename);
+			ok = false;
+			break;
+		}
+
+		COM_CreatePath (tmp);
+		out = Sys_fopen (tmp, "wb");
+		if (!out)
+		{
+			Install_Fail (job, INSTALL_ERR_FILE, "couldn't create %s", tmp);
+			ok = false;
+			break;
+		}
+
+		ok = Install_UnpackEntry (f, &stat, out);
+		if (fclose (out) != 0)
+			ok = false;
+		if (!ok)
+		{
+			Sys_remove (tmp);
+			Install_Fail (job, INSTALL_ERR_ARCHIVE, "couldn't unpack \"%s\"", stat.m_filename);
+			break;
+		}
+
+		Sys_remove (path);
+		if (Sys_rename (tmp, path) != 0)
+		{
+			Sys_remove (tmp);
+			Install_Fail (job, INSTALL_ERR_FILE, "couldn't rename %s", tmp);
+			ok = false;
+		}
+	}
+
+	mz_zip_reader_end (&zip);
+	fclose (f);
+
+	return ok;
+}
+
+/*
+==================
+Install_FinishTask
+
+Verifies the downloaded file and moves it into place
+==================
+*/
+static void Install_FinishTask (void *param)
+{
+	installjob_t	*job = (installjob_t *) param;
+	char			path[MAX_OSPATH];
+
+	if (job->result != INSTALL_OK)
+		goto done;
+
+	if (!Install_Verify (job))
+	{
+		// start over next time
+		if (job->result == INSTALL_ERR_VERIFY)
+			Sys_remove (job->partpath);
+		goto done;
+	}
+
+	if (job->archive)
+	{
+		if (Install_Unpack (job))
+			Sys_remove (job->partpath);
+		goto done;
+	}
+
+	if ((size_t) q_snprintf (path, sizeof (path), "%s/%s", job->req.dir, job->req.filename) >= sizeof (path))
+	{
+		Install_Fail (job, INSTALL_ERR_FILE, "path too long");
+		goto done;
+	}
+	if (Sys_rename (job->partpath, path) != 0)
+		Install_Fail (job, INSTALL_ERR_FILE, "couldn't rename %s", job->partpath);
+
+done:
+	Tasks_PostToMainThread (Install_Done, job);
+}
+
+#ifndef WITHOUT_CURL
+
+/*
+==================
+Install_WriteChunk
+==================
+*/
+static size_t Install_WriteChunk (void *buffer, size_t size, size_t nmemb, void *stream)
+{
+	installjob_t	*job = (installjob_t *) stream;
+	size_t			ret;
+
+	if (SDL_AtomicGet (&install.cancel))
+		return 0;
+
+	if (!job->checkedresponse)
+	{
+		long response = 0;
+		curl_easy_getinfo (job->curl, CURLINFO_RESPONSE_CODE, &response);
+		job->checkedresponse = true;
+		if (response != 200 && response != 206)
+			job->discard = true;	// error page
+	}
+
+	if (job->discard)
+		return nmemb;
+
+	ret = fwrite (buffer, size, nmemb, job->file);
+	job->written += ret;
+	if (job->req.progress)
+		SDL_AtomicAdd (job->req.progress, (int) ret);
+
+	return ret;
+}
+
+/*
+==================
+Install_BeginDownload
+
+Returns false if the job doesn't need a transfer (it's either complete or failed)
+==================
+*/
+static qboolean Install_BeginDownload (CURLM *multi, installjob_t *job)
+{
+	FILE		*f;
+	CURLMcode	mc;
+
+	COM_CreatePath (job->partpath);
+
+	job->offset = 0;
+	job->written = 0;
+	job->checkedresponse = false;
+	job->discard = false;
+	f = Sys_fopen (job->partpath, "rb");
+	if (f)
+	{
+		job->offset = COM_filelength (f);
+		fclose (f);
+	}
+
+	// partial file is larger than expected, can't be resumed
+	if (job->req.size > 0.0 && (double) job->offset > job->req.size)
+	{
+		Sys_remove (job->partpath);
+		job->offset = 0;
+	}
+
+	if (job->req.progress)
+		SDL_AtomicSet (job->req.progress, (int) job->offset);
+
+	// already complete (e.g. interrupted while verifying)
+	if (job->req.size > 0.0 && (double) job->offset == job->req.size)
+		return false;
+
+	job->file = Sys_fopen (job->partpath, job->offset > 0 ? "ab" : "wb");
+	if (!job->file)
+	{
+		Install_Fail (job, INSTALL_ERR_FILE, "couldn't create %s", job->partpath);
+		return false;
+	}
+
+	job->curl = curl_easy_init ();
+	if (!job->curl)
+	{
+		fclose (job->file);
+		job->file = NULL;
+		Install_Fail (job, INSTALL_ERR_NETWORK, "curl_easy_init failed");
+		return false;
+	}
+
+	curl_easy_setopt (job->curl, CURLOPT_URL, job->req.url);
+	curl_easy_setopt (job->curl, CURLOPT_WRITEFUNCTION, Install_WriteChunk);
+	curl_easy_setopt (job->curl, CURLOPT_WRITEDATA, job);
+	curl_easy_setopt (job->curl, CURLOPT_USE_SSL, CURLUSESSL_ALL);
+	curl_easy_setopt (job->curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt (job->curl, CURLOPT_MAXREDIRS, 50L);
+	if (job->offset > 0)
+		curl_easy_setopt (job->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t) job->offset);
+
+	mc = curl_multi_add_handle (multi, job->curl);
+	if (mc != CURLM_OK)
+	{
+		curl_easy_cleanup (job->curl);
+		job->curl = NULL;
+		fclose (job->file);
+		job->file = NULL;
+		Install_Fail (job, INSTALL_ERR_NETWORK, "%s", curl_multi_strerror (mc));
+		return false;
+	}
+
+	return true;
+}
+
+/*
+==================
+Install_EndDownload
+
+Returns true if the transfer should be started again from scratch
+==================
+*/
+static qboolean Install_EndDownload (CURLM *multi, installjob_t *job, CURLcode code)
+{
+	long response = 0;
+
+	curl_easy_getinfo (job->curl, CURLINFO_RESPONSE_CODE, &response);
+	curl_multi_remove_handle (multi, job->curl);
+	curl_easy_cleanup (job->curl);
+	job->curl = NULL;
+
+	if (job->file && fclose (job->file) != 0 && code == CURLE_OK)
+		Install_Fail (job, INSTALL_ERR_FILE, "couldn't write %s", job->partpath);
+	job->file = NULL;
+
+	// libcurl fails a resumed transfer if the server replies with the whole file (200),
+	// throw the partial file away and request the file without a range
+	if (job->result == INSTALL_OK && code == CURLE_RANGE_ERROR && job->offset > 0 && !SDL_AtomicGet (&install.cancel))
+	{
+		Sys_remove (job->partpath);
+		return true;
+	}
+
+	if (job->result == INSTALL_OK)
+	{
+		if (SDL_AtomicGet (&install.cancel))
+			job->result = INSTALL_CANCELLED;
+		else if (code != CURLE_OK)
+			Install_Fail (job, INSTALL_ERR_NETWORK, "%s", curl_easy_strerror (code));
+		else if (response == 416 && job->offset > 0)
+			;	// nothing left to download, verification will tell if the file is complete
+		else if (response != 200 && response != 206)
+			Install_Fail (job, INSTALL_ERR_HTTP, "HTTP status %ld", response);
+	}
+
+	// don't leave empty partial files behind
+	if (job->result != INSTALL_OK && !job->offset && !job->written)
+		Sys_remove (job->partpath);
+
+	return false;
+}
+
+/*
+==================
+Install_ServiceTask
+
+Drives all transfers through a single multi handle until the queue is empty
+==================
+*/
+static void Install_ServiceTask (void *unused)
+{
+	installjob_t	*downloads[MAX_INSTALL_DOWNLOADS];
+	installjob_t	*job;
+	CURLM			*multi;
+	CURLMsg			*msg;
+	CURLMcode		mc = CURLM_OK;
+	int				i, numdownloads = 0, still_running, msgs_left;
+
+	multi = curl_multi_init ();
+
+	for (;;)
+	{
+		// pick up new jobs
+		SDL_AtomicLock (&install.lock);
+		while (install.queue && numdownloads < MAX_INSTALL_DOWNLOADS)
+		{
+			job = install.queue;
+			install.queue = job->next;
+			job->next = NULL;
+
+			if (!multi)
+				Install_Fail (job, INSTALL_ERR_NETWORK, "curl_multi_init failed");
+			else if (SDL_AtomicGet (&install.cancel))
+				job->result = INSTALL_CANCELLED;
+			else if (Install_BeginDownload (multi, job))
+			{
+				downloads[numdownloads++] = job;
+				continue;
+			}
+			Task_Run (Install_FinishTask, job, &install.finish_tasks);
+		}
+		if (!install.queue)
+			install.queuetail = NULL;
+		if (!numdownloads && !install.queue)
+		{
+			install.running = false;
+			SDL_AtomicUnlock (&install.lock);
+			break;
+		}
+		SDL_AtomicUnlock (&install.lock);
+
+		if (!numdownloads)
+			continue;
+
+		mc = curl_multi_perform (multi, &still_running);
+		if (mc == CURLM_OK && still_running)
+			mc = curl_multi_poll (multi, NULL, 0, INSTALL_POLL_MS, NULL);
+
+		while ((msg = curl_multi_info_read (multi, &msgs_left)) != NULL)
+		{
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			for (i = 0; i < numdownloads; i++)
+				if (downloads[i]->curl == msg->easy_handle)
+					break;
+			if (i == numdownloads)
+				continue;
+			job = downloads[i];
+			downloads[i] = downloads[--numdownloads];
+			if (Install_EndDownload (multi, job, msg->data.result) && Install_BeginDownload (multi, job))
+			{
+				downloads[numdownloads++] = job;
+				continue;
+			}
+			Task_Run (Install_FinishTask, job, &install.finish_tasks);
+		}
+
+		// abort everything that's still in flight
+		if (mc != CURLM_OK || SDL_AtomicGet (&install.cancel))
+		{
+			for (i = 0; i < numdownloads; i++)
+			{
+				job = downloads[i];
+				if (mc != CURLM_OK)
+					Install_Fail (job, INSTALL_ERR_NETWORK, "%s", curl_multi_strerror (mc));
+				Install_EndDownload (multi, job, CURLE_ABORTED_BY_CALLBACK);
+				Task_Run (Install_FinishTask, job, &install.finish_tasks);
+			}
+			numdownloads = 0;
+		}
+	}
+
+	if (multi)
+		curl_multi_cleanup (multi);
+}
+
+#endif // WITHOUT_CURL
+
+/*
+==================
+Install_Start
+
+Queues a download, returns false if the request is invalid
+==================
+*/
+qboolean Install_Start (const installrequest_t *req)
+{
+	installjob_t	*job;
+	const char		*name, *ext;
+#ifndef WITHOUT_CURL
+	qboolean		start;
+#endif
+
+	job = (installjob_t *) calloc (1, sizeof (*job));
+	if (!job)
+		return false;
+	job->req = *req;
+
+	// archives are named after the URL, plain files after their final name
+	name = COM_SkipPath (job->req.url);
+	ext = COM_FileGetExtension (name);
+	job->archive = !q_strcasecmp (ext, "zip");
+	if (!job->archive)
+		name = job->req.filename;
+	if (!*name || (size_t) q_snprintf (job->partpath, sizeof (job->partpath), "%s/%s.part", job->req.dir, name) >= sizeof (job->partpath))
+	{
+		free (job);
+		return false;
+	}
+
+	SDL_AtomicIncRef (&install.active);
+
+#ifdef WITHOUT_CURL
+	Install_Fail (job, INSTALL_ERR_NETWORK, "download support disabled at compile time.");
+	Task_Run (Install_FinishTask, job, &install.finish_tasks);
+#else
+	SDL_AtomicSet (&install.cancel, 0);
+	SDL_AtomicLock (&install.lock);
+	if (install.queuetail)
+		install.queuetail->next = job;
+	else
+		install.queue = job;
+	install.queuetail = job;
+	start = !install.running;
+	install.running = true;
+	SDL_AtomicUnlock (&install.lock);
+
+	// the service task takes the lock too (and may run inline if no thread can be created)
+	if (start)
+		Task_RunBlocking (Install_ServiceTask, NULL, &install.service_task);
+#endif
+
+	return true;
+}
+
+/*
+==================
+Install_NumActive
+
+Number of requests that haven't been reported back yet
+==================
+*/
+int Install_NumActive (void)
+{
+	return SDL_AtomicGet (&install.active);
+}
+
+/*
+==================
+Install_Shutdown
+
+Cancels all transfers, partial files are kept so they can be resumed later
+==================
+*/
+void Install_Shutdown (void)
+{
+	SDL_AtomicSet (&install.cancel, 1);
+	Task_Wait (&install.service_task);
+	Task_Wait (&install.finish_tasks);
+}
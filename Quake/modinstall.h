@@ -0,0 +1,73 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef _MODINSTALL_H_
+#define _MODINSTALL_H_
+
+// modinstall.c -- add-on download and install service
+
+/*
+All downloads share a single curl multi handle driven by one task, up to
+MAX_INSTALL_DOWNLOADS at a time; further requests wait in a queue.
+
+Data is written to "<dir>/<file>.part" and an interrupted download is
+resumed from there with an HTTP range request the next time it's started.
+Once complete, the file is checked against the expected size and CRC-32
+(if known), then either renamed to its final name or, for .zip archives,
+unpacked entry by entry into the destination directory. Verification and
+unpacking run as a separate task so that they don't hold up the other
+downloads.
+
+The completion callback is invoked on the main thread.
+*/
+
+#define MAX_URL					2048
+#define MAX_INSTALL_DOWNLOADS	4
+
+typedef enum
+{
+	INSTALL_OK,
+	INSTALL_CANCELLED,
+	INSTALL_ERR_FILE,		// couldn't create or write a local file
+	INSTALL_ERR_NETWORK,	// transfer failed
+	INSTALL_ERR_HTTP,		// unexpected HTTP status
+	INSTALL_ERR_VERIFY,		// size or checksum mismatch
+	INSTALL_ERR_ARCHIVE,	// couldn't unpack the archive
+} installresult_t;
+
+typedef void (*installdonefunc_t) (void *param, installresult_t result, const char *error);
+
+typedef struct
+{
+	char				url[MAX_URL];
+	char				dir[MAX_OSPATH];		// destination directory
+	char				filename[MAX_QPATH];	// final name (ignored for archives)
+	double				size;					// expected size in bytes, 0 if unknown
+	uint32_t			crc;					// expected CRC-32, if hascrc is set
+	qboolean			hascrc;
+	SDL_atomic_t		*progress;				// optional, bytes downloaded so far
+	installdonefunc_t	done;
+	void				*param;
+} installrequest_t;
+
+qboolean Install_Start (const installrequest_t *req);
+int Install_NumActive (void);
+void Install_Shutdown (void);
+
+#endif /* _MODINSTALL_H_ */
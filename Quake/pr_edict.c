@@ -51,6 +51,75 @@ cvar_t	saved2 = {"saved2", "0", CVAR_ARCHIVE};
 cvar_t	saved3 = {"saved3", "0", CVAR_ARCHIVE};
 cvar_t	saved4 = {"saved4", "0", CVAR_ARCHIVE};
 
+/*
+Resident progs images
+
+Everything PR_LoadProgs derives from a progs file (the byte-swapped lumps,
+merged field defs, hash and offset tables, builtin mappings, savegame fields)
+only depends on the file contents and on the VM type, so it's kept in malloc'd
+memory across level changes. On the next load of the same file (same path_id,
+size and CRC) only the mutable state is reset: functions (profiling counters),
+globals and the string tables.
+*/
+#define MAX_RESIDENT_PROGS	4
+
+typedef struct prprogsimage_s
+{
+	qboolean		valid;
+	qboolean		csqc;
+	char			filename[MAX_QPATH];
+	unsigned int	path_id;
+	int				filesize;
+	unsigned short	crc;
+	int				lastused;
+	double			buildtime;		// in seconds, for the load time breakdown
+
+	dprograms_t		*progs;			// immutable after load
+	ddef_t			*fielddefs;		// either inside progs or owned by the image
+	const char		**enginestrings;	// engine strings referenced by progs data, re-registered in order on reuse
+
+	int				edict_size;
+	int				effects_mask;
+	struct pr_extfields_s extfields;
+
+	builtin_t		builtins[MAX_BUILTINS];
+	qcextension_t	builtin_ext[MAX_BUILTINS];
+	int				numbuiltins;
+
+	prhashtable_t	ht_fields;
+	prhashtable_t	ht_functions;
+	prhashtable_t	ht_globals;
+
+	int				numentityfields;
+	int				*entityfieldofs;
+	ddef_t			**entityfields;
+	int				*functionsizes;
+
+	int				maxfieldofs;
+	int				*ofstofield;
+
+	int				maxglobalofs;
+	int				*ofstoglobal;
+} prprogsimage_t;
+
+static prprogsimage_t	pr_images[MAX_RESIDENT_PROGS];
+static int				pr_imagesequence;
+
+/*
+=================
+PR_ImageAlloc
+
+Returns zero-filled memory owned by a resident progs image
+=================
+*/
+static void *PR_ImageAlloc (size_t size, const char *name)
+{
+	void *ptr = calloc (1, size ? size : 1);
+	if (!ptr)
+		Sys_Error ("PR_ImageAlloc: out of memory on %" SDL_PRIu64 " bytes (%s)", (uint64_t)size, name);
+	return ptr;
+}
+
 /*
 =================
 PR_HashInit
@@ -60,8 +129,8 @@ static void PR_HashInit (prhashtable_t *table, int capacity, const char *name)
 {
 	capacity *= 2; // 50% load factor
 	table->capacity = capacity;
-	table->strings = (const char **) Hunk_AllocName (sizeof(*table->strings) * capacity, name);
-	table->indices = (int         *) Hunk_AllocName (sizeof(*table->indices) * capacity, name);
+	table->strings = (const char **) PR_ImageAlloc (sizeof(*table->strings) * capacity, name);
+	table->indices = (int         *) PR_ImageAlloc (sizeof(*table->indices) * capacity, name);
 }
 
 /*
@@ -1223,6 +1292,47 @@ static void ED_RezoneString (string_t *ref, const char *str)
 	qcvm->knownzone[id>>3] |= 1u<<(id&7);
 }
 
+/*
+=============
+ED_ParseVector
+
+Returns false if the string has fewer than 3 components
+(the missing ones are set to 0)
+=============
+*/
+static qboolean ED_ParseVector (const char *s, float *out)
+{
+	int		i;
+	char	string[128];
+	char	*v, *w;
+	char	*end;
+
+	q_strlcpy (string, s, sizeof(string));
+	end = (char *)string + strlen(string);
+	v = string;
+	w = string;
+
+	for (i = 0; i < 3 && (w <= end); i++) // ericw -- added (w <= end) check
+	{
+	// set v to the next space (or 0 byte), and change that char to a 0 byte
+		while (*v && *v != ' ')
+			v++;
+		*v = 0;
+		out[i] = atof (w);
+		w = v = v+1;
+	}
+	// ericw -- fill remaining elements to 0 in case we hit the end of string
+	// before reading 3 floats.
+	if (i < 3)
+	{
+		for (; i < 3; i++)
+			out[i] = 0.0f;
+		return false;
+	}
+
+	return true;
+}
+
 /*
 =============
 ED_ParseEval
@@ -1233,11 +1343,7 @@ returns false if error
 */
 static qboolean ED_ParseEpair (void *base, ddef_t *key, const char *s, qboolean zoned)
 {
-	int		i;
-	char	string[128];
 	ddef_t	*def;
-	char	*v, *w;
-	char	*end;
 	void	*d;
 	dfunction_t	*func;
 
@@ -1257,28 +1363,8 @@ static qboolean ED_ParseEpair (void *base, ddef_t *key, const char *s, qboolean
 		break;
 
 	case ev_vector:
-		q_strlcpy (string, s, sizeof(string));
-		end = (char *)string + strlen(string);
-		v = string;
-		w = string;
-
-		for (i = 0; i < 3 && (w <= end); i++) // ericw -- added (w <= end) check
-		{
-		// set v to the next space (or 0 byte), and change that char to a 0 byte
-			while (*v && *v != ' ')
-				v++;
-			*v = 0;
-			((float *)d)[i] = atof (w);
-			w = v = v+1;
-		}
-		// ericw -- fill remaining elements to 0 in case we hit the end of string
-		// before reading 3 floats.
-		if (i < 3)
-		{
+		if (!ED_ParseVector (s, (float *)d))
 			Con_DWarning ("Avoided reading garbage for \"%s\" \"%s\"\n", PR_GetString(key->s_name), s);
-			for (; i < 3; i++)
-				((float *)d)[i] = 0.0f;
-		}
 		break;
 
 	case ev_entity:
@@ -1437,6 +1523,507 @@ static qboolean ED_IsSkillSelector (const edict_t *ent)
 }
 
 
+/*
+===============================================================================
+
+PARALLEL ENTITY LUMP PARSING
+
+The entity lump is tokenized and its keys are resolved to fields on worker
+threads, producing a compact list of key/value pairs per entity. Entities
+are then allocated, filled in and spawned serially, in the original order,
+so the QC side sees exactly the same sequence as with a single-pass parse.
+The parsed lump is kept around and reused if the next map has the same
+entity text and progs (e.g. restart, or a .ent override that didn't change).
+
+===============================================================================
+*/
+
+#define MAX_ED_PARSE_CHUNKS		8
+#define MIN_ED_PARSE_CHUNK		512		// entities per chunk
+
+typedef struct edparsedpair_s
+{
+	int			field;		// index into fielddefs, -1 if the key isn't a field
+	int			keyname;	// offset into the chunk's strings
+	int			value;		// offset into the chunk's strings
+	float		v[3];		// pre-converted float/vector value
+	qboolean	partial;	// vector with fewer than 3 components
+} edparsedpair_t;
+
+typedef struct edparsedent_s
+{
+	int			firstpair;
+	int			numpairs;
+	qboolean	init;		// at least one key/value pair
+	qboolean	hasalpha;
+	float		alpha;
+} edparsedent_t;
+
+typedef struct edparsechunk_s
+{
+	qcvm_t			*vm;
+	const char		*start;
+	const char		*end;		// start of the next chunk, NULL for the last one
+	qboolean		mismatch;	// didn't end where the next chunk starts
+	char			error[1100];	// Host_Error message, raised after the chunk's entities are spawned
+
+	edparsedent_t	*ents;
+	edparsedpair_t	*pairs;
+	char			*strings;
+} edparsechunk_t;
+
+typedef struct edparsedlump_s
+{
+	char			*text;		// copy of the entity lump this was parsed from
+	unsigned		hash;
+	size_t			length;
+	unsigned short	progscrc;
+	int				numfielddefs;
+	int				numchunks;
+	edparsechunk_t	chunks[MAX_ED_PARSE_CHUNKS];
+} edparsedlump_t;
+
+static edparsedlump_t	ed_parsedlump;
+
+/*
+================
+ED_SkipToken
+
+Same tokenization rules as COM_ParseEx, but only reports
+the first character of the token instead of copying it
+================
+*/
+static const char *ED_SkipToken (const char *data, int *first)
+{
+	int		c;
+
+	*first = 0;
+
+skipwhite:
+	while ((c = *data) <= ' ')
+	{
+		if (c == 0)
+			return NULL;	// end of file
+		data++;
+	}
+
+	if (c == '/' && data[1] == '/')
+	{
+		while (*data && *data != '\n')
+			data++;
+		goto skipwhite;
+	}
+
+	if (c == '/' && data[1] == '*')
+	{
+		data += 2;
+		while (*data && !(*data == '*' && data[1] == '/'))
+			data++;
+		if (*data)
+			data += 2;
+		goto skipwhite;
+	}
+
+	if (c == '\"')
+	{
+		data++;
+		if (*data != '\"')
+			*first = *data;
+		while (1)
+		{
+			if ((c = *data) != 0)
+				++data;
+			if (c == '\"' || !c)
+				return data;
+		}
+	}
+
+	*first = c;
+	if (c == '{' || c == '}'|| c == '('|| c == ')' || c == '\'' || c == ':')
+		return data+1;
+
+	do
+	{
+		data++;
+		c = *data;
+		if (c == '{' || c == '}'|| c == '('|| c == ')' || c == '\'')
+			break;
+	} while (c > 32);
+
+	return data;
+}
+
+/*
+================
+ED_FindEntityStarts
+
+Returns the position of every top-level opening brace,
+stopping at the first thing that doesn't look like an entity
+================
+*/
+static const char **ED_FindEntityStarts (const char *data)
+{
+	const char	**starts = NULL;
+	const char	*start;
+	int			c;
+
+	while (1)
+	{
+		start = data;
+		data = ED_SkipToken (data, &c);
+		if (!data || c != '{')
+			break;
+		VEC_PUSH (starts, start);
+
+		while (1)
+		{
+			data = ED_SkipToken (data, &c);	// key
+			if (!data)
+				return starts;
+			if (c == '}')
+				break;
+			data = ED_SkipToken (data, &c);	// value
+			if (!data)
+				return starts;
+		}
+	}
+
+	return starts;
+}
+
+/*
+================
+ED_AddParsedString
+================
+*/
+static int ED_AddParsedString (edparsechunk_t *chunk, const char *str)
+{
+	int ofs = VEC_SIZE (chunk->strings);
+	Vec_Append ((void **) &chunk->strings, 1, str, strlen (str) + 1);
+	return ofs;
+}
+
+/*
+================
+ED_ParseChunkEdict
+
+Same as ED_ParseEdict, but stores the key/value pairs in the chunk
+instead of an edict. Returns NULL on error.
+================
+*/
+static const char *ED_ParseChunkEdict (edparsechunk_t *chunk, const char *data)
+{
+	edparsedent_t	parsed;
+	edparsedpair_t	pair;
+	ddef_t			*key;
+	char			keyname[256];
+	qboolean		anglehack;
+	int				n;
+
+	memset (&parsed, 0, sizeof (parsed));
+	parsed.firstpair = VEC_SIZE (chunk->pairs);
+
+	while (1)
+	{
+		data = COM_Parse (data);
+		if (com_token[0] == '}')
+			break;
+		if (!data)
+		{
+			q_strlcpy (chunk->error, "ED_ParseEntity: EOF without closing brace", sizeof (chunk->error));
+			return NULL;
+		}
+
+		if (!strcmp(com_token, "angle"))
+		{
+			strcpy (com_token, "angles");
+			anglehack = true;
+		}
+		else
+			anglehack = false;
+
+		if (!strcmp(com_token, "light"))
+			strcpy (com_token, "light_lev");
+
+		q_strlcpy (keyname, com_token, sizeof(keyname));
+
+		n = strlen(keyname);
+		while (n && keyname[n-1] == ' ')
+		{
+			keyname[n-1] = 0;
+			n--;
+		}
+
+		data = COM_ParseEx (data, !strcmp (keyname, "wad") ? CPE_ALLOWTRUNC : CPE_NOTRUNC);
+		if (!data)
+		{
+			q_strlcpy (chunk->error, "ED_ParseEntity: EOF without closing brace", sizeof (chunk->error));
+			return NULL;
+		}
+
+		if (com_token[0] == '}')
+		{
+			q_strlcpy (chunk->error, "ED_ParseEntity: closing brace without data", sizeof (chunk->error));
+			return NULL;
+		}
+
+		parsed.init = true;
+
+		if (keyname[0] == '_')
+			continue;
+
+		if (!strcmp(keyname, "alpha"))
+		{
+			parsed.hasalpha = true;
+			parsed.alpha = Q_atof(com_token);
+		}
+
+		memset (&pair, 0, sizeof (pair));
+		key = ED_FindField (keyname);
+		if (!key)
+		{
+			// the warning is printed when the entity is spawned
+			if (!strncmp(keyname, "sky", 3) || !strcmp(keyname, "fog") || !strcmp(keyname, "alpha"))
+				continue;
+			pair.field = -1;
+			pair.keyname = ED_AddParsedString (chunk, keyname);
+			VEC_PUSH (chunk->pairs, pair);
+			continue;
+		}
+
+		if (anglehack)
+		{
+			char	temp[32];
+			q_strlcpy (temp, com_token, sizeof(temp));
+			q_snprintf (com_token, sizeof(com_token), "0 %s 0", temp);
+		}
+
+		pair.field = key - chunk->vm->fielddefs;
+		pair.value = ED_AddParsedString (chunk, com_token);
+		switch (key->type & ~DEF_SAVEGLOBAL)
+		{
+		case ev_float:
+			pair.v[0] = atof (com_token);
+			break;
+		case ev_vector:
+			pair.partial = !ED_ParseVector (com_token, pair.v);
+			break;
+		default:
+			break;
+		}
+		VEC_PUSH (chunk->pairs, pair);
+	}
+
+	parsed.numpairs = VEC_SIZE (chunk->pairs) - parsed.firstpair;
+	VEC_PUSH (chunk->ents, parsed);
+
+	return data;
+}
+
+/*
+================
+ED_ParseChunk
+================
+*/
+static void ED_ParseChunk (void *param)
+{
+	edparsechunk_t	*chunk = (edparsechunk_t *) param;
+	const char		*data = chunk->start;
+	qcvm_t			*oldvm = qcvm;
+
+	// workers are reused, so restore their vm when done
+	qcvm = chunk->vm;
+
+	while (!chunk->end || data < chunk->end)
+	{
+		data = COM_Parse (data);
+		if (!data)
+			break;
+		if (com_token[0] != '{')
+		{
+			q_snprintf (chunk->error, sizeof (chunk->error), "ED_LoadFromFile: found %s when expecting {", com_token);
+			break;
+		}
+		data = ED_ParseChunkEdict (chunk, data);
+		if (!data)
+			break;
+	}
+
+	if (!chunk->error[0] && chunk->end && data != chunk->end)
+		chunk->mismatch = true;
+
+	qcvm = oldvm;
+}
+
+/*
+================
+ED_FreeParsedLump
+================
+*/
+static void ED_FreeParsedLump (edparsedlump_t *lump)
+{
+	int i;
+
+	for (i = 0; i < lump->numchunks; i++)
+	{
+		VEC_FREE (lump->chunks[i].ents);
+		VEC_FREE (lump->chunks[i].pairs);
+		VEC_FREE (lump->chunks[i].strings);
+	}
+	free (lump->text);
+	memset (lump, 0, sizeof (*lump));
+}
+
+/*
+================
+ED_ParseLump
+
+Splits the entity lump into chunks and parses them in parallel
+================
+*/
+static void ED_ParseLump (edparsedlump_t *lump, const char *data)
+{
+	taskcounter_t	counter;
+	const char		**starts = NULL;
+	int				i, numents, numchunks;
+
+	if (Tasks_NumWorkers () > 1)
+		starts = ED_FindEntityStarts (data);
+	numents = VEC_SIZE (starts);
+	numchunks = q_min (q_min (Tasks_NumWorkers (), MAX_ED_PARSE_CHUNKS), numents / MIN_ED_PARSE_CHUNK);
+	numchunks = q_max (numchunks, 1);
+
+	lump->numchunks = numchunks;
+	for (i = 0; i < numchunks; i++)
+	{
+		edparsechunk_t *chunk = &lump->chunks[i];
+		chunk->vm = qcvm;
+		chunk->start = i ? starts[(int)((int64_t)numents * i / numchunks)] : data;
+		chunk->end = NULL;
+		if (i > 0)
+			lump->chunks[i - 1].end = chunk->start;
+	}
+	VEC_FREE (starts);
+
+	memset (&counter, 0, sizeof (counter));
+	for (i = 1; i < numchunks; i++)
+		Task_Run (ED_ParseChunk, &lump->chunks[i], &counter);
+	ED_ParseChunk (&lump->chunks[0]);
+	Task_Wait (&counter);
+
+	for (i = 0; i < numchunks; i++)
+	{
+		if (lump->chunks[i].error[0])
+			break;
+		if (lump->chunks[i].mismatch)
+		{
+			// the quick scan disagreed with the parser, start over on a single thread
+			Con_DPrintf ("ED_ParseLump: chunk %d mismatch, reparsing\n", i);
+			ED_FreeParsedLump (lump);
+			lump->numchunks = 1;
+			lump->chunks[0].vm = qcvm;
+			lump->chunks[0].start = data;
+			ED_ParseChunk (&lump->chunks[0]);
+			break;
+		}
+	}
+}
+
+/*
+================
+ED_GetParsedLump
+
+Returns the parsed version of the entity lump,
+reusing the previous one if nothing has changed
+================
+*/
+static edparsedlump_t *ED_GetParsedLump (const char *data)
+{
+	edparsedlump_t	*lump = &ed_parsedlump;
+	size_t			length = strlen (data);
+	unsigned		hash = COM_HashBlock (data, length);
+
+	if (lump->numchunks &&
+		lump->hash == hash &&
+		lump->length == length &&
+		lump->progscrc == qcvm->crc &&
+		lump->numfielddefs == qcvm->progs->numfielddefs &&
+		memcmp (lump->text, data, length) == 0)
+	{
+		Con_DPrintf ("Reusing parsed entity lump\n");
+		return lump;
+	}
+
+	ED_FreeParsedLump (lump);
+	ED_ParseLump (lump, data);
+	lump->text = (char *) malloc (length + 1);
+	if (!lump->text)
+		Sys_Error ("ED_GetParsedLump: out of memory on %" SDL_PRIu64 " bytes", (uint64_t)(length + 1));
+	memcpy (lump->text, data, length + 1);
+	lump->hash = hash;
+	lump->length = length;
+	lump->progscrc = qcvm->crc;
+	lump->numfielddefs = qcvm->progs->numfielddefs;
+
+	return lump;
+}
+
+/*
+================
+ED_SetParsedEdict
+
+Fills in an edict from the pairs parsed by ED_ParseChunkEdict
+================
+*/
+static void ED_SetParsedEdict (edict_t *ent, const edparsechunk_t *chunk, const edparsedent_t *parsed)
+{
+	const edparsedpair_t	*pair;
+	ddef_t					*key;
+	float					*d;
+	int						i;
+
+	if (ent != qcvm->edicts)	// hack
+		memset (&ent->v, 0, qcvm->progs->entityfields * 4);
+
+	//johnfitz -- hack to support .alpha even when progs.dat doesn't know about it
+	if (parsed->hasalpha)
+		ent->alpha = ENTALPHA_ENCODE(parsed->alpha);
+
+	for (i = 0, pair = chunk->pairs + parsed->firstpair; i < parsed->numpairs; i++, pair++)
+	{
+		if (pair->field < 0)
+		{
+			Con_DPrintf ("\"%s\" is not a field\n", chunk->strings + pair->keyname); //johnfitz -- was Con_Printf
+			continue;
+		}
+
+		key = qcvm->fielddefs + pair->field;
+		d = (float *)&ent->v + key->ofs;
+		switch (key->type & ~DEF_SAVEGLOBAL)
+		{
+		case ev_float:
+			d[0] = pair->v[0];
+			break;
+
+		case ev_vector:
+			d[0] = pair->v[0];
+			d[1] = pair->v[1];
+			d[2] = pair->v[2];
+			if (pair->partial)
+				Con_DWarning ("Avoided reading garbage for \"%s\" \"%s\"\n", PR_GetString(key->s_name), chunk->strings + pair->value);
+			break;
+
+		default:
+			if (!ED_ParseEpair ((void *)&ent->v, key, chunk->strings + pair->value, qcvm != &sv.qcvm))
+				Host_Error ("ED_ParseEdict: parse error");
+			break;
+		}
+	}
+
+	if (!parsed->init)
+		ED_Free (ent);
+}
+
 /*
 ================
 ED_LoadFromFile
@@ -1458,24 +2045,37 @@ void ED_LoadFromFile (const char *data)
 	dfunction_t	*func;
 	edict_t		*ent = NULL;
 	int		inhibit = 0;
+	int		i, j;
+	edparsedlump_t	*lump;
+	edparsechunk_t	*chunk;
 
 	pr_global_struct->time = qcvm->time;
 
-	// parse ents
-	while (1)
+	if (!data)
+		data = "";
+
+	LoadProf_Begin ("ED_GetParsedLump");
+	lump = ED_GetParsedLump (data);
+	LoadProf_End ();
+
+	// spawn ents, chunk by chunk
+	for (i = 0, j = 0, chunk = lump->chunks; i < lump->numchunks; j++)
 	{
-		// parse the opening brace
-		data = COM_Parse (data);
-		if (!data)
-			break;
-		if (com_token[0] != '{')
-			Host_Error ("ED_LoadFromFile: found %s when expecting {",com_token);
+		if (j == VEC_SIZE (chunk->ents))
+		{
+			if (chunk->error[0])
+				Host_Error ("%s", chunk->error);
+			i++;
+			chunk++;
+			j = -1;
+			continue;
+		}
 
 		if (!ent)
 			ent = EDICT_NUM(0);
 		else
 			ent = ED_Alloc ();
-		data = ED_ParseEdict (data, ent);
+		ED_SetParsedEdict (ent, chunk, &chunk->ents[j]);
 
 		if (!ent->v.classname)
 		{
@@ -1647,8 +2247,7 @@ void PR_ClearProgs(qcvm_t *vm)
 	if (qcvm->knownstrings)
 		Z_Free ((void *)qcvm->knownstrings);
 	free(qcvm->edicts); // ericw -- sv.edicts switched to use malloc()
-	if (qcvm->fielddefs != (ddef_t *)((byte *)qcvm->progs + qcvm->progs->ofs_fielddefs))
-		free(qcvm->fielddefs);
+	// progs data, field defs and lookup tables are owned by the resident image
 	memset(qcvm, 0, sizeof(*qcvm));
 
 	qcvm = NULL;
@@ -1763,8 +2362,23 @@ void PR_EnableExtensions (void)
 		Con_DPrintf2("Found %i autocvars\n", numautocvars);
 }
 
+/*
+===============
+PR_NewResidentString
+
+Registers a copy of the string that lives as long as the resident image
+===============
+*/
+static string_t PR_NewResidentString (prprogsimage_t *img, const char *str)
+{
+	char *copy = (char *) PR_ImageAlloc (strlen (str) + 1, "enginestring");
+	strcpy (copy, str);
+	VEC_PUSH (img->enginestrings, copy);
+	return PR_SetEngineString (copy);
+}
+
 //makes sure extension fields are actually registered so they can be used for mappers without qc changes. eg so scale can be used.
-static void PR_MergeEngineFieldDefs (void)
+static void PR_MergeEngineFieldDefs (prprogsimage_t *img)
 {
 	struct {
 		const char *fname;
@@ -1814,12 +2428,11 @@ static void PR_MergeEngineFieldDefs (void)
 	if (maxdefs != qcvm->progs->numfielddefs)
 	{	//we now know how many entries we need to add...
 		ddef_t *olddefs = qcvm->fielddefs;
-		qcvm->fielddefs = malloc(maxdefs * sizeof(*qcvm->fielddefs));
-		if (!qcvm->fielddefs)
-			Sys_Error ("PR_MergeEngineFieldDefs: out of memory (%d defs)", maxdefs);
+		qcvm->fielddefs = (ddef_t *) PR_ImageAlloc (maxdefs * sizeof(*qcvm->fielddefs), "fielddefs");
 		memcpy(qcvm->fielddefs, olddefs, qcvm->progs->numfielddefs*sizeof(*qcvm->fielddefs));
 		if (olddefs != (ddef_t *)((byte *)qcvm->progs + qcvm->progs->ofs_fielddefs))
 			free(olddefs);
+		img->fielddefs = qcvm->fielddefs;
 
 		//allocate the extra defs
 		for (j = 0; j < countof(extrafields); j++)
@@ -1828,7 +2441,7 @@ static void PR_MergeEngineFieldDefs (void)
 			{	//looks like its new. make sure ED_FindField can find it.
 				qcvm->fielddefs[qcvm->progs->numfielddefs].ofs = extrafields[j].newidx;
 				qcvm->fielddefs[qcvm->progs->numfielddefs].type = extrafields[j].type;
-				qcvm->fielddefs[qcvm->progs->numfielddefs].s_name = ED_NewString(extrafields[j].fname);
+				qcvm->fielddefs[qcvm->progs->numfielddefs].s_name = PR_NewResidentString(img, extrafields[j].fname);
 				qcvm->progs->numfielddefs++;
 
 				if (extrafields[j].type == ev_vector)
@@ -1837,7 +2450,7 @@ static void PR_MergeEngineFieldDefs (void)
 					{
 						qcvm->fielddefs[qcvm->progs->numfielddefs].ofs = extrafields[j].newidx+a;
 						qcvm->fielddefs[qcvm->progs->numfielddefs].type = ev_float;
-						qcvm->fielddefs[qcvm->progs->numfielddefs].s_name = ED_NewString(va("%s_%c", extrafields[j].fname, 'x'+a));
+						qcvm->fielddefs[qcvm->progs->numfielddefs].s_name = PR_NewResidentString(img, va("%s_%c", extrafields[j].fname, 'x'+a));
 						qcvm->progs->numfielddefs++;
 					}
 				}
@@ -1989,8 +2602,8 @@ static void PR_FindEntityFields (void)
 	}
 
 	qcvm->numentityfields = count;
-	qcvm->entityfieldofs = (int *) Hunk_AllocName (qcvm->numentityfields * sizeof (int), "entityfieldofs");
-	qcvm->entityfields = (ddef_t **) Hunk_AllocName (qcvm->numentityfields * sizeof (ddef_t*), "entityfields");
+	qcvm->entityfieldofs = (int *) PR_ImageAlloc (qcvm->numentityfields * sizeof (int), "entityfieldofs");
+	qcvm->entityfields = (ddef_t **) PR_ImageAlloc (qcvm->numentityfields * sizeof (ddef_t*), "entityfields");
 
 	count = 0;
 	for (i = 1; i < qcvm->progs->numfielddefs; i++)
@@ -2027,7 +2640,7 @@ static void PR_FindFunctionRanges (void)
 	int		i, mark;
 	int		*order;
 
-	qcvm->functionsizes = (int *) Hunk_AllocName (qcvm->progs->numfunctions * sizeof (*order), "func_sizes");
+	qcvm->functionsizes = (int *) PR_ImageAlloc (qcvm->progs->numfunctions * sizeof (*order), "func_sizes");
 	mark = Hunk_LowMark ();
 
 	order = (int *) Hunk_AllocNoFill (qcvm->progs->numfunctions * sizeof (*order));
@@ -2079,7 +2692,7 @@ static void PR_FillOffsetTables (void)
 		*passes[pass].maxofs = maxofs;
 
 		// alloc table and fill it with -1
-		data = *passes[pass].offsets = (int *) Hunk_AllocNameNoFill ((maxofs + 1) * sizeof (int), passes[pass].allocname);
+		data = *passes[pass].offsets = (int *) PR_ImageAlloc ((maxofs + 1) * sizeof (int), passes[pass].allocname);
 		for (i = 0; i <= maxofs; i++)
 			data[i] = -1;
 
@@ -2092,21 +2705,116 @@ static void PR_FillOffsetTables (void)
 
 /*
 ===============
-PR_LoadProgs
+PR_FreeProgsImage
 ===============
 */
-qboolean PR_LoadProgs (const char *filename, qboolean fatal)
+static void PR_FreeProgsImage (prprogsimage_t *img)
 {
-	int			i;
+	size_t i;
 
-	PR_ClearProgs(qcvm);	//just in case.
+	for (i = 0; i < VEC_SIZE (img->enginestrings); i++)
+		free ((void *) img->enginestrings[i]);
+	VEC_FREE (img->enginestrings);
 
-	qcvm->progs = (dprograms_t *)COM_LoadHunkFile (filename, NULL);
-	if (!qcvm->progs)
-		return false;
-	Con_DPrintf ("Programs occupy %" SDL_PRIs64 "K.\n", com_filesize/1024);
+	free (img->progs);
+	free (img->fielddefs);
+	free (img->ht_fields.strings);
+	free (img->ht_fields.indices);
+	free (img->ht_functions.strings);
+	free (img->ht_functions.indices);
+	free (img->ht_globals.strings);
+	free (img->ht_globals.indices);
+	free (img->entityfieldofs);
+	free (img->entityfields);
+	free (img->functionsizes);
+	free (img->ofstofield);
+	free (img->ofstoglobal);
+
+	memset (img, 0, sizeof (*img));
+}
+
+/*
+===============
+PR_FindProgsImage
+
+Returns the resident image matching the given file, if any
+===============
+*/
+static prprogsimage_t *PR_FindProgsImage (const char *filename, qboolean csqc, unsigned int path_id, int filesize, unsigned short crc)
+{
+	int i;
+
+	for (i = 0; i < MAX_RESIDENT_PROGS; i++)
+	{
+		prprogsimage_t *img = &pr_images[i];
+		if (img->valid && img->csqc == csqc && img->path_id == path_id &&
+			img->filesize == filesize && img->crc == crc && !strcmp (img->filename, filename))
+			return img;
+	}
+
+	return NULL;
+}
+
+/*
+===============
+PR_IsProgsImageInUse
+
+Returns true if the server or client qcvm is still running the given image
+===============
+*/
+static qboolean PR_IsProgsImageInUse (const prprogsimage_t *img)
+{
+	return img->progs && (sv.qcvm.progs == img->progs || cl.qcvm.progs == img->progs);
+}
+
+/*
+===============
+PR_AllocProgsImage
+
+Returns an empty image slot, evicting the least recently used one if needed.
+Images that a qcvm still references are never evicted.
+===============
+*/
+static prprogsimage_t *PR_AllocProgsImage (void)
+{
+	prprogsimage_t *best = NULL;
+	int i;
+
+	for (i = 0; i < MAX_RESIDENT_PROGS; i++)
+	{
+		prprogsimage_t *img = &pr_images[i];
+		if (!img->valid)
+		{
+			best = img;
+			break;
+		}
+		if (PR_IsProgsImageInUse (img))
+			continue;
+		if (!best || img->lastused < best->lastused)
+			best = img;
+	}
+
+	if (!best)
+		Sys_Error ("PR_AllocProgsImage: all %d progs images are in use", MAX_RESIDENT_PROGS);
+
+	PR_FreeProgsImage (best);
+
+	return best;
+}
 
-	qcvm->crc = CRC_Block (qcvm->progs, com_filesize);
+/*
+===============
+PR_BuildProgsImage
+
+Byte-swaps and validates the progs data owned by img,
+then fills in all the derived tables
+===============
+*/
+static qboolean PR_BuildProgsImage (prprogsimage_t *img, const char *filename, qboolean fatal)
+{
+	int			i;
+
+	qcvm->progs = img->progs;
 
 	// byte swap the header
 	for (i = 0; i < (int) sizeof(*qcvm->progs) / 4; i++)
@@ -2164,7 +2872,7 @@ qboolean PR_LoadProgs (const char *filename, qboolean fatal)
 
 	qcvm->functions = (dfunction_t *)((byte *)qcvm->progs + qcvm->progs->ofs_functions);
 	qcvm->strings = (char *)qcvm->progs + qcvm->progs->ofs_strings;
-	if (qcvm->progs->ofs_strings + qcvm->progs->numstrings >= com_filesize)
+	if (qcvm->progs->ofs_strings + qcvm->progs->numstrings >= img->filesize)
 		Host_Error ("progs.dat strings go past end of file\n");
 
 	// initialize the strings
@@ -2223,7 +2931,7 @@ qboolean PR_LoadProgs (const char *filename, qboolean fatal)
 		((int *)qcvm->globals)[i] = LittleLong (((int *)qcvm->globals)[i]);
 
 	//spike: detect extended fields from progs
-	PR_MergeEngineFieldDefs ();
+	PR_MergeEngineFieldDefs (img);
 #define QCEXTFIELD(n,t) qcvm->extfields.n = ED_FindFieldOffset (#n);
 	QCEXTFIELDS_ALL
 	QCEXTFIELDS_GAME
@@ -2240,7 +2948,6 @@ qboolean PR_LoadProgs (const char *filename, qboolean fatal)
 	PR_InitHashTables ();
 	PR_InitBuiltins ();
 	PR_PatchRereleaseBuiltins ();
-	PR_EnableExtensions ();
 	PR_FindSavegameFields ();
 	PR_FindEntityFields ();
 	PR_FindFunctionRanges ();
@@ -2248,6 +2955,150 @@ qboolean PR_LoadProgs (const char *filename, qboolean fatal)
 
 	qcvm->effects_mask = PR_FindSupportedEffects ();
 
+	// transfer ownership of the derived data to the image
+	img->edict_size		= qcvm->edict_size;
+	img->effects_mask	= qcvm->effects_mask;
+	img->extfields		= qcvm->extfields;
+	img->numbuiltins	= qcvm->numbuiltins;
+	memcpy (img->builtins, qcvm->builtins, sizeof (img->builtins));
+	memcpy (img->builtin_ext, qcvm->builtin_ext, sizeof (img->builtin_ext));
+	img->ht_fields		= qcvm->ht_fields;
+	img->ht_functions	= qcvm->ht_functions;
+	img->ht_globals		= qcvm->ht_globals;
+	img->numentityfields = qcvm->numentityfields;
+	img->entityfieldofs	= qcvm->entityfieldofs;
+	img->entityfields	= qcvm->entityfields;
+	img->functionsizes	= qcvm->functionsizes;
+	img->maxfieldofs	= qcvm->maxfieldofs;
+	img->ofstofield		= qcvm->ofstofield;
+	img->maxglobalofs	= qcvm->maxglobalofs;
+	img->ofstoglobal	= qcvm->ofstoglobal;
+
+	return true;
+}
+
+/*
+===============
+PR_ApplyProgsImage
+
+Points the current qcvm at the resident image and resets the mutable state
+(functions, globals and strings) to the values in the progs file
+===============
+*/
+static void PR_ApplyProgsImage (const prprogsimage_t *img)
+{
+	dprograms_t	*progs = img->progs;
+	size_t		i;
+
+	qcvm->progs			= progs;
+	qcvm->crc			= img->crc;
+	qcvm->statements	= (dstatement_t *)((byte *)progs + progs->ofs_statements);
+	qcvm->globaldefs	= (ddef_t *)((byte *)progs + progs->ofs_globaldefs);
+	qcvm->fielddefs		= img->fielddefs ? img->fielddefs : (ddef_t *)((byte *)progs + progs->ofs_fielddefs);
+	qcvm->strings		= (char *)progs + progs->ofs_strings;
+	qcvm->stringssize	= progs->numstrings;
+
+	// functions hold profiling counters, globals are modified by the qc code
+	qcvm->functions = (dfunction_t *) Hunk_AllocNameNoFill (progs->numfunctions * sizeof (dfunction_t), "functions");
+	memcpy (qcvm->functions, (byte *)progs + progs->ofs_functions, progs->numfunctions * sizeof (dfunction_t));
+	qcvm->globals = (float *) Hunk_AllocNameNoFill (progs->numglobals * sizeof (float), "globals");
+	memcpy (qcvm->globals, (byte *)progs + progs->ofs_globals, progs->numglobals * sizeof (float));
+	pr_global_struct = (globalvars_t*)qcvm->globals;
+
+	// re-register the engine strings in the same order so that the string_t's stored in the image stay valid
+	qcvm->numknownstrings = 0;
+	qcvm->maxknownstrings = 0;
+	if (qcvm->knownstrings)
+		Z_Free ((void *)qcvm->knownstrings);
+	qcvm->knownstrings = NULL;
+	qcvm->firstfreeknownstring = NULL;
+	PR_SetEngineString("");
+	for (i = 0; i < VEC_SIZE (img->enginestrings); i++)
+		if (PR_SetEngineString (img->enginestrings[i]) != -2 - (int)i)
+			Sys_Error ("PR_ApplyProgsImage: engine string mismatch for %s", img->enginestrings[i]);
+
+	qcvm->edict_size	= img->edict_size;
+	qcvm->effects_mask	= img->effects_mask;
+	qcvm->extfields		= img->extfields;
+	qcvm->numbuiltins	= img->numbuiltins;
+	memcpy (qcvm->builtins, img->builtins, sizeof (qcvm->builtins));
+	memcpy (qcvm->builtin_ext, img->builtin_ext, sizeof (qcvm->builtin_ext));
+	qcvm->ht_fields		= img->ht_fields;
+	qcvm->ht_functions	= img->ht_functions;
+	qcvm->ht_globals	= img->ht_globals;
+	qcvm->numentityfields = img->numentityfields;
+	qcvm->entityfieldofs = img->entityfieldofs;
+	qcvm->entityfields	= img->entityfields;
+	qcvm->functionsizes	= img->functionsizes;
+	qcvm->maxfieldofs	= img->maxfieldofs;
+	qcvm->ofstofield	= img->ofstofield;
+	qcvm->maxglobalofs	= img->maxglobalofs;
+	qcvm->ofstoglobal	= img->ofstoglobal;
+}
+
+/*
+===============
+PR_LoadProgs
+===============
+*/
+qboolean PR_LoadProgs (const char *filename, qboolean fatal)
+{
+	prprogsimage_t	*img;
+	byte			*data;
+	unsigned int	path_id;
+	int				filesize;
+	unsigned short	crc;
+	qboolean		csqc = (qcvm == &cl.qcvm);
+	qboolean		reused;
+	double			time0, time1, time2, time3;
+
+	PR_ClearProgs(qcvm);	//just in case.
+
+	time0 = Sys_DoubleTime ();
+	data = COM_LoadMallocFile (filename, &path_id);
+	if (!data)
+		return false;
+	filesize = com_filesize;
+	crc = CRC_Block (data, filesize);
+	Con_DPrintf ("Programs occupy %dK.\n", filesize/1024);
+	time1 = Sys_DoubleTime ();
+
+	img = PR_FindProgsImage (filename, csqc, path_id, filesize, crc);
+	reused = img != NULL;
+	if (reused)
+		free (data);
+	else
+	{
+		img = PR_AllocProgsImage ();
+		img->progs = (dprograms_t *) data;
+		img->csqc = csqc;
+		q_strlcpy (img->filename, filename, sizeof (img->filename));
+		img->path_id = path_id;
+		img->filesize = filesize;
+		img->crc = crc;
+		if (!PR_BuildProgsImage (img, filename, fatal))
+		{
+			PR_FreeProgsImage (img);
+			return false;
+		}
+		img->valid = true;
+	}
+	img->lastused = ++pr_imagesequence;
+	time2 = Sys_DoubleTime ();
+
+	PR_ApplyProgsImage (img);
+	PR_EnableExtensions ();
+	time3 = Sys_DoubleTime ();
+
+	if (!reused)
+		img->buildtime = time2 - time1;
+
+	Con_DPrintf ("%s: %.1f ms (read+crc %.1f ms, %s %.1f ms, reset %.1f ms)\n",
+		filename, (time3 - time0) * 1000.0, (time1 - time0) * 1000.0,
+		reused ? "reused image, built in" : "build", img->buildtime * 1000.0,
+		(time3 - time2) * 1000.0
+	);
+
 	return true;
 }
 
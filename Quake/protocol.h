@@ -224,6 +224,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define svc_backtolobby		55
 #define svc_localsound		56
 
+// ironwail extensions, only sent to clients that ask for them
+#define svc_signonblob		57	// [long] size [long] compressed size [long] offset [short] length [bytes] deflated signon buffers
+
 //
 // client to server
 //
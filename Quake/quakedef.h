@@ -252,6 +252,7 @@ typedef struct
 
 #include "cmd.h"
 #include "crc.h"
+#include "loadprof.h"
 
 #include "platform.h"
 #if defined(SDL_FRAMEWORK) || defined(NO_SDL_CONFIG)
@@ -265,6 +266,9 @@ typedef struct
 #define	APIENTRY
 #endif
 
+#include "tasks.h"
+#include "modinstall.h"
+
 #include "progs.h"
 #include "server.h"
 
@@ -315,6 +319,7 @@ extern	double		host_frametime;
 extern	double		host_rawframetime;
 extern	byte		*host_colormap;
 extern	int		host_framecount;	// incremented every frame, never reset
+extern	int		host_hunklevel;		// hunk mark after initialization, levels are loaded above it
 extern	double		realtime;		// not bounded in any way, changed at
 							// start of every frame, never reset
 
@@ -444,7 +449,6 @@ extern qboolean		isDedicated;
 
 extern int		minimum_memory;
 
-void Host_InvokeOnMainThread (void (*func) (void *param), void *param);
 
 #endif /* RC_INVOKED */
 
@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern cvar_t gl_overbright_models, gl_fullbrights, r_lerpmodels, r_lerpmove; //johnfitz
 extern cvar_t scr_fov, cl_gun_fovscale, cl_gun_x, cl_gun_y, cl_gun_z;
 extern cvar_t r_oit;
+extern cvar_t r_lodbias;
 
 //up to 16 color translated skins
 gltexture_t *playertextures[MAX_SCOREBOARD]; //johnfitz -- changed to an array of pointers
@@ -49,7 +50,8 @@ typedef struct {
 } lerpdata_t;
 //johnfitz
 
-#define MAX_ALIAS_INSTANCES 256
+#define MAX_ALIAS_INSTANCES	4096
+#define MAX_ALIAS_DRAWS		4096
 
 typedef struct aliasinstance_s {
 	float		worldmatrix[12];
@@ -63,7 +65,9 @@ typedef struct aliasinstance_s {
 
 struct ibuf_s {
 	int			count;
-	entity_t	*ent;
+	int			first;		// first instance of the current batch
+	entity_t	*ent;		// entity that started the current batch
+	int			lod;		// detail level of the current batch
 
 	struct {
 		float	matviewproj[16];
@@ -76,6 +80,51 @@ struct ibuf_s {
 	aliasinstance_t inst[MAX_ALIAS_INSTANCES];
 } ibuf;
 
+//
+// Draws are collected per shader/state bucket and submitted together,
+// one glMultiDrawElementsIndirect per bucket if bindless textures are available
+// (same as the world: one indirect draw per call otherwise)
+//
+
+typedef enum {
+	ALIASBLEND_OPAQUE,		// opaque entity, opaque skin
+	ALIASBLEND_ALPHAPIXELS,	// opaque entity, skin with transparent pixels
+	ALIASBLEND_TRANSLUCENT,	// translucent entity
+
+	ALIASBLEND_COUNT
+} aliasblend_t;
+
+#define ALIAS_DRAW_KEY(blend, alphatest, poseverttype)	(((blend) * 2 + (alphatest)) * 3 + (poseverttype))
+#define NUM_ALIAS_DRAW_KEYS								(ALIASBLEND_COUNT * 2 * 3)
+
+typedef struct aliasdrawcmd_s {
+	GLuint		count;
+	GLuint		instanceCount;
+	GLuint		firstIndex;
+	GLint		baseVertex;
+	GLuint		baseInstance;
+} aliasdrawcmd_t;
+
+typedef struct aliasbindlesscall_s {
+	GLuint64	texture;
+	GLuint64	fullbright;
+} aliasbindlesscall_t;
+
+typedef struct aliasboundcall_s {
+	GLint		baseinstance;
+	GLint		padding;
+} aliasboundcall_t;
+
+typedef struct aliasdraw_s {
+	int				key;
+	int				pool;		// index in gl_alias_pools
+	aliasdrawcmd_t	cmd;
+	gltexture_t		*textures[2];
+} aliasdraw_t;
+
+static aliasdraw_t		aliasdraws[MAX_ALIAS_DRAWS];
+static int				numaliasdraws;
+
 /*
 =================
 R_SetupAliasFrame -- johnfitz -- rewritten to support lerping
@@ -286,42 +335,74 @@ void R_SetupAliasLighting (entity_t	*e)
 	VectorScale (lightcolor, 1.0f / 200.0f, lightcolor);
 }
 
+#define LOD_FULL_DETAIL_SIZE	160.f	// projected radius (in pixels) below which the first reduced level is used
+
 /*
 =================
-R_FlushAliasInstances
+R_SelectAliasLOD
+
+Each reduced level has about half the triangles of the previous one,
+so it's used once the model's projected radius halves as well
 =================
 */
-void R_FlushAliasInstances (qboolean showtris)
+static int R_SelectAliasLOD (entity_t *e, aliashdr_t *hdr, const vec3_t origin)
 {
-	extern cvar_t r_softemu_mdl_warp;
-	qmodel_t* model;
-	aliashdr_t* mainhdr, *hdr;
-	qboolean	alphatest, translucent, oit;
-	int			totalverts;
-	int			poseverttype;
-	int			skinnum, anim, mode;
-	unsigned	state, opaque_state, transparent_state;
-	GLuint		buf;
-	GLbyte* ofs;
-	size_t		ibuf_size;
-	GLuint		buffers[2];
-	GLintptr	offsets[2];
-	GLsizeiptr	sizes[2];
-	gltexture_t* textures[2];
+	vec3_t	delta;
+	float	radius, dist, size;
+	int		lod;
 
-	if (!ibuf.count)
-		return;
+	if (!hdr->numlods || e == &cl.viewent)
+		return 0;
 
-	model = ibuf.ent->model;
-	mainhdr = (aliashdr_t*)Mod_Extradata (model);
-	anim = (int)(cl.time * 10) & 3;
+	VectorSubtract (e->model->maxs, e->model->mins, delta);
+	radius = 0.5f * VectorLength (delta) * ENTSCALE_DECODE (e->scale);
 
-	GL_BeginGroup (model->name);
-	poseverttype = mainhdr->poseverttype;
+	VectorSubtract (origin, r_refdef.vieworg, delta);
+	dist = VectorLength (delta);
+	if (dist <= radius)
+		return 0;
+
+	size = radius / dist * (0.5f * r_refdef.vrect.height) / tanf (DEG2RAD (r_refdef.fov_y) * 0.5f);
+	if (size <= 0.f)
+		return hdr->numlods;
+
+	lod = (int) ceilf (log2f (LOD_FULL_DETAIL_SIZE / size) + r_lodbias.value);
+	return CLAMP (0, lod, hdr->numlods);
+}
+
+/*
+=================
+R_SubmitAliasDraws
+
+Draws all the collected alias model batches
+=================
+*/
+static void R_SubmitAliasDraws (void)
+{
+	extern cvar_t	r_softemu_mdl_warp;
+	static aliasdrawcmd_t cmds[MAX_ALIAS_DRAWS];
+	static union {
+		aliasbindlesscall_t	bindless[MAX_ALIAS_DRAWS];
+		aliasboundcall_t	bound[MAX_ALIAS_DRAWS];
+	} calls;
+	static short	order[MAX_ALIAS_DRAWS];
+	int				keyofs[NUM_ALIAS_DRAW_KEYS + 1];
+	int				i, j, key, mode, pending, pool;
+	unsigned		state;
+	GLuint			buf;
+	GLbyte			*ofs;
+	size_t			ibuf_size;
+
+	pending = ibuf.count - ibuf.first;
+
+	if (!numaliasdraws)
+		goto done;
+	if (!gl_alias_numpools)
+	{
+		numaliasdraws = 0;
+		goto done;
+	}
 
-	alphatest = model->flags & MF_HOLEY ? 1 : 0;
-	translucent = !ENTALPHA_OPAQUE (ibuf.ent->alpha);
-	oit = translucent && R_GetEffectiveAlphaMode () == ALPHAMODE_OIT;
 	switch (softemu)
 	{
 	case SOFTEMU_BANDED:
@@ -334,20 +415,6 @@ void R_FlushAliasInstances (qboolean showtris)
 		mode = r_softemu_mdl_warp.value > 0.f ? ALIASSHADER_NOPERSP : ALIASSHADER_STANDARD;
 		break;
 	}
-	GL_UseProgram (glprogs.alias[oit][mode][alphatest][poseverttype]);
-
-	if (poseverttype == PV_IQM)
-		state = GLS_CULL_BACK | GLS_ATTRIBS (5);
-	else
-		state = GLS_CULL_BACK | GLS_ATTRIBS (1);
-
-	opaque_state = (state | GLS_BLEND_OPAQUE) & ~(GLS_BLEND_ALPHA_OIT | GLS_NO_ZWRITE);
-	transparent_state = (state | GLS_BLEND_ALPHA) & ~(GLS_BLEND_OPAQUE | GLS_CULL_BACK);
-
-	if (translucent)
-	{
-		GL_SetState ((state | GLS_BLEND_ALPHA_OIT | GLS_NO_ZWRITE) & ~GLS_CULL_BACK);
-	}
 
 	memcpy (ibuf.global.matviewproj, r_matviewproj, sizeof (r_matviewproj));
 	memcpy (ibuf.global.eyepos, r_refdef.vieworg, sizeof (r_refdef.vieworg));
@@ -359,61 +426,210 @@ void R_FlushAliasInstances (qboolean showtris)
 		;
 	ibuf.global.dither = r_framedata.screendither;
 
-	ibuf_size = sizeof (ibuf.global) + sizeof (ibuf.inst[0]) * ibuf.count;
+	ibuf_size = sizeof (ibuf.global) + sizeof (ibuf.inst[0]) * ibuf.first;
 	GL_Upload (GL_SHADER_STORAGE_BUFFER, &ibuf.global, ibuf_size, &buf, &ofs);
+	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 1, buf, (GLintptr)ofs, ibuf_size);
 
-	for (hdr = mainhdr, totalverts = 0; hdr; hdr = Mod_NextSurface (hdr))
-		totalverts += hdr->numverts_vbo;
+	// one pass per pool, each pool's vertex buffer fits in a shader storage block
+	for (pool = 0; pool < gl_alias_numpools; pool++)
+	{
+		const aliaspool_t *p = &gl_alias_pools[pool];
+
+		// sort the pool's draws by bucket
+		memset (keyofs, 0, sizeof (keyofs));
+		for (i = 0; i < numaliasdraws; i++)
+			if (aliasdraws[i].pool == pool)
+				keyofs[aliasdraws[i].key + 1]++;
+		for (key = 0; key < NUM_ALIAS_DRAW_KEYS; key++)
+			keyofs[key + 1] += keyofs[key];
+		if (!keyofs[NUM_ALIAS_DRAW_KEYS])
+			continue;
+		for (i = 0; i < numaliasdraws; i++)
+			if (aliasdraws[i].pool == pool)
+				order[keyofs[aliasdraws[i].key]++] = i;
+		for (key = NUM_ALIAS_DRAW_KEYS; key > 0; key--)
+			keyofs[key] = keyofs[key - 1];
+		keyofs[0] = 0;
+
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 2, p->vbo, 0, p->vbosize);
+		GL_BindBuffer (GL_ARRAY_BUFFER, p->vbo);
+		GL_BindBuffer (GL_ELEMENT_ARRAY_BUFFER, p->ibo);
+
+		for (key = 0; key < NUM_ALIAS_DRAW_KEYS; key++)
+		{
+			int		first = keyofs[key];
+			int		count = keyofs[key + 1] - first;
+			int		poseverttype = key % 3;
+			int		alphatest = (key / 3) & 1;
+			int		blend = key / 6;
+			qboolean oit = blend == ALIASBLEND_TRANSLUCENT && R_GetEffectiveAlphaMode () == ALPHAMODE_OIT;
+			GLuint	cmdbuf;
+			GLbyte	*cmdofs;
+
+			if (!count)
+				continue;
+
+			GL_UseProgram (glprogs.alias[oit][mode][alphatest][poseverttype]);
+
+			if (poseverttype == PV_IQM)
+				state = GLS_CULL_BACK | GLS_ATTRIBS (5);
+			else
+				state = GLS_CULL_BACK | GLS_ATTRIBS (1);
+
+			if (blend == ALIASBLEND_OPAQUE)
+				GL_SetState ((state | GLS_BLEND_OPAQUE) & ~(GLS_BLEND_ALPHA_OIT | GLS_NO_ZWRITE));
+			else if (blend == ALIASBLEND_ALPHAPIXELS)
+				GL_SetState ((state | GLS_BLEND_ALPHA) & ~(GLS_BLEND_OPAQUE | GLS_CULL_BACK));
+			else
+				GL_SetState ((state | GLS_BLEND_ALPHA_OIT | GLS_NO_ZWRITE) & ~GLS_CULL_BACK);
+
+			if (poseverttype == PV_IQM)
+			{
+				GL_VertexAttribPointerFunc (0, 3, GL_FLOAT, GL_FALSE, sizeof (iqmvert_t), (void*)offsetof (iqmvert_t, xyz));
+				GL_VertexAttribPointerFunc (1, 4, GL_BYTE, GL_TRUE, sizeof (iqmvert_t), (void*)offsetof (iqmvert_t, norm));
+				GL_VertexAttribPointerFunc (2, 2, GL_FLOAT, GL_FALSE, sizeof (iqmvert_t), (void*)offsetof (iqmvert_t, st));
+				GL_VertexAttribPointerFunc (3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof (iqmvert_t), (void*)offsetof (iqmvert_t, weight));
+				GL_VertexAttribIPointerFunc (4, 4, GL_UNSIGNED_BYTE, sizeof (iqmvert_t), (void*)offsetof (iqmvert_t, idx));
+			}
+			else // PV_QUAKE1 || PV_MD3
+			{
+				GL_VertexAttribPointerFunc (0, 2, GL_FLOAT, GL_FALSE, sizeof (meshst_t), (void*)0);
+			}
+
+			for (i = 0; i < count; i++)
+			{
+				const aliasdraw_t *draw = &aliasdraws[order[first + i]];
+				cmds[i] = draw->cmd;
+				if (gl_bindless_able)
+				{
+					calls.bindless[i].texture = draw->textures[0]->bindless_handle;
+					calls.bindless[i].fullbright = draw->textures[1]->bindless_handle;
+					draw->textures[0]->visframe = draw->textures[1]->visframe = r_framecount;
+				}
+				else
+				{
+					calls.bound[i].baseinstance = draw->cmd.baseInstance;
+					calls.bound[i].padding = 0;
+				}
+			}
+
+			GL_Upload (GL_DRAW_INDIRECT_BUFFER, cmds, sizeof (cmds[0]) * count, &cmdbuf, &cmdofs);
+			GL_BindBuffer (GL_DRAW_INDIRECT_BUFFER, cmdbuf);
+
+			if (gl_bindless_able)
+			{
+				GL_Upload (GL_SHADER_STORAGE_BUFFER, calls.bindless, sizeof (calls.bindless[0]) * count, &buf, &ofs);
+				GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 3, buf, (GLintptr)ofs, sizeof (calls.bindless[0]) * count);
+				GL_MultiDrawElementsIndirectFunc (GL_TRIANGLES, GL_UNSIGNED_SHORT, cmdofs, count, sizeof (cmds[0]));
+			}
+			else
+			{
+				GL_Upload (GL_SHADER_STORAGE_BUFFER, calls.bound, sizeof (calls.bound[0]) * count, &buf, &ofs);
+				GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 3, buf, (GLintptr)ofs, sizeof (calls.bound[0]) * count);
+				for (j = 0; j < count; j++)
+				{
+					GL_Uniform1iFunc (0, j);
+					GL_BindTextures (0, 2, aliasdraws[order[first + j]].textures);
+					GL_DrawElementsIndirectFunc (GL_TRIANGLES, GL_UNSIGNED_SHORT, cmdofs + j * sizeof (cmds[0]));
+				}
+			}
+		}
+	}
+
+	numaliasdraws = 0;
+
+done:
+	// keep the instances of a batch that hasn't been added yet
+	if (pending && ibuf.first)
+		memmove (ibuf.inst, ibuf.inst + ibuf.first, pending * sizeof (ibuf.inst[0]));
+	ibuf.first = 0;
+	ibuf.count = pending;
+}
+
+/*
+=================
+R_FlushAliasInstances
+
+Turns the current batch into draw calls. Opaque batches are only drawn
+by R_SubmitAliasDraws; translucent ones (and showtris) right away, to keep
+the sort order.
+=================
+*/
+void R_FlushAliasInstances (qboolean showtris)
+{
+	qmodel_t* model;
+	aliashdr_t* mainhdr, *hdr;
+	qboolean	alphatest, translucent;
+	int			poseverttype, numsurfs;
+	int			skinnum, anim, blend, i, count;
+	GLint		basevertex, posebase;
+	gltexture_t* textures[2];
+
+	count = ibuf.count - ibuf.first;
+	if (!count)
+		return;
+
+	model = ibuf.ent->model;
+	mainhdr = (aliashdr_t*)Mod_Extradata (model);
+	anim = (int)(cl.time * 10) & 3;
+
+	// not in the vertex pool (too big, or not uploaded yet)
+	if (mainhdr->vbopool < 0 || mainhdr->vbopool >= gl_alias_numpools)
+	{
+		ibuf.count = ibuf.first;
+		return;
+	}
+
+	poseverttype = mainhdr->poseverttype;
+	alphatest = model->flags & MF_HOLEY ? 1 : 0;
+	translucent = !ENTALPHA_OPAQUE (ibuf.ent->alpha);
 
-	buffers[0] = buf;
-	offsets[0] = (GLintptr)ofs;
-	sizes[0] = ibuf_size;
 	switch (poseverttype)
 	{
 	case PV_IQM:
-		buffers[1] = model->meshvbo; offsets[1] = mainhdr->vboposeofs; sizes[1] = sizeof (bonepose_t) * mainhdr->numbones * mainhdr->numposes;
+		basevertex = mainhdr->vbovertofs / sizeof (iqmvert_t);
+		posebase = mainhdr->vboposeofs / sizeof (bonepose_t);
 		break;
 	case PV_MD3:
-		buffers[1] = model->meshvbo; offsets[1] = mainhdr->vbovertofs; sizes[1] = sizeof (md3pose_t) * totalverts * mainhdr->numposes;
+		basevertex = mainhdr->vbostofs / sizeof (meshst_t);
+		posebase = mainhdr->vbovertofs / sizeof (md3pose_t) - basevertex; // gl_VertexID includes the base vertex
 		break;
 	case PV_QUAKE1:
-		buffers[1] = model->meshvbo; offsets[1] = mainhdr->vbovertofs; sizes[1] = sizeof (meshxyz_t) * totalverts * mainhdr->numposes;
+		basevertex = mainhdr->vbostofs / sizeof (meshst_t);
+		posebase = mainhdr->vbovertofs / sizeof (meshxyz_t) - basevertex;
 		break;
 	default:
+		ibuf.count = ibuf.first;
 		return;
 	}
 
-	GL_BindBuffer (GL_ARRAY_BUFFER, model->meshvbo);
-	GL_BindBuffer (GL_ELEMENT_ARRAY_BUFFER, model->meshindexesvbo);
-	GL_BindBuffersRange (GL_SHADER_STORAGE_BUFFER, 1, 2, buffers, offsets, sizes);
+	for (hdr = mainhdr, numsurfs = 0; hdr; hdr = Mod_NextSurface (hdr))
+		numsurfs++;
+	if (numaliasdraws + numsurfs > MAX_ALIAS_DRAWS)
+		R_SubmitAliasDraws ();
 
-	if (poseverttype == PV_IQM)
-	{
-		GL_VertexAttribPointerFunc (0, 3, GL_FLOAT, GL_FALSE, sizeof (iqmvert_t), (void*)(mainhdr->vbovertofs + offsetof (iqmvert_t, xyz)));
-		GL_VertexAttribPointerFunc (1, 4, GL_BYTE, GL_TRUE, sizeof (iqmvert_t), (void*)(mainhdr->vbovertofs + offsetof (iqmvert_t, norm)));
-		GL_VertexAttribPointerFunc (2, 2, GL_FLOAT, GL_FALSE, sizeof (iqmvert_t), (void*)(mainhdr->vbovertofs + offsetof (iqmvert_t, st)));
-		GL_VertexAttribPointerFunc (3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof (iqmvert_t), (void*)(mainhdr->vbovertofs + offsetof (iqmvert_t, weight)));
-		GL_VertexAttribIPointerFunc (4, 4, GL_UNSIGNED_BYTE, sizeof (iqmvert_t), (void*)(mainhdr->vbovertofs + offsetof (iqmvert_t, idx)));
-	}
-	else // PV_QUAKE1 || PV_MD3
+	for (i = ibuf.first; i < ibuf.count; i++)
 	{
-		GL_VertexAttribPointerFunc (0, 2, GL_FLOAT, GL_FALSE, sizeof (meshst_t), (void*)mainhdr->vbostofs);
+		ibuf.inst[i].pose1 += posebase;
+		ibuf.inst[i].pose2 += posebase;
 	}
 
-	if (!translucent)
-		GL_SetState (opaque_state);
-
 	for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
 	{
+		aliasdraw_t *draw;
+
 		skinnum = ibuf.ent->skinnum;
 		if ((skinnum >= hdr->numskins) || (skinnum < 0)) skinnum = 0;
 		textures[0] = hdr->gltextures[skinnum][anim];
 		if (!textures[0]) continue;
 
-		if (!translucent && (textures[0]->flags & TEXPREF_ALPHAPIXELS))
-		{
-			continue;
-		}
+		if (translucent)
+			blend = ALIASBLEND_TRANSLUCENT;
+		else if (textures[0]->flags & TEXPREF_ALPHAPIXELS)
+			blend = ALIASBLEND_ALPHAPIXELS;
+		else
+			blend = ALIASBLEND_OPAQUE;
+
 		textures[1] = hdr->fbtextures[skinnum][anim];
 		if (hdr == mainhdr && ibuf.ent->colormap != vid.colormap && !gl_nocolors.value)
 			if (CL_IsPlayerEnt (ibuf.ent)) textures[0] = playertextures[ibuf.ent - cl_entities - 1];
@@ -422,44 +638,32 @@ void R_FlushAliasInstances (qboolean showtris)
 		if (!textures[1]) textures[1] = blacktexture;
 		if (showtris) { textures[0] = blacktexture; textures[1] = whitetexture; }
 
-		GL_BindTextures (0, 2, textures);
-		GL_DrawElementsInstancedFunc (GL_TRIANGLES, hdr->numindexes, GL_UNSIGNED_SHORT, (void*)hdr->eboofs, ibuf.count);
-		rs_aliaspasses += hdr->numtris * ibuf.count;
-	}
-
-	if (!translucent)
-	{
-		GL_SetState (transparent_state);
-
-		for (hdr = mainhdr; hdr; hdr = Mod_NextSurface (hdr))
+		draw = &aliasdraws[numaliasdraws++];
+		draw->key = ALIAS_DRAW_KEY (blend, alphatest, poseverttype);
+		draw->pool = mainhdr->vbopool;
+		if (ibuf.lod > 0)
 		{
-			skinnum = ibuf.ent->skinnum;
-			if ((skinnum >= hdr->numskins) || (skinnum < 0)) skinnum = 0;
-			textures[0] = hdr->gltextures[skinnum][anim];
-			if (!textures[0]) continue;
-
-			if (!(textures[0]->flags & TEXPREF_ALPHAPIXELS))
-			{ 
-				continue;
-			}
-
-			textures[1] = hdr->fbtextures[skinnum][anim];
-			if (hdr == mainhdr && ibuf.ent->colormap != vid.colormap && !gl_nocolors.value)
-				if (CL_IsPlayerEnt (ibuf.ent)) textures[0] = playertextures[ibuf.ent - cl_entities - 1];
-			if (!gl_fullbrights.value) textures[1] = blacktexture;
-			if (r_lightmap_cheatsafe) { textures[0] = greytexture; textures[1] = blacktexture; }
-			if (!textures[1]) textures[1] = blacktexture;
-			if (showtris) { textures[0] = blacktexture; textures[1] = whitetexture; }
-
-			GL_BindTextures (0, 2, textures);
-			GL_DrawElementsInstancedFunc (GL_TRIANGLES, hdr->numindexes, GL_UNSIGNED_SHORT, (void*)hdr->eboofs, ibuf.count);
-			rs_aliaspasses += hdr->numtris * ibuf.count;
+			draw->cmd.count = hdr->lodnumindexes[ibuf.lod - 1];
+			draw->cmd.firstIndex = hdr->lodeboofs[ibuf.lod - 1] / sizeof (unsigned short);
 		}
+		else
+		{
+			draw->cmd.count = hdr->numindexes;
+			draw->cmd.firstIndex = hdr->eboofs / sizeof (unsigned short);
+		}
+		draw->cmd.instanceCount = count;
+		draw->cmd.baseVertex = basevertex;
+		draw->cmd.baseInstance = ibuf.first;
+		draw->textures[0] = textures[0];
+		draw->textures[1] = textures[1];
 
+		rs_aliaspasses += draw->cmd.count / 3 * count;
 	}
 
-	ibuf.count = 0;
-	GL_EndGroup ();
+	ibuf.first = ibuf.count;
+
+	if (translucent || showtris)
+		R_SubmitAliasDraws ();
 }
 
 /*
@@ -467,18 +671,18 @@ void R_FlushAliasInstances (qboolean showtris)
 R_Alias_CanAddToBatch
 =================
 */
-static qboolean R_Alias_CanAddToBatch (const entity_t *e)
+static qboolean R_Alias_CanAddToBatch (const entity_t *e, int lod)
 {
 	// empty batch
-	if (!ibuf.count)
+	if (ibuf.count == ibuf.first)
 		return true;
 
 	// full batch
 	if (ibuf.count == countof (ibuf.inst))
 		return false;
 
-	// different models/skins
-	if (ibuf.ent->model != e->model || ibuf.ent->skinnum != e->skinnum)
+	// different models/skins/detail levels
+	if (ibuf.ent->model != e->model || ibuf.ent->skinnum != e->skinnum || ibuf.lod != lod)
 		return false;
 
 	// players have custom colors
@@ -501,12 +705,22 @@ static void R_DrawAliasModel_Real (entity_t *e, qboolean showtris)
 	float		model_matrix[16];
 	aliasinstance_t	*instance;
 	int			totalverts;
+	int			lod;
 
 	//
 	// setup pose/lerp data -- do it first so we don't miss updates due to culling
 	//
 	paliashdr = (aliashdr_t *)Mod_Extradata (e->model);
 
+	// model offsets are about to change, draw everything that uses the old ones
+	if (GLMesh_VertexBuffersDirty ())
+	{
+		R_FlushAliasInstances (showtris);
+		R_SubmitAliasDraws ();
+	}
+	// upload any newly loaded models (appending doesn't move the existing ones)
+	GLMesh_UpdateVertexBuffers ();
+
 	R_SetupAliasFrame (e, paliashdr, &lerpdata);
 	R_SetupEntityTransform (e, &lerpdata);
 
@@ -535,6 +749,8 @@ static void R_DrawAliasModel_Real (entity_t *e, qboolean showtris)
 	if (R_CullModelForEntity(e))
 		return;
 
+	lod = R_SelectAliasLOD (e, paliashdr, lerpdata.origin);
+
 	//
 	// transform it
 	//
@@ -569,11 +785,22 @@ static void R_DrawAliasModel_Real (entity_t *e, qboolean showtris)
 	if (showtris)
 		entalpha = 1.f;
 
-	if (!R_Alias_CanAddToBatch (e))
+	if (!R_Alias_CanAddToBatch (e, lod))
 		R_FlushAliasInstances (showtris);
+	if (ibuf.count == countof (ibuf.inst))
+		R_SubmitAliasDraws ();
 
-	if (!ibuf.count)
+	if (ibuf.count == ibuf.first)
+	{
 		ibuf.ent = e;
+		ibuf.lod = lod;
+	}
+
+	if (!showtris)
+	{
+		dev_stats.aliaslods[lod]++;
+		dev_peakstats.aliaslods[lod] = q_max (dev_peakstats.aliaslods[lod], dev_stats.aliaslods[lod]);
+	}
 
 	instance = &ibuf.inst[ibuf.count++];
 
@@ -613,6 +840,7 @@ void R_DrawAliasModels (entity_t **ents, int count)
 	for (i = 0; i < count; i++)
 		R_DrawAliasModel_Real (ents[i], false);
 	R_FlushAliasInstances (false);
+	R_SubmitAliasDraws ();
 }
 
 /*
@@ -626,4 +854,5 @@ void R_DrawAliasModels_ShowTris (entity_t **ents, int count)
 	for (i = 0; i < count; i++)
 		R_DrawAliasModel_Real (ents[i], true);
 	R_FlushAliasInstances (true);
+	R_SubmitAliasDraws ();
 }
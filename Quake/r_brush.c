@@ -442,12 +442,17 @@ void GL_BuildLightmaps (void)
 {
 	int			i, j, xblocks, yblocks, lmsize;
 	lightmap_t	*lm;
+	gltexture_t	*glt;
 
 	r_framecount = 1; // no dlightcache
 
 	//Spike -- wipe out all the lightmap data (johnfitz -- the gltexture objects were already freed by Mod_ClearAll)
 	GL_FreeLightmapData ();
 
+	// ...unless the world was kept resident across the level change
+	if ((glt = TexMgr_FindTexture (cl.worldmodel, "lightmap")) != NULL)
+		TexMgr_FreeTexture (glt);
+
 	gl_lightmap_format = GL_RGBA;//FIXME: hardcoded for now!
 
 	switch (gl_lightmap_format)
@@ -566,6 +571,7 @@ void GL_DeleteBModelBuffers (void)
 	gl_bmodel_surf_buffer = 0;
 	gl_bmodel_marksurf_buffer = 0;
 	gl_bmodel_marksurf_buffer_size = 0;
+	R_InvalidateStaticBModels ();
 }
 
 /*
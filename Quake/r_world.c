@@ -29,6 +29,7 @@ extern cvar_t gl_zfix; // QuakeSpasm z-fighting fix
 extern cvar_t r_oit;
 
 extern gltexture_t *lightmap_texture;
+extern int *cl_efrags;
 
 extern GLuint gl_bmodel_vbo;
 extern size_t gl_bmodel_vbo_size;
@@ -45,9 +46,29 @@ typedef struct gpumark_frame_s {
 	vec3_t		vieworg;
 	GLuint		oldskyleaf;
 	GLuint		framecount;
-	GLuint		padding[3];
+	GLuint		numstatics;
+	GLuint		padding[2];
 } gpumark_frame_t;
 
+// static brush entities culled on the gpu, rebuilt when the static entity list changes
+typedef struct staticbmodeldraw_s {
+	entity_t	*ent;
+	texture_t	*texture;
+	int			instance;
+} staticbmodeldraw_t;
+
+static GLuint				gl_bmodel_static_buffer;
+static GLuint				gl_bmodel_static_leaf_buffer;
+static size_t				gl_bmodel_static_leaf_buffer_size;
+static GLuint				gl_bmodel_static_instance_buffer;
+static GLuint				gl_bmodel_static_cmd_buffer;
+static staticbmodeldraw_t	*static_bmodel_draws;	// solid pass draws first, then alpha-tested ones
+static int					num_static_bmodels;
+static int					num_static_solid_draws;
+static qboolean				static_bmodels_dirty = true;
+
+static void R_BuildStaticBModels (void);
+
 byte *SV_FatPVS (vec3_t org, qmodel_t *worldmodel);
 
 /*
@@ -66,6 +87,9 @@ static void R_MarkVisSurfaces (byte* vis)
 
 	GL_BeginGroup ("Mark surfaces");
 
+	if (static_bmodels_dirty)
+		R_BuildStaticBModels ();
+
 	for (i = 0; i < 4; i++)
 	{
 		frame.frustum[i][0] = frustum[i].normal[0];
@@ -78,6 +102,8 @@ static void R_MarkVisSurfaces (byte* vis)
 	frame.vieworg[2] = r_refdef.vieworg[2];
 	frame.oldskyleaf = r_oldskyleaf.value != 0.f;
 	frame.framecount = r_framecount;
+	frame.numstatics = num_static_bmodels;
+	frame.padding[0] = frame.padding[1] = 0;
 
 	COMPILE_TIME_ASSERT (vis_alignment_must_be_power_of_2, (VIS_ALIGN & (VIS_ALIGN - 1)) == 0);
 	COMPILE_TIME_ASSERT (vis_alignment_must_be_multiple_of_uint, (VIS_ALIGN & 3) == 0);
@@ -96,8 +122,16 @@ static void R_MarkVisSurfaces (byte* vis)
 	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 5, gl_bmodel_surf_buffer, 0, cl.worldmodel->numsurfaces * sizeof(bmodel_gpu_surf_t));
 	GL_Upload (GL_UNIFORM_BUFFER, &frame, sizeof(frame), &buf, &ofs);
 	GL_BindBufferRange (GL_UNIFORM_BUFFER, 1, buf, (GLintptr)ofs, sizeof(frame));
+	if (num_static_bmodels)
+	{
+		// static entities read the commands of their submodels, not just the world ones
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 1, gl_bmodel_indirect_buffer, 0, gl_bmodel_indirect_buffer_size);
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 6, gl_bmodel_static_cmd_buffer, 0, VEC_SIZE (static_bmodel_draws) * sizeof (bmodel_draw_indirect_t));
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 7, gl_bmodel_static_buffer, 0, num_static_bmodels * sizeof (bmodel_gpu_static_t));
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 0, gl_bmodel_static_leaf_buffer, 0, gl_bmodel_static_leaf_buffer_size);
+	}
 
-	GL_DispatchComputeFunc ((nummark + 63) / 64, 1, 1);
+	GL_DispatchComputeFunc ((nummark + num_static_bmodels + 63) / 64, 1, 1);
 	GL_MemoryBarrierFunc (GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
 
 	GL_EndGroup ();
@@ -225,32 +259,19 @@ static void R_ResetBModelCalls (GLuint program)
 
 /*
 =============
-R_FlushBModelCalls
+R_SubmitBModelCalls
+
+Issues numcalls indirect draws starting at cmdofs in the bound draw indirect buffer,
+using the first numcalls entries in bmodel_calls as per-draw parameters
 =============
 */
-static void R_FlushBModelCalls (void)
+static void R_SubmitBModelCalls (size_t cmdofs, int numcalls)
 {
-	GLuint	cmdbuf, buf;
+	GLuint	buf;
 	GLbyte	*ofs;
-	size_t	dstcmdofs;
-
-	if (!num_bmodel_calls)
-		return;
-
-	GL_ReserveDeviceMemory (GL_DRAW_INDIRECT_BUFFER, sizeof (bmodel_draw_indirect_t) * num_bmodel_calls, &cmdbuf, &dstcmdofs);
-
-	GL_UseProgram (glprogs.gather_indirect);
-	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 5, gl_bmodel_indirect_buffer, 0, gl_bmodel_indirect_buffer_size);
-	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 6, cmdbuf, dstcmdofs, sizeof (bmodel_draw_indirect_t) * num_bmodel_calls);
-	GL_Upload (GL_SHADER_STORAGE_BUFFER, bmodel_call_remap, sizeof (bmodel_call_remap[0]) * num_bmodel_calls, &buf, &ofs);
-	GL_BindBufferRange  (GL_SHADER_STORAGE_BUFFER, 7, buf, (GLintptr)ofs, sizeof (bmodel_call_remap[0]) * num_bmodel_calls);
-	GL_DispatchComputeFunc ((num_bmodel_calls + 63) / 64, 1, 1);
-	GL_MemoryBarrierFunc (GL_COMMAND_BARRIER_BIT);
 
-	GL_UseProgram (bmodel_batch_program);
 	GL_BindBuffer (GL_ELEMENT_ARRAY_BUFFER, gl_bmodel_ibo);
 	GL_BindBuffer (GL_ARRAY_BUFFER, gl_bmodel_vbo);
-	GL_BindBuffer (GL_DRAW_INDIRECT_BUFFER, cmdbuf);
 	GL_VertexAttribPointerFunc (0, 3, GL_FLOAT, GL_FALSE, sizeof (glvert_t), (void *) offsetof (glvert_t, pos));
 	GL_VertexAttribPointerFunc (1, 4, GL_FLOAT, GL_FALSE, sizeof (glvert_t), (void *) offsetof (glvert_t, st));
 	GL_VertexAttribPointerFunc (2, 1, GL_FLOAT, GL_FALSE, sizeof (glvert_t), (void *) offsetof (glvert_t, lmofs));
@@ -258,42 +279,68 @@ static void R_FlushBModelCalls (void)
 
 	if (gl_bindless_able)
 	{
-		GL_Upload (GL_SHADER_STORAGE_BUFFER, bmodel_calls.bindless.params, sizeof (bmodel_calls.bindless.params[0]) * num_bmodel_calls, &buf, &ofs);
-		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 1, buf, (GLintptr)ofs, sizeof (bmodel_calls.bindless.params[0]) * num_bmodel_calls);
-		GL_MultiDrawElementsIndirectFunc (GL_TRIANGLES, GL_UNSIGNED_INT, (const void *)dstcmdofs, num_bmodel_calls, sizeof (bmodel_draw_indirect_t));
+		GL_Upload (GL_SHADER_STORAGE_BUFFER, bmodel_calls.bindless.params, sizeof (bmodel_calls.bindless.params[0]) * numcalls, &buf, &ofs);
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 1, buf, (GLintptr)ofs, sizeof (bmodel_calls.bindless.params[0]) * numcalls);
+		GL_MultiDrawElementsIndirectFunc (GL_TRIANGLES, GL_UNSIGNED_INT, (const void *)cmdofs, numcalls, sizeof (bmodel_draw_indirect_t));
 	}
 	else
 	{
 		int i;
 
-		GL_Upload (GL_SHADER_STORAGE_BUFFER, &bmodel_calls.bound.params, sizeof (bmodel_calls.bound.params[0]) * num_bmodel_calls, &buf, &ofs);
-		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 1, buf, (GLintptr)ofs, sizeof (bmodel_calls.bound.params[0]) * num_bmodel_calls);
+		GL_Upload (GL_SHADER_STORAGE_BUFFER, &bmodel_calls.bound.params, sizeof (bmodel_calls.bound.params[0]) * numcalls, &buf, &ofs);
+		GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 1, buf, (GLintptr)ofs, sizeof (bmodel_calls.bound.params[0]) * numcalls);
 
-		for (i = 0; i < num_bmodel_calls; i++)
+		for (i = 0; i < numcalls; i++)
 		{
 			GL_Uniform1iFunc (0, i);
 			GL_BindTextures (0, 2, bmodel_calls.bound.textures[i]);
-			GL_DrawElementsIndirectFunc (GL_TRIANGLES, GL_UNSIGNED_INT, (const byte *)(dstcmdofs + i * sizeof (bmodel_draw_indirect_t)));
+			GL_DrawElementsIndirectFunc (GL_TRIANGLES, GL_UNSIGNED_INT, (const byte *)(cmdofs + i * sizeof (bmodel_draw_indirect_t)));
 		}
 	}
+}
+
+/*
+=============
+R_FlushBModelCalls
+=============
+*/
+static void R_FlushBModelCalls (void)
+{
+	GLuint	cmdbuf, buf;
+	GLbyte	*ofs;
+	size_t	dstcmdofs;
+
+	if (!num_bmodel_calls)
+		return;
+
+	GL_ReserveDeviceMemory (GL_DRAW_INDIRECT_BUFFER, sizeof (bmodel_draw_indirect_t) * num_bmodel_calls, &cmdbuf, &dstcmdofs);
+
+	GL_UseProgram (glprogs.gather_indirect);
+	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 5, gl_bmodel_indirect_buffer, 0, gl_bmodel_indirect_buffer_size);
+	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 6, cmdbuf, dstcmdofs, sizeof (bmodel_draw_indirect_t) * num_bmodel_calls);
+	GL_Upload (GL_SHADER_STORAGE_BUFFER, bmodel_call_remap, sizeof (bmodel_call_remap[0]) * num_bmodel_calls, &buf, &ofs);
+	GL_BindBufferRange  (GL_SHADER_STORAGE_BUFFER, 7, buf, (GLintptr)ofs, sizeof (bmodel_call_remap[0]) * num_bmodel_calls);
+	GL_DispatchComputeFunc ((num_bmodel_calls + 63) / 64, 1, 1);
+	GL_MemoryBarrierFunc (GL_COMMAND_BARRIER_BIT);
+
+	GL_UseProgram (bmodel_batch_program);
+	GL_BindBuffer (GL_DRAW_INDIRECT_BUFFER, cmdbuf);
+	R_SubmitBModelCalls (dstcmdofs, num_bmodel_calls);
 
 	num_bmodel_calls = 0;
 }
 
 /*
 =============
-R_AddBModelCall
+R_SetBModelCallParams
 =============
 */
-static void R_AddBModelCall (int index, int first_instance, int num_instances, texture_t *t, qboolean zfix)
+static void R_SetBModelCallParams (int call, int first_instance, texture_t *t, qboolean zfix)
 {
 	GLuint		flags;
 	float		alpha;
 	gltexture_t	*tx, *fb;
 
-	if (num_bmodel_calls == MAX_BMODEL_DRAWS)
-		R_FlushBModelCalls ();
-
 	if (t)
 	{
 		tx = t->gltexture;
@@ -316,23 +363,41 @@ static void R_AddBModelCall (int index, int first_instance, int num_instances, t
 
 	if (gl_bindless_able)
 	{
-		bmodel_bindless_gpu_call_t *call = &bmodel_calls.bindless.params[num_bmodel_calls];
-		call->flags = flags;
-		call->alpha = alpha;
-		call->texture = tx ? tx->bindless_handle : greytexture->bindless_handle;
-		call->fullbright = fb ? fb->bindless_handle : blacktexture->bindless_handle;
+		bmodel_bindless_gpu_call_t *params = &bmodel_calls.bindless.params[call];
+		params->flags = flags;
+		params->alpha = alpha;
+		params->texture = tx ? tx->bindless_handle : greytexture->bindless_handle;
+		params->fullbright = fb ? fb->bindless_handle : blacktexture->bindless_handle;
+		// not bound, so mark them as used for the texture manager
+		if (tx)
+			tx->visframe = r_framecount;
+		if (fb)
+			fb->visframe = r_framecount;
 	}
 	else
 	{
-		bmodel_bound_gpu_call_t *call = &bmodel_calls.bound.params[num_bmodel_calls];
-		gltexture_t **textures = bmodel_calls.bound.textures[num_bmodel_calls];
-		call->flags = flags;
-		call->alpha = alpha;
-		call->baseinstance = first_instance;
-		call->padding = 0;
+		bmodel_bound_gpu_call_t *params = &bmodel_calls.bound.params[call];
+		gltexture_t **textures = bmodel_calls.bound.textures[call];
+		params->flags = flags;
+		params->alpha = alpha;
+		params->baseinstance = first_instance;
+		params->padding = 0;
 		textures[0] = tx ? tx : greytexture;
 		textures[1] = fb ? fb : blacktexture;
 	}
+}
+
+/*
+=============
+R_AddBModelCall
+=============
+*/
+static void R_AddBModelCall (int index, int first_instance, int num_instances, texture_t *t, qboolean zfix)
+{
+	if (num_bmodel_calls == MAX_BMODEL_DRAWS)
+		R_FlushBModelCalls ();
+
+	R_SetBModelCallParams (num_bmodel_calls, first_instance, t, zfix);
 
 	SDL_assert (num_instances > 0);
 	SDL_assert (num_instances <= MAX_BMODEL_INSTANCES);
@@ -734,3 +799,252 @@ void R_DrawBrushModels_ShowTris (entity_t **ents, int count)
 {
 	R_DrawBrushModels_Real (ents, count, BP_SHOWTRIS, false);
 }
+
+/*
+===============================================================================
+
+				GPU-CULLED STATIC BRUSH ENTITIES
+
+Opaque static brush entities without sky or liquid surfaces never change,
+so their bounds, leafs and instance data are uploaded once. The cull/mark
+pass then tests them against the PVS and frustum and writes their indirect
+draw commands directly, instead of going through R_AddStaticModels and
+R_CullModelForEntity every frame.
+
+===============================================================================
+*/
+
+/*
+=============
+R_IsGPUStaticBModel
+=============
+*/
+qboolean R_IsGPUStaticBModel (const entity_t *ent)
+{
+	const qmodel_t *mod = ent->model;
+
+	if (!mod || mod->type != mod_brush || !ENTALPHA_OPAQUE (ent->alpha))
+		return false;
+
+	// sky and liquid surfaces are drawn in separate passes
+	return mod->texofs[TEXTYPE_SKY] != 0 && mod->texofs[TEXTYPE_COUNT] == mod->texofs[TEXTYPE_SKY];
+}
+
+/*
+=============
+R_InvalidateStaticBModels
+=============
+*/
+void R_InvalidateStaticBModels (void)
+{
+	static_bmodels_dirty = true;
+}
+
+/*
+=============
+R_BuildStaticBModels
+=============
+*/
+static void R_BuildStaticBModels (void)
+{
+	int						i, j, numleafs, numsolid, numcutout, firstsolid, firstcutout;
+	int						*efrags;
+	entity_t				*ent;
+	bmodel_gpu_static_t		*statics = NULL;
+	bmodel_gpu_instance_t	*instances = NULL;
+	GLuint					*leafs = NULL;
+	entity_t				**ents = NULL;
+
+	static_bmodels_dirty = false;
+
+	GL_DeleteBuffer (gl_bmodel_static_buffer);
+	GL_DeleteBuffer (gl_bmodel_static_leaf_buffer);
+	GL_DeleteBuffer (gl_bmodel_static_instance_buffer);
+	GL_DeleteBuffer (gl_bmodel_static_cmd_buffer);
+	gl_bmodel_static_buffer = 0;
+	gl_bmodel_static_leaf_buffer = 0;
+	gl_bmodel_static_leaf_buffer_size = 0;
+	gl_bmodel_static_instance_buffer = 0;
+	gl_bmodel_static_cmd_buffer = 0;
+	VEC_CLEAR (static_bmodel_draws);
+	num_static_bmodels = 0;
+	num_static_solid_draws = 0;
+
+	if (!cl.worldmodel || !gl_bmodel_indirect_buffer)
+		return;
+
+	// count solid draws first, so that the alpha-tested ones can follow them
+	for (i = 0, numsolid = 0, ent = cl_static_entities; i < cl.num_statics; i++, ent++)
+		if (R_IsGPUStaticBModel (ent))
+			numsolid += ent->model->texofs[TEXTYPE_CUTOUT];
+
+	for (i = 0, firstsolid = 0, firstcutout = numsolid, ent = cl_static_entities, efrags = cl_efrags; i < cl.num_statics; i++, ent++)
+	{
+		qmodel_t				*mod = ent->model;
+		bmodel_gpu_static_t		*dst;
+		bmodel_gpu_instance_t	*inst;
+
+		if (!mod)
+			continue;
+
+		numleafs = *efrags++;
+		if (!R_IsGPUStaticBModel (ent))
+		{
+			efrags += numleafs;
+			continue;
+		}
+
+		numsolid = mod->texofs[TEXTYPE_CUTOUT];
+		numcutout = mod->texofs[TEXTYPE_SKY] - mod->texofs[TEXTYPE_CUTOUT];
+
+		VEC_PUSH (statics, (bmodel_gpu_static_t) {0});
+		dst = &statics[num_static_bmodels];
+		R_GetEntityBounds (ent, dst->mins, dst->maxs);
+		dst->firstleaf = VEC_SIZE (leafs);
+		dst->numleafs = numleafs;
+		dst->firstcmd = mod->firstcmd;
+		dst->numsolid = numsolid;
+		dst->numcutout = numcutout;
+		dst->firstsolid = firstsolid;
+		dst->firstcutout = firstcutout;
+
+		for (j = 0; j < numleafs; j++)
+			VEC_PUSH (leafs, efrags[j]);
+		efrags += numleafs;
+
+		VEC_PUSH (instances, (bmodel_gpu_instance_t) {0});
+		inst = &instances[num_static_bmodels];
+		R_InitBModelInstance (inst, ent);
+
+		VEC_PUSH (ents, ent);
+
+		firstsolid += numsolid;
+		firstcutout += numcutout;
+		num_static_bmodels++;
+	}
+	num_static_solid_draws = firstsolid;
+
+	// the draw list mirrors the layout of the output commands
+	for (i = 0; i < num_static_bmodels; i++)
+	{
+		qmodel_t *mod = ents[i]->model;
+		for (j = 0; j < mod->texofs[TEXTYPE_CUTOUT]; j++)
+		{
+			staticbmodeldraw_t draw = {ents[i], mod->textures[mod->usedtextures[j]], i};
+			VEC_PUSH (static_bmodel_draws, draw);
+		}
+	}
+	for (i = 0; i < num_static_bmodels; i++)
+	{
+		qmodel_t *mod = ents[i]->model;
+		for (j = mod->texofs[TEXTYPE_CUTOUT]; j < mod->texofs[TEXTYPE_SKY]; j++)
+		{
+			staticbmodeldraw_t draw = {ents[i], mod->textures[mod->usedtextures[j]], i};
+			VEC_PUSH (static_bmodel_draws, draw);
+		}
+	}
+
+	if (num_static_bmodels)
+	{
+		gl_bmodel_static_leaf_buffer_size = q_max (VEC_SIZE (leafs), 1) * sizeof (GLuint);
+		if (!VEC_SIZE (leafs))
+			VEC_PUSH (leafs, 0);
+
+		gl_bmodel_static_buffer = GL_CreateBuffer (GL_SHADER_STORAGE_BUFFER, GL_STATIC_DRAW, "static bmodels",
+			sizeof (statics[0]) * num_static_bmodels, statics
+		);
+		gl_bmodel_static_leaf_buffer = GL_CreateBuffer (GL_SHADER_STORAGE_BUFFER, GL_STATIC_DRAW, "static bmodel leafs",
+			gl_bmodel_static_leaf_buffer_size, leafs
+		);
+		gl_bmodel_static_instance_buffer = GL_CreateBuffer (GL_SHADER_STORAGE_BUFFER, GL_STATIC_DRAW, "static bmodel instances",
+			sizeof (instances[0]) * num_static_bmodels, instances
+		);
+		gl_bmodel_static_cmd_buffer = GL_CreateBuffer (GL_SHADER_STORAGE_BUFFER, GL_DYNAMIC_DRAW, "static bmodel indirect cmds",
+			sizeof (bmodel_draw_indirect_t) * VEC_SIZE (static_bmodel_draws), NULL
+		);
+	}
+
+	Con_DPrintf ("%d static brush entities culled on the gpu (%d draws)\n", num_static_bmodels, (int) VEC_SIZE (static_bmodel_draws));
+
+	VEC_FREE (statics);
+	VEC_FREE (instances);
+	VEC_FREE (leafs);
+	VEC_FREE (ents);
+}
+
+/*
+=============
+R_DrawStaticBrushModels_Real
+=============
+*/
+static void R_DrawStaticBrushModels_Real (brushpass_t pass)
+{
+	int			i, first, count, numcalls;
+	GLuint		program;
+
+	if (!num_static_bmodels || !r_drawentities.value)
+		return;
+
+	switch (pass)
+	{
+	default:
+	case BP_SOLID:
+		first = 0;
+		count = num_static_solid_draws;
+		program = R_ChooseBModelProgram (false, false);
+		break;
+	case BP_ALPHATEST:
+		first = num_static_solid_draws;
+		count = VEC_SIZE (static_bmodel_draws) - num_static_solid_draws;
+		program = R_ChooseBModelProgram (false, true);
+		break;
+	case BP_SHOWTRIS:
+		first = 0;
+		count = VEC_SIZE (static_bmodel_draws);
+		program = glprogs.world[0][0][0];
+		break;
+	}
+
+	if (!count)
+		return;
+
+	GL_UseProgram (program);
+	GL_SetState (GLS_CULL_BACK | GLS_BLEND_OPAQUE | GLS_ATTRIBS(4));
+	if (pass != BP_SHOWTRIS)
+		GL_Bind (GL_TEXTURE2, r_fullbright_cheatsafe ? greytexture : lightmap_texture);
+	GL_BindBufferRange (GL_SHADER_STORAGE_BUFFER, 2, gl_bmodel_static_instance_buffer, 0, sizeof (bmodel_gpu_instance_t) * num_static_bmodels);
+	GL_BindBuffer (GL_DRAW_INDIRECT_BUFFER, gl_bmodel_static_cmd_buffer);
+
+	for (/**/; count > 0; first += numcalls, count -= numcalls)
+	{
+		numcalls = q_min (count, MAX_BMODEL_DRAWS);
+		for (i = 0; i < numcalls; i++)
+		{
+			staticbmodeldraw_t *draw = &static_bmodel_draws[first + i];
+			texture_t *t = pass != BP_SHOWTRIS ? R_TextureAnimation (draw->texture, draw->ent->frame) : NULL;
+			R_SetBModelCallParams (i, draw->instance, t, false);
+		}
+		R_SubmitBModelCalls (first * sizeof (bmodel_draw_indirect_t), numcalls);
+	}
+}
+
+/*
+=============
+R_DrawStaticBrushModels
+=============
+*/
+void R_DrawStaticBrushModels (void)
+{
+	R_DrawStaticBrushModels_Real (BP_SOLID);
+	R_DrawStaticBrushModels_Real (BP_ALPHATEST);
+}
+
+/*
+=============
+R_DrawStaticBrushModels_ShowTris
+=============
+*/
+void R_DrawStaticBrushModels_ShowTris (void)
+{
+	R_DrawStaticBrushModels_Real (BP_SHOWTRIS);
+}
@@ -50,6 +50,7 @@ typedef struct lightcache_s {
 typedef struct entity_s
 {
 	qboolean				forcelink;		// model changed
+	qboolean				active;			// listed in cl.activeentities
 
 	int						update_type;
 
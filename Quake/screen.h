@@ -35,6 +35,8 @@ void SCR_CenterPrint (const char *str);
 
 void SCR_BeginLoadingPlaque (void);
 void SCR_EndLoadingPlaque (void);
+void SCR_LoadingUpdate (void);
+void SCR_LoadingProgress (const char *phase, int done, int total);
 
 int SCR_ModalMessage (const char *text, float timeout); //johnfitz -- added timeout
 
@@ -72,6 +72,11 @@ typedef struct
 	int			num_signon_buffers;
 	sizebuf_t	*signon_buffers[MAX_SIGNON_BUFFERS];
 
+	byte		*signonblob;		// deflated copy of the signon buffers, malloc'ed
+	int			signonblobsize;
+	int			signonblobsrcsize;	// total size of the signon buffers when the blob was made
+	int			signonblobgen;		// bumped every time the blob is remade
+
 	unsigned	protocol; //johnfitz
 	unsigned	protocolflags;
 
@@ -132,7 +137,9 @@ typedef struct client_s
 	qboolean		spawned;			// false = don't send datagrams
 	qboolean		dropasap;			// has been told to go to another level
 	enum sendsignon_e	sendsignon;			// only valid before spawned
-	int				signonidx;
+	int				signonidx;			// signon buffer index, or byte offset into sv.signonblob
+	qboolean		signonblob;			// client asked for svc_signonblob in prespawn
+	int				signonblobgen;
 
 	double			last_message;		// reliable messages must be sent
 										// periodically
@@ -278,6 +285,7 @@ void SV_LocalSound (client_t *client, const char *sample); // for 2021 rerelease
 void SV_DropClient (qboolean crash);
 
 void SV_SendClientMessages (void);
+void SV_FreeSignonBlob (void);
 void SV_ClearDatagram (void);
 void SV_ReserveSignonSpace (int numbytes);
 
@@ -949,6 +949,8 @@ void S_ExtraUpdate (void)
 {
 	if (snd_noextraupdate.value)
 		return;		// don't pollute timings
+	if (sound_started)
+		BGM_Update();	// cheap now that music is decoded on its own thread
 	S_Update_();
 }
 
@@ -28,7 +28,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 ResampleSfx
 ================
 */
-static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
+static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, const byte *data)
 {
 	int		outcount;
 	int		srcsample;
@@ -71,7 +71,7 @@ static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 		for (i = 0; i < outcount; i++)
 		{
 			if (inwidth == 2)
-				sample = LittleShort ( ((short *)data)[srcsample] );
+				sample = LittleShort ( ((const short *)data)[srcsample] );
 			else
 				sample = (int)( (unsigned char)(data[srcsample]) - 128) << 8;
 			if (sc->width == 2)
@@ -95,7 +95,7 @@ S_LoadSound
 sfxcache_t *S_LoadSound (sfx_t *s)
 {
 	char	namebuffer[256];
-	byte	*data;
+	fileview_t	file;
 	wavinfo_t	info;
 	int		len;
 	float	stepscale;
@@ -114,25 +114,23 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 
 //	Con_Printf ("loading %s\n",namebuffer);
 
-	data = COM_LoadMallocFile (namebuffer, NULL);
-
-	if (!data)
+	if (!COM_MapFile (namebuffer, &file, NULL))
 	{
 		Con_Printf ("Couldn't load %s\n", namebuffer);
 		return NULL;
 	}
 
-	info = GetWavinfo (s->name, data, com_filesize);
+	info = GetWavinfo (s->name, file.data, file.size);
 	if (info.channels != 1)
 	{
-		free (data);
+		COM_UnmapFile (&file);
 		Con_Printf ("%s is a stereo sample\n",s->name);
 		return NULL;
 	}
 
 	if (info.width != 1 && info.width != 2)
 	{
-		free (data);
+		COM_UnmapFile (&file);
 		Con_Printf("%s is not 8 or 16 bit\n", s->name);
 		return NULL;
 	}
@@ -144,7 +142,7 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 
 	if (info.samples == 0 || len == 0)
 	{
-		free (data);
+		COM_UnmapFile (&file);
 		Con_Printf("%s has zero samples\n", s->name);
 		return NULL;
 	}
@@ -152,7 +150,7 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	sc = (sfxcache_t *) Cache_Alloc ( &s->cache, len + sizeof(sfxcache_t), s->name);
 	if (!sc)
 	{
-		free (data);
+		COM_UnmapFile (&file);
 		return NULL;
 	}
 
@@ -162,9 +160,9 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	sc->width = info.width;
 	sc->stereo = info.channels;
 
-	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
+	ResampleSfx (s, sc->speed, sc->width, file.data + info.dataofs);
 
-	free (data);
+	COM_UnmapFile (&file);
 
 	return sc;
 }
@@ -179,10 +177,10 @@ WAV loading
 ===============================================================================
 */
 
-static byte	*data_p;
-static byte	*iff_end;
-static byte	*last_chunk;
-static byte	*iff_data;
+static const byte	*data_p;
+static const byte	*iff_end;
+static const byte	*last_chunk;
+static const byte	*iff_data;
 static int	iff_chunk_len;
 
 static short GetLittleShort (void)
@@ -260,7 +258,7 @@ static void DumpChunks (void)
 GetWavinfo
 ============
 */
-wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength)
+wavinfo_t GetWavinfo (const char *name, const byte *wav, int wavlength)
 {
 	wavinfo_t	info;
 	int	i;
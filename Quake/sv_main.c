@@ -34,6 +34,9 @@ int		sv_protocol = PROTOCOL_RMQ; //johnfitz
 extern cvar_t nomonsters;
 
 static cvar_t sv_netsort = {"sv_netsort", "1", CVAR_NONE};
+static cvar_t sv_signonblob = {"sv_signonblob", "1", CVAR_NONE}; // send deflated signon buffers to clients that support it
+
+#define SIGNONBLOB_FRAGMENT	30000	// fragments only go into an empty message, keeping it below the 32000 limit used by some clients
 
 //============================================================================
 
@@ -174,6 +177,7 @@ void SV_Init (void)
 	Cvar_RegisterVariable (&sv_gameplayfix_random);
 	Cvar_RegisterVariable (&sv_gameplayfix_elevators);
 	Cvar_RegisterVariable (&sv_netsort);
+	Cvar_RegisterVariable (&sv_signonblob);
 	Cvar_RegisterVariable (&sv_autoload);
 	Cvar_RegisterVariable (&sv_autosave);
 	Cvar_RegisterVariable (&sv_autosave_interval);
@@ -1362,6 +1366,100 @@ void SV_SendNop (client_t *client)
 	client->last_message = realtime;
 }
 
+/*
+=======================
+SV_UpdateSignonBlob
+
+(Re)builds the deflated copy of the signon buffers if they changed
+since it was last made (signon buffers are only ever appended to)
+=======================
+*/
+static void SV_UpdateSignonBlob (void)
+{
+	byte	*data;
+	size_t	blobsize;
+	int		i, size;
+
+	for (i = 0, size = 0; i < sv.num_signon_buffers; i++)
+		size += sv.signon_buffers[i]->cursize;
+	if (sv.signonblob && size == sv.signonblobsrcsize)
+		return;
+
+	data = (byte *) malloc (q_max (size, 1));
+	if (!data)
+		Sys_Error ("SV_UpdateSignonBlob: out of memory on %d bytes", size);
+	for (i = 0, size = 0; i < sv.num_signon_buffers; i++)
+	{
+		memcpy (data + size, sv.signon_buffers[i]->data, sv.signon_buffers[i]->cursize);
+		size += sv.signon_buffers[i]->cursize;
+	}
+
+	free (sv.signonblob);
+	sv.signonblob = COM_Deflate (data, size, &blobsize);
+	sv.signonblobsize = (int) blobsize;
+	sv.signonblobsrcsize = size;
+	sv.signonblobgen++;
+	free (data);
+
+	Con_DPrintf ("Signon blob: %d bytes deflated to %d\n", size, sv.signonblobsize);
+}
+
+/*
+=======================
+SV_FreeSignonBlob
+=======================
+*/
+void SV_FreeSignonBlob (void)
+{
+	free (sv.signonblob);
+	sv.signonblob = NULL;
+	sv.signonblobsize = 0;
+	sv.signonblobsrcsize = 0;
+}
+
+/*
+=======================
+SV_SendSignonBlob
+
+Sends the next fragment of the deflated signon buffers
+to a client that asked for svc_signonblob
+=======================
+*/
+static void SV_SendSignonBlob (client_t *client)
+{
+	sizebuf_t	*msg = &client->message;
+	int			len;
+
+	SV_UpdateSignonBlob ();
+
+	// signon buffers changed (e.g. makestatic) while sending, start over
+	if (client->signonblobgen != sv.signonblobgen)
+	{
+		client->signonblobgen = sv.signonblobgen;
+		client->signonidx = 0;
+	}
+
+	// wait until other pending data has been sent, so that a message never holds more than one fragment
+	if (msg->cursize)
+		return;
+
+	len = q_min (sv.signonblobsize - client->signonidx, SIGNONBLOB_FRAGMENT);
+	len = q_min (len, msg->maxsize - 15);
+	if (len <= 0)
+		return;
+
+	MSG_WriteByte (msg, svc_signonblob);
+	MSG_WriteLong (msg, sv.signonblobsrcsize);
+	MSG_WriteLong (msg, sv.signonblobsize);
+	MSG_WriteLong (msg, client->signonidx);
+	MSG_WriteShort (msg, len);
+	SZ_Write (msg, sv.signonblob + client->signonidx, len);
+	client->signonidx += len;
+
+	if (client->signonidx == sv.signonblobsize)
+		client->sendsignon = PRESPAWN_SIGNONMSG;
+}
+
 /*
 =======================
 SV_SendClientMessages
@@ -1398,7 +1496,11 @@ void SV_SendClientMessages (void)
 					SV_SendNop (host_client);
 				continue;	// don't send out non-signon messages
 			}
-			if (host_client->sendsignon == PRESPAWN_SIGNONBUFS)
+			if (host_client->sendsignon == PRESPAWN_SIGNONBUFS && host_client->signonidx == 0 && host_client->signonblob)
+				host_client->signonblob = sv_signonblob.value && !SV_IsLocalClient (host_client);
+			if (host_client->sendsignon == PRESPAWN_SIGNONBUFS && host_client->signonblob)
+				SV_SendSignonBlob (host_client);
+			else if (host_client->sendsignon == PRESPAWN_SIGNONBUFS)
 			{
 				qboolean local = SV_IsLocalClient (host_client);
 				while (host_client->signonidx < sv.num_signon_buffers)
@@ -1909,8 +2011,9 @@ void SV_SpawnServer (const char *server)
 {
 	static char	dummy[8] = { 0,0,0,0,0,0,0,0 };
 	edict_t		*ent;
-	int			i, signonsize;
+	int			i, signonsize, mark;
 	qcvm_t		*vm = qcvm;
+	char		modelname[sizeof(sv.modelname)];
 
 	// let's not have any servers with no name
 	if (hostname.string[0] == 0)
@@ -1920,6 +2023,9 @@ void SV_SpawnServer (const char *server)
 	Con_DPrintf ("SpawnServer: %s\n",server);
 	svs.changelevel_issued = false;		// now safe to issue another
 
+	LoadProf_BeginSession (server);
+	LoadProf_Begin ("SV_SpawnServer");
+
 	PR_SwitchQCVM(NULL);
 
 //
@@ -1947,7 +2053,11 @@ void SV_SpawnServer (const char *server)
 // set up the new server
 //
 	//memset (&sv, 0, sizeof(sv));
+	q_snprintf (modelname, sizeof(modelname), "maps/%s.bsp", server);
+	Mod_KeepWorld (modelname);
+	LoadProf_Begin ("Host_ClearMemory");
 	Host_ClearMemory ();
+	LoadProf_End ();
 
 	q_strlcpy (sv.name, server, sizeof(sv.name));
 	if (developer.value || map_checks.value)
@@ -1963,9 +2073,33 @@ void SV_SpawnServer (const char *server)
 	}
 	else sv.protocolflags = 0;
 
+// load the world first, so that it can be kept resident for the next level
+	q_strlcpy (sv.modelname, modelname, sizeof(sv.modelname));
+	mark = Hunk_LowMark ();
+	LoadProf_Begin ("Mod_ForName (world)");
+	sv.worldmodel = Mod_ForName (sv.modelname, false);
+	LoadProf_End ();
+	if (!sv.worldmodel)
+	{
+		Con_Printf ("Couldn't spawn server %s\n", sv.modelname);
+		sv.active = false;
+		PR_SwitchQCVM(vm);
+		LoadProf_EndSession ();
+		return;
+	}
+	sv.models[1] = sv.worldmodel;
+
+	LoadProf_Begin ("Mod_ForName (submodels)");
+	for (i=1 ; i<sv.worldmodel->numsubmodels ; i++)
+		sv.models[i+1] = Mod_ForName (localmodels[i], false);
+	LoadProf_End ();
+	Mod_SetResidentWorld (sv.worldmodel, mark);
+
 	PR_SwitchQCVM(vm);
 // load progs to get entity field count
+	LoadProf_Begin ("PR_LoadProgs");
 	PR_LoadProgs ("progs.dat", true);
+	LoadProf_End ();
 
 // allocate server memory
 	/* Host_ClearMemory() called above already cleared the whole sv structure */
@@ -2000,17 +2134,6 @@ void SV_SpawnServer (const char *server)
 
 	qcvm->time = 1.0;
 
-	q_strlcpy (sv.name, server, sizeof(sv.name));
-	q_snprintf (sv.modelname, sizeof(sv.modelname), "maps/%s.bsp", server);
-	sv.worldmodel = Mod_ForName (sv.modelname, false);
-	if (!sv.worldmodel)
-	{
-		Con_Printf ("Couldn't spawn server %s\n", sv.modelname);
-		sv.active = false;
-		return;
-	}
-	sv.models[1] = sv.worldmodel;
-
 //
 // clear world interaction links
 //
@@ -2020,10 +2143,7 @@ void SV_SpawnServer (const char *server)
 	sv.model_precache[0] = dummy;
 	sv.model_precache[1] = sv.modelname;
 	for (i=1 ; i<sv.worldmodel->numsubmodels ; i++)
-	{
 		sv.model_precache[1+i] = localmodels[i];
-		sv.models[i+1] = Mod_ForName (localmodels[i], false);
-	}
 
 //
 // load the rest of the entities
@@ -2045,7 +2165,9 @@ void SV_SpawnServer (const char *server)
 // serverflags are for cross level information (sigils)
 	pr_global_struct->serverflags = svs.serverflags;
 
+	LoadProf_Begin ("ED_LoadFromFile");
 	ED_LoadFromFile (sv.worldmodel->entities);
+	LoadProf_End ();
 
 	sv.active = true;
 
@@ -2054,11 +2176,15 @@ void SV_SpawnServer (const char *server)
 
 // run two frames to allow everything to settle
 	host_frametime = 0.1;
+	LoadProf_Begin ("SV_Physics");
 	SV_Physics ();
 	SV_Physics ();
+	LoadProf_End ();
 
 // create a baseline for more efficient communications
+	LoadProf_Begin ("SV_CreateBaseline");
 	SV_CreateBaseline ();
+	LoadProf_End ();
 
 	//johnfitz -- warn if signon buffer larger than standard server can handle
 	for (i = 0, signonsize = 0; i < sv.num_signon_buffers; i++)
@@ -2078,5 +2204,9 @@ void SV_SpawnServer (const char *server)
 
 	if (sv.mapchecks.active)
 		SV_PrintMapChecklist ();
+
+	LoadProf_End ();
+	if (cls.state == ca_dedicated)
+		LoadProf_EndSession ();
 }
 
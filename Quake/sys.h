@@ -85,6 +85,21 @@ int Sys_FileRead (int handle, void *dest, int count);
 int Sys_FileWrite (int handle,const void *data, int count);
 qboolean Sys_FileExists (const char *path);
 qboolean Sys_GetFileTime (const char *path, time_t *out);
+
+// Maps the whole file read-only into memory.
+// Returns NULL if the file can't be opened, is empty or can't be mapped.
+const void *Sys_MapFile (const char *path, size_t *size);
+void Sys_UnmapFile (const void *data, size_t size);
+
+// Files opened for positional reads. There is no handle table and no file
+// pointer involved, so a single sysfile_t can be read by several threads.
+typedef struct sysfile_s sysfile_t;
+sysfile_t *Sys_FileOpenShared (const char *path);
+int Sys_FileReadAt (sysfile_t *file, qfileofs_t offset, void *dest, int count);
+void Sys_FileCloseShared (sysfile_t *file);
+
+// returns the size of a regular file, or -1 if there's no such file
+qfileofs_t Sys_FileSize (const char *path);
 void Sys_mkdir (const char *path);
 FILE *Sys_fopen (const char *path, const char *mode);
 int Sys_fseek (FILE *file, qfileofs_t ofs, int origin);
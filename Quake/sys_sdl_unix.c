@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <libgen.h>	/* dirname() and basename() */
 #endif
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <fcntl.h>
 #include <time.h>
@@ -217,6 +218,16 @@ int Sys_FileType (const char *path)
 	return FS_ENT_NONE;
 }
 
+qfileofs_t Sys_FileSize (const char *path)
+{
+	struct stat	st;
+
+	if (stat (path, &st) != 0 || !S_ISREG (st.st_mode))
+		return -1;
+
+	return st.st_size;
+}
+
 qboolean Sys_GetFileTime (const char *path, time_t *out)
 {
 	struct stat st;
@@ -226,6 +237,83 @@ qboolean Sys_GetFileTime (const char *path, time_t *out)
 	return true;
 }
 
+const void *Sys_MapFile (const char *path, size_t *size)
+{
+	struct stat	st;
+	void		*data;
+	int			fd;
+
+	fd = open (path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+	if (fstat (fd, &st) != 0 || st.st_size <= 0 || (uint64_t) st.st_size > (uint64_t) SIZE_MAX)
+	{
+		close (fd);
+		return NULL;
+	}
+
+	data = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd); // the mapping keeps its own reference to the file
+	if (data == MAP_FAILED)
+		return NULL;
+
+	*size = (size_t) st.st_size;
+	return data;
+}
+
+void Sys_UnmapFile (const void *data, size_t size)
+{
+	if (data)
+		munmap ((void *) data, size);
+}
+
+struct sysfile_s
+{
+	int		fd;
+};
+
+sysfile_t *Sys_FileOpenShared (const char *path)
+{
+	sysfile_t	*file;
+	int			fd;
+
+	fd = open (path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	file = (sysfile_t *) malloc (sizeof (*file));
+	if (!file)
+		Sys_Error ("Sys_FileOpenShared: out of memory");
+	file->fd = fd;
+
+	return file;
+}
+
+int Sys_FileReadAt (sysfile_t *file, qfileofs_t offset, void *dest, int count)
+{
+	int		total = 0;
+
+	while (total < count)
+	{
+		ssize_t n = pread (file->fd, (byte *) dest + total, count - total, (off_t) (offset + total));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		total += (int) n;
+	}
+
+	return total;
+}
+
+void Sys_FileCloseShared (sysfile_t *file)
+{
+	if (!file)
+		return;
+	close (file->fd);
+	free (file);
+}
+
 #if defined(__linux__) || defined(__sun) || defined(sun) || defined(_AIX)
 static int Sys_NumCPUs (void)
 {
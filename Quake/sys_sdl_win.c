@@ -302,6 +302,109 @@ qboolean Sys_GetFileTime (const char *path, time_t *out)
 	return ret;
 }
 
+const void *Sys_MapFile (const char *path, size_t *size)
+{
+	wchar_t			wpath[MAX_PATH];
+	HANDLE			file, mapping;
+	LARGE_INTEGER	filesize;
+	void			*data;
+
+	UTF8ToWideString (path, wpath, countof (wpath));
+	file = CreateFileW (wpath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+	if (!GetFileSizeEx (file, &filesize) || filesize.QuadPart <= 0 || (uint64_t) filesize.QuadPart > (uint64_t) SIZE_MAX)
+	{
+		CloseHandle (file);
+		return NULL;
+	}
+
+	mapping = CreateFileMappingW (file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle (file);
+	if (!mapping)
+		return NULL;
+
+	data = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle (mapping); // the view keeps the mapping alive
+	if (!data)
+		return NULL;
+
+	*size = (size_t) filesize.QuadPart;
+	return data;
+}
+
+void Sys_UnmapFile (const void *data, size_t size)
+{
+	if (data)
+		UnmapViewOfFile (data);
+}
+
+struct sysfile_s
+{
+	HANDLE	handle;
+};
+
+sysfile_t *Sys_FileOpenShared (const char *path)
+{
+	wchar_t		wpath[MAX_PATH];
+	sysfile_t	*file;
+	HANDLE		handle;
+
+	UTF8ToWideString (path, wpath, countof (wpath));
+	handle = CreateFileW (wpath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	file = (sysfile_t *) malloc (sizeof (*file));
+	if (!file)
+		Sys_Error ("Sys_FileOpenShared: out of memory");
+	file->handle = handle;
+
+	return file;
+}
+
+int Sys_FileReadAt (sysfile_t *file, qfileofs_t offset, void *dest, int count)
+{
+	int		total = 0;
+
+	while (total < count)
+	{
+		OVERLAPPED	ov;
+		DWORD		n = 0;
+
+		// an explicit offset makes ReadFile ignore the shared file pointer
+		memset (&ov, 0, sizeof (ov));
+		ov.Offset = (DWORD) (offset + total);
+		ov.OffsetHigh = (DWORD) ((uint64_t) (offset + total) >> 32);
+		if (!ReadFile (file->handle, (byte *) dest + total, count - total, &n, &ov) || !n)
+			break;
+		total += (int) n;
+	}
+
+	return total;
+}
+
+void Sys_FileCloseShared (sysfile_t *file)
+{
+	if (!file)
+		return;
+	CloseHandle (file->handle);
+	free (file);
+}
+
+qfileofs_t Sys_FileSize (const char *path)
+{
+	wchar_t						wpath[MAX_PATH];
+	WIN32_FILE_ATTRIBUTE_DATA	data;
+
+	UTF8ToWideString (path, wpath, countof (wpath));
+	if (!GetFileAttributesExW (wpath, GetFileExInfoStandard, &data) ||
+		(data.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY|FILE_ATTRIBUTE_DEVICE)))
+		return -1;
+
+	return ((qfileofs_t) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+}
+
 static qboolean Sys_GetRegistryString (HKEY root, const wchar_t *dir, const wchar_t *keyname, char *out, size_t maxchars)
 {
 	LSTATUS		err;
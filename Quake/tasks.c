@@ -0,0 +1,709 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// tasks.c -- worker pool and main thread queue
+
+#include "quakedef.h"
+
+#define MIN_TASK_WORKERS	2
+#define MAX_TASK_WORKERS	32
+#define MIN_DEQUE_SIZE		64
+
+typedef struct task_s
+{
+	taskfunc_t			func;
+	void				*param;
+	taskcounter_t		*counter;
+	qboolean			workeronly;	// never run by Task_Wait on the waiting thread
+	struct task_s		*next;		// counter waiting list
+} task_t;
+
+typedef struct
+{
+	SDL_SpinLock		lock;
+	task_t				**items;
+	size_t				head;		// stealing end
+	size_t				tail;		// owner end
+	size_t				capacity;
+} taskdeque_t;
+
+typedef struct mainproc_s
+{
+	taskfunc_t			func;
+	void				*param;
+	struct mainproc_s	*next;
+} mainproc_t;
+
+static struct
+{
+	int					numworkers;
+	SDL_Thread			*threads[MAX_TASK_WORKERS];
+	taskdeque_t			deques[MAX_TASK_WORKERS];
+	SDL_atomic_t		queued;
+	SDL_atomic_t		nextdeque;
+	SDL_atomic_t		quit;
+	SDL_mutex			*mutex;
+	SDL_cond			*wake;		// signaled when a task is queued and a worker is sleeping
+	SDL_cond			*done;		// signaled when a counter drops to zero and someone is waiting
+	int					sleeping;
+	int					waiting;
+	SDL_atomic_t		blocking;	// threads started by Task_RunBlocking that haven't finished yet
+} tasks;
+
+// multi-producer, single-consumer queue (intrusive, with a stub node)
+static struct
+{
+	mainproc_t			*head;		// producers
+	mainproc_t			*tail;		// consumer
+	mainproc_t			stub;
+	SDL_atomic_t		closed;
+} mainqueue;
+
+static THREAD_LOCAL int	task_worker = -1;
+
+//==============================================================================
+//
+// Deques
+//
+//==============================================================================
+
+/*
+================
+Deque_Push
+
+Adds a task at the owner end, growing the deque if needed
+================
+*/
+static void Deque_Push (taskdeque_t *deque, task_t *task)
+{
+	SDL_AtomicLock (&deque->lock);
+	if (deque->tail - deque->head == deque->capacity)
+	{
+		size_t		i, capacity = q_max (deque->capacity * 2, MIN_DEQUE_SIZE);
+		task_t		**items = (task_t **) malloc (capacity * sizeof (*items));
+		if (!items)
+			Sys_Error ("Deque_Push: out of memory on %" SDL_PRIu64 " bytes", (uint64_t) (capacity * sizeof (*items)));
+		for (i = deque->head; i != deque->tail; i++)
+			items[i & (capacity - 1)] = deque->items[i & (deque->capacity - 1)];
+		free (deque->items);
+		deque->items = items;
+		deque->capacity = capacity;
+	}
+	deque->items[(deque->tail++) & (deque->capacity - 1)] = task;
+	SDL_AtomicUnlock (&deque->lock);
+}
+
+/*
+================
+Deque_Pop
+
+Removes the most recently pushed task (owner end)
+================
+*/
+static task_t *Deque_Pop (taskdeque_t *deque)
+{
+	task_t *task = NULL;
+	SDL_AtomicLock (&deque->lock);
+	if (deque->tail != deque->head)
+		task = deque->items[(--deque->tail) & (deque->capacity - 1)];
+	SDL_AtomicUnlock (&deque->lock);
+	return task;
+}
+
+/*
+================
+Deque_Steal
+
+Removes the oldest task (stealing end)
+================
+*/
+static task_t *Deque_Steal (taskdeque_t *deque)
+{
+	task_t *task = NULL;
+	SDL_AtomicLock (&deque->lock);
+	if (deque->tail != deque->head)
+		task = deque->items[(deque->head++) & (deque->capacity - 1)];
+	SDL_AtomicUnlock (&deque->lock);
+	return task;
+}
+
+/*
+================
+Deque_Take
+
+Removes the oldest task that releases the given counter
+and may be run by Task_Wait
+================
+*/
+static task_t *Deque_Take (taskdeque_t *deque, taskcounter_t *counter)
+{
+	task_t	*task = NULL;
+	size_t	i, mask;
+
+	SDL_AtomicLock (&deque->lock);
+	mask = deque->capacity - 1;
+	for (i = deque->head; i != deque->tail; i++)
+	{
+		if (deque->items[i & mask]->counter != counter || deque->items[i & mask]->workeronly)
+			continue;
+		task = deque->items[i & mask];
+		// close the gap, keeping the order of the other tasks
+		for (; i != deque->head; i--)
+			deque->items[i & mask] = deque->items[(i - 1) & mask];
+		deque->head++;
+		break;
+	}
+	SDL_AtomicUnlock (&deque->lock);
+	return task;
+}
+
+//==============================================================================
+//
+// Workers
+//
+//==============================================================================
+
+/*
+================
+Tasks_Submit
+================
+*/
+static void Tasks_Submit (task_t *task)
+{
+	int index = task_worker;
+	if (index < 0)
+		index = (int) ((unsigned int) SDL_AtomicAdd (&tasks.nextdeque, 1) % (unsigned int) tasks.numworkers);
+
+	Deque_Push (&tasks.deques[index], task);
+	SDL_AtomicIncRef (&tasks.queued);
+
+	SDL_LockMutex (tasks.mutex);
+	if (tasks.sleeping)
+		SDL_CondSignal (tasks.wake);
+	SDL_UnlockMutex (tasks.mutex);
+}
+
+/*
+================
+Tasks_Grab
+
+Pops a task from the worker's own deque, or steals one from another worker
+================
+*/
+static task_t *Tasks_Grab (int self)
+{
+	task_t	*task;
+	int		i;
+
+	if (!SDL_AtomicGet (&tasks.queued))
+		return NULL;
+
+	task = Deque_Pop (&tasks.deques[self]);
+	for (i = 1; !task && i < tasks.numworkers; i++)
+		task = Deque_Steal (&tasks.deques[(self + i) % tasks.numworkers]);
+
+	if (task)
+		SDL_AtomicAdd (&tasks.queued, -1);
+
+	return task;
+}
+
+/*
+================
+Tasks_GrabFor
+
+Finds a queued task that releases the given counter, in any deque
+================
+*/
+static task_t *Tasks_GrabFor (taskcounter_t *counter)
+{
+	task_t	*task = NULL;
+	int		i, first;
+
+	if (!SDL_AtomicGet (&tasks.queued))
+		return NULL;
+
+	first = q_max (task_worker, 0);
+	for (i = 0; !task && i < tasks.numworkers; i++)
+		task = Deque_Take (&tasks.deques[(first + i) % tasks.numworkers], counter);
+
+	if (task)
+		SDL_AtomicAdd (&tasks.queued, -1);
+
+	return task;
+}
+
+/*
+================
+TaskCounter_Release
+
+Note: the counter may go out of scope as soon as it reaches zero,
+so it must not be touched after the lock is released
+================
+*/
+static void TaskCounter_Release (taskcounter_t *counter)
+{
+	task_t		*waiters = NULL;
+	qboolean	zero;
+
+	SDL_AtomicLock (&counter->lock);
+	zero = SDL_AtomicDecRef (&counter->pending);
+	if (zero)
+	{
+		waiters = counter->waiters;
+		counter->waiters = NULL;
+	}
+	SDL_AtomicUnlock (&counter->lock);
+
+	if (!zero)
+		return;
+
+	while (waiters)
+	{
+		task_t *next = waiters->next;
+		waiters->next = NULL;
+		Tasks_Submit (waiters);
+		waiters = next;
+	}
+
+	SDL_LockMutex (tasks.mutex);
+	if (tasks.waiting)
+		SDL_CondBroadcast (tasks.done);
+	SDL_UnlockMutex (tasks.mutex);
+}
+
+/*
+================
+Task_Execute
+================
+*/
+static void Task_Execute (task_t *task)
+{
+	task->func (task->param);
+	if (task->counter)
+		TaskCounter_Release (task->counter);
+	free (task);
+}
+
+/*
+================
+Tasks_Worker
+================
+*/
+static int Tasks_Worker (void *param)
+{
+	task_worker = (int) (intptr_t) param;
+
+	while (true)
+	{
+		task_t *task = Tasks_Grab (task_worker);
+		if (task)
+		{
+			Task_Execute (task);
+			continue;
+		}
+
+		SDL_LockMutex (tasks.mutex);
+		if (SDL_AtomicGet (&tasks.quit))
+		{
+			SDL_UnlockMutex (tasks.mutex);
+			break;
+		}
+		tasks.sleeping++;
+		while (!SDL_AtomicGet (&tasks.queued) && !SDL_AtomicGet (&tasks.quit))
+			SDL_CondWait (tasks.wake, tasks.mutex);
+		tasks.sleeping--;
+		SDL_UnlockMutex (tasks.mutex);
+	}
+
+	return 0;
+}
+
+//==============================================================================
+//
+// Public interface
+//
+//==============================================================================
+
+/*
+================
+Task_Alloc
+================
+*/
+static task_t *Task_Alloc (taskfunc_t func, void *param, taskcounter_t *counter)
+{
+	task_t *task = (task_t *) malloc (sizeof (*task));
+	if (!task)
+		Sys_Error ("Task_Alloc: out of memory");
+	task->func = func;
+	task->param = param;
+	task->counter = counter;
+	task->workeronly = false;
+	task->next = NULL;
+	if (counter)
+		SDL_AtomicIncRef (&counter->pending);
+	return task;
+}
+
+/*
+================
+Task_Run
+================
+*/
+void Task_Run (taskfunc_t func, void *param, taskcounter_t *counter)
+{
+	task_t *task = Task_Alloc (func, param, counter);
+	if (!tasks.numworkers)
+		Task_Execute (task);
+	else
+		Tasks_Submit (task);
+}
+
+/*
+================
+Task_RunOnWorker
+
+Like Task_Run, but Task_Wait leaves the task to the workers instead of
+running it on the waiting thread
+================
+*/
+void Task_RunOnWorker (taskfunc_t func, void *param, taskcounter_t *counter)
+{
+	task_t *task = Task_Alloc (func, param, counter);
+	task->workeronly = true;
+	if (!tasks.numworkers)
+		Task_Execute (task);
+	else
+		Tasks_Submit (task);
+}
+
+/*
+================
+Task_RunAfter
+================
+*/
+void Task_RunAfter (taskfunc_t func, void *param, taskcounter_t *counter, taskcounter_t *dependency)
+{
+	task_t *task = Task_Alloc (func, param, counter);
+
+	if (dependency && tasks.numworkers)
+	{
+		SDL_AtomicLock (&dependency->lock);
+		if (SDL_AtomicGet (&dependency->pending))
+		{
+			task->next = dependency->waiters;
+			dependency->waiters = task;
+			task = NULL;
+		}
+		SDL_AtomicUnlock (&dependency->lock);
+	}
+
+	if (!task)
+		return;
+	if (!tasks.numworkers)
+		Task_Execute (task);
+	else
+		Tasks_Submit (task);
+}
+
+/*
+================
+Task_BlockingThread
+================
+*/
+static int Task_BlockingThread (void *param)
+{
+	Task_Execute ((task_t *) param);
+	SDL_AtomicAdd (&tasks.blocking, -1);
+	return 0;
+}
+
+/*
+================
+Task_RunBlocking
+
+Runs the task on a thread of its own, for work that spends most of its time
+blocked (e.g. downloads) and would otherwise hold on to a pool worker
+================
+*/
+void Task_RunBlocking (taskfunc_t func, void *param, taskcounter_t *counter)
+{
+	task_t		*task = Task_Alloc (func, param, counter);
+	SDL_Thread	*thread;
+
+	SDL_AtomicIncRef (&tasks.blocking);
+	thread = SDL_CreateThread (Task_BlockingThread, "Blocking task", task);
+	if (thread)
+	{
+		SDL_DetachThread (thread);
+		return;
+	}
+	SDL_AtomicAdd (&tasks.blocking, -1);
+
+	Con_DPrintf ("Task_RunBlocking: couldn't create thread, using the worker pool\n");
+	if (!tasks.numworkers)
+		Task_Execute (task);
+	else
+		Tasks_Submit (task);
+}
+
+/*
+================
+Task_IsDone
+================
+*/
+qboolean Task_IsDone (taskcounter_t *counter)
+{
+	if (SDL_AtomicGet (&counter->pending))
+		return false;
+	// wait for TaskCounter_Release to let go of the counter
+	SDL_AtomicLock (&counter->lock);
+	SDL_AtomicUnlock (&counter->lock);
+	return true;
+}
+
+/*
+================
+Task_Wait
+
+Runs the queued tasks of the counter while waiting, so that the waiting
+thread (the main thread included) helps with the work it depends on.
+Unrelated tasks are left to the workers: they could take long, or need
+thread state (e.g. a qcvm) that the waiting thread is already using.
+================
+*/
+void Task_Wait (taskcounter_t *counter)
+{
+	while (SDL_AtomicGet (&counter->pending))
+	{
+		task_t *task = Tasks_GrabFor (counter);
+		if (task)
+		{
+			Task_Execute (task);
+			continue;
+		}
+
+		// short timeout: tasks may be queued without signaling tasks.done
+		SDL_LockMutex (tasks.mutex);
+		tasks.waiting++;
+		if (SDL_AtomicGet (&counter->pending))
+			SDL_CondWaitTimeout (tasks.done, tasks.mutex, 1);
+		tasks.waiting--;
+		SDL_UnlockMutex (tasks.mutex);
+	}
+
+	Task_IsDone (counter);
+}
+
+/*
+================
+Tasks_NumWorkers
+================
+*/
+int Tasks_NumWorkers (void)
+{
+	return q_max (tasks.numworkers, 1);
+}
+
+/*
+================
+Tasks_PostToMainThread
+================
+*/
+void Tasks_PostToMainThread (taskfunc_t func, void *param)
+{
+	mainproc_t *proc, *prev;
+
+	if (!SDL_AtomicGetPtr ((void **) &mainqueue.head) || SDL_AtomicGet (&mainqueue.closed))
+		return;
+
+	proc = (mainproc_t *) malloc (sizeof (*proc));
+	if (!proc)
+		Sys_Error ("Tasks_PostToMainThread: out of memory");
+	proc->func = func;
+	proc->param = param;
+	proc->next = NULL;
+
+	prev = (mainproc_t *) SDL_AtomicSetPtr ((void **) &mainqueue.head, proc);
+	SDL_AtomicSetPtr ((void **) &prev->next, proc);
+}
+
+/*
+================
+MainQueue_Pop
+
+Returns NULL when the queue is empty, or when a producer is in the middle
+of a push (the node will be picked up next time)
+================
+*/
+static mainproc_t *MainQueue_Pop (void)
+{
+	mainproc_t *tail = mainqueue.tail;
+	mainproc_t *next = (mainproc_t *) SDL_AtomicGetPtr ((void **) &tail->next);
+
+	if (tail == &mainqueue.stub)
+	{
+		if (!next)
+			return NULL;
+		mainqueue.tail = tail = next;
+		next = (mainproc_t *) SDL_AtomicGetPtr ((void **) &tail->next);
+	}
+
+	if (next)
+	{
+		mainqueue.tail = next;
+		return tail;
+	}
+
+	if (tail != SDL_AtomicGetPtr ((void **) &mainqueue.head))
+		return NULL;
+
+	// put the stub back so that the last node can be removed
+	mainqueue.stub.next = NULL;
+	next = (mainproc_t *) SDL_AtomicSetPtr ((void **) &mainqueue.head, &mainqueue.stub);
+	SDL_AtomicSetPtr ((void **) &next->next, &mainqueue.stub);
+
+	next = (mainproc_t *) SDL_AtomicGetPtr ((void **) &tail->next);
+	if (next)
+	{
+		mainqueue.tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
+
+/*
+================
+Tasks_RunMainThreadQueue
+================
+*/
+void Tasks_RunMainThreadQueue (void)
+{
+	mainproc_t *proc;
+
+	if (!mainqueue.tail)
+		return;
+
+	while ((proc = MainQueue_Pop ()) != NULL)
+	{
+		proc->func (proc->param);
+		free (proc);
+	}
+}
+
+/*
+================
+Tasks_Init
+================
+*/
+void Tasks_Init (void)
+{
+	int i, numworkers;
+
+	mainqueue.stub.next = NULL;
+	mainqueue.head = mainqueue.tail = &mainqueue.stub;
+	SDL_AtomicSet (&mainqueue.closed, 0);
+
+	tasks.mutex = SDL_CreateMutex ();
+	if (!tasks.mutex)
+		Sys_Error ("Tasks_Init: could not create mutex");
+	tasks.wake = SDL_CreateCond ();
+	tasks.done = SDL_CreateCond ();
+	if (!tasks.wake || !tasks.done)
+		Sys_Error ("Tasks_Init: could not create condition variable");
+
+	numworkers = CLAMP (MIN_TASK_WORKERS, host_parms->numcpus, MAX_TASK_WORKERS);
+
+	// workers can submit to their own deque as soon as they start,
+	// so publish the final count before creating any of them
+	tasks.numworkers = numworkers;
+	for (i = 0; i < numworkers; i++)
+	{
+		tasks.threads[i] = SDL_CreateThread (Tasks_Worker, "Worker", (void *) (intptr_t) i);
+		if (!tasks.threads[i])
+			break;
+	}
+
+	if (!i)
+	{
+		Sys_Printf ("Couldn't create worker threads, tasks will run synchronously\n");
+		tasks.numworkers = 0;
+		return;
+	}
+
+	// tasks queued on the deques of missing workers are still picked up through stealing
+	Sys_Printf ("Started %d worker threads\n", i);
+}
+
+/*
+================
+Tasks_CloseMainThreadQueue
+
+Runs pending main thread functions, any later ones are dropped
+================
+*/
+void Tasks_CloseMainThreadQueue (void)
+{
+	Tasks_RunMainThreadQueue ();
+	SDL_AtomicSet (&mainqueue.closed, 1);
+}
+
+/*
+================
+Tasks_Shutdown
+
+All subsystems are expected to have waited for their tasks by now
+================
+*/
+void Tasks_Shutdown (void)
+{
+	mainproc_t	*proc;
+	int			i;
+
+	if (!tasks.mutex)
+		return;
+
+	SDL_LockMutex (tasks.mutex);
+	SDL_AtomicSet (&tasks.quit, 1);
+	SDL_CondBroadcast (tasks.wake);
+	SDL_UnlockMutex (tasks.mutex);
+
+	for (i = 0; i < tasks.numworkers; i++)
+	{
+		if (tasks.threads[i])
+			SDL_WaitThread (tasks.threads[i], NULL);
+		while (tasks.deques[i].tail != tasks.deques[i].head)
+			free (Deque_Steal (&tasks.deques[i]));
+		free (tasks.deques[i].items);
+	}
+
+	// blocking tasks were waited for, but their threads may still be releasing the counter
+	while (SDL_AtomicGet (&tasks.blocking))
+		SDL_Delay (1);
+
+	SDL_AtomicSet (&mainqueue.closed, 1);
+	while ((proc = MainQueue_Pop ()) != NULL)
+		free (proc);
+
+	SDL_DestroyCond (tasks.done);
+	SDL_DestroyCond (tasks.wake);
+	SDL_DestroyMutex (tasks.mutex);
+	memset (&tasks, 0, sizeof (tasks));
+}
@@ -0,0 +1,73 @@
+/*
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef _TASKS_H_
+#define _TASKS_H_
+
+// tasks.h -- worker pool and main thread queue
+
+/*
+Tasks run on a fixed pool of worker threads sized to the number of cores.
+Each worker owns a deque: tasks submitted from a worker go to the bottom
+of its own deque and are popped from there, idle workers steal from the
+top of the other deques.
+
+A counter tracks a group of tasks: Task_Run increments it and it is
+decremented when the task returns. Task_RunAfter holds a task back until
+the given counter drops to zero. Counters must be zero-initialized and
+must outlive the tasks that reference them.
+
+Task_Wait blocks until a counter drops to zero, running the counter's own
+queued tasks in the meantime (on workers and on the main thread alike).
+Tasks that need thread state of their own (e.g. a qcvm) go through
+Task_RunOnWorker, which Task_Wait leaves to the workers. The pool is meant
+for short CPU work: tasks that block for a long time (e.g. network
+downloads) go through Task_RunBlocking, which gives them a thread of their
+own, and should poll a cancellation flag so that waiting for them doesn't
+stall shutdown.
+
+Tasks_PostToMainThread queues a function to be run by the main thread at
+the start of the next frame. It's safe to call from any thread.
+*/
+
+typedef void (*taskfunc_t) (void *param);
+
+typedef struct taskcounter_s
+{
+	SDL_atomic_t		pending;
+	SDL_SpinLock		lock;
+	struct task_s		*waiters;
+} taskcounter_t;
+
+void Tasks_Init (void);
+void Tasks_CloseMainThreadQueue (void);
+void Tasks_Shutdown (void);
+int Tasks_NumWorkers (void);
+
+void Task_Run (taskfunc_t func, void *param, taskcounter_t *counter);
+void Task_RunOnWorker (taskfunc_t func, void *param, taskcounter_t *counter);
+void Task_RunAfter (taskfunc_t func, void *param, taskcounter_t *counter, taskcounter_t *dependency);
+void Task_RunBlocking (taskfunc_t func, void *param, taskcounter_t *counter);
+void Task_Wait (taskcounter_t *counter);
+qboolean Task_IsDone (taskcounter_t *counter);
+
+void Tasks_PostToMainThread (taskfunc_t func, void *param);
+void Tasks_RunMainThreadQueue (void);
+
+#endif /* _TASKS_H_ */